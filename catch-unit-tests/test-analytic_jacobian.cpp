@@ -0,0 +1,104 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#include "catch.hpp"
+
+extern std::string getTestFile(const std::string& fileName);
+
+#include <cmath>
+
+#include <copasi/copasi.h>
+#include <copasi/core/CRootContainer.h>
+#include <copasi/CopasiDataModel/CDataModel.h>
+#include <copasi/model/CModel.h>
+#include <copasi/math/CMathContainer.h>
+#include <copasi/math/CMathJacobian.h>
+
+static void compare_jacobians(CMathContainer & container, const bool & reduced)
+{
+  container.updateSimulatedValues(reduced);
+
+  CMathJacobian Jacobian;
+  REQUIRE(Jacobian.compile(container, reduced, false) == true);
+  REQUIRE(Jacobian.isValid() == true);
+
+  Jacobian.calculate();
+
+  CMatrix< C_FLOAT64 > Analytic;
+  Jacobian.getDense(Analytic);
+
+  // Dense finite differences
+  CMatrix< C_FLOAT64 > FiniteDifferences;
+  container.setUseJacobianColoring(false);
+  container.calculateJacobian(FiniteDifferences, 1e-6, reduced);
+
+  REQUIRE(Analytic.numRows() == FiniteDifferences.numRows());
+  REQUIRE(Analytic.numCols() == FiniteDifferences.numCols());
+
+  for (size_t i = 0; i < Analytic.numRows(); ++i)
+    for (size_t j = 0; j < Analytic.numCols(); ++j)
+      {
+        INFO("reduced: " << reduced << " row: " << i << " column: " << j);
+        CHECK(Analytic(i, j) == Approx(FiniteDifferences(i, j)).epsilon(1e-4).scale(1e-2));
+      }
+
+  // Finite differences with column coloring
+  CMatrix< C_FLOAT64 > Colored;
+  container.setUseJacobianColoring(true);
+  container.calculateJacobian(Colored, 1e-6, reduced);
+
+  REQUIRE(Colored.numRows() == FiniteDifferences.numRows());
+
+  for (size_t i = 0; i < Colored.numRows(); ++i)
+    for (size_t j = 0; j < Colored.numCols(); ++j)
+      {
+        INFO("reduced: " << reduced << " row: " << i << " column: " << j);
+        CHECK(Colored(i, j) == Approx(FiniteDifferences(i, j)).epsilon(1e-8).scale(1e-4));
+      }
+}
+
+TEST_CASE("2: analytic Jacobian matches finite differences", "[copasi][math]")
+{
+  if (CRootContainer::getRoot() == NULL)
+    CRootContainer::init(0, NULL, false);
+
+  CDataModel * pDataModel = CRootContainer::addDatamodel();
+  REQUIRE(pDataModel != NULL);
+
+  // The model contains rate laws, a function definition, assignments, a rate rule,
+  // a piecewise function and a moiety.
+  REQUIRE(pDataModel->importSBML(getTestFile("test-data/jacobian_test.xml")) == true);
+
+  CMathContainer & Container = pDataModel->getModel()->getMathContainer();
+  Container.applyInitialValues();
+
+  SECTION("initial state")
+  {
+    compare_jacobians(Container, false);
+    compare_jacobians(Container, true);
+  }
+
+  SECTION("other branch of the piecewise function")
+  {
+    // Move A below the threshold of the piecewise assignment of v
+    CVector< C_FLOAT64 > State = Container.getState(false);
+    const CDataVector< CMetab > & Species = Container.getModel().getMetabolitesX();
+    C_FLOAT64 * pA = NULL;
+
+    for (size_t i = 0; i < Species.size(); ++i)
+      if (Species[i].getObjectName() == "A")
+        pA = (C_FLOAT64 *) Container.getMathObject(Species[i].getValueReference())->getValuePointer();
+
+    REQUIRE(pA != NULL);
+    *pA *= 0.25;
+
+    compare_jacobians(Container, false);
+    compare_jacobians(Container, true);
+
+    Container.setState(State);
+  }
+
+  CRootContainer::removeDatamodel(pDataModel);
+}
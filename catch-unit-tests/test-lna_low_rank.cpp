@@ -0,0 +1,172 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include <copasi/copasi.h>
+#include <copasi/core/CRootContainer.h>
+#include <copasi/core/CDataArray.h>
+#include <copasi/CopasiDataModel/CDataModel.h>
+#include <copasi/model/CModel.h>
+#include <copasi/math/CMathContainer.h>
+#include <copasi/lna/CLNATask.h>
+#include <copasi/lna/CLNAProblem.h>
+#include <copasi/lna/CLNAMethod.h>
+
+static void add_reaction(CModel * pModel, const std::string & name, const std::string & scheme,
+                         const std::string & function, const std::string & parameter,
+                         const C_FLOAT64 & value)
+{
+  CReaction * pReaction = pModel->createReaction(name);
+  REQUIRE(pReaction != NULL);
+  REQUIRE(pReaction->setReactionScheme(scheme, function, false, false) == true);
+  pReaction->setParameterValue(parameter, value);
+}
+
+static void run_lna(CLNATask & task, const std::string & solver)
+{
+  CLNAMethod * pMethod = static_cast< CLNAMethod * >(task.getMethod());
+  pMethod->setValue("Lyapunov Solver", solver);
+  pMethod->setValue("Materialize Matrices", true);
+
+  REQUIRE(task.initialize(CCopasiTask::NO_OUTPUT, NULL, NULL) == true);
+  REQUIRE(task.process(true) == true);
+  task.restore();
+}
+
+TEST_CASE("9: the low-rank Lyapunov solver matches Bartels-Stewart", "[copasi][lna]")
+{
+  if (CRootContainer::getRoot() == NULL)
+    CRootContainer::init(0, NULL, false);
+
+  CDataModel * pDataModel = CRootContainer::addDatamodel();
+  REQUIRE(pDataModel != NULL);
+  REQUIRE(pDataModel->newModel(NULL, true) == true);
+
+  CModel * pModel = pDataModel->getModel();
+  REQUIRE(pModel->createCompartment("cell", 1.0) != NULL);
+  REQUIRE(pModel->createMetabolite("A", "cell", 1.0) != NULL);
+  REQUIRE(pModel->createMetabolite("B", "cell", 1.0) != NULL);
+  REQUIRE(pModel->createMetabolite("C", "cell", 1.0) != NULL);
+
+  // A small irreversible network with a triangular Jacobian, i.e., real negative eigenvalues.
+  add_reaction(pModel, "R1", "-> A", "Constant flux (irreversible)", "v", 10.0);
+  add_reaction(pModel, "R2", "A -> B", "Mass action (irreversible)", "k1", 1.0);
+  add_reaction(pModel, "R3", "A -> C", "Mass action (irreversible)", "k1", 0.2);
+  add_reaction(pModel, "R4", "B -> C", "Mass action (irreversible)", "k1", 0.3);
+  add_reaction(pModel, "R5", "B ->", "Mass action (irreversible)", "k1", 0.5);
+  add_reaction(pModel, "R6", "C ->", "Mass action (irreversible)", "k1", 2.0);
+
+  REQUIRE(pModel->compileIfNecessary(NULL) == true);
+
+  CLNATask * pTask = dynamic_cast< CLNATask * >(&pDataModel->getTaskList()->operator[](CTaskEnum::TaskName[CTaskEnum::Task::lna]));
+  REQUIRE(pTask != NULL);
+  static_cast< CLNAProblem * >(pTask->getProblem())->setSteadyStateRequested(true);
+
+  CLNAMethod * pMethod = static_cast< CLNAMethod * >(pTask->getMethod());
+
+  // The tolerance must dominate the error of the numerical Jacobian in the residual check.
+  const C_FLOAT64 Tolerance = 1e-8;
+  pMethod->setValue("Tolerance", Tolerance);
+
+  run_lna(*pTask, "Bartels-Stewart");
+
+  CMatrix< C_FLOAT64 > B = pMethod->getBMatrixReduced();
+  CMatrix< C_FLOAT64 > C = pMethod->getCovarianceMatrixReduced();
+  CMatrix< C_FLOAT64 > CFull = pMethod->getCovarianceMatrix();
+
+  size_t n = pModel->getMathContainer().getCountIndependentSpecies();
+  REQUIRE(n == 3);
+  REQUIRE(B.numRows() == n);
+  REQUIRE(C.numRows() == n);
+
+  run_lna(*pTask, "Low-Rank ADI");
+
+  const CMatrix< C_FLOAT64 > & Z = pMethod->getCovarianceFactorReduced();
+  REQUIRE(Z.numRows() == n);
+  REQUIRE(Z.numCols() > 0);
+
+  // C = Z * Z^T
+  CMatrix< C_FLOAT64 > ZZt(n, n);
+  C_FLOAT64 Norm = 0.0;
+
+  for (size_t i = 0; i < n; ++i)
+    for (size_t j = 0; j < n; ++j)
+      {
+        ZZt(i, j) = 0.0;
+
+        for (size_t l = 0; l < Z.numCols(); ++l)
+          ZZt(i, j) += Z(i, l) * Z(j, l);
+
+        Norm = std::max(Norm, fabs(C(i, j)));
+      }
+
+  SECTION("the factor reproduces the covariance matrix")
+  {
+    for (size_t i = 0; i < n; ++i)
+      for (size_t j = 0; j < n; ++j)
+        {
+          INFO("i: " << i << ", j: " << j);
+          CHECK(ZZt(i, j) == Approx(C(i, j)).epsilon(1e-6).scale(1e-6 * Norm));
+        }
+  }
+
+  SECTION("the materialized matrices match Bartels-Stewart")
+  {
+    const CMatrix< C_FLOAT64 > & CLowRank = pMethod->getCovarianceMatrixReduced();
+    const CMatrix< C_FLOAT64 > & CFullLowRank = pMethod->getCovarianceMatrix();
+
+    REQUIRE(CLowRank.numRows() == n);
+    REQUIRE(CFullLowRank.numRows() == CFull.numRows());
+
+    for (size_t i = 0; i < n; ++i)
+      for (size_t j = 0; j < n; ++j)
+        CHECK(CLowRank(i, j) == Approx(C(i, j)).epsilon(1e-6).scale(1e-6 * Norm));
+
+    for (size_t i = 0; i < CFull.numRows(); ++i)
+      for (size_t j = 0; j < CFull.numCols(); ++j)
+        CHECK(CFullLowRank(i, j) == Approx(CFull(i, j)).epsilon(1e-6).scale(1e-6 * Norm));
+
+    // The annotations must follow the materialized matrices.
+    CHECK(pMethod->getCovarianceMatrixReducedAnn()->getAnnotationsCN(0).size() == n);
+    CHECK(pMethod->getBMatrixReducedAnn()->getAnnotationsCN(1).size() == n);
+    CHECK(pMethod->getCovarianceMatrixAnn()->getAnnotationsCN(0).size() == CFull.numRows());
+  }
+
+  SECTION("the residual of the Lyapunov equation is below the tolerance")
+  {
+    // The residual A * X + X * A^T + G * G^T = W * W^T is bounded by the squared
+    // Frobenius norm of W, which must be below Tolerance * ||G||_F^2 = Tolerance * trace(B).
+    CMatrix< C_FLOAT64 > Jacobian;
+    pModel->getMathContainer().calculateJacobian(Jacobian, 1e-6, true);
+
+    size_t Offset = Jacobian.numRows() - n;
+    C_FLOAT64 TraceB = 0.0;
+    C_FLOAT64 Residual = 0.0;
+
+    for (size_t i = 0; i < n; ++i)
+      {
+        TraceB += B(i, i);
+
+        for (size_t j = 0; j < n; ++j)
+          {
+            C_FLOAT64 R = B(i, j);
+
+            for (size_t l = 0; l < n; ++l)
+              R += Jacobian(i + Offset, l + Offset) * ZZt(l, j) + ZZt(i, l) * Jacobian(j + Offset, l + Offset);
+
+            Residual += R * R;
+          }
+      }
+
+    CHECK(sqrt(Residual) <= Tolerance * TraceB);
+  }
+
+  CRootContainer::removeDatamodel(pDataModel);
+}
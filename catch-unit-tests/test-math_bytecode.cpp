@@ -0,0 +1,103 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#include "catch.hpp"
+
+extern std::string getTestFile(const std::string& fileName);
+
+#include <cmath>
+
+#include <copasi/copasi.h>
+#include <copasi/core/CRootContainer.h>
+#include <copasi/CopasiDataModel/CDataModel.h>
+#include <copasi/model/CModel.h>
+#include <copasi/math/CMathContainer.h>
+#include <copasi/math/CMathExpression.h>
+
+static size_t compare_bytecode(CMathContainer & container)
+{
+  size_t Compared = 0;
+
+  const CVectorCore< C_FLOAT64 > & Values = container.getValues();
+  const C_FLOAT64 * pValue = Values.array();
+  const C_FLOAT64 * pValueEnd = pValue + Values.size();
+
+  for (; pValue != pValueEnd; ++pValue)
+    {
+      const CMathObject * pObject = container.getMathObject(pValue);
+
+      if (pObject == NULL || pObject->getExpressionPtr() == NULL)
+        continue;
+
+      CMathExpression * pExpression = const_cast< CMathExpression * >(pObject->getExpressionPtr());
+
+      if (!pExpression->getBytecode().isValid())
+        continue;
+
+      CMathExpression::setUseBytecode(true);
+      C_FLOAT64 Bytecode = pExpression->value();
+
+      CMathExpression::setUseBytecode(false);
+      C_FLOAT64 Tree = pExpression->value();
+
+      INFO("expression: " << pExpression->getInfix());
+
+      // The bytecode performs the same operations as the tree and must give identical results.
+      if (std::isnan(Tree))
+        CHECK(std::isnan(Bytecode));
+      else
+        CHECK(Bytecode == Tree);
+
+      ++Compared;
+    }
+
+  CMathExpression::setUseBytecode(true);
+
+  return Compared;
+}
+
+TEST_CASE("3: bytecode values match the tree evaluation", "[copasi][math]")
+{
+  if (CRootContainer::getRoot() == NULL)
+    CRootContainer::init(0, NULL, false);
+
+  CDataModel * pDataModel = CRootContainer::addDatamodel();
+  REQUIRE(pDataModel != NULL);
+
+  SECTION("functions, piecewise and logical operators")
+  {
+    REQUIRE(pDataModel->importSBML(getTestFile("test-data/jacobian_test.xml")) == true);
+
+    CMathContainer & Container = pDataModel->getModel()->getMathContainer();
+    Container.applyInitialValues();
+    Container.updateSimulatedValues(false);
+
+    REQUIRE(compare_bytecode(Container) > 0);
+  }
+
+  SECTION("brusselator example")
+  {
+    REQUIRE(pDataModel->loadModel(getTestFile("test-data/brusselator.cps"), NULL) == true);
+
+    CMathContainer & Container = pDataModel->getModel()->getMathContainer();
+    Container.applyInitialValues();
+    Container.updateSimulatedValues(false);
+
+    REQUIRE(compare_bytecode(Container) > 0);
+  }
+
+  SECTION("events")
+  {
+    REQUIRE(pDataModel->loadModel(getTestFile("test-data/simple_v3_event.cps"), NULL) == true);
+
+    CMathContainer & Container = pDataModel->getModel()->getMathContainer();
+    Container.applyInitialValues();
+    Container.updateSimulatedValues(false);
+
+    REQUIRE(compare_bytecode(Container) > 0);
+  }
+
+  CRootContainer::removeDatamodel(pDataModel);
+}
@@ -0,0 +1,144 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#include "catch.hpp"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <copasi/copasi.h>
+#include <copasi/core/CRootContainer.h>
+#include <copasi/CopasiDataModel/CDataModel.h>
+#include <copasi/model/CModel.h>
+#include <copasi/math/CMathContainer.h>
+#include <copasi/math/CMathExpression.h>
+#include <copasi/math/CMathNativeCode.h>
+
+// Every function, operator, and logical subtype which is translated to native code.
+// X and Y are replaced by the values of the model.
+static const char * Expressions[] =
+{
+  "X + Y", "X - Y", "X * Y", "X / Y", "X ^ Y", "X % Y", "X mod Y",
+  "log(X)", "log10(X)", "exp(X)",
+  "sin(X)", "cos(X)", "tan(X)", "sec(X)", "csc(X)", "cot(X)",
+  "sinh(X)", "cosh(X)", "tanh(X)", "sech(X)", "csch(X)", "coth(X)",
+  "asin(X)", "acos(X)", "atan(X)", "arcsec(X)", "arccsc(X)", "arccot(X)",
+  "arcsinh(X)", "arccosh(X)", "arctanh(X)", "arcsech(X)", "arccsch(X)", "arccoth(X)",
+  "sign(X)", "sqrt(X)", "abs(X)", "floor(X)", "ceil(X)", "factorial(X)",
+  "-X", "+X", "not(X)", "max(X, Y)", "min(X, Y)",
+  "X or Y", "X xor Y", "X and Y", "X == Y", "X != Y", "X > Y", "X >= Y", "X < Y", "X <= Y",
+  "if(X > Y, sec(X), arcsec(Y))",
+  NULL
+};
+
+static std::string replace_values(std::string expression, const std::string & x, const std::string & y)
+{
+  std::string::size_type pos;
+
+  while ((pos = expression.find('X')) != std::string::npos)
+    expression.replace(pos, 1, x);
+
+  while ((pos = expression.find('Y')) != std::string::npos)
+    expression.replace(pos, 1, y);
+
+  return expression;
+}
+
+TEST_CASE("8: native code values match the tree evaluation", "[copasi][math]")
+{
+  if (!CMathNativeCode::isSupported())
+    return;
+
+  if (CRootContainer::getRoot() == NULL)
+    CRootContainer::init(0, NULL, false);
+
+  CDataModel * pDataModel = CRootContainer::addDatamodel();
+  REQUIRE(pDataModel != NULL);
+  REQUIRE(pDataModel->newModel(NULL, true) == true);
+
+  CModel * pModel = pDataModel->getModel();
+
+  // The arguments are constant state variables so that all assignments are simulated values.
+  CModelValue * pX = pModel->createModelValue("x", 1.0);
+  pX->setStatus(CModelEntity::Status::ODE);
+  REQUIRE(pX->setExpression("0").isSuccess());
+
+  CModelValue * pY = pModel->createModelValue("y", 1.0);
+  pY->setStatus(CModelEntity::Status::ODE);
+  REQUIRE(pY->setExpression("0").isSuccess());
+
+  std::string X = "<" + pX->getValueReference()->getCN() + ">";
+  std::string Y = "<" + pY->getValueReference()->getCN() + ">";
+
+  std::vector< CModelValue * > Assignments;
+
+  for (const char ** pExpression = Expressions; *pExpression != NULL; ++pExpression)
+    {
+      CModelValue * pValue = pModel->createModelValue("f" + std::to_string(Assignments.size()), 0.0);
+      pValue->setStatus(CModelEntity::Status::ASSIGNMENT);
+
+      INFO("expression: " << *pExpression);
+      REQUIRE(pValue->setExpression(replace_values(*pExpression, X, Y)).isSuccess());
+
+      Assignments.push_back(pValue);
+    }
+
+  REQUIRE(pModel->compileIfNecessary(NULL) == true);
+
+  CMathContainer & Container = pModel->getMathContainer();
+  Container.setUseNativeCode(false);
+
+  CVectorCore< C_FLOAT64 > & Values = Container.getValues();
+  C_FLOAT64 * pXValue = (C_FLOAT64 *) Container.getMathObject(pX->getValueReference())->getValuePointer();
+  C_FLOAT64 * pYValue = (C_FLOAT64 *) Container.getMathObject(pY->getValueReference())->getValuePointer();
+
+  CMathNativeCode NativeCode;
+  std::vector< const CMathUpdateSequence * > Sequences;
+  Sequences.push_back(&Container.getSimulationValuesSequence(false));
+
+  // All expressions must be translated; a failure would silently fall back to the tree.
+  REQUIRE(NativeCode.compile(Values, Sequences) == true);
+
+  CMathNativeCode::Function pFunction = NativeCode.getFunction(0);
+  REQUIRE(pFunction != NULL);
+
+  // The arguments cover the domains of all functions and the boundary of the logical values.
+  const C_FLOAT64 Arguments[][2] =
+  {
+    {0.5, 1.0}, {1.0, 0.5}, {0.0, 0.0}, {1.0, 1.0}, {0.8, 3.0}, {2.5, -0.3}, {-1.7, 0.5}, {4.0, 2.0}
+  };
+
+  for (size_t i = 0; i < sizeof(Arguments) / sizeof(Arguments[0]); ++i)
+    {
+      *pXValue = Arguments[i][0];
+      *pYValue = Arguments[i][1];
+
+      CVector< C_FLOAT64 > Native = Values;
+      (*pFunction)(Native.array());
+
+      CMathExpression::setUseBytecode(false);
+      Container.updateSimulatedValues(false);
+      CMathExpression::setUseBytecode(true);
+
+      for (size_t j = 0; j < Assignments.size(); ++j)
+        {
+          const C_FLOAT64 * pTree = (const C_FLOAT64 *) Container.getMathObject(Assignments[j]->getValueReference())->getValuePointer();
+          const C_FLOAT64 & Tree = *pTree;
+          const C_FLOAT64 & Value = Native[pTree - Values.array()];
+
+          INFO("expression: " << Expressions[j] << ", x: " << Arguments[i][0] << ", y: " << Arguments[i][1]);
+
+          if (std::isnan(Tree))
+            CHECK(std::isnan(Value));
+          else if (std::isinf(Tree))
+            CHECK(Value == Tree);
+          else
+            CHECK(Value == Approx(Tree).epsilon(1e-12).scale(1e-12));
+        }
+    }
+
+  CRootContainer::removeDatamodel(pDataModel);
+}
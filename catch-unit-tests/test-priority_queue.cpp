@@ -0,0 +1,166 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#include "catch.hpp"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <copasi/copasi.h>
+#include <copasi/utilities/CIndexedPriorityQueue.h>
+
+// A simple linear congruential generator makes the sequence of operations reproducible.
+static size_t next_random(size_t & state)
+{
+  state = (state * 1103515245 + 12345) & 0x7fffffff;
+  return state;
+}
+
+static C_FLOAT64 random_key(size_t & state)
+{
+  // Occasionally create infinite keys and ties, which are both common in the Next Reaction method.
+  switch (next_random(state) % 16)
+    {
+      case 0:
+        return std::numeric_limits< C_FLOAT64 >::infinity();
+
+      case 1:
+        return 1.0;
+
+      default:
+        return 100.0 * (C_FLOAT64) next_random(state) / (C_FLOAT64) 0x7fffffff;
+    }
+}
+
+// Check the top of the queue and the keys against the reference, in which NaN marks indices not queued.
+static void check_queue(const CIndexedPriorityQueue & queue, const std::vector< C_FLOAT64 > & reference)
+{
+  C_FLOAT64 Top = std::numeric_limits< C_FLOAT64 >::quiet_NaN();
+  size_t Size = 0;
+
+  for (size_t i = 0; i < reference.size(); ++i)
+    if (!std::isnan(reference[i]))
+      {
+        ++Size;
+
+        if (std::isnan(Top) || reference[i] < Top)
+          Top = reference[i];
+
+        CHECK(queue.getKey(i) == reference[i]);
+      }
+
+  REQUIRE(queue.size() == Size);
+
+  if (Size == 0)
+    return;
+
+  // Among equal keys any index may be on top.
+  CHECK(queue.topKey() == Top);
+  CHECK(reference[queue.topIndex()] == Top);
+}
+
+// The protocol of the Next Reaction method: build the heap and reschedule reactions.
+static void check_next_reaction(const CIndexedPriorityQueue::Type & type)
+{
+  const size_t Count = 50;
+  const size_t Operations = 5000;
+
+  CIndexedPriorityQueue Queue(type);
+  REQUIRE(Queue.getType() == type);
+
+  size_t State = 42;
+  std::vector< C_FLOAT64 > Reference(Count);
+
+  for (size_t i = 0; i < Count; ++i)
+    {
+      Reference[i] = random_key(State);
+      Queue.pushPair(i, Reference[i]);
+    }
+
+  Queue.buildHeap();
+  check_queue(Queue, Reference);
+
+  for (size_t i = 0; i < Operations; ++i)
+    {
+      // Mostly the top is rescheduled to a later time, as in a simulation.
+      size_t Index = (next_random(State) % 4 == 0) ? next_random(State) % Count : Queue.topIndex();
+      C_FLOAT64 Key = random_key(State);
+
+      if (Index == Queue.topIndex())
+        Key += Queue.topKey();
+
+      Reference[Index] = Key;
+      Queue.updateNode(Index, Key);
+
+      check_queue(Queue, Reference);
+    }
+}
+
+// The protocol of the hybrid methods: insert, remove, and update reactions.
+static void check_hybrid(const CIndexedPriorityQueue::Type & type)
+{
+  const size_t Count = 50;
+  const size_t Operations = 5000;
+
+  CIndexedPriorityQueue Queue(type);
+  REQUIRE(Queue.getType() == type);
+
+  size_t State = 4711;
+  std::vector< C_FLOAT64 > Reference(Count, std::numeric_limits< C_FLOAT64 >::quiet_NaN());
+
+  Queue.initializeIndexPointer(Count);
+
+  for (size_t i = 0; i < Operations; ++i)
+    {
+      size_t Index = next_random(State) % Count;
+      C_FLOAT64 Key = random_key(State);
+
+      if (std::isnan(Reference[Index]))
+        {
+          Reference[Index] = Key;
+          Queue.insertStochReaction(Index, Key);
+        }
+      else if (next_random(State) % 2 == 0)
+        {
+          Reference[Index] = std::numeric_limits< C_FLOAT64 >::quiet_NaN();
+          Queue.removeStochReaction(Index);
+        }
+      else
+        {
+          Reference[Index] = Key;
+          Queue.updateNode(Index, Key);
+        }
+
+      check_queue(Queue, Reference);
+    }
+}
+
+TEST_CASE("5: priority queue variants agree with a reference", "[copasi][utilities]")
+{
+  SECTION("binary heap")
+  {
+    check_next_reaction(CIndexedPriorityQueue::Type::BinaryHeap);
+    check_hybrid(CIndexedPriorityQueue::Type::BinaryHeap);
+  }
+
+  SECTION("4-ary heap")
+  {
+    check_next_reaction(CIndexedPriorityQueue::Type::QuaternaryHeap);
+    check_hybrid(CIndexedPriorityQueue::Type::QuaternaryHeap);
+  }
+
+  SECTION("8-ary heap")
+  {
+    check_next_reaction(CIndexedPriorityQueue::Type::OctonaryHeap);
+    check_hybrid(CIndexedPriorityQueue::Type::OctonaryHeap);
+  }
+
+  SECTION("calendar queue")
+  {
+    check_next_reaction(CIndexedPriorityQueue::Type::CalendarQueue);
+    check_hybrid(CIndexedPriorityQueue::Type::CalendarQueue);
+  }
+}
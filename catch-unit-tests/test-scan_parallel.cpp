@@ -0,0 +1,178 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#include "catch.hpp"
+
+extern std::string getTestFile(const std::string& fileName);
+
+#include <vector>
+
+#include <copasi/copasi.h>
+
+#ifdef USE_OMP
+# include <omp.h>
+#endif // USE_OMP
+
+#include <copasi/core/CRootContainer.h>
+#include <copasi/CopasiDataModel/CDataModel.h>
+#include <copasi/model/CModel.h>
+#include <copasi/output/COutputHandler.h>
+#include <copasi/scan/CScanTask.h>
+#include <copasi/scan/CScanProblem.h>
+#include <copasi/steadystate/CSteadyStateTask.h>
+
+// An output interface which records the values of the given objects for each grid point.
+class CScanRecorder: public COutputInterface
+{
+public:
+  CScanRecorder(const std::vector< CCommonName > & cns):
+    COutputInterface(),
+    mCNs(cns),
+    mValuePointers(),
+    mData()
+  {}
+
+  virtual bool compile(CObjectInterface::ContainerList listOfContainer)
+  {
+    mObjects.clear();
+    mValuePointers.clear();
+    mData.clear();
+
+    std::vector< CCommonName >::const_iterator it = mCNs.begin();
+    std::vector< CCommonName >::const_iterator end = mCNs.end();
+
+    for (; it != end; ++it)
+      {
+        const CObjectInterface * pObject = CObjectInterface::GetObjectFromCN(listOfContainer, *it);
+
+        if (pObject == NULL) return false;
+
+        mObjects.insert(pObject);
+        mValuePointers.push_back((const C_FLOAT64 *) pObject->getValuePointer());
+      }
+
+    return true;
+  }
+
+  virtual void output(const Activity & activity)
+  {
+    if (activity != DURING) return;
+
+    std::vector< const C_FLOAT64 * >::const_iterator it = mValuePointers.begin();
+    std::vector< const C_FLOAT64 * >::const_iterator end = mValuePointers.end();
+
+    for (; it != end; ++it)
+      mData.push_back(**it);
+  }
+
+  const std::vector< C_FLOAT64 > & getData() const
+  {
+    return mData;
+  }
+
+private:
+  std::vector< CCommonName > mCNs;
+  std::vector< const C_FLOAT64 * > mValuePointers;
+  std::vector< C_FLOAT64 > mData;
+};
+
+static std::vector< C_FLOAT64 > run_scan(CScanTask & task, const std::vector< CCommonName > & cns, const int & threads)
+{
+#ifdef USE_OMP
+  int MaxThreads = omp_get_max_threads();
+  omp_set_num_threads(threads);
+#endif // USE_OMP
+
+  CScanRecorder Recorder(cns);
+  COutputHandler Handler;
+  Handler.addInterface(&Recorder);
+
+  REQUIRE(task.initialize(CCopasiTask::OUTPUT_UI, &Handler, NULL) == true);
+  REQUIRE(task.process(true) == true);
+  task.restore();
+
+#ifdef USE_OMP
+  omp_set_num_threads(MaxThreads);
+#endif // USE_OMP
+
+  return Recorder.getData();
+}
+
+static void check_scan(CScanTask & task, const std::vector< CCommonName > & cns)
+{
+  std::vector< C_FLOAT64 > Serial = run_scan(task, cns, 1);
+  std::vector< C_FLOAT64 > Parallel = run_scan(task, cns, 4);
+
+  // 21 grid points are reported
+  REQUIRE(Serial.size() == 21 * cns.size());
+  REQUIRE(Parallel.size() == Serial.size());
+
+  for (size_t i = 0; i < Serial.size(); ++i)
+    {
+      INFO("index: " << i);
+      CHECK(Parallel[i] == Approx(Serial[i]).epsilon(1e-8).scale(1e-8));
+    }
+}
+
+TEST_CASE("7: parallel scans report the same values as serial scans", "[copasi][scan]")
+{
+  if (CRootContainer::getRoot() == NULL)
+    CRootContainer::init(0, NULL, false);
+
+  CDataModel * pDataModel = CRootContainer::addDatamodel();
+  REQUIRE(pDataModel != NULL);
+  REQUIRE(pDataModel->loadModel(getTestFile("test-data/brusselator.cps"), NULL) == true);
+
+  CModel * pModel = pDataModel->getModel();
+
+  const CMetab * pX = NULL;
+  const CMetab * pB = NULL;
+  const CDataVector< CMetab > & Species = pModel->getMetabolites();
+
+  for (size_t i = 0; i < Species.size(); ++i)
+    if (Species[i].getObjectName() == "X")
+      pX = &Species[i];
+    else if (Species[i].getObjectName() == "B")
+      pB = &Species[i];
+
+  REQUIRE(pX != NULL);
+  REQUIRE(pB != NULL);
+
+  CSteadyStateTask * pSteadyState = dynamic_cast< CSteadyStateTask * >(&pDataModel->getTaskList()->operator[](CTaskEnum::TaskName[CTaskEnum::Task::steadyState]));
+  REQUIRE(pSteadyState != NULL);
+
+  CScanTask * pTask = dynamic_cast< CScanTask * >(&pDataModel->getTaskList()->operator[](CTaskEnum::TaskName[CTaskEnum::Task::scan]));
+  REQUIRE(pTask != NULL);
+
+  CScanProblem * pProblem = static_cast< CScanProblem * >(pTask->getProblem());
+  pProblem->setSubtask(CTaskEnum::Task::steadyState);
+  pProblem->setOutputInSubtask(false);
+  pProblem->setContinueFromCurrentState(false);
+
+  // The eigenvalues of the steady state change from real to complex along the scan.
+  CCopasiParameterGroup * pItem = pProblem->addScanItem(CScanProblem::SCAN_LINEAR, 20, pB->getInitialConcentrationReference());
+  pItem->setValue< C_FLOAT64 >("Minimum", 0.5);
+  pItem->setValue< C_FLOAT64 >("Maximum", 3.0);
+
+  std::vector< CCommonName > CNs;
+  CNs.push_back(pX->getConcentrationReference()->getCN());
+
+  SECTION("container values")
+  {
+    check_scan(*pTask, CNs);
+  }
+
+  SECTION("results of the subtask")
+  {
+    // The eigenvalues are not part of the math container.
+    const CEigen & Eigen = pSteadyState->getEigenValuesReduced();
+    CNs.push_back(Eigen.getObject(CCommonName("Reference=Maximum real part"))->getCN());
+    CNs.push_back(Eigen.getObject(CCommonName("Reference=Maximum imaginary part"))->getCN());
+
+    check_scan(*pTask, CNs);
+  }
+
+  CRootContainer::removeDatamodel(pDataModel);
+}
@@ -0,0 +1,130 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#include "catch.hpp"
+
+#include <cmath>
+
+#include <copasi/copasi.h>
+#include <copasi/core/CMatrix.h>
+#include <copasi/core/CVector.h>
+#include <copasi/utilities/CSparseLU.h>
+#include <copasi/utilities/CLeastSquareSolution.h>
+
+// A simple linear congruential generator makes the matrices reproducible.
+static C_FLOAT64 next_random(size_t & state)
+{
+  state = (state * 1103515245 + 12345) & 0x7fffffff;
+  return (C_FLOAT64) state / (C_FLOAT64) 0x7fffffff;
+}
+
+// Create a random sparse matrix with a dominant permuted diagonal, i.e., a regular
+// matrix which requires pivoting.
+static void create_matrix(const size_t & size, size_t & state,
+                          CMatrix< C_INT32 > & structure, CMatrix< C_FLOAT64 > & matrix)
+{
+  structure.resize(size, size);
+  structure = 0;
+  matrix.resize(size, size);
+  matrix = 0.0;
+
+  for (size_t i = 0; i < size; ++i)
+    for (size_t j = 0; j < size; ++j)
+      if (next_random(state) < 0.15)
+        {
+          structure(i, j) = 1;
+          matrix(i, j) = next_random(state) - 0.5;
+        }
+
+  for (size_t i = 0; i < size; ++i)
+    {
+      size_t j = (i + 3) % size;
+      structure(i, j) = 1;
+      matrix(i, j) += 3.0;
+    }
+}
+
+TEST_CASE("6: sparse LU solutions match the dense solution", "[copasi][utilities]")
+{
+  size_t State = 17;
+
+  SECTION("regular matrices")
+  {
+    for (size_t Size = 1; Size < 40; Size += 3)
+      {
+        INFO("size: " << Size);
+
+        CMatrix< C_INT32 > Structure;
+        CMatrix< C_FLOAT64 > Matrix;
+        create_matrix(Size, State, Structure, Matrix);
+
+        CSparseLU LU;
+        REQUIRE(LU.analyze(Structure) == true);
+        REQUIRE(LU.factorize(Matrix) == true);
+
+        CVector< C_FLOAT64 > B(Size);
+
+        for (size_t i = 0; i < Size; ++i)
+          B[i] = next_random(State);
+
+        CVector< C_FLOAT64 > Sparse;
+        REQUIRE(LU.solve(CVectorCore< const C_FLOAT64 >(Size, B.array()), Sparse) == true);
+
+        CVector< C_FLOAT64 > Dense;
+        REQUIRE(CLeastSquareSolution::solve(Matrix, CVectorCore< const C_FLOAT64 >(Size, B.array()), Dense) == Size);
+
+        REQUIRE(Sparse.size() == Dense.size());
+
+        for (size_t i = 0; i < Size; ++i)
+          CHECK(Sparse[i] == Approx(Dense[i]).epsilon(1e-10).scale(1e-10));
+      }
+  }
+
+  SECTION("shifted matrices")
+  {
+    const size_t Size = 20;
+    const C_FLOAT64 Shift = -0.75;
+
+    CMatrix< C_INT32 > Structure;
+    CMatrix< C_FLOAT64 > Matrix;
+    create_matrix(Size, State, Structure, Matrix);
+
+    CSparseLU LU;
+    REQUIRE(LU.analyze(Structure) == true);
+    REQUIRE(LU.factorize(Matrix, Shift) == true);
+
+    CMatrix< C_FLOAT64 > Shifted = Matrix;
+
+    for (size_t i = 0; i < Size; ++i)
+      Shifted(i, i) += Shift;
+
+    CVector< C_FLOAT64 > B(Size);
+
+    for (size_t i = 0; i < Size; ++i)
+      B[i] = next_random(State);
+
+    CVector< C_FLOAT64 > Sparse;
+    REQUIRE(LU.solve(CVectorCore< const C_FLOAT64 >(Size, B.array()), Sparse) == true);
+
+    CVector< C_FLOAT64 > Dense;
+    REQUIRE(CLeastSquareSolution::solve(Shifted, CVectorCore< const C_FLOAT64 >(Size, B.array()), Dense) == Size);
+
+    for (size_t i = 0; i < Size; ++i)
+      CHECK(Sparse[i] == Approx(Dense[i]).epsilon(1e-10).scale(1e-10));
+  }
+
+  SECTION("singular matrices are detected")
+  {
+    CMatrix< C_INT32 > Structure(2, 2);
+    Structure = 1;
+
+    CMatrix< C_FLOAT64 > Matrix(2, 2);
+    Matrix = 1.0;
+
+    CSparseLU LU;
+    REQUIRE(LU.analyze(Structure) == true);
+    CHECK(LU.factorize(Matrix) == false);
+  }
+}
@@ -0,0 +1,88 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#include "catch.hpp"
+
+extern std::string getTestFile(const std::string& fileName);
+
+#include <cstring>
+
+#include <copasi/copasi.h>
+#include <copasi/core/CRootContainer.h>
+#include <copasi/CopasiDataModel/CDataModel.h>
+#include <copasi/model/CModel.h>
+#include <copasi/timesens/CTimeSensTask.h>
+#include <copasi/timesens/CTimeSensProblem.h>
+
+static CVector< C_FLOAT64 > calculate_sensitivities(CTimeSensTask & task, const CTaskEnum::Method & method)
+{
+  REQUIRE(task.setMethodType(method) == true);
+  REQUIRE(task.initialize(CCopasiTask::NO_OUTPUT, NULL, NULL) == true);
+  REQUIRE(task.process(true) == true);
+  task.restore();
+
+  const CArray & Result = static_cast< CTimeSensProblem * >(task.getProblem())->getStateResult();
+  const CArray::index_type & Size = Result.size();
+
+  REQUIRE(Size.size() == 2);
+
+  CVector< C_FLOAT64 > Sensitivities(Size[0] * Size[1]);
+  memcpy(Sensitivities.array(), Result.array(), Sensitivities.size() * sizeof(C_FLOAT64));
+
+  return Sensitivities;
+}
+
+TEST_CASE("4: analytic time sensitivities match finite differences", "[copasi][timesens]")
+{
+  if (CRootContainer::getRoot() == NULL)
+    CRootContainer::init(0, NULL, false);
+
+  CDataModel * pDataModel = CRootContainer::addDatamodel();
+  REQUIRE(pDataModel != NULL);
+
+  // The model contains rate laws, a function definition, assignments, a rate rule,
+  // a piecewise function and a moiety.
+  REQUIRE(pDataModel->importSBML(getTestFile("test-data/jacobian_test.xml")) == true);
+
+  CModel * pModel = pDataModel->getModel();
+  CTimeSensTask * pTask = dynamic_cast< CTimeSensTask * >(&pDataModel->getTaskList()->operator[](CTaskEnum::TaskName[CTaskEnum::Task::timeSens]));
+  REQUIRE(pTask != NULL);
+
+  CTimeSensProblem * pProblem = static_cast< CTimeSensProblem * >(pTask->getProblem());
+  pProblem->setDuration(5.0);
+  pProblem->setStepNumber(50);
+  pProblem->setTimeSeriesRequested(false);
+
+  // Sensitivities with respect to global quantities used in rate laws, assignments,
+  // and the rate rule as well as an initial concentration
+  pProblem->clearParameterCNs();
+  pProblem->addParameterCN(pModel->getModelValues()["k1"].getInitialValueReference()->getCN());
+  pProblem->addParameterCN(pModel->getModelValues()["k2"].getInitialValueReference()->getCN());
+  pProblem->addParameterCN(pModel->getModelValues()["Km"].getInitialValueReference()->getCN());
+
+  const CDataVector< CMetab > & Species = pModel->getMetabolites();
+
+  for (size_t i = 0; i < Species.size(); ++i)
+    if (Species[i].getObjectName() == "A")
+      pProblem->addParameterCN(Species[i].getInitialConcentrationReference()->getCN());
+
+  REQUIRE(pProblem->getNumParameters() == 4);
+
+  CVector< C_FLOAT64 > FiniteDifferences = calculate_sensitivities(*pTask, CTaskEnum::Method::timeSensLsoda);
+  CVector< C_FLOAT64 > Analytic = calculate_sensitivities(*pTask, CTaskEnum::Method::timeSensLsodaAnalytic);
+
+  REQUIRE(Analytic.size() == FiniteDifferences.size());
+  REQUIRE(Analytic.size() > 0);
+
+  // The finite difference method perturbs the parameters by a relative factor of 1e-5
+  // and both results are subject to the integration tolerances.
+  for (size_t i = 0; i < Analytic.size(); ++i)
+    {
+      INFO("index: " << i);
+      CHECK(Analytic[i] == Approx(FiniteDifferences[i]).epsilon(1e-3).scale(1e-3));
+    }
+
+  CRootContainer::removeDatamodel(pDataModel);
+}
@@ -52,6 +52,7 @@
 #include "copasi/randomGenerator/CRandom.h"
 #include "copasi/core/CDataTimer.h"
 #include "copasi/report/CKeyFactory.h"
+#include "copasi/report/CReport.h"
 #include "copasi/utilities/CVersion.h"
 #include "copasi/utilities/CDirEntry.h"
 #include "copasi/utilities/CSparseMatrix.h"
@@ -72,6 +73,7 @@ int exportParametersToIniFile();
 CDataModel* pDataModel = NULL;
 bool Validate = false;
 std::string ReportFileName;
+CReport::Format ReportFormat = CReport::Format::Text;
 std::string ScheduledTask;
 
 int main(int argc, char *argv[])
@@ -133,6 +135,25 @@ int main(int argc, char *argv[])
   COptions::getValue("License", License);
 
   COptions::getValue("ReportFile", ReportFileName);
+
+  copasi::ReportFormat_enum Format;
+  COptions::getValue("ReportFormat", Format);
+
+  switch (Format)
+    {
+      case copasi::ReportFormat_buffered:
+        ReportFormat = CReport::Format::BufferedText;
+        break;
+
+      case copasi::ReportFormat_binary:
+        ReportFormat = CReport::Format::Binary;
+        break;
+
+      default:
+        ReportFormat = CReport::Format::Text;
+        break;
+    }
+
   COptions::getValue("ScheduledTask", ScheduledTask);
 
   if (License)
@@ -458,6 +479,8 @@ for (CCopasiTask & task : TaskList)
             task.getReport().setTarget(ReportFileName);
           }
 
+        task.getReport().setFormat(ReportFormat);
+
 
         try
           {
@@ -0,0 +1,27 @@
+// Copyright (C) 2019 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+// Copyright (C) 2017 - 2018 by Pedro Mendes, Virginia Tech Intellectual
+// Properties, Inc., University of Heidelberg, and University of
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+// Copyright (C) 2012 - 2016 by Pedro Mendes, Virginia Tech Intellectual
+// Properties, Inc., University of Heidelberg, and The University
+// of Manchester.
+// All rights reserved.
+
+#ifndef COPASI_VERSION
+#define COPASI_VERSION
+
+#define COPASI_VERSION_MAJOR 4
+#define COPASI_VERSION_MINOR 12
+#define COPASI_VERSION_BUILD 65
+#define COPASI_VERSION_MODIFIED false
+#define COPASI_VERSION_COMPATIBILITY {207}
+#define COPASI_VERSION_COMMENT ""
+#define COPASI_VERSION_CREATOR ""
+
+#endif // COPASI_VERSION
@@ -0,0 +1,147 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+/**
+ * This example measures how fast the dependents of reactions are iterated in the
+ * reaction dependency graph used by the stochastic methods. A large sparse reaction
+ * network is generated in which each reaction consumes and produces randomly chosen
+ * species. A reaction depends on another reaction if it consumes one of the species
+ * changed by it. After each simulated reaction event the dependents of the fired
+ * reaction are iterated once in the std::set based graph and once in the frozen
+ * compressed sparse row graph.
+ */
+
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+#define COPASI_MAIN
+
+#include "copasi/copasi.h"
+#include "copasi/randomGenerator/CRandom.h"
+#include "copasi/utilities/CDependencyGraph.h"
+#include "copasi/utilities/CopasiTime.h"
+
+using namespace std;
+
+static double eventsPerSecond(const CCopasiTimeVariable & start, const size_t & events)
+{
+  C_INT64 MicroSeconds = (CCopasiTimeVariable::getCurrentWallTime() - start).getMicroSeconds();
+
+  if (MicroSeconds <= 0) MicroSeconds = 1;
+
+  return 1e6 * events / MicroSeconds;
+}
+
+int main(int argc, char** argv)
+{
+  if (argc > 4)
+    {
+      std::cerr << "Usage: benchmarkDependencyGraph [reactions] [species per reaction] [events]" << std::endl;
+      return 1;
+    }
+
+  size_t Reactions = (argc > 1) ? strtoul(argv[1], NULL, 10) : 100000;
+  size_t SpeciesPerReaction = (argc > 2) ? strtoul(argv[2], NULL, 10) : 3;
+  size_t Events = (argc > 3) ? strtoul(argv[3], NULL, 10) : 10000000;
+
+  if (Reactions == 0)
+    {
+      std::cerr << "The number of reactions must be positive." << std::endl;
+      return 1;
+    }
+
+  // We have roughly as many species as reactions.
+  size_t Species = Reactions;
+  CRandom * pRandom = CRandom::createGenerator(CRandom::mt19937, 1);
+
+  // The reactions consuming each species
+  std::vector< std::vector< size_t > > Consumers(Species);
+  std::vector< std::vector< size_t > > Changed(Reactions);
+  size_t i, j;
+
+  for (i = 0; i < Reactions; ++i)
+    for (j = 0; j < SpeciesPerReaction; ++j)
+      {
+        size_t Substrate = pRandom->getRandomU(Species - 1);
+        size_t Product = pRandom->getRandomU(Species - 1);
+
+        Consumers[Substrate].push_back(i);
+        Changed[i].push_back(Substrate);
+        Changed[i].push_back(Product);
+      }
+
+  CCopasiTimeVariable Start = CCopasiTimeVariable::getCurrentWallTime();
+
+  CDependencyGraph DG;
+  DG.resize(Reactions);
+
+  for (i = 0; i < Reactions; ++i)
+    {
+      std::vector< size_t >::const_iterator it = Changed[i].begin();
+      std::vector< size_t >::const_iterator end = Changed[i].end();
+
+      for (; it != end; ++it)
+        {
+          std::vector< size_t >::const_iterator itConsumer = Consumers[*it].begin();
+          std::vector< size_t >::const_iterator endConsumer = Consumers[*it].end();
+
+          for (; itConsumer != endConsumer; ++itConsumer)
+            DG.addDependent(i, *itConsumer);
+        }
+    }
+
+  C_INT64 BuildTime = (CCopasiTimeVariable::getCurrentWallTime() - Start).getMicroSeconds();
+
+  Start = CCopasiTimeVariable::getCurrentWallTime();
+  DG.freeze();
+  C_INT64 FreezeTime = (CCopasiTimeVariable::getCurrentWallTime() - Start).getMicroSeconds();
+
+  // The sequence of fired reactions
+  std::vector< size_t > Fired(Events);
+
+  for (i = 0; i < Events; ++i)
+    Fired[i] = pRandom->getRandomU(Reactions - 1);
+
+  std::cout << "Reactions:         " << Reactions << std::endl;
+  std::cout << "Events:            " << Events << std::endl;
+  std::cout << "Build (set):       " << BuildTime << " us" << std::endl;
+  std::cout << "Freeze (CSR):      " << FreezeTime << " us" << std::endl;
+
+  // The checksums must be identical.
+  size_t SetChecksum = 0;
+  Start = CCopasiTimeVariable::getCurrentWallTime();
+
+  for (i = 0; i < Events; ++i)
+    {
+      const std::set< size_t > & Dependents = DG.getDependents(Fired[i]);
+      std::set< size_t >::const_iterator it = Dependents.begin();
+      std::set< size_t >::const_iterator end = Dependents.end();
+
+      for (; it != end; ++it)
+        SetChecksum += *it;
+    }
+
+  std::cout << "std::set:          " << eventsPerSecond(Start, Events) << " events/s" << std::endl;
+
+  size_t FrozenChecksum = 0;
+  Start = CCopasiTimeVariable::getCurrentWallTime();
+
+  for (i = 0; i < Events; ++i)
+    {
+      const size_t * pDependent = DG.beginDependents(Fired[i]);
+      const size_t * pDependentEnd = DG.endDependents(Fired[i]);
+
+      for (; pDependent != pDependentEnd; ++pDependent)
+        FrozenChecksum += *pDependent;
+    }
+
+  std::cout << "CSR:               " << eventsPerSecond(Start, Events) << " events/s"
+            << (FrozenChecksum == SetChecksum ? "" : " (dependents differ)") << std::endl;
+
+  delete pRandom;
+
+  return 0;
+}
@@ -0,0 +1,282 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+/**
+ * This example measures the throughput of the implementations of the indexed priority
+ * queue used by the Next Reaction method. The operations on the queue are recorded
+ * while a stochastic time course is run for a COPASI or SBML file. Alternatively a
+ * previously recorded stream (extension .pqs) is read. The recorded stream is then
+ * replayed for each implementation.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+#include <limits>
+
+#define COPASI_MAIN
+
+#include "copasi/CopasiTypes.h"
+#include "copasi/trajectory/CTrajectoryTask.h"
+#include "copasi/trajectory/CTrajectoryProblem.h"
+#include "copasi/utilities/CIndexedPriorityQueue.h"
+#include "copasi/utilities/CopasiTime.h"
+#include "copasi/commandline/CLocaleString.h"
+
+using namespace std;
+
+struct Operation
+{
+  char Type;
+  size_t Index;
+  C_FLOAT64 Key;
+};
+
+static bool readOperations(std::istream & is, std::vector< Operation > & operations)
+{
+  std::string Line;
+
+  while (std::getline(is, Line))
+    {
+      if (Line.empty()) continue;
+
+      std::istringstream Fields(Line);
+      Operation Op;
+      std::string Key;
+
+      Op.Type = Line[0];
+      Op.Index = 0;
+      Op.Key = 0.0;
+
+      Fields.ignore(1);
+
+      switch (Op.Type)
+        {
+          case 'p':
+          case 'i':
+          case 'u':
+            // strtod reads inf and nan which may appear in the stream
+            Fields >> Op.Index >> Key;
+            Op.Key = strtod(Key.c_str(), NULL);
+            break;
+
+          case 'r':
+          case 'n':
+            Fields >> Op.Index;
+            break;
+
+          case 'c':
+          case 'b':
+          case 't':
+            break;
+
+          default:
+            return false;
+        }
+
+      operations.push_back(Op);
+    }
+
+  return true;
+}
+
+static C_FLOAT64 replay(CIndexedPriorityQueue & queue, const std::vector< Operation > & operations)
+{
+  // The sum of the top keys must be identical for all implementations.
+  C_FLOAT64 Checksum = 0.0;
+
+  std::vector< Operation >::const_iterator it = operations.begin();
+  std::vector< Operation >::const_iterator end = operations.end();
+
+  for (; it != end; ++it)
+    switch (it->Type)
+      {
+        case 'c':
+          queue.clear();
+          break;
+
+        case 'n':
+          queue.initializeIndexPointer(it->Index);
+          break;
+
+        case 'p':
+          queue.pushPair(it->Index, it->Key);
+          break;
+
+        case 'b':
+          queue.buildHeap();
+          break;
+
+        case 'i':
+          queue.insertStochReaction(it->Index, it->Key);
+          break;
+
+        case 'r':
+          queue.removeStochReaction(it->Index);
+          break;
+
+        case 'u':
+          queue.updateNode(it->Index, it->Key);
+          break;
+
+        case 't':
+        {
+          C_FLOAT64 Key = queue.topKey();
+          queue.topIndex();
+
+          if (Key < std::numeric_limits< C_FLOAT64 >::infinity())
+            Checksum += Key;
+        }
+        break;
+      }
+
+  return Checksum;
+}
+
+static bool recordOperations(CDataModel * pDataModel, const C_FLOAT64 & duration, std::ostream & os)
+{
+  CDataVectorN< CCopasiTask > & TaskList = * pDataModel->getTaskList();
+  CTrajectoryTask * pTrajectoryTask = dynamic_cast< CTrajectoryTask * >(&TaskList["Time-Course"]);
+
+  if (pTrajectoryTask == NULL)
+    return false;
+
+  pTrajectoryTask->setMethodType(CTaskEnum::Method::stochastic);
+
+  CTrajectoryProblem * pProblem = dynamic_cast< CTrajectoryProblem * >(pTrajectoryTask->getProblem());
+
+  if (duration > 0.0)
+    pProblem->setDuration(duration);
+
+  pProblem->setTimeSeriesRequested(false);
+
+  bool success = true;
+
+  CIndexedPriorityQueue::setRecorder(&os);
+
+  try
+    {
+      success = pTrajectoryTask->initialize(CCopasiTask::NO_OUTPUT, pDataModel, NULL) &&
+                pTrajectoryTask->process(true);
+    }
+  catch (...)
+    {
+      success = false;
+    }
+
+  CIndexedPriorityQueue::setRecorder(NULL);
+  pTrajectoryTask->restore();
+
+  return success;
+}
+
+int main(int argc, char** argv)
+{
+  // initialize the backend library
+  CRootContainer::init(argc, argv);
+  assert(CRootContainer::getRoot() != NULL);
+  // create a new datamodel
+  CDataModel* pDataModel = CRootContainer::addDatamodel();
+  assert(CRootContainer::getDatamodelList()->size() == 1);
+
+  if (argc < 2 || argc > 4)
+    {
+      std::cerr << "Usage: benchmarkPriorityQueue <copasi or SBML file> [duration] [recorded stream file]" << std::endl;
+      std::cerr << "       benchmarkPriorityQueue <recorded stream file (.pqs)>" << std::endl;
+      CRootContainer::destroy();
+      return 1;
+    }
+
+  std::string filename = argv[1];
+  std::vector< Operation > Operations;
+  bool result = false;
+
+  if (filename.size() > 4 &&
+      filename.substr(filename.size() - 4) == ".pqs")
+    {
+      std::ifstream Stream(CLocaleString::fromUtf8(filename).c_str());
+      result = Stream.good() && readOperations(Stream, Operations);
+    }
+  else
+    {
+      try
+        {
+          if (filename.size() > 4 &&
+              filename.substr(filename.size() - 4) == ".cps")
+            result = pDataModel->loadModel(filename, NULL);
+          else
+            result = pDataModel->importSBML(filename, NULL);
+        }
+      catch (...)
+        {
+          result = false;
+        }
+
+      std::stringstream Stream;
+      C_FLOAT64 Duration = (argc > 2) ? strtod(argv[2], NULL) : 0.0;
+
+      if (result &&
+          !recordOperations(pDataModel, Duration, Stream))
+        {
+          std::cerr << "Error while running the time course with the Next Reaction method." << std::endl;
+          std::cerr << CCopasiMessage::getAllMessageText(true);
+          CRootContainer::destroy();
+          return 1;
+        }
+
+      if (result && argc > 3)
+        {
+          std::ofstream Record(CLocaleString::fromUtf8(argv[3]).c_str());
+          Record << Stream.str();
+        }
+
+      result = result && readOperations(Stream, Operations);
+    }
+
+  if (!result)
+    {
+      std::cerr << "Error while opening the file named \"" << filename << "\"." << std::endl;
+      CRootContainer::destroy();
+      return 1;
+    }
+
+  std::cout << "Operations:        " << Operations.size() << std::endl;
+
+  const char * Names[] = {"binary heap", "4-ary heap", "8-ary heap", "calendar queue"};
+  const CIndexedPriorityQueue::Type Types[] =
+  {
+    CIndexedPriorityQueue::Type::BinaryHeap,
+    CIndexedPriorityQueue::Type::QuaternaryHeap,
+    CIndexedPriorityQueue::Type::OctonaryHeap,
+    CIndexedPriorityQueue::Type::CalendarQueue
+  };
+
+  C_FLOAT64 Reference = std::numeric_limits< C_FLOAT64 >::quiet_NaN();
+
+  for (size_t i = 0; i < 4; ++i)
+    {
+      CIndexedPriorityQueue Queue(Types[i]);
+
+      CCopasiTimeVariable Start = CCopasiTimeVariable::getCurrentWallTime();
+      C_FLOAT64 Checksum = replay(Queue, Operations);
+      C_INT64 MicroSeconds = (CCopasiTimeVariable::getCurrentWallTime() - Start).getMicroSeconds();
+
+      if (MicroSeconds <= 0) MicroSeconds = 1;
+
+      if (i == 0)
+        Reference = Checksum;
+
+      std::cout << Names[i] << ":\t" << 1e6 * Operations.size() / MicroSeconds << " operations/s"
+                << (Checksum == Reference ? "" : " (top keys differ)") << std::endl;
+    }
+
+  // clean up the library
+  CRootContainer::destroy();
+  return 0;
+}
@@ -0,0 +1,129 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+/**
+ * This example measures the number of right hand side evaluations per second,
+ * i.e., calls to CMathContainer::updateSimulatedValues, for a COPASI or SBML file.
+ * The update sequences are applied with and without freezing and expressions are
+ * evaluated with and without bytecode.
+ */
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+
+#define COPASI_MAIN
+
+#include "copasi/CopasiTypes.h"
+#include "copasi/math/CMathContainer.h"
+#include "copasi/math/CMathExpression.h"
+#include "copasi/utilities/CopasiTime.h"
+
+using namespace std;
+
+static double evaluationsPerSecond(CMathContainer & container, const size_t & evaluations)
+{
+  // Warm up, this also freezes the update sequence if requested
+  container.updateSimulatedValues(false);
+
+  CCopasiTimeVariable Start = CCopasiTimeVariable::getCurrentWallTime();
+
+  for (size_t i = 0; i < evaluations; ++i)
+    {
+      container.updateSimulatedValues(false);
+    }
+
+  C_INT64 MicroSeconds = (CCopasiTimeVariable::getCurrentWallTime() - Start).getMicroSeconds();
+
+  if (MicroSeconds <= 0) MicroSeconds = 1;
+
+  return 1e6 * evaluations / MicroSeconds;
+}
+
+int main(int argc, char** argv)
+{
+  // initialize the backend library
+  CRootContainer::init(argc, argv);
+  assert(CRootContainer::getRoot() != NULL);
+  // create a new datamodel
+  CDataModel* pDataModel = CRootContainer::addDatamodel();
+  assert(CRootContainer::getDatamodelList()->size() == 1);
+
+  if (argc < 2 || argc > 3)
+    {
+      std::cerr << "Usage: benchmarkRHS <copasi or SBML file> [evaluations]" << std::endl;
+      CRootContainer::destroy();
+      return 1;
+    }
+
+  std::string filename = argv[1];
+  size_t Evaluations = (argc == 3) ? strtoul(argv[2], NULL, 10) : 100000;
+
+  bool result = false;
+
+  try
+    {
+      if (filename.size() > 4 &&
+          filename.substr(filename.size() - 4) == ".cps")
+        result = pDataModel->loadModel(filename, NULL);
+      else
+        result = pDataModel->importSBML(filename, NULL);
+    }
+  catch (...)
+    {
+    }
+
+  if (!result)
+    {
+      std::cerr << "Error while opening the file named \"" << filename << "\"." << std::endl;
+      CRootContainer::destroy();
+      return 1;
+    }
+
+  CMathContainer & Container = pDataModel->getModel()->getMathContainer();
+
+  std::cout << "State variables:   " << Container.getState(false).size() << std::endl;
+  std::cout << "Sequence length:   " << Container.getSimulationValuesSequence(false).size() << std::endl;
+  std::cout << "Evaluations:       " << Evaluations << std::endl;
+
+  // The reference rates are calculated without any optimization
+  CMathUpdateSequence::setUseFrozen(false);
+  CMathExpression::setUseBytecode(false);
+  Container.updateSimulatedValues(false);
+  CVector< C_FLOAT64 > Reference = Container.getRate(false);
+
+  const char * Names[] = {"tree, generic", "tree, frozen", "bytecode, generic", "bytecode, frozen"};
+
+  for (size_t i = 0; i < 4; ++i)
+    {
+      CMathExpression::setUseBytecode(i > 1);
+      CMathUpdateSequence::setUseFrozen(i % 2 == 1);
+
+      double Rate = evaluationsPerSecond(Container, Evaluations);
+
+      // The optimizations must not change the result
+      const C_FLOAT64 * pReference = Reference.array();
+      const C_FLOAT64 * pRate = Container.getRate(false).array();
+      const C_FLOAT64 * pRateEnd = pRate + Reference.size();
+      bool Identical = true;
+
+      for (; pRate != pRateEnd; ++pRate, ++pReference)
+        if (*pRate != *pReference &&
+            !(std::isnan(*pRate) && std::isnan(*pReference)))
+          {
+            Identical = false;
+          }
+
+      std::cout << Names[i] << ":\t" << Rate << " evaluations/s" << (Identical ? "" : " (rates differ)") << std::endl;
+    }
+
+  CMathExpression::setUseBytecode(true);
+  CMathUpdateSequence::setUseFrozen(true);
+
+  // clean up the library
+  CRootContainer::destroy();
+  return 0;
+}
@@ -326,6 +326,15 @@ CCopasiMessage.size=_COPASI.CCopasiMessage_size
   %pythoncode
   %{
 
+      def iterRows(self, concentrations=False):
+        """Iterates over the recorded steps of the time series without random access.
+        Each row is returned as a python list of the values of all variables.
+        """
+        it=CTimeSeriesRowIterator(self)
+        while it.isValid():
+          yield list(it.getRow(concentrations))
+          it.next()
+
       def getTitles(self):
         """Returns the titles of the variables in the time series
         as a python list.
@@ -416,6 +425,59 @@ CCopasiMessage.size=_COPASI.CCopasiMessage_size
 %pythoncode
 %{
 
+def readBinaryReport(fileName):
+    """Reads a report written in the binary format (see CReport.Format_Binary).
+
+    Returns a tuple (cns, rows) where cns is the list of the common names of the
+    columns and rows is a list of lists of float values. Separators are rows of NaN values.
+    """
+    import struct
+    from array import array
+
+    with open(fileName, 'rb') as f:
+        if f.read(8) != b'COPASIRB':
+            raise IOError("'%s' is not a binary COPASI report" % fileName)
+
+        order = '<'
+        version, mark, columns = struct.unpack(order + '3I', f.read(12))
+
+        if mark != 0x01020304:
+            order = '>'
+            version, mark, columns = struct.unpack(order + '3I', struct.pack('<3I', version, mark, columns))
+
+        if version != 1:
+            raise IOError("unsupported binary COPASI report version '%d'" % version)
+
+        cns = []
+
+        for column in range(columns):
+            type, length = struct.unpack(order + '2I', f.read(8))
+
+            if type != 0:
+                raise IOError("unsupported column type '%d'" % type)
+
+            cns.append(f.read(length).decode('utf-8'))
+
+        values = array('d')
+        data = f.read()
+        data = data[:len(data) - len(data) % values.itemsize]
+
+        if hasattr(values, 'frombytes'):
+            values.frombytes(data)
+        else:
+            values.fromstring(data)
+
+        if (order == '<') != (sys.byteorder == 'little'):
+            values.byteswap()
+
+    rows = []
+
+    if columns > 0:
+        for start in range(0, len(values) - len(values) % columns, columns):
+            rows.append(values[start:start + columns].tolist())
+
+    return cns, rows
+
 class _VectorIterator:
     def __init__(self, vector):
         #type: (COPASI.MetabVector) -> None
@@ -35,6 +35,13 @@
 %ignore CRandom::vare;
 %ignore CRandom::XMLType;
 %ignore CRandom::TypeName;
+%ignore CRandom::fillRandomU;
+%ignore CRandom::fillRandomCC;
+%ignore CRandom::fillRandomCO;
+%ignore CRandom::fillRandomOO;
+%ignore CRandom::fillRandomExp;
+%ignore CRandom::fillRandomNormal01;
+%ignore CRandom::fillRandomPoisson;
 
 // suppress warnings on nested structures
 %warnfilter(325) PoissonVars;
@@ -30,6 +30,7 @@
 
 %ignore CTrajectoryTask::load;
 %ignore CTrajectoryTask::initialize;
+%ignore CTrajectoryTask::getEnsemble;
 
 #ifdef SWIGR
 // we ignore the method that takes an int and create a new method that takes
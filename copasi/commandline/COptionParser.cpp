@@ -75,6 +75,9 @@ const char const_usage[] =
   "  --nologo                      Surpresses the startup message.\n"
   "  --report-file file            Override report file name to be used except\n"
   "                                for the one defined in the scheduled task.\n"
+  "  --report-format format        The format of the report file: text,\n"
+  "                                buffered (text without flushing each row),\n"
+  "                                or binary.\n"
   "  --scheduled-task taskName     Override the task marked as executable.\n"
   "  --validate                    Only validate the given input file (COPASI,\n"
   "                                Gepasi, or SBML) without performing any\n"
@@ -274,6 +277,9 @@ void copasi::COptionParser::finalize(void)
           case option_ReportFile:
             throw option_error("missing value for 'report-file' option");
 
+          case option_ReportFormat:
+            throw option_error("missing value for 'report-format' option");
+
           case option_SBMLSchema:
             throw option_error("missing value for 'SBMLSchema' option");
 
@@ -771,6 +777,20 @@ void copasi::COptionParser::parse_long_option(const char *option, int position,
       state_ = state_value;
       return;
     }
+  else if (strcmp(option, "report-format") == 0)
+    {
+      if (source != source_cl) throw option_error("the 'report-format' option is only allowed on the command line");
+
+      if (locations_.ReportFormat)
+        {
+          throw option_error("the 'report-format' option is only allowed once");
+        }
+
+      openum_ = option_ReportFormat;
+      locations_.ReportFormat = position;
+      state_ = state_value;
+      return;
+    }
   else if (strcmp(option, "save") == 0)
     {
       source = source; // kill compiler unused variable warning
@@ -980,6 +1000,32 @@ void copasi::COptionParser::parse_value(const char *value)
       }
       break;
 
+      case option_ReportFormat:
+      {
+        ReportFormat_enum evalue;
+
+        if (strcmp(value, "text") == 0)
+          {
+            evalue = ReportFormat_text;
+          }
+        else if (strcmp(value, "buffered") == 0)
+          {
+            evalue = ReportFormat_buffered;
+          }
+        else if (strcmp(value, "binary") == 0)
+          {
+            evalue = ReportFormat_binary;
+          }
+        else
+          {
+            std::string error("'"); error += value; error += "' is an invalid value for the 'report-format' option";
+            throw option_error(error);
+          }
+
+        options_.ReportFormat = evalue;
+      }
+      break;
+
       case option_SBMLSchema:
       {
         SBMLSchema_enum evalue;
@@ -1131,6 +1177,9 @@ const char* expand_long_name(const std::string &name)
   if (name_size <= 11 && name.compare(0, name_size, "report-file", name_size) == 0)
     matches.push_back("report-file");
 
+  if (name_size <= 13 && name.compare(0, name_size, "report-format", name_size) == 0)
+    matches.push_back("report-format");
+
   if (name_size <= 4 && name.compare(0, name_size, "save", name_size) == 0)
     matches.push_back("save");
 
@@ -71,6 +71,13 @@ enum SBMLSchema_enum
   SBMLSchema_L3V2
 };
 
+enum ReportFormat_enum
+{
+  ReportFormat_text,
+  ReportFormat_buffered,
+  ReportFormat_binary
+};
+
 /**
  * the following struct is used to hold the values of
  * the options. It has a constructor that sets all the option
@@ -83,6 +90,7 @@ struct options
     License(false),
     MaxTime(0),
     NoLogo(false),
+    ReportFormat(ReportFormat_text),
     SBMLSchema(SBMLSchema_L2V4),
     Validate(false),
     Verbose(false)
@@ -107,6 +115,7 @@ struct options
   bool     NoLogo;
   std::string     ReparameterizeModel;
   std::string     ReportFile;
+  ReportFormat_enum     ReportFormat;
   SBMLSchema_enum     SBMLSchema;
   std::string     Save;
   std::string     ScheduledTask;
@@ -142,6 +151,7 @@ struct option_locations
   size_type NoLogo;
   size_type ReparameterizeModel;
   size_type ReportFile;
+  size_type ReportFormat;
   size_type SBMLSchema;
   size_type Save;
   size_type ScheduledTask;
@@ -245,6 +255,7 @@ private:
     option_MaxTime,
     option_ConvertToIrreversible,
     option_ReportFile,
+    option_ReportFormat,
     option_ScheduledTask,
     option_ReparameterizeModel,
     option_ExportIni
@@ -248,6 +248,7 @@ void COptions::init(C_INT argc, char *argv[])
   setValue("ConvertToIrreversible", Options.ConvertToIrreversible);
   setValue("ScheduledTask", Options.ScheduledTask);
   setValue("ReportFile", Options.ReportFile);
+  setValue("ReportFormat", Options.ReportFormat);
 
   setValue("ReparameterizeModel", Options.ReparameterizeModel);
   setValue("ExportIni", Options.ExportIni);
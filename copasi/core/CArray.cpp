@@ -88,3 +88,33 @@ size_t CArray::dimensionality() const
 {
   return mDim;
 }
+
+size_t CArray::offset(const index_type & index) const
+{
+  if (index.size() != mDim) return C_INVALID_INDEX;
+
+  size_t Offset = 0;
+  index_type::const_iterator itSize = mSizes.begin();
+  index_type::const_iterator itFactor = mFactors.begin();
+  index_type::const_iterator it = index.begin();
+  index_type::const_iterator end = index.end();
+
+  for (; it != end; ++it, ++itSize, ++itFactor)
+    {
+      if (*it >= *itSize) return C_INVALID_INDEX;
+
+      Offset += *itFactor **it;
+    }
+
+  return Offset;
+}
+
+CArray::data_type * CArray::array()
+{
+  return mData.data();
+}
+
+const CArray::data_type * CArray::array() const
+{
+  return mData.data();
+}
@@ -57,6 +57,25 @@ public:
 
   size_t dimensionality() const;
 
+  /**
+   * Retrieve the position of the indexed element in the contiguous data
+   * @param const index_type & index
+   * @return size_t offset (C_INVALID_INDEX if the index is out of range)
+   */
+  size_t offset(const index_type & index) const;
+
+  /**
+   * Retrieve the contiguous data in row major order
+   * @return data_type * array
+   */
+  data_type * array();
+
+  /**
+   * Retrieve the contiguous data in row major order
+   * @return const data_type * array
+   */
+  const data_type * array() const;
+
 private:
   std::vector<data_type> mData;
 
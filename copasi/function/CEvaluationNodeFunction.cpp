@@ -1472,6 +1472,12 @@ CEvaluationNode * CEvaluationNodeFunction::getLeft()
 const CEvaluationNode * CEvaluationNodeFunction::getLeft() const
 {return mpArgNode1;}
 
+CEvaluationNodeFunction::Function1 CEvaluationNodeFunction::getFunction1() const
+{return mpFunction;}
+
+CEvaluationNodeFunction::Function2 CEvaluationNodeFunction::getFunction2() const
+{return mpFunction2;}
+
 #include "copasi/utilities/copasimathml.h"
 
 // virtual
@@ -54,6 +54,12 @@ class CDataModel;
  */
 class CEvaluationNodeFunction : public CEvaluationNode
 {
+public:
+  typedef C_FLOAT64(*Function1)(C_FLOAT64 arg1);
+
+  typedef C_FLOAT64(*Function2)(const C_FLOAT64 & arg1,
+                                const C_FLOAT64 & arg2);
+
   // Operations
 private:
   /**
@@ -197,6 +203,18 @@ public:
   CEvaluationNode * getLeft();
   const CEvaluationNode * getLeft() const;
 
+  /**
+   * Retrieve the function of one argument used to calculate the node
+   * @return Function1 function (NULL if not applicable)
+   */
+  Function1 getFunction1() const;
+
+  /**
+   * Retrieve the function of two arguments used to calculate the node
+   * @return Function2 function (NULL if not applicable)
+   */
+  Function2 getFunction2() const;
+
 private:
   std::string handleSign(const std::string & str) const;
 
@@ -289,10 +307,9 @@ private:
 
   // Attributes
 private:
-  C_FLOAT64(*mpFunction)(C_FLOAT64 arg1);
+  Function1 mpFunction;
 
-  C_FLOAT64(*mpFunction2)(const C_FLOAT64 & arg1,
-                          const C_FLOAT64 & arg2);
+  Function2 mpFunction2;
 
   C_FLOAT64(*mpFunction4)(const C_FLOAT64 & arg1,
                           const C_FLOAT64 & arg2,
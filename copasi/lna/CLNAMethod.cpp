@@ -15,6 +15,7 @@
 
 #include <cmath>
 #include <limits>
+#include <algorithm>
 
 #include "copasi/copasi.h"
 
@@ -26,10 +27,24 @@
 #include "copasi/utilities/utility.h"
 #include "copasi/utilities/CCopasiTask.h"
 #include "copasi/utilities/CReadConfig.h"
+#include "copasi/utilities/CSparseLU.h"
 
 #include "copasi/lapack/blaswrap.h"
 #include "copasi/lapack/lapackwrap.h"
 
+// The number of Arnoldi steps with A and A^-1 used to determine the ADI shifts
+#define ADI_ARNOLDI_STEPS 20
+#define ADI_INVERSE_ARNOLDI_STEPS 10
+
+// The maximal number of ADI shifts, which are used cyclically
+#define ADI_MAX_SHIFTS 10
+
+// static
+const CEnumAnnotation< std::string, CLNAMethod::eLyapunovSolver > CLNAMethod::LyapunovSolver(
+{
+  "Bartels-Stewart",
+  "Low-Rank ADI"});
+
 /**
  * Default constructor
  */
@@ -37,6 +52,8 @@ CLNAMethod::CLNAMethod(const CDataContainer * pParent,
                        const CTaskEnum::Method & methodType,
                        const CTaskEnum::Task & taskType):
   CCopasiMethod(pParent, methodType, taskType),
+  mLyapunovSolver(eLyapunovSolver::BartelsStewart),
+  mMaterializeMatrices(true),
   mSteadyStateResolution(1.0e-9),
   mSSStatus(CSteadyStateMethod::notFound)
 {
@@ -47,6 +64,8 @@ CLNAMethod::CLNAMethod(const CDataContainer * pParent,
 CLNAMethod::CLNAMethod(const CLNAMethod & src,
                        const CDataContainer * pParent):
   CCopasiMethod(src, pParent),
+  mLyapunovSolver(src.mLyapunovSolver),
+  mMaterializeMatrices(src.mMaterializeMatrices),
   mSteadyStateResolution(src.mSteadyStateResolution),
   mSSStatus(CSteadyStateMethod::notFound)
 {
@@ -93,6 +112,19 @@ CLNAMethod::~CLNAMethod()
 
 void CLNAMethod::initializeParameter()
 {
+  CCopasiParameter *pParm;
+
+  assertParameter("Lyapunov Solver", CCopasiParameter::Type::STRING, LyapunovSolver[0]);
+  pParm = getParameter("Lyapunov Solver");
+
+  if (pParm != NULL)
+    pParm->setValidValues(LyapunovSolver);
+
+  // The parameters of the low-rank solver
+  assertParameter("Tolerance", CCopasiParameter::Type::UDOUBLE, (C_FLOAT64) 1.0e-010);
+  assertParameter("Iteration Limit", CCopasiParameter::Type::UINT, (unsigned C_INT32) 100);
+  assertParameter("Materialize Matrices", CCopasiParameter::Type::BOOL, true);
+
   /*  CCopasiParameter *pParm;
 
       assertParameter("Placeholder Factor", CCopasiParameter::Type::UDOUBLE, 1.0e-009);
@@ -111,22 +143,34 @@ bool CLNAMethod::elevateChildren()
   return true;
 }
 
+void CLNAMethod::readSolverParameters()
+{
+  mLyapunovSolver = LyapunovSolver.toEnum(getValue< std::string >("Lyapunov Solver"), eLyapunovSolver::BartelsStewart);
+  mMaterializeMatrices = mLyapunovSolver == eLyapunovSolver::BartelsStewart ||
+                         getValue< bool >("Materialize Matrices");
+}
+
 void CLNAMethod::resizeAllMatrices()
 {
   const CModel & Model = mpContainer->getModel();
 
-  mBMatrixReduced.resize(mpContainer->getCountIndependentSpecies(), mpContainer->getCountIndependentSpecies());
+  readSolverParameters();
+
+  // The dense matrices are empty if only the factors are calculated.
+  size_t numIndependentMetabs = mMaterializeMatrices ? mpContainer->getCountIndependentSpecies() : 0;
+  size_t numReactionMetabs = mMaterializeMatrices ? mpContainer->getCountIndependentSpecies() + mpContainer->getCountDependentSpecies() : 0;
+
+  mBMatrixReduced.resize(numIndependentMetabs, numIndependentMetabs);
   mBMatrixReducedAnn->resize();
   mBMatrixReducedAnn->setCopasiVector(0, Model.getMetabolitesX());
   mBMatrixReducedAnn->setCopasiVector(1, Model.getMetabolitesX());
 
-  mCovarianceMatrixReduced.resize(mpContainer->getCountIndependentSpecies(), mpContainer->getCountIndependentSpecies());
+  mCovarianceMatrixReduced.resize(numIndependentMetabs, numIndependentMetabs);
   mCovarianceMatrixReducedAnn->resize();
   mCovarianceMatrixReducedAnn->setCopasiVector(0, Model.getMetabolitesX());
   mCovarianceMatrixReducedAnn->setCopasiVector(1, Model.getMetabolitesX());
 
-  mCovarianceMatrix.resize(mpContainer->getCountIndependentSpecies() + mpContainer->getCountDependentSpecies(),
-                           mpContainer->getCountIndependentSpecies() + mpContainer->getCountDependentSpecies());
+  mCovarianceMatrix.resize(numReactionMetabs, numReactionMetabs);
   mCovarianceMatrixAnn->resize();
   mCovarianceMatrixAnn->setCopasiVector(0, Model.getMetabolitesX());
   mCovarianceMatrixAnn->setCopasiVector(1, Model.getMetabolitesX());
@@ -134,6 +178,11 @@ void CLNAMethod::resizeAllMatrices()
 
 int CLNAMethod::calculateCovarianceMatrixReduced()
 {
+  if (mLyapunovSolver == eLyapunovSolver::LowRankADI)
+    {
+      return calculateCovarianceFactorReduced();
+    }
+
   // code snippet: transform something into particle space:
   // *(metabs[i]->getCompartment())->getValue()*mpModel->getQuantity2NumberFactor();
 
@@ -513,6 +562,556 @@ int CLNAMethod::calculateCovarianceMatrixReduced()
   return LNA_OK;
 }
 
+void CLNAMethod::calculateBFactorReduced()
+{
+  CVectorCore< CMathReaction > & Reactions = mpContainer->getReactions();
+  const CVectorCore< C_FLOAT64 > & ParticleFluxes = mpContainer->getParticleFluxes();
+
+  size_t numMetabs = mpContainer->getCountIndependentSpecies();
+
+  // Each reaction contributes flux * N(:, k) * N(:, k)^T to the B matrix (reduced), i.e.,
+  // the column sqrt(flux) * N(:, k) to its factor G.
+  CMatrix< C_FLOAT64 > G(numMetabs, Reactions.size());
+  G = 0.0;
+
+  std::vector< size_t > Columns;
+
+  const CMathReaction * pReaction = Reactions.array();
+  const CMathReaction * pReactionEnd = pReaction + Reactions.size();
+  const C_FLOAT64 * pParticleFlux = ParticleFluxes.array();
+
+  size_t FirstReactionSpeciesIndex = mpContainer->getCountFixedEventTargets() + 1 + mpContainer->getCountODEs();
+  CMathObject * pFirstReactionSpecies = mpContainer->getMathObject(mpContainer->getState(false).array() + FirstReactionSpeciesIndex);
+  CMathObject * pSpecies;
+
+  for (size_t k = 0; pReaction != pReactionEnd; ++pReaction, ++pParticleFlux, ++k)
+    {
+      // The LNA requires irreversible reactions, i.e., non negative fluxes.
+      if (!(*pParticleFlux > 0.0)) continue;
+
+      C_FLOAT64 Factor = sqrt(*pParticleFlux);
+      bool Contributes = false;
+
+      const CMathReaction::Balance & Balances = pReaction->getNumberBalance();
+      const CMathReaction::SpeciesBalance * pBalance = Balances.array();
+      const CMathReaction::SpeciesBalance * pBalanceEnd = pBalance + Balances.size();
+
+      for (; pBalance != pBalanceEnd; ++pBalance)
+        {
+          pSpecies = mpContainer->getMathObject(pBalance->first);
+
+          if (pSpecies->getSimulationType() == CMath::SimulationType::Independent &&
+              pBalance->second != 0.0)
+            {
+              G(pSpecies - pFirstReactionSpecies, k) += Factor * pBalance->second;
+              Contributes = true;
+            }
+        }
+
+      if (Contributes)
+        Columns.push_back(k);
+    }
+
+  // Only reactions changing independent species contribute.
+  mBFactorReduced.resize(numMetabs, Columns.size());
+
+  for (size_t i = 0; i < numMetabs; ++i)
+    for (size_t j = 0; j < Columns.size(); ++j)
+      mBFactorReduced(i, j) = G(i, Columns[j]);
+}
+
+int CLNAMethod::calculateCovarianceFactorReduced()
+{
+  size_t numMetabs = mpContainer->getCountIndependentSpecies();
+
+  calculateBFactorReduced();
+  mCovarianceFactorReduced.resize(numMetabs, 0);
+
+  size_t numColumns = mBFactorReduced.numCols();
+
+  // Without noise the covariance vanishes.
+  if (numMetabs == 0 || numColumns == 0)
+    return LNA_OK;
+
+  // get the Jacobian (reduced) and its structure
+  C_FLOAT64 derivationFactor = 1e-6;
+  mpContainer->calculateJacobian(mJacobianReduced, derivationFactor, true);
+
+  CMatrix< C_INT32 > Dependencies;
+  mpContainer->calculateJacobianDependencies(Dependencies, true);
+
+  // The independent species are the last entries of the reduced state.
+  size_t Offset = mJacobianReduced.numRows() - numMetabs;
+
+  CMatrix< C_FLOAT64 > A(numMetabs, numMetabs);
+  CMatrix< C_INT32 > Pattern(numMetabs, numMetabs);
+
+  for (size_t i = 0; i < numMetabs; ++i)
+    for (size_t j = 0; j < numMetabs; ++j)
+      {
+        C_FLOAT64 & a = A(i, j);
+
+        a = mJacobianReduced(i + Offset, j + Offset);
+
+        if (!std::isfinite(a) && !std::isnan(a))
+          {
+            if (a > 0)
+              a = std::numeric_limits< C_FLOAT64 >::max();
+            else
+              a = - std::numeric_limits< C_FLOAT64 >::max();
+          }
+
+        Pattern(i, j) = (Dependencies(i + Offset, j + Offset) != 0 || a != 0.0) ? 1 : 0;
+      }
+
+  CSparseLU LU;
+  std::vector< C_FLOAT64 > Shifts;
+
+  if (!LU.analyze(Pattern) ||
+      !calculateADIShifts(A, LU, Shifts))
+    {
+      CCopasiMessage(CCopasiMessage::ERROR, "LNA: No ADI shifts could be determined for the low-rank Lyapunov solver.");
+      return LNA_NOT_OK;
+    }
+
+  // Each shift requires its own factorization of A + p * I
+  std::vector< CSparseLU > Factors(Shifts.size());
+  std::vector< bool > Factorized(Shifts.size(), false);
+
+  C_FLOAT64 Tolerance = getValue< C_FLOAT64 >("Tolerance");
+  unsigned C_INT32 IterationLimit = getValue< unsigned C_INT32 >("Iteration Limit");
+
+  // The residual of the Lyapunov equation after each step is W * W^T, its norm is
+  // bounded by the square of the Frobenius norm of W.
+  CMatrix< C_FLOAT64 > W = mBFactorReduced;
+  CMatrix< C_FLOAT64 > V(numMetabs, numColumns);
+  CMatrix< C_FLOAT64 > Z;
+
+  C_FLOAT64 InitialResidual = 0.0;
+  C_FLOAT64 * pW = W.array();
+  C_FLOAT64 * pWEnd = pW + W.size();
+
+  for (; pW != pWEnd; ++pW)
+    InitialResidual += *pW * *pW;
+
+  CVector< C_FLOAT64 > Column(numMetabs);
+  CVector< C_FLOAT64 > Solution;
+  size_t CompressedRank = numColumns;
+  bool Converged = false;
+
+  for (unsigned C_INT32 Iteration = 0; Iteration < IterationLimit && !Converged; ++Iteration)
+    {
+      size_t s = Iteration % Shifts.size();
+      const C_FLOAT64 & p = Shifts[s];
+
+      if (!Factorized[s])
+        {
+          if (!Factors[s].analyze(Pattern) ||
+              !Factors[s].factorize(A, p))
+            {
+              CCopasiMessage(CCopasiMessage::ERROR, "LNA: The shifted Jacobian is singular.");
+              return LNA_NOT_OK;
+            }
+
+          Factorized[s] = true;
+        }
+
+      // V = (A + p * I)^-1 * W
+      for (size_t j = 0; j < numColumns; ++j)
+        {
+          for (size_t i = 0; i < numMetabs; ++i)
+            Column[i] = W(i, j);
+
+          Factors[s].solve(CVectorCore< const C_FLOAT64 >(numMetabs, Column.array()), Solution);
+
+          for (size_t i = 0; i < numMetabs; ++i)
+            V(i, j) = Solution[i];
+        }
+
+      // W = W - 2 * p * V and Z = [Z, sqrt(-2 * p) * V]
+      C_FLOAT64 Scale = sqrt(-2.0 * p);
+      size_t OldColumns = Z.numCols();
+      Z.resize(numMetabs, OldColumns + numColumns, true);
+
+      C_FLOAT64 Residual = 0.0;
+
+      for (size_t i = 0; i < numMetabs; ++i)
+        for (size_t j = 0; j < numColumns; ++j)
+          {
+            C_FLOAT64 & w = W(i, j);
+            w -= 2.0 * p * V(i, j);
+            Residual += w * w;
+
+            Z(i, OldColumns + j) = Scale * V(i, j);
+          }
+
+      if (std::isnan(Residual))
+        break;
+
+      Converged = Residual <= Tolerance * InitialResidual;
+
+      // Remove redundant columns whenever the factor has doubled in size.
+      if (Z.numCols() >= 2 * CompressedRank)
+        {
+          compressFactor(Z);
+          CompressedRank = std::max(Z.numCols(), numColumns);
+        }
+    }
+
+  if (!Converged)
+    {
+      CCopasiMessage(CCopasiMessage::ERROR, "LNA: The low-rank Lyapunov solver did not converge within %d iterations.", IterationLimit);
+      return LNA_NOT_OK;
+    }
+
+  compressFactor(Z);
+  mCovarianceFactorReduced = Z;
+
+  return LNA_OK;
+}
+
+bool CLNAMethod::calculateADIShifts(const CMatrix< C_FLOAT64 > & A,
+                                    CSparseLU & LU,
+                                    std::vector< C_FLOAT64 > & shifts) const
+{
+  shifts.clear();
+
+  // Estimate the large and small eigenvalues of A by the Ritz values of A and A^-1
+  std::vector< std::complex< C_FLOAT64 > > RitzValues;
+  calculateRitzValues(A, NULL, ADI_ARNOLDI_STEPS, RitzValues);
+
+  std::vector< std::complex< C_FLOAT64 > > InverseRitzValues;
+
+  if (LU.factorize(A))
+    calculateRitzValues(A, &LU, ADI_INVERSE_ARNOLDI_STEPS, InverseRitzValues);
+
+  std::vector< std::complex< C_FLOAT64 > >::const_iterator it = InverseRitzValues.begin();
+  std::vector< std::complex< C_FLOAT64 > >::const_iterator end = InverseRitzValues.end();
+
+  for (; it != end; ++it)
+    if (std::abs(*it) > 0.0)
+      RitzValues.push_back(1.0 / *it);
+
+  // Only stable Ritz values are suitable shifts.
+  std::vector< std::complex< C_FLOAT64 > > Candidates;
+
+  for (it = RitzValues.begin(), end = RitzValues.end(); it != end; ++it)
+    if (it->real() < 0.0 && std::isfinite(it->real()))
+      Candidates.push_back(*it);
+
+  if (Candidates.empty())
+    return false;
+
+  // Penzl's heuristic restricted to real shifts: The first shift minimizes the maximum of
+  // the ADI rational function over all candidates. Each further shift is the real part of
+  // the candidate where the rational function of the current shifts is largest.
+  std::vector< std::complex< C_FLOAT64 > >::const_iterator itShift;
+  std::vector< std::complex< C_FLOAT64 > >::const_iterator endCandidates = Candidates.end();
+
+  C_FLOAT64 MinMax = std::numeric_limits< C_FLOAT64 >::infinity();
+  C_FLOAT64 Shift = Candidates[0].real();
+
+  for (itShift = Candidates.begin(); itShift != endCandidates; ++itShift)
+    {
+      C_FLOAT64 p = itShift->real();
+      C_FLOAT64 Max = 0.0;
+
+      for (it = Candidates.begin(); it != endCandidates; ++it)
+        Max = std::max(Max, std::abs((*it - p) / (*it + p)));
+
+      if (Max < MinMax)
+        {
+          MinMax = Max;
+          Shift = p;
+        }
+    }
+
+  shifts.push_back(Shift);
+
+  while (shifts.size() < ADI_MAX_SHIFTS)
+    {
+      C_FLOAT64 Max = 0.0;
+      Shift = 0.0;
+
+      for (it = Candidates.begin(); it != endCandidates; ++it)
+        {
+          C_FLOAT64 Value = 1.0;
+          std::vector< C_FLOAT64 >::const_iterator itP = shifts.begin();
+          std::vector< C_FLOAT64 >::const_iterator endP = shifts.end();
+
+          for (; itP != endP; ++itP)
+            Value *= std::abs((*it - *itP) / (*it + *itP));
+
+          if (Value > Max)
+            {
+              Max = Value;
+              Shift = it->real();
+            }
+        }
+
+      // All candidates are already covered by the shifts.
+      if (Max <= 0.0 ||
+          std::find(shifts.begin(), shifts.end(), Shift) != shifts.end())
+        break;
+
+      shifts.push_back(Shift);
+    }
+
+  return true;
+}
+
+void CLNAMethod::calculateRitzValues(const CMatrix< C_FLOAT64 > & A,
+                                     const CSparseLU * pInverse,
+                                     const size_t & steps,
+                                     std::vector< std::complex< C_FLOAT64 > > & ritzValues) const
+{
+  ritzValues.clear();
+
+  size_t n = A.numRows();
+  size_t k = std::min(steps, n);
+
+  if (k == 0) return;
+
+  // The Arnoldi basis and the Hessenberg matrix
+  std::vector< CVector< C_FLOAT64 > > Basis(k + 1);
+  CMatrix< C_FLOAT64 > H(k + 1, k);
+  H = 0.0;
+
+  Basis[0].resize(n);
+  Basis[0] = 1.0 / sqrt((C_FLOAT64) n);
+
+  CVector< C_FLOAT64 > w(n);
+  size_t j;
+
+  for (j = 0; j < k; ++j)
+    {
+      const CVector< C_FLOAT64 > & v = Basis[j];
+
+      if (pInverse != NULL)
+        {
+          pInverse->solve(CVectorCore< const C_FLOAT64 >(n, v.array()), w);
+        }
+      else
+        {
+          for (size_t r = 0; r < n; ++r)
+            {
+              const C_FLOAT64 * pA = A[r];
+              const C_FLOAT64 * pAEnd = pA + n;
+              const C_FLOAT64 * pV = v.array();
+              C_FLOAT64 & wr = w[r];
+
+              for (wr = 0.0; pA != pAEnd; ++pA, ++pV)
+                wr += *pA * *pV;
+            }
+        }
+
+      // Modified Gram-Schmidt orthogonalization
+      C_FLOAT64 Norm = 0.0;
+
+      for (size_t i = 0; i <= j; ++i)
+        {
+          C_FLOAT64 & h = H(i, j);
+          h = 0.0;
+
+          for (size_t r = 0; r < n; ++r)
+            h += w[r] * Basis[i][r];
+
+          for (size_t r = 0; r < n; ++r)
+            w[r] -= h * Basis[i][r];
+        }
+
+      for (size_t r = 0; r < n; ++r)
+        Norm += w[r] * w[r];
+
+      Norm = sqrt(Norm);
+
+      if (std::isnan(Norm)) return;
+
+      H(j + 1, j) = Norm;
+
+      // An invariant subspace has been found.
+      if (Norm <= 100.0 * std::numeric_limits< C_FLOAT64 >::epsilon() * std::max(fabs(H(j, j)), 1.0))
+        {
+          ++j;
+          break;
+        }
+
+      Basis[j + 1].resize(n);
+
+      for (size_t r = 0; r < n; ++r)
+        Basis[j + 1][r] = w[r] / Norm;
+    }
+
+  // The eigenvalues of the leading j x j Hessenberg matrix are the Ritz values.
+  // The row major transposed is the column major Hessenberg matrix.
+  C_INT N = (C_INT) j;
+  CMatrix< C_FLOAT64 > Ht(j, j);
+
+  for (size_t r = 0; r < j; ++r)
+    for (size_t c = 0; c < j; ++c)
+      Ht(c, r) = H(r, c);
+
+  char job = 'E';
+  char compz = 'N';
+  C_INT ilo = 1;
+  C_INT ihi = N;
+  C_INT ldz = 1;
+  C_INT lwork = std::max< C_INT >(1, 11 * N);
+  C_INT info;
+  CVector< C_FLOAT64 > wr(j);
+  CVector< C_FLOAT64 > wi(j);
+  CVector< C_FLOAT64 > work(lwork);
+
+  dhseqr_(&job, &compz, &N, &ilo, &ihi, Ht.array(), &N, wr.array(), wi.array(),
+          NULL, &ldz, work.array(), &lwork, &info);
+
+  if (info != 0) return;
+
+  for (size_t i = 0; i < j; ++i)
+    ritzValues.push_back(std::complex< C_FLOAT64 >(wr[i], wi[i]));
+}
+
+// static
+void CLNAMethod::compressFactor(CMatrix< C_FLOAT64 > & Z)
+{
+  // The row major n x m matrix Z is the column major m x n matrix Z^T = U * S * V^T.
+  // Thus Z * Z^T = V * S^2 * V^T and the compressed factor is V * S.
+  C_INT m = (C_INT) Z.numCols();
+  C_INT n = (C_INT) Z.numRows();
+  C_INT Min = std::min(m, n);
+
+  if (Min == 0) return;
+
+  char jobu = 'N';
+  char jobvt = 'S';
+  C_INT ldu = 1;
+  C_INT lwork = -1;
+  C_INT info;
+  CVector< C_FLOAT64 > S(Min);
+
+  // The column major Min x n matrix V^T is the row major n x Min matrix V.
+  CMatrix< C_FLOAT64 > V(n, Min);
+  CVector< C_FLOAT64 > work(1);
+
+  // dgesvd destroys its input, thus Z must remain intact in case of failure.
+  CMatrix< C_FLOAT64 > A = Z;
+
+  // LWORK workspace query
+  dgesvd_(&jobu, &jobvt, &m, &n, A.array(), &m, S.array(), NULL, &ldu,
+          V.array(), &Min, work.array(), &lwork, &info);
+
+  lwork = (C_INT) work[0];
+  work.resize(lwork);
+
+  dgesvd_(&jobu, &jobvt, &m, &n, A.array(), &m, S.array(), NULL, &ldu,
+          V.array(), &Min, work.array(), &lwork, &info);
+
+  if (info != 0) return;
+
+  // Singular values below this threshold do not contribute to Z * Z^T in double precision.
+  C_FLOAT64 Threshold = sqrt(std::numeric_limits< C_FLOAT64 >::epsilon()) * S[0];
+  size_t Rank = 0;
+
+  while (Rank < (size_t) Min && S[Rank] > Threshold)
+    ++Rank;
+
+  Z.resize(n, Rank);
+
+  for (size_t i = 0; i < (size_t) n; ++i)
+    for (size_t l = 0; l < Rank; ++l)
+      Z(i, l) = V(i, l) * S[l];
+}
+
+bool CLNAMethod::materializeMatrices()
+{
+  size_t numIndependentMetabs = mpContainer->getCountIndependentSpecies();
+  size_t numDependentMetabs = mpContainer->getCountDependentSpecies();
+  size_t numReactionMetabs = numIndependentMetabs + numDependentMetabs;
+
+  if (mBFactorReduced.numRows() != numIndependentMetabs ||
+      mCovarianceFactorReduced.numRows() != numIndependentMetabs)
+    return false;
+
+  const CModel & Model = mpContainer->getModel();
+
+  // B = G * G^T and C = Z * Z^T
+  mBMatrixReduced.resize(numIndependentMetabs, numIndependentMetabs);
+  mBMatrixReduced = 0.0;
+  mBMatrixReducedAnn->resize();
+  mBMatrixReducedAnn->setCopasiVector(0, Model.getMetabolitesX());
+  mBMatrixReducedAnn->setCopasiVector(1, Model.getMetabolitesX());
+
+  mCovarianceMatrixReduced.resize(numIndependentMetabs, numIndependentMetabs);
+  mCovarianceMatrixReduced = 0.0;
+  mCovarianceMatrixReducedAnn->resize();
+  mCovarianceMatrixReducedAnn->setCopasiVector(0, Model.getMetabolitesX());
+  mCovarianceMatrixReducedAnn->setCopasiVector(1, Model.getMetabolitesX());
+
+  // The row major factor Z (n x k) is the column major matrix Z^T, i.e., the column major
+  // product (Z^T)^T * Z^T is the symmetric matrix Z * Z^T.
+  char transa = 'T';
+  char transb = 'N';
+  C_FLOAT64 alpha = 1.0;
+  C_FLOAT64 beta = 0.0;
+  C_INT n = (C_INT) numIndependentMetabs;
+  C_INT k = (C_INT) mBFactorReduced.numCols();
+
+  if (n > 0 && k > 0)
+    dgemm_(&transa, &transb, &n, &n, &k, &alpha,
+           mBFactorReduced.array(), &k,
+           mBFactorReduced.array(), &k,
+           &beta, mBMatrixReduced.array(), &n);
+
+  k = (C_INT) mCovarianceFactorReduced.numCols();
+
+  if (n > 0 && k > 0)
+    dgemm_(&transa, &transb, &n, &n, &k, &alpha,
+           mCovarianceFactorReduced.array(), &k,
+           mCovarianceFactorReduced.array(), &k,
+           &beta, mCovarianceMatrixReduced.array(), &n);
+
+  // The covariance matrix of the full system is (L * Z) * (L * Z)^T, with L the link matrix
+  // consisting of the identity and the link matrix L0 for the dependent species.
+  mCovarianceMatrix.resize(numReactionMetabs, numReactionMetabs);
+  mCovarianceMatrix = 0.0;
+  mCovarianceMatrixAnn->resize();
+  mCovarianceMatrixAnn->setCopasiVector(0, Model.getMetabolitesX());
+  mCovarianceMatrixAnn->setCopasiVector(1, Model.getMetabolitesX());
+
+  if (n == 0 || k == 0)
+    return true;
+
+  CMatrix< C_FLOAT64 > LZ(numReactionMetabs, (size_t) k);
+  memcpy(LZ.array(), mCovarianceFactorReduced.array(), sizeof(C_FLOAT64) * mCovarianceFactorReduced.size());
+
+  C_INT d = (C_INT) numDependentMetabs;
+
+  if (d > 0)
+    {
+      // The row major product L0 * Z is the column major product Z^T * L0^T
+      const CLinkMatrix & L0 = mpContainer->getModel().getL0();
+
+      transa = 'N';
+      transb = 'N';
+
+      dgemm_(&transa, &transb, &k, &d, &n, &alpha,
+             mCovarianceFactorReduced.array(), &k,
+             const_cast< C_FLOAT64 * >(L0.array()), &n,
+             &beta, LZ[numIndependentMetabs], &k);
+    }
+
+  transa = 'T';
+  transb = 'N';
+  C_INT N = (C_INT) numReactionMetabs;
+
+  dgemm_(&transa, &transb, &N, &N, &k, &alpha,
+         LZ.array(), &k,
+         LZ.array(), &k,
+         &beta, mCovarianceMatrix.array(), &N);
+
+  return true;
+}
+
 /**
  * Re-calculate covariances for the full system
  */
@@ -595,12 +1194,17 @@ int CLNAMethod::CalculateLNA()
     {
       if (calculateCovarianceMatrixReduced() == LNA_OK)
         {
-          calculateCovarianceMatrixFull();
+          if (mLyapunovSolver == eLyapunovSolver::BartelsStewart)
+            calculateCovarianceMatrixFull();
+          else if (mMaterializeMatrices)
+            materializeMatrices();
+
           return LNA_OK;
         }
     }
 
   // something went wrong
+  mCovarianceFactorReduced.resize(mpContainer->getCountIndependentSpecies(), 0);
   mBMatrixReduced = std::numeric_limits< C_FLOAT64 >::quiet_NaN();
   mCovarianceMatrixReduced = std::numeric_limits< C_FLOAT64 >::quiet_NaN();
   mCovarianceMatrix = std::numeric_limits< C_FLOAT64 >::quiet_NaN();
@@ -624,6 +1228,8 @@ C_INT32 CLNAMethod::load(CReadConfig & C_UNUSED(configBuffer))
 
 bool CLNAMethod::process()
 {
+  readSolverParameters();
+
   return (CalculateLNA() == LNA_OK);
   // maybe, introduce additional checks here later
 }
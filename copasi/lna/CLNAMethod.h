@@ -17,6 +17,7 @@
 #define COPASI_CLNAMethod_H__
 
 #include <vector>
+#include <complex>
 
 #include "copasi/core/CMatrix.h"
 #include "copasi/utilities/CCopasiMethod.h"
@@ -27,6 +28,7 @@
 #define LNA_NOT_OK 1
 
 class CModel;
+class CSparseLU;
 
 class CLNAMethod: public CCopasiMethod
 {
@@ -37,6 +39,21 @@ public:
     nonNegEigenvaluesExist
   };
 
+  /**
+   * The solvers for the Lyapunov equation A * C + C * A^T + B = 0:
+   *   BartelsStewart: dense Schur decomposition, O(N^3) time and O(N^2) memory.
+   *   LowRankADI: low-rank ADI iteration with the sparse Jacobian and the factor B = G * G^T,
+   *               which returns the covariance in factored form C = Z * Z^T.
+   */
+  enum struct eLyapunovSolver
+  {
+    BartelsStewart,
+    LowRankADI,
+    __SIZE
+  };
+
+  static const CEnumAnnotation< std::string, eLyapunovSolver > LyapunovSolver;
+
 private:
   /**
    * LNA Matrices
@@ -56,6 +73,18 @@ private:
   // Link matrix that links the dependent and the reduced system
   CMatrix<C_FLOAT64> mL;
 
+  // The factor G of the B matrix (reduced) B = G * G^T with one column per reaction
+  CMatrix<C_FLOAT64> mBFactorReduced;
+
+  // The factor Z of the covariance matrix (reduced) C = Z * Z^T
+  CMatrix<C_FLOAT64> mCovarianceFactorReduced;
+
+  // The solver for the Lyapunov equation
+  eLyapunovSolver mLyapunovSolver;
+
+  // Indicates whether the low-rank solver fills the dense matrices
+  bool mMaterializeMatrices;
+
   C_FLOAT64 mSteadyStateResolution;
 
   CSteadyStateMethod::ReturnCode mSSStatus;
@@ -119,6 +148,13 @@ public:
   const CDataArray* getCovarianceMatrixReducedAnn() const
   {return mCovarianceMatrixReducedAnn;}
 
+  /**
+   * Retrieve the factor Z of the covariance matrix (reduced) C = Z * Z^T
+   * calculated by the low-rank solver.
+   */
+  const CMatrix<C_FLOAT64> & getCovarianceFactorReduced() const
+  {return mCovarianceFactorReduced;}
+
   // remove the following, or change scaled versions to
   // fano factors, coefficient of variations etc.
   const CDataArray* getScaledBMatrixReducedAnn() const
@@ -143,6 +179,13 @@ public:
 
   void calculateCovarianceMatrixFull();
 
+  /**
+   * Fill the dense B matrix (reduced) and covariance matrices, i.e., the annotated
+   * arrays, from the factors calculated by the low-rank solver.
+   * @return bool success
+   */
+  bool materializeMatrices();
+
   /**
    * Resizes all result matrices and updates the corresponding
    * array annotations.
@@ -193,5 +236,53 @@ private:
    * Intialize the method parameter
    */
   void initializeParameter();
+
+  /**
+   * Read the solver parameters into the attributes
+   */
+  void readSolverParameters();
+
+  /**
+   * Calculate the factor G of the B matrix (reduced)
+   */
+  void calculateBFactorReduced();
+
+  /**
+   * Solve the Lyapunov equation with the low-rank ADI iteration and store the
+   * factor of the covariance matrix (reduced).
+   * @return int status
+   */
+  int calculateCovarianceFactorReduced();
+
+  /**
+   * Determine real ADI shifts with Penzl's heuristic from the Ritz values of A and A^-1.
+   * @param const CMatrix< C_FLOAT64 > & A
+   * @param CSparseLU & LU (analyzed for the structure of A)
+   * @param std::vector< C_FLOAT64 > & shifts
+   * @return bool success
+   */
+  bool calculateADIShifts(const CMatrix< C_FLOAT64 > & A,
+                          CSparseLU & LU,
+                          std::vector< C_FLOAT64 > & shifts) const;
+
+  /**
+   * Calculate the Ritz values of A, or of A^-1 if the factorization is given,
+   * with the Arnoldi process.
+   * @param const CMatrix< C_FLOAT64 > & A
+   * @param const CSparseLU * pInverse
+   * @param const size_t & steps
+   * @param std::vector< std::complex< C_FLOAT64 > > & ritzValues
+   */
+  void calculateRitzValues(const CMatrix< C_FLOAT64 > & A,
+                           const CSparseLU * pInverse,
+                           const size_t & steps,
+                           std::vector< std::complex< C_FLOAT64 > > & ritzValues) const;
+
+  /**
+   * Compress the columns of the factor Z with a truncated singular value decomposition
+   * such that Z * Z^T is preserved. Z is not changed if the decomposition fails.
+   * @param CMatrix< C_FLOAT64 > & Z
+   */
+  static void compressFactor(CMatrix< C_FLOAT64 > & Z);
 };
 #endif // COPASI_CLNAMethod_H__
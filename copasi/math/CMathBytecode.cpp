@@ -0,0 +1,310 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#include <map>
+
+#include "copasi/copasi.h"
+
+#include "copasi/math/CMathBytecode.h"
+
+#include "copasi/function/CEvaluationNode.h"
+
+namespace
+{
+struct sOperand
+{
+  const C_FLOAT64 * pValue;
+  bool isConstant;
+};
+}
+
+CMathBytecode::CMathBytecode():
+  mValid(false),
+  mInstructions(),
+  mpInstructions(NULL),
+  mpInstructionsEnd(NULL),
+  mRegisters(),
+  mConstants(),
+  mpResult(NULL),
+  mInvalidResult(std::numeric_limits< C_FLOAT64 >::quiet_NaN())
+{
+  mpResult = &mInvalidResult;
+}
+
+CMathBytecode::~CMathBytecode()
+{}
+
+void CMathBytecode::clear()
+{
+  mValid = false;
+  mInstructions.clear();
+  mpInstructions = NULL;
+  mpInstructionsEnd = NULL;
+  mRegisters.resize(0);
+  mConstants.resize(0);
+  mpResult = &mInvalidResult;
+}
+
+const bool & CMathBytecode::isValid() const
+{
+  return mValid;
+}
+
+size_t CMathBytecode::size() const
+{
+  return mInstructions.size();
+}
+
+bool CMathBytecode::compile(const CEvaluationNode * pRootNode,
+                            const CVectorCore< CEvaluationNode * > & calculationSequence)
+{
+  clear();
+
+  if (pRootNode == NULL)
+    return false;
+
+  // Each node of the sequence needs at most one register or constant. The storage must not be
+  // reallocated since the instructions refer to it.
+  mRegisters.resize(calculationSequence.size());
+  mRegisters = std::numeric_limits< C_FLOAT64 >::quiet_NaN();
+  mConstants.resize(calculationSequence.size());
+  mConstants = std::numeric_limits< C_FLOAT64 >::quiet_NaN();
+
+  C_FLOAT64 * pRegister = mRegisters.array();
+  C_FLOAT64 * pConstant = mConstants.array();
+
+  std::map< const CEvaluationNode *, sOperand > Operands;
+  std::vector< sOperand > Arguments;
+
+  CEvaluationNode * const * ppNode = calculationSequence.array();
+  CEvaluationNode * const * ppNodeEnd = ppNode + calculationSequence.size();
+
+  for (; ppNode != ppNodeEnd; ++ppNode)
+    {
+      const CEvaluationNode * pNode = *ppNode;
+
+      // Determine the operands, nodes not in the calculation sequence are leaves which provide their value.
+      Arguments.clear();
+      bool Constant = true;
+
+      const CEvaluationNode * pChild = static_cast< const CEvaluationNode * >(pNode->getChild());
+
+      for (; pChild != NULL; pChild = static_cast< const CEvaluationNode * >(pChild->getSibling()))
+        {
+          std::map< const CEvaluationNode *, sOperand >::const_iterator found = Operands.find(pChild);
+          sOperand Operand;
+
+          if (found != Operands.end())
+            {
+              Operand = found->second;
+            }
+          else
+            {
+              Operand.pValue = pChild->getValuePointer();
+              Operand.isConstant = (pChild->mainType() == CEvaluationNode::MainType::NUMBER ||
+                                    pChild->mainType() == CEvaluationNode::MainType::CONSTANT);
+            }
+
+          Constant &= Operand.isConstant;
+          Arguments.push_back(Operand);
+        }
+
+      sInstruction Instruction;
+      Instruction.pResult = NULL;
+      Instruction.pArg1 = Arguments.size() > 0 ? Arguments[0].pValue : NULL;
+      Instruction.pArg2 = Arguments.size() > 1 ? Arguments[1].pValue : NULL;
+      Instruction.pArg3 = Arguments.size() > 2 ? Arguments[2].pValue : NULL;
+      Instruction.pFunction1 = NULL;
+      Instruction.pFunction2 = NULL;
+
+      size_t RequiredArguments = 2;
+      bool Valid = true;
+
+      switch (pNode->mainType())
+        {
+          case CEvaluationNode::MainType::OPERATOR:
+            switch (pNode->subType())
+              {
+                case CEvaluationNode::SubType::PLUS:
+                  Instruction.opCode = OpCode::PLUS;
+                  break;
+
+                case CEvaluationNode::SubType::MINUS:
+                  Instruction.opCode = OpCode::MINUS;
+                  break;
+
+                case CEvaluationNode::SubType::MULTIPLY:
+                  Instruction.opCode = OpCode::MULTIPLY;
+                  break;
+
+                case CEvaluationNode::SubType::DIVIDE:
+                  Instruction.opCode = OpCode::DIVIDE;
+                  break;
+
+                case CEvaluationNode::SubType::POWER:
+                  Instruction.opCode = OpCode::POWER;
+                  break;
+
+                case CEvaluationNode::SubType::MODULUS:
+                  Instruction.opCode = OpCode::MODULUS;
+                  break;
+
+                case CEvaluationNode::SubType::REMAINDER:
+                  Instruction.opCode = OpCode::REMAINDER;
+                  break;
+
+                default:
+                  Valid = false;
+                  break;
+              }
+
+            break;
+
+          case CEvaluationNode::MainType::FUNCTION:
+          {
+            const CEvaluationNodeFunction * pFunction = static_cast< const CEvaluationNodeFunction * >(pNode);
+
+            if (pFunction->getFunction1() != NULL)
+              {
+                Instruction.opCode = OpCode::FUNCTION1;
+                Instruction.pFunction1 = pFunction->getFunction1();
+                RequiredArguments = 1;
+              }
+            else if (pFunction->getFunction2() != NULL)
+              {
+                Instruction.opCode = OpCode::FUNCTION2;
+                Instruction.pFunction2 = pFunction->getFunction2();
+              }
+            else
+              {
+                Valid = false;
+              }
+
+            // Random numbers must be drawn for each evaluation.
+            switch (pNode->subType())
+              {
+                case CEvaluationNode::SubType::RUNIFORM:
+                case CEvaluationNode::SubType::RNORMAL:
+                case CEvaluationNode::SubType::RPOISSON:
+                case CEvaluationNode::SubType::RGAMMA:
+                  Constant = false;
+                  break;
+
+                default:
+                  break;
+              }
+          }
+          break;
+
+          case CEvaluationNode::MainType::CHOICE:
+            Instruction.opCode = OpCode::CHOICE;
+            RequiredArguments = 3;
+
+            // A constant condition selects the branch during compile. The instructions of both
+            // branches are still executed to assure that random numbers are drawn as by the tree.
+            if (Arguments.size() == 3 &&
+                Arguments[0].isConstant)
+              {
+                Operands[pNode] = (*Arguments[0].pValue > 0.5) ? Arguments[1] : Arguments[2];
+                continue;
+              }
+
+            break;
+
+          case CEvaluationNode::MainType::LOGICAL:
+            switch (pNode->subType())
+              {
+                case CEvaluationNode::SubType::OR:
+                  Instruction.opCode = OpCode::OR;
+                  break;
+
+                case CEvaluationNode::SubType::XOR:
+                  Instruction.opCode = OpCode::XOR;
+                  break;
+
+                case CEvaluationNode::SubType::AND:
+                  Instruction.opCode = OpCode::AND;
+                  break;
+
+                case CEvaluationNode::SubType::EQ:
+                  Instruction.opCode = OpCode::EQ;
+                  break;
+
+                case CEvaluationNode::SubType::NE:
+                  Instruction.opCode = OpCode::NE;
+                  break;
+
+                case CEvaluationNode::SubType::GT:
+                  Instruction.opCode = OpCode::GT;
+                  break;
+
+                case CEvaluationNode::SubType::GE:
+                  Instruction.opCode = OpCode::GE;
+                  break;
+
+                case CEvaluationNode::SubType::LT:
+                  Instruction.opCode = OpCode::LT;
+                  break;
+
+                case CEvaluationNode::SubType::LE:
+                  Instruction.opCode = OpCode::LE;
+                  break;
+
+                default:
+                  Valid = false;
+                  break;
+              }
+
+            break;
+
+          default:
+            // Delays, calls, vectors, and other nodes are not supported.
+            Valid = false;
+            break;
+        }
+
+      if (!Valid ||
+          Arguments.size() != RequiredArguments)
+        {
+          clear();
+          return false;
+        }
+
+      sOperand Result;
+      Result.isConstant = Constant;
+
+      if (Constant)
+        {
+          // Constant folding
+          Instruction.pResult = pConstant++;
+          execute(Instruction);
+        }
+      else
+        {
+          Instruction.pResult = pRegister++;
+          mInstructions.push_back(Instruction);
+        }
+
+      Result.pValue = Instruction.pResult;
+      Operands[pNode] = Result;
+    }
+
+  std::map< const CEvaluationNode *, sOperand >::const_iterator found = Operands.find(pRootNode);
+
+  if (found != Operands.end())
+    {
+      mpResult = found->second.pValue;
+    }
+  else
+    {
+      mpResult = pRootNode->getValuePointer();
+    }
+
+  mpInstructions = mInstructions.empty() ? NULL : &mInstructions[0];
+  mpInstructionsEnd = mpInstructions + mInstructions.size();
+  mValid = true;
+
+  return mValid;
+}
@@ -0,0 +1,263 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#ifndef COPASI_CMathBytecode
+#define COPASI_CMathBytecode
+
+#include <vector>
+#include <cmath>
+#include <limits>
+
+#include "copasi/core/CVector.h"
+#include "copasi/function/CEvaluationNodeFunction.h"
+
+class CEvaluationNode;
+
+/**
+ * The bytecode is a flat array of instructions lowered from the calculation sequence of an
+ * evaluation tree. The operands are direct pointers to the values of the objects, to constants, or to
+ * registers holding intermediate results. Operations with constant operands are folded during compile.
+ * The calculations performed are identical to the ones of the nodes, i.e., the result is
+ * bit-identical to CEvaluationTree::calculate.
+ */
+class CMathBytecode
+{
+public:
+  enum struct OpCode
+  {
+    PLUS,
+    MINUS,
+    MULTIPLY,
+    DIVIDE,
+    POWER,
+    MODULUS,
+    REMAINDER,
+    FUNCTION1,
+    FUNCTION2,
+    CHOICE,
+    OR,
+    XOR,
+    AND,
+    EQ,
+    NE,
+    GT,
+    GE,
+    LT,
+    LE
+  };
+
+  struct sInstruction
+  {
+    OpCode opCode;
+    C_FLOAT64 * pResult;
+    const C_FLOAT64 * pArg1;
+    const C_FLOAT64 * pArg2;
+    const C_FLOAT64 * pArg3;
+    CEvaluationNodeFunction::Function1 pFunction1;
+    CEvaluationNodeFunction::Function2 pFunction2;
+  };
+
+private:
+  /**
+   * Hidden copy constructor
+   */
+  CMathBytecode(const CMathBytecode & src);
+
+  /**
+   * Hidden assignment operator
+   */
+  CMathBytecode & operator = (const CMathBytecode & rhs);
+
+public:
+  /**
+   * Default constructor
+   */
+  CMathBytecode();
+
+  /**
+   * Destructor
+   */
+  ~CMathBytecode();
+
+  /**
+   * Compile the bytecode for the calculation sequence of a tree. If the tree contains
+   * nodes which are not supported the bytecode is invalid.
+   * @param const CEvaluationNode * pRootNode
+   * @param const CVectorCore< CEvaluationNode * > & calculationSequence
+   * @return bool isValid
+   */
+  bool compile(const CEvaluationNode * pRootNode,
+               const CVectorCore< CEvaluationNode * > & calculationSequence);
+
+  /**
+   * Clear the bytecode.
+   */
+  void clear();
+
+  /**
+   * Check whether the bytecode is valid.
+   * @return const bool & isValid
+   */
+  const bool & isValid() const;
+
+  /**
+   * Execute the bytecode
+   * @return const C_FLOAT64 & value
+   */
+  inline const C_FLOAT64 & calculate()
+  {
+    const sInstruction * pInstruction = mpInstructions;
+    const sInstruction * pEnd = mpInstructionsEnd;
+
+    for (; pInstruction != pEnd; ++pInstruction)
+      {
+        execute(*pInstruction);
+      }
+
+    return *mpResult;
+  }
+
+  /**
+   * Retrieve the number of instructions
+   * @return size_t size
+   */
+  size_t size() const;
+
+private:
+  /**
+   * Execute a single instruction
+   * @param const sInstruction & instruction
+   */
+  static inline void execute(const sInstruction & instruction)
+  {
+    switch (instruction.opCode)
+      {
+        case OpCode::PLUS:
+          *instruction.pResult = *instruction.pArg1 + *instruction.pArg2;
+          break;
+
+        case OpCode::MINUS:
+          *instruction.pResult = *instruction.pArg1 - *instruction.pArg2;
+          break;
+
+        case OpCode::MULTIPLY:
+          *instruction.pResult = *instruction.pArg1 **instruction.pArg2;
+          break;
+
+        case OpCode::DIVIDE:
+          *instruction.pResult = *instruction.pArg1 / *instruction.pArg2;
+          break;
+
+        case OpCode::POWER:
+          *instruction.pResult = pow(*instruction.pArg1, *instruction.pArg2);
+          break;
+
+        case OpCode::MODULUS:
+          if ((C_INT32) *instruction.pArg2 == 0)
+            *instruction.pResult = std::numeric_limits< C_FLOAT64 >::quiet_NaN();
+          else
+            *instruction.pResult = (C_FLOAT64)(((C_INT32) * instruction.pArg1) % ((C_INT32) * instruction.pArg2));
+
+          break;
+
+        case OpCode::REMAINDER:
+          *instruction.pResult = fmod(*instruction.pArg1, *instruction.pArg2);
+          break;
+
+        case OpCode::FUNCTION1:
+          *instruction.pResult = (*instruction.pFunction1)(*instruction.pArg1);
+          break;
+
+        case OpCode::FUNCTION2:
+          *instruction.pResult = (*instruction.pFunction2)(*instruction.pArg1, *instruction.pArg2);
+          break;
+
+        case OpCode::CHOICE:
+          *instruction.pResult = (*instruction.pArg1 > 0.5) ? *instruction.pArg2 : *instruction.pArg3;
+          break;
+
+        case OpCode::OR:
+          *instruction.pResult = (*instruction.pArg1 > 0.5 ||
+                                  *instruction.pArg2 > 0.5) ? 1.0 : 0.0;
+          break;
+
+        case OpCode::XOR:
+          *instruction.pResult = ((*instruction.pArg1 > 0.5 && *instruction.pArg2 < 0.5) ||
+                                  (*instruction.pArg1 < 0.5 && *instruction.pArg2 > 0.5)) ? 1.0 : 0.0;
+          break;
+
+        case OpCode::AND:
+          *instruction.pResult = (*instruction.pArg1 > 0.5 &&
+                                  *instruction.pArg2 > 0.5) ? 1.0 : 0.0;
+          break;
+
+        case OpCode::EQ:
+          *instruction.pResult = (*instruction.pArg1 == *instruction.pArg2) ? 1.0 : 0.0;
+          break;
+
+        case OpCode::NE:
+          *instruction.pResult = (*instruction.pArg1 != *instruction.pArg2) ? 1.0 : 0.0;
+          break;
+
+        case OpCode::GT:
+          *instruction.pResult = (*instruction.pArg1 > *instruction.pArg2) ? 1.0 : 0.0;
+          break;
+
+        case OpCode::GE:
+          *instruction.pResult = (*instruction.pArg1 >= *instruction.pArg2) ? 1.0 : 0.0;
+          break;
+
+        case OpCode::LT:
+          *instruction.pResult = (*instruction.pArg1 < *instruction.pArg2) ? 1.0 : 0.0;
+          break;
+
+        case OpCode::LE:
+          *instruction.pResult = (*instruction.pArg1 <= *instruction.pArg2) ? 1.0 : 0.0;
+          break;
+      }
+  }
+
+  /**
+   * Indicates whether the bytecode is valid
+   */
+  bool mValid;
+
+  /**
+   * The instructions
+   */
+  std::vector< sInstruction > mInstructions;
+
+  /**
+   * Pointer to the first instruction
+   */
+  const sInstruction * mpInstructions;
+
+  /**
+   * Pointer past the last instruction
+   */
+  const sInstruction * mpInstructionsEnd;
+
+  /**
+   * The registers holding intermediate results
+   */
+  CVector< C_FLOAT64 > mRegisters;
+
+  /**
+   * The constants created by folding
+   */
+  CVector< C_FLOAT64 > mConstants;
+
+  /**
+   * Pointer to the result
+   */
+  const C_FLOAT64 * mpResult;
+
+  /**
+   * Storage for the result of an invalid or empty bytecode
+   */
+  C_FLOAT64 mInvalidResult;
+};
+
+#endif // COPASI_CMathBytecode
@@ -13,12 +13,16 @@
 // of Manchester.
 // All rights reserved.
 
+#include <algorithm>
+#include <functional>
+
 #include "copasi/copasi.h"
 
 #include "CMathContainer.h"
 #include "CMathExpression.h"
 #include "CMathEventQueue.h"
 #include "CMathUpdateSequence.h"
+#include "CMathNativeCode.h"
 
 #include "copasi/model/CModel.h"
 #include "copasi/model/CCompartment.h"
@@ -302,7 +306,14 @@ CMathContainer::CMathContainer():
   mNoiseInputObjects(),
   mUpdateSequences(),
   mNumTotalRootsIgnored(0),
-  mValueChangeProhibited()
+  mValueChangeProhibited(),
+  mUseJacobianColoring(true),
+  mJacobianColumnColors(),
+  mJacobianColumnColorsReduced(),
+  mJacobianColoring(),
+  mJacobianColoringReduced(),
+  mUseNativeCode(false),
+  mpNativeCode(NULL)
 {
   memset(&mSize, 0, sizeof(mSize));
 }
@@ -400,7 +411,14 @@ CMathContainer::CMathContainer(CModel & model):
   mNoiseInputObjects(),
   mUpdateSequences(),
   mNumTotalRootsIgnored(0),
-  mValueChangeProhibited()
+  mValueChangeProhibited(),
+  mUseJacobianColoring(true),
+  mJacobianColumnColors(),
+  mJacobianColumnColorsReduced(),
+  mJacobianColoring(),
+  mJacobianColoringReduced(),
+  mUseNativeCode(false),
+  mpNativeCode(NULL)
 {
   memset(&mSize, 0, sizeof(mSize));
 
@@ -420,7 +438,7 @@ CMathContainer::CMathContainer(const CMathContainer & src):
   mpModel(src.mpModel),
   mpAvogadro(src.mpAvogadro),
   mpQuantity2NumberFactor(src.mpQuantity2NumberFactor),
-  mRandom(src.mRandom, this),
+  mRandom("Random", this, InvalidValue),
   mpProcessQueue(new CMathEventQueue(*this)),
   mpRandomGenerator(CRandom::createGenerator()),
   mValues(),
@@ -456,117 +474,89 @@ CMathContainer::CMathContainer(const CMathContainer & src):
   mDiscontinuous(),
   mDelayValues(),
   mDelayLags(),
+  mTransitionTimes(),
   mInitialState(),
   mCompleteInitialState(),
   mState(),
   mStateReduced(),
-  mHistory(src.mHistory),
+  mHistory(),
   mHistoryReduced(),
   mRate(),
   mRateReduced(),
   mNoiseReduced(),
-  mInitialDependencies(src.mInitialDependencies, this),
-  mTransientDependencies(src.mTransientDependencies, this),
-  mSynchronizeInitialValuesSequenceExtensive(src.mSynchronizeInitialValuesSequenceExtensive),
-  mSynchronizeInitialValuesSequenceIntensive(src.mSynchronizeInitialValuesSequenceIntensive),
-  mApplyInitialValuesSequence(src.mApplyInitialValuesSequence),
-  mSimulationValuesSequence(src.mSimulationValuesSequence),
-  mSimulationValuesSequenceReduced(src.mSimulationValuesSequenceReduced),
-  mRootSequence(src.mRootSequence),
-  mRootSequenceReduced(src.mRootSequenceReduced),
-  mNoiseSequence(src.mNoiseSequence),
-  mNoiseSequenceReduced(src.mNoiseSequenceReduced),
-  mPrioritySequence(src.mPrioritySequence),
-  mTransientDataObjectSequence(src.mTransientDataObjectSequence),
-  mInitialStateValueExtensive(src.mInitialStateValueExtensive),
-  mInitialStateValueIntensive(src.mInitialStateValueIntensive),
-  mInitialStateValueAll(src.mInitialStateValueAll),
-  mStateValues(src.mStateValues),
-  mReducedStateValues(src.mReducedStateValues),
-  mSimulationRequiredValues(src.mSimulationRequiredValues),
+  mInitialDependencies(this),
+  mTransientDependencies(this),
+  mSynchronizeInitialValuesSequenceExtensive(),
+  mSynchronizeInitialValuesSequenceIntensive(),
+  mApplyInitialValuesSequence(),
+  mSimulationValuesSequence(),
+  mSimulationValuesSequenceReduced(),
+  mRootSequence(),
+  mRootSequenceReduced(),
+  mNoiseSequence(),
+  mNoiseSequenceReduced(),
+  mPrioritySequence(),
+  mTransientDataObjectSequence(),
+  mInitialStateValueExtensive(),
+  mInitialStateValueIntensive(),
+  mInitialStateValueAll(),
+  mStateValues(),
+  mReducedStateValues(),
+  mSimulationRequiredValues(),
   mObjects(),
   mOldObjects(),
   mpObjectsBuffer(NULL),
   mEvents(),
   mReactions(),
-  mRootIsDiscrete(src.mRootIsDiscrete),
-  mRootIsTimeDependent(src.mRootIsTimeDependent),
-  mRootProcessors(src.mRootProcessors),
-  mRootDerivativesState(src.mRootDerivativesState),
-  mRootDerivatives(src.mRootDerivatives),
-  mDataObject2MathObject(src.mDataObject2MathObject),
-  mDataValue2MathObject(src.mDataValue2MathObject),
+  mRootIsDiscrete(),
+  mRootIsTimeDependent(),
+  mRootProcessors(),
+  mRootDerivativesState(),
+  mRootDerivatives(),
+  mDataObject2MathObject(),
+  mDataValue2MathObject(),
   mDataValue2DataObject(src.mDataValue2DataObject),
   mDiscontinuityEvents("Discontinuities", this),
   mDiscontinuityInfix2Object(),
   mTriggerInfix2Event(),
   mRootCount2Events(),
   mDelays(),
-  mIsAutonomous(src.mIsAutonomous),
+  mIsAutonomous(true),
   mSize(),
-  mNoiseInputObjects(src.mNoiseInputObjects),
+  mNoiseInputObjects(),
   mUpdateSequences(),
-  mNumTotalRootsIgnored(src.mNumTotalRootsIgnored),
-  mValueChangeProhibited(src.mValueChangeProhibited)
+  mNumTotalRootsIgnored(0),
+  mValueChangeProhibited(),
+  mUseJacobianColoring(src.mUseJacobianColoring),
+  mJacobianColumnColors(),
+  mJacobianColumnColorsReduced(),
+  mJacobianColoring(),
+  mJacobianColoringReduced(),
+  mUseNativeCode(src.mUseNativeCode),
+  mpNativeCode(NULL)
 {
+  memset(&mSize, 0, sizeof(mSize));
+
   // We do not want the model to know about the math container therefore we
   // do not use &model in the constructor of CDataContainer
   setObjectParent(mpModel);
 
-  memset(&mSize, 0, sizeof(mSize));
-  sSize size = src.mSize;
-
-  std::vector< CMath::sRelocate > Relocations = resize(size);
-
-  mValues = src.mValues;
-
-  // Copy the objects
-  CMathObject * pObject = mObjects.array();
-  CMathObject * pObjectEnd = pObject + mObjects.size();
-  const CMathObject * pObjectSrc = src.mObjects.array();
-
-  for (; pObject != pObjectEnd; ++pObject, ++pObjectSrc)
-    {
-      pObject->copy(*pObjectSrc, *this);
-      pObject->relocate(this, Relocations);
-    }
-
-  CMathEvent * pEvent = mEvents.array();
-  CMathEvent * pEventEnd = pEvent + mEvents.size();
-  const CMathEvent * pEventSrc = src.mEvents.array();
-
-  for (; pEvent != pEventEnd; ++pEvent, ++pEventSrc)
-    {
-      pEvent->copy(*pEventSrc, *this);
-      pEvent->relocate(this, Relocations);
-    }
-
-  CMathReaction * pReaction = mReactions.array();
-  CMathReaction * pReactionEnd = pReaction + mReactions.size();
-  const CMathReaction * pReactionSrc = src.mReactions.array();
+  // The copy is compiled independently from the model. This assures that all objects, events,
+  // delays, dependency graphs, and update sequences refer to the values of the copy, i.e., the
+  // copy can be used concurrently with the source.
+  compile();
 
-  for (; pReaction != pReactionEnd; ++pReaction, ++pReactionSrc)
+  // The layout of the values only depends on the model, i.e., we can copy the current values.
+  if (mValues.size() == src.mValues.size())
     {
-      pReaction->copy(*pReactionSrc, *this);
-      pReaction->relocate(this, Relocations);
+      mValues = src.mValues;
+      mHistory = src.mHistory;
     }
-
-  CMathDelay * pDelay = mDelays.array();
-  CMathDelay * pDelayEnd = pDelay + mDelays.size();
-  const CMathDelay * pDelaySrc = src.mDelays.array();
-
-  for (; pDelay != pDelayEnd; ++pDelay, ++pDelaySrc)
-    {
-      pDelay->copy(*pDelaySrc, *this);
-      pDelay->relocate(this, Relocations);
-    }
-
-  mOldValues.initialize(mValues);
-  mOldObjects.initialize(mObjects);
 }
 
 CMathContainer::~CMathContainer()
 {
+  pdelete(mpNativeCode);
   pdelete(mpProcessQueue);
   pdelete(mpRandomGenerator);
   pdeletev(mpValuesBuffer)
@@ -1008,6 +998,10 @@ void CMathContainer::applyInitialValues()
 
 void CMathContainer::updateSimulatedValues(const bool & useMoieties)
 {
+  if (mUseNativeCode &&
+      applyNativeCode(useMoieties ? 1 : 0))
+    return;
+
   if (useMoieties)
     {
       applyUpdateSequence(mSimulationValuesSequenceReduced);
@@ -1020,6 +1014,10 @@ void CMathContainer::updateSimulatedValues(const bool & useMoieties)
 
 void CMathContainer::updateRootValues(const bool & useMoieties)
 {
+  if (mUseNativeCode &&
+      applyNativeCode(useMoieties ? 3 : 2))
+    return;
+
   if (useMoieties)
     {
       applyUpdateSequence(mRootSequenceReduced);
@@ -1030,6 +1028,43 @@ void CMathContainer::updateRootValues(const bool & useMoieties)
     }
 }
 
+void CMathContainer::setUseNativeCode(const bool & useNativeCode)
+{
+  // The loaded code is kept so that subsequent runs do not recompile it. It is
+  // removed whenever the update sequences or the values change.
+  mUseNativeCode = useNativeCode;
+}
+
+const bool & CMathContainer::getUseNativeCode() const
+{
+  return mUseNativeCode;
+}
+
+bool CMathContainer::applyNativeCode(const size_t & index)
+{
+  if (mpNativeCode == NULL)
+    {
+      // The order determines the index of the sequences.
+      std::vector< const CMathUpdateSequence * > Sequences;
+      Sequences.push_back(&mSimulationValuesSequence);
+      Sequences.push_back(&mSimulationValuesSequenceReduced);
+      Sequences.push_back(&mRootSequence);
+      Sequences.push_back(&mRootSequenceReduced);
+
+      mpNativeCode = new CMathNativeCode();
+      mpNativeCode->compile(mValues, Sequences);
+    }
+
+  CMathNativeCode::Function pFunction = mpNativeCode->getFunction(index);
+
+  if (pFunction == NULL)
+    return false;
+
+  (*pFunction)(mValues.array());
+
+  return true;
+}
+
 void CMathContainer::updateNoiseValues(const bool & useMoieties)
 {
   if (useMoieties)
@@ -1121,13 +1156,7 @@ void CMathContainer::updatePriorityValues()
 
 void CMathContainer::applyUpdateSequence(const CCore::CUpdateSequence & updateSequence)
 {
-  CCore::CUpdateSequence::const_iterator it = updateSequence.begin();
-  CCore::CUpdateSequence::const_iterator end = updateSequence.end();
-
-  for (; it != end; ++it)
-    {
-      (*it)->calculateValue();
-    }
+  updateSequence.apply();
 }
 
 void CMathContainer::fetchInitialState()
@@ -1462,6 +1491,17 @@ void CMathContainer::compile()
   // Create eventual delays
   createDelays();
 
+  // The objects have been recompiled, i.e., frozen update sequences and native code are no longer valid.
+  pdelete(mpNativeCode);
+
+  std::set< CMathUpdateSequence * >::iterator itUpdateSequence = mUpdateSequences.begin();
+  std::set< CMathUpdateSequence * >::iterator endUpdateSequence = mUpdateSequences.end();
+
+  for (; itUpdateSequence != endUpdateSequence; ++itUpdateSequence)
+    {
+      (*itUpdateSequence)->thaw();
+    }
+
   createDependencyGraphs();
   createValueChangeProhibited();
   createUpdateSequences();
@@ -2387,6 +2427,9 @@ void CMathContainer::createValueChangeProhibited()
 
 void CMathContainer::createUpdateSequences()
 {
+  // The native code refers to the previous sequences.
+  pdelete(mpNativeCode);
+
   sanitizeDataValue2DataObject();
   createSynchronizeInitialValuesSequence();
   createApplyInitialValuesSequence();
@@ -2750,6 +2793,12 @@ void CMathContainer::createUpdateSimulationValuesSequence()
       ReducedSimulationRequiredValues.insert(pObject);
     }
 
+  // The Jacobian coloring must be recalculated
+  mJacobianColumnColors.resize(0);
+  mJacobianColumnColorsReduced.resize(0);
+  mJacobianColoring.resize(0, 0);
+  mJacobianColoringReduced.resize(0, 0);
+
   // Build the update sequence
   mTransientDependencies.getUpdateSequence(mSimulationValuesSequence, CCore::SimulationContext::Default, mStateValues, mSimulationRequiredValues);
   mTransientDependencies.getUpdateSequence(mSimulationValuesSequenceReduced, CCore::SimulationContext::UseMoieties, mReducedStateValues, ReducedSimulationRequiredValues);
@@ -3012,6 +3061,204 @@ void CMathContainer::calculateRootJacobian(CMatrix< C_FLOAT64 > & jacobian)
 void CMathContainer::calculateJacobian(CMatrix< C_FLOAT64 > & jacobian,
                                        const C_FLOAT64 & derivationFactor,
                                        const bool & reduced)
+{
+  if (mUseJacobianColoring)
+    {
+      size_t Dim = getState(reduced).size() - mSize.nFixedEventTargets - mSize.nTime;
+      const CMatrix< size_t > & Coloring = reduced ? mJacobianColoringReduced : mJacobianColoring;
+
+      if (Coloring.numCols() != Dim)
+        {
+          compileJacobianColoring(reduced);
+        }
+
+      // The coloring is only used if it reduces the number of evaluations.
+      if (Coloring.numRows() < Dim)
+        {
+          calculateJacobianColored(jacobian, derivationFactor, reduced);
+          return;
+        }
+    }
+
+  calculateJacobianDense(jacobian, derivationFactor, reduced);
+}
+
+void CMathContainer::setUseJacobianColoring(const bool & useJacobianColoring)
+{
+  mUseJacobianColoring = useJacobianColoring;
+}
+
+const bool & CMathContainer::getUseJacobianColoring() const
+{
+  return mUseJacobianColoring;
+}
+
+void CMathContainer::compileJacobianColoring(const bool & reduced)
+{
+  CVector< size_t > & ColumnColors = reduced ? mJacobianColumnColorsReduced : mJacobianColumnColors;
+  CMatrix< size_t > & Coloring = reduced ? mJacobianColoringReduced : mJacobianColoring;
+
+  CMatrix< C_INT32 > Dependencies;
+  calculateJacobianDependencies(Dependencies, reduced);
+
+  size_t Dim = Dependencies.numRows();
+  size_t Row, Col;
+
+  // The rows each column contributes to.
+  std::vector< std::vector< size_t > > ColumnRows(Dim);
+
+  for (Row = 0; Row < Dim; ++Row)
+    for (Col = 0; Col < Dim; ++Col)
+      if (Dependencies(Row, Col) != 0)
+        {
+          ColumnRows[Col].push_back(Row);
+        }
+
+  // We color the columns with largest number of non-zeros first.
+  std::vector< std::pair< size_t, size_t > > Order(Dim);
+
+  for (Col = 0; Col < Dim; ++Col)
+    {
+      Order[Col] = std::make_pair(ColumnRows[Col].size(), Col);
+    }
+
+  std::stable_sort(Order.begin(), Order.end(), std::greater< std::pair< size_t, size_t > >());
+
+  // Greedy coloring: two columns may have the same color if they do not share a row.
+  std::vector< std::vector< size_t > > RowColumnOfColor;
+  ColumnColors.resize(Dim);
+
+  std::vector< std::pair< size_t, size_t > >::const_iterator itOrder = Order.begin();
+  std::vector< std::pair< size_t, size_t > >::const_iterator endOrder = Order.end();
+
+  for (; itOrder != endOrder; ++itOrder)
+    {
+      Col = itOrder->second;
+      const std::vector< size_t > & Rows = ColumnRows[Col];
+      size_t Color = 0;
+
+      for (; Color < RowColumnOfColor.size(); ++Color)
+        {
+          std::vector< size_t >::const_iterator itRow = Rows.begin();
+          std::vector< size_t >::const_iterator endRow = Rows.end();
+
+          for (; itRow != endRow; ++itRow)
+            if (RowColumnOfColor[Color][*itRow] != C_INVALID_INDEX) break;
+
+          if (itRow == endRow) break;
+        }
+
+      if (Color == RowColumnOfColor.size())
+        {
+          RowColumnOfColor.push_back(std::vector< size_t >(Dim, C_INVALID_INDEX));
+        }
+
+      std::vector< size_t >::const_iterator itRow = Rows.begin();
+      std::vector< size_t >::const_iterator endRow = Rows.end();
+
+      for (; itRow != endRow; ++itRow)
+        {
+          RowColumnOfColor[Color][*itRow] = Col;
+        }
+
+      ColumnColors[Col] = Color;
+    }
+
+  Coloring.resize(RowColumnOfColor.size(), Dim);
+
+  for (size_t Color = 0; Color < RowColumnOfColor.size(); ++Color)
+    for (Row = 0; Row < Dim; ++Row)
+      {
+        Coloring(Color, Row) = RowColumnOfColor[Color][Row];
+      }
+}
+
+void CMathContainer::calculateJacobianColored(CMatrix< C_FLOAT64 > & jacobian,
+    const C_FLOAT64 & derivationFactor,
+    const bool & reduced)
+{
+  const CVector< size_t > & ColumnColors = reduced ? mJacobianColumnColorsReduced : mJacobianColumnColors;
+  const CMatrix< size_t > & Coloring = reduced ? mJacobianColoringReduced : mJacobianColoring;
+
+  size_t Dim = Coloring.numCols();
+  jacobian.resize(Dim, Dim);
+  jacobian = 0.0;
+
+  C_FLOAT64 DerivationFactor = std::max(derivationFactor, 100.0 * std::numeric_limits< C_FLOAT64 >::epsilon());
+
+  C_FLOAT64 * pState = mState.array() + mSize.nFixedEventTargets + mSize.nTime;
+  const C_FLOAT64 * pRate = mRate.array() + mSize.nFixedEventTargets + mSize.nTime;
+
+  CVector< C_FLOAT64 > Store(Dim);
+  CVector< C_FLOAT64 > X1(Dim);
+  CVector< C_FLOAT64 > X2(Dim);
+  CVector< C_FLOAT64 > InvDelta(Dim);
+
+  CVector< C_FLOAT64 > Y1(Dim);
+  CVector< C_FLOAT64 > Y2(Dim);
+
+  size_t Col, Row;
+
+  // The perturbations are the same as for the dense calculation.
+  for (Col = 0; Col < Dim; ++Col)
+    {
+      Store[Col] = pState[Col];
+
+      // We only need to make sure that we do not have an underflow problem
+      if (fabs(Store[Col]) < DerivationFactor)
+        {
+          X1[Col] = 0.0;
+
+          if (Store[Col] < 0.0)
+            X2[Col] = -2.0 * DerivationFactor;
+          else
+            X2[Col] = 2.0 * DerivationFactor;
+        }
+      else
+        {
+          X1[Col] = Store[Col] * (1.0 + DerivationFactor);
+          X2[Col] = Store[Col] * (1.0 - DerivationFactor);
+        }
+
+      InvDelta[Col] = 1.0 / (X2[Col] - X1[Col]);
+    }
+
+  for (size_t Color = 0; Color < Coloring.numRows(); ++Color)
+    {
+      for (Col = 0; Col < Dim; ++Col)
+        if (ColumnColors[Col] == Color)
+          pState[Col] = X1[Col];
+
+      updateSimulatedValues(reduced);
+      memcpy(Y1.array(), pRate, Dim * sizeof(C_FLOAT64));
+
+      for (Col = 0; Col < Dim; ++Col)
+        if (ColumnColors[Col] == Color)
+          pState[Col] = X2[Col];
+
+      updateSimulatedValues(reduced);
+      memcpy(Y2.array(), pRate, Dim * sizeof(C_FLOAT64));
+
+      for (Col = 0; Col < Dim; ++Col)
+        if (ColumnColors[Col] == Color)
+          pState[Col] = Store[Col];
+
+      // Each row depends on at most one column of the current color.
+      const size_t * pColumn = Coloring[Color];
+
+      for (Row = 0; Row < Dim; ++Row, ++pColumn)
+        if (*pColumn != C_INVALID_INDEX)
+          {
+            jacobian(Row, *pColumn) = (Y2[Row] - Y1[Row]) * InvDelta[*pColumn];
+          }
+    }
+
+  updateSimulatedValues(reduced);
+}
+
+void CMathContainer::calculateJacobianDense(CMatrix< C_FLOAT64 > & jacobian,
+    const C_FLOAT64 & derivationFactor,
+    const bool & reduced)
 {
   size_t Dim = getState(reduced).size() - mSize.nFixedEventTargets - mSize.nTime;
   jacobian.resize(Dim, Dim);
@@ -5153,6 +5400,9 @@ void CMathContainer::finishResize()
 void CMathContainer::relocate(const sSize & size,
                               const std::vector< CMath::sRelocate > & Relocations)
 {
+  // The native code refers to the old layout of the values.
+  pdelete(mpNativeCode);
+
   size_t nExtensiveValues = size.nFixed + size.nFixedEventTargets + size.nTime + size.nODE + size.nODESpecies + size.nReactionSpecies + size.nAssignment;
 
   // Move the objects to the new location
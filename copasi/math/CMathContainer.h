@@ -38,6 +38,7 @@ class CReaction;
 class CMoiety;
 class CRandom;
 class CMathEventQueue;
+class CMathNativeCode;
 
 template < class CType > class CDataVector;
 
@@ -432,6 +433,35 @@ public:
                          const C_FLOAT64 & derivationFactor,
                          const bool & reduced);
 
+  /**
+   * Set whether the Jacobian is calculated by perturbing structurally independent
+   * columns simultaneously (Curtis-Powell-Reid coloring). The column coloring is
+   * determined once from the Jacobian dependencies. If the coloring does not reduce the
+   * number of required evaluations the dense calculation is used.
+   * @param const bool & useJacobianColoring
+   */
+  void setUseJacobianColoring(const bool & useJacobianColoring);
+
+  /**
+   * Check whether the Jacobian is calculated using a column coloring.
+   * @return const bool & useJacobianColoring
+   */
+  const bool & getUseJacobianColoring() const;
+
+  /**
+   * Set whether the simulated values and roots are calculated by native code. The code is
+   * generated, compiled, and loaded on first use. Sequences which can not be compiled
+   * are applied as usual.
+   * @param const bool & useNativeCode
+   */
+  void setUseNativeCode(const bool & useNativeCode);
+
+  /**
+   * Check whether the simulated values and roots are calculated by native code
+   * @return const bool & useNativeCode
+   */
+  const bool & getUseNativeCode() const;
+
   /**
    * Calculates whether matrix elements in the Jacobian are identical
    * to zero or not and stored it in the provided matrix.
@@ -1015,6 +1045,41 @@ private:
    */
   void createUpdateSimulationValuesSequence();
 
+  /**
+   * Determine the column coloring for the finite difference calculation of the Jacobian
+   * @param const bool & reduced
+   */
+  void compileJacobianColoring(const bool & reduced);
+
+  /**
+   * Apply the native code for the sequence with the given index if available. The native
+   * code is compiled if needed.
+   * @param const size_t & index
+   * @return bool applied
+   */
+  bool applyNativeCode(const size_t & index);
+
+  /**
+   * Calculate the Jacobian with finite differences perturbing one column at a time.
+   * @param CMatrix< C_FLOAT64 > & Jacobian
+   * @param const C_FLOAT64 & derivationFactor,
+   * @param const bool & reduced
+   */
+  void calculateJacobianDense(CMatrix< C_FLOAT64 > & jacobian,
+                              const C_FLOAT64 & derivationFactor,
+                              const bool & reduced);
+
+  /**
+   * Calculate the Jacobian with finite differences perturbing all columns of the same
+   * color simultaneously.
+   * @param CMatrix< C_FLOAT64 > & Jacobian
+   * @param const C_FLOAT64 & derivationFactor,
+   * @param const bool & reduced
+   */
+  void calculateJacobianColored(CMatrix< C_FLOAT64 > & jacobian,
+                                const C_FLOAT64 & derivationFactor,
+                                const bool & reduced);
+
   /**
    * Create the update sequences used to calculate all transient data values
    */
@@ -1446,6 +1511,43 @@ private:
    * A set of object for which changing the initial value is prohibeted;
    */
   CObjectInterface::ObjectSet mValueChangeProhibited;
+
+  /**
+   * A flag indicating whether the Jacobian is calculated using a column coloring
+   */
+  bool mUseJacobianColoring;
+
+  /**
+   * The color of each column of the Jacobian
+   */
+  CVector< size_t > mJacobianColumnColors;
+
+  /**
+   * The color of each column of the reduced Jacobian
+   */
+  CVector< size_t > mJacobianColumnColorsReduced;
+
+  /**
+   * For each color (row) the column which determines the Jacobian entry of each row,
+   * C_INVALID_INDEX if the row does not depend on any column of that color.
+   */
+  CMatrix< size_t > mJacobianColoring;
+
+  /**
+   * For each color (row) the column which determines the reduced Jacobian entry of each row,
+   * C_INVALID_INDEX if the row does not depend on any column of that color.
+   */
+  CMatrix< size_t > mJacobianColoringReduced;
+
+  /**
+   * A flag indicating whether native code is used
+   */
+  bool mUseNativeCode;
+
+  /**
+   * The native code for the simulated values and roots (NULL if not yet compiled)
+   */
+  CMathNativeCode * mpNativeCode;
 };
 
 #endif // COPASI_CMathContainer
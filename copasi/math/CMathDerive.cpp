@@ -1,8 +1,9 @@
-// Copyright (C) 2019 by Pedro Mendes, Rector and Visitors of the
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
 // University of Virginia, University of Heidelberg, and University
 // of Connecticut School of Medicine.
 // All rights reserved.
 
+#include <cmath>
 
 #include "copasi/copasi.h"
 
@@ -10,13 +11,18 @@
 
 #include "copasi/math/CMathContainer.h"
 #include "copasi/math/CMathExpression.h"
-#include "copasi/function/CDerive.h"
-
+#include "copasi/function/CEvaluationNode.h"
 
+CMathDerive::CMathDerive():
+  mpContainer(NULL),
+  mpRootNode(NULL),
+  mDerive()
+{}
 
 CMathDerive::CMathDerive(const CMathContainer* pContainer, size_t fun, size_t var):
   mpContainer(pContainer),
-  mpRootNode(NULL)
+  mpRootNode(NULL),
+  mDerive()
 {
   if (!pContainer)
     return;
@@ -24,7 +30,10 @@ CMathDerive::CMathDerive(const CMathContainer* pContainer, size_t fun, size_t va
   initOneVar(fun, var);
 }
 
-
+CMathDerive::~CMathDerive()
+{
+  CDerive::deleteBranch(mpRootNode);
+}
 
 void CMathDerive::initOneVar(size_t fun, size_t var)
 {
@@ -36,20 +45,14 @@ void CMathDerive::initOneVar(size_t fun, size_t var)
   if (var >= max)
     return;
 
-
   CMathObject* pFMO = mpContainer->getMathObject(&mpContainer->getValues()[fun]);
-  CMathObject* pVMO = mpContainer->getMathObject(&mpContainer->getValues()[var]);
 
   const CMathExpression* pMExp = pFMO->getExpressionPtr();
 
-  //CEvaluationNode* tmp;
-
-  //std::vector<const CEvaluationNode*> env;
-
-  CDerive derive;
-  derive.deriveBranch(pMExp->getRoot(), NULL);
-
+  if (pMExp == NULL)
+    return;
 
+  mpRootNode = deriveBranch(pMExp->getRoot(), &mpContainer->getValues()[var]);
 }
 
 const CEvaluationNode* CMathDerive::getRootNode()
@@ -57,134 +60,375 @@ const CEvaluationNode* CMathDerive::getRootNode()
   return mpRootNode;
 }
 
+// static
+bool CMathDerive::dependsOn(const CEvaluationNode * pNode, const C_FLOAT64 * pVariable)
+{
+  if (pNode == NULL)
+    return false;
 
-#ifdef XXX
+  if (pNode->mainType() == CEvaluationNode::MainType::OBJECT &&
+      pNode->subType() == CEvaluationNode::SubType::POINTER &&
+      static_cast< const CEvaluationNodeObject * >(pNode)->getObjectValuePtr() == pVariable)
+    return true;
 
-#include "copasi/function/CDerive.h"
+  const CEvaluationNode * pChild = static_cast< const CEvaluationNode * >(pNode->getChild());
 
-CEvaluationNode* CModel::prepareElasticity(const CReaction * pReaction, const CModelEntity* pVar, bool simplify)
-{
-  //TODO check: pVar should be a pointer to a variable (ODE or REACTION), a local parameter, an initial value, or a fixed entity
-  //it should not be an entity with an assignment.
+  for (; pChild != NULL; pChild = static_cast< const CEvaluationNode * >(pChild->getSibling()))
+    if (dependsOn(pChild, pVariable))
+      return true;
 
-  //here we select the actual derivation variable: concentration, or value, or volume, etc. TODO
-  const CDataObject * pVarObj = pVar->CModelEntity::getValueObject();
-  //const CDataObject * pVarObj = pVar->getValueObject();
+  return false;
+}
 
-  CEvaluationNode* tmp;
-  CExpression * derivExp = new CExpression("derivative expression", this);
+CEvaluationNode * CMathDerive::deriveBranch(const CEvaluationNode * pNode, const C_FLOAT64 * pVariable)
+{
+  if (pNode == NULL)
+    return NULL;
+
+  // Everything not depending on the variable is constant.
+  if (!dependsOn(pNode, pVariable))
+    return new CEvaluationNodeNumber(CEvaluationNode::SubType::INTEGER, "0");
 
-  //first handle mass action
-  if (dynamic_cast<const CMassAction*>(pReaction->getFunction()))
+  switch (pNode->mainType())
     {
-      //create the explicit kinetic law, so that we can calculate the derivative
-      //we use the metabs in the object nodes. These are automatically converted to concentration references
-      //during compile later
-      CEvaluationNode* tmp_ma;
+      case CEvaluationNode::MainType::OBJECT:
+        // Only the pointer to the variable itself depends on the variable.
+        return new CEvaluationNodeNumber(CEvaluationNode::SubType::INTEGER, "1");
+        break;
+
+      case CEvaluationNode::MainType::OPERATOR:
+        return deriveOperator(pNode, pVariable);
+        break;
+
+      case CEvaluationNode::MainType::FUNCTION:
+        return deriveFunction(pNode, pVariable);
+        break;
+
+      case CEvaluationNode::MainType::CHOICE:
+        return deriveChoice(pNode, pVariable);
+        break;
+
+      case CEvaluationNode::MainType::LOGICAL:
+        // Logical values are piecewise constant.
+        return new CEvaluationNodeNumber(CEvaluationNode::SubType::INTEGER, "0");
+        break;
+
+      default:
+        break;
+    }
 
-      //forward part
-      std::vector<const CDataObject*> prod;
-      size_t j;
+  // Delays, calls, and other nodes are not supported
+  return NULL;
+}
 
-      for (j = 0; j < pReaction->getMap().getObjects()[1].vector->size(); ++j)
-        {
-          prod.push_back((*(pReaction->getMap().getObjects()[1].vector))[j].value); //substrates
-        }
+CEvaluationNode * CMathDerive::deriveOperator(const CEvaluationNode * pNode, const C_FLOAT64 * pVariable)
+{
+  const CEvaluationNode * pA = static_cast< const CEvaluationNode * >(pNode->getChild());
 
-      prod.push_back(pReaction->getMap().getObjects()[0].value); //k1
+  if (pA == NULL) return NULL;
 
-      if (prod.size() == 1)
-        tmp_ma = new CEvaluationNodeObject(CEvaluationNode::SubType::CN, "<" + prod[0]->getCN() + ">");
-      else
-        {
-          tmp_ma = CDerive::multiply(new CEvaluationNodeObject(CEvaluationNode::SubType::CN, "<" + prod[0]->getCN() + ">"),
-                                     new CEvaluationNodeObject(CEvaluationNode::SubType::CN, "<" + prod[1]->getCN() + ">"), simplify);
+  const CEvaluationNode * pB = static_cast< const CEvaluationNode * >(pA->getSibling());
 
-          for (j = 2; j < prod.size(); ++j)
-            tmp_ma = CDerive::multiply(tmp_ma,
-                                       new CEvaluationNodeObject(CEvaluationNode::SubType::CN, "<" + prod[j]->getCN() + ">"), simplify);
-        }
+  if (pB == NULL) return NULL;
+
+  CEvaluationNode * pDA = deriveBranch(pA, pVariable);
+
+  if (pDA == NULL) return NULL;
+
+  CEvaluationNode * pDB = deriveBranch(pB, pVariable);
+
+  if (pDB == NULL)
+    {
+      CDerive::deleteBranch(pDA);
+      return NULL;
+    }
+
+  switch (pNode->subType())
+    {
+      case CEvaluationNode::SubType::PLUS:
+        return mDerive.add(pDA, pDB);
+        break;
+
+      case CEvaluationNode::SubType::MINUS:
+        return mDerive.subtract(pDA, pDB);
+        break;
+
+      case CEvaluationNode::SubType::MULTIPLY:
+        // a' * b + a * b'
+        return mDerive.add(mDerive.multiply(pDA, pB->copyBranch()),
+                           mDerive.multiply(pA->copyBranch(), pDB));
+        break;
+
+      case CEvaluationNode::SubType::DIVIDE:
+
+        if (CDerive::isZero(pDB))
+          {
+            // a' / b
+            CDerive::deleteBranch(pDB);
+            return mDerive.divide(pDA, pB->copyBranch());
+          }
+
+        // (a' * b - a * b') / b^2
+        return mDerive.divide(mDerive.subtract(mDerive.multiply(pDA, pB->copyBranch()),
+                                               mDerive.multiply(pA->copyBranch(), pDB)),
+                              mDerive.power(pB->copyBranch(),
+                                            new CEvaluationNodeNumber(CEvaluationNode::SubType::INTEGER, "2")));
+        break;
+
+      case CEvaluationNode::SubType::POWER:
+
+        if (CDerive::isZero(pDB))
+          {
+            // b * a^(b - 1) * a'
+            CDerive::deleteBranch(pDB);
+            return mDerive.multiply(mDerive.multiply(pB->copyBranch(),
+                                                     mDerive.power(pA->copyBranch(),
+                                                                   mDerive.subtract(pB->copyBranch(),
+                                                                                    new CEvaluationNodeNumber(CEvaluationNode::SubType::INTEGER, "1")))),
+                                    pDA);
+          }
 
-      //backwards part
-      if (pReaction->isReversible())
         {
-          CEvaluationNode * ttt = tmp_ma; //store the forward part
-          CEvaluationNode * tt2; //for the backwards part
-          prod.clear();
-
-          for (j = 0; j < pReaction->getMap().getObjects()[3].vector->size(); ++j)
-            {
-              prod.push_back((*(pReaction->getMap().getObjects()[3].vector))[j].value); //products
-            }
-
-          prod.push_back(pReaction->getMap().getObjects()[2].value); //k2
-
-          if (prod.size() == 1)
-            tt2 = new CEvaluationNodeObject(CEvaluationNode::SubType::CN, "<" + prod[0]->getCN() + ">");
-          else
-            {
-              tt2 = CDerive::multiply(new CEvaluationNodeObject(CEvaluationNode::SubType::CN, "<" + prod[0]->getCN() + ">"),
-                                      new CEvaluationNodeObject(CEvaluationNode::SubType::CN, "<" + prod[1]->getCN() + ">"), simplify);
-
-              for (j = 2; j < prod.size(); ++j)
-                tt2 = CDerive::multiply(tt2,
-                                        new CEvaluationNodeObject(CEvaluationNode::SubType::CN, "<" + prod[j]->getCN() + ">"), simplify);
-            }
-
-          tmp_ma = new CEvaluationNodeOperator(CEvaluationNode::SubType::MINUS, "-");
-          tmp_ma->addChild(ttt);
-          tmp_ma->addChild(tt2);
+          // a^b * (b' * log(a) + b * a' / a)
+          CEvaluationNode * pLog = new CEvaluationNodeFunction(CEvaluationNode::SubType::LOG, "log");
+          pLog->addChild(pA->copyBranch());
+
+          return mDerive.multiply(pNode->copyBranch(),
+                                  mDerive.add(mDerive.multiply(pDB, pLog),
+                                              mDerive.divide(mDerive.multiply(pB->copyBranch(), pDA),
+                                                             pA->copyBranch())));
         }
+        break;
 
-      CExpression * tmpExp = new CExpression("Mass action expression", this);
-      CDerive::compileTree(tmp_ma, tmpExp);
+      default:
+        break;
+    }
+
+  // Modulus and remainder are not supported
+  CDerive::deleteBranch(pDA);
+  CDerive::deleteBranch(pDB);
 
-      tmpExp->setRoot(tmp_ma);
-      tmpExp->compile(); //this converts references from model entities to value references
+  return NULL;
+}
 
-      std::vector<const CEvaluationNode*> env;
-      tmp = CDerive::deriveBranch(tmp_ma, pVarObj, env, derivExp, simplify);
+CEvaluationNode * CMathDerive::deriveFunction(const CEvaluationNode * pNode, const C_FLOAT64 * pVariable)
+{
+  const CEvaluationNode * pA = static_cast< const CEvaluationNode * >(pNode->getChild());
 
-      CDerive::deleteBranch(tmp_ma);
+  if (pA == NULL) return NULL;
+
+  switch (pNode->subType())
+    {
+      case CEvaluationNode::SubType::SIGN:
+      case CEvaluationNode::SubType::FLOOR:
+      case CEvaluationNode::SubType::CEIL:
+        // Piecewise constant
+        return new CEvaluationNodeNumber(CEvaluationNode::SubType::INTEGER, "0");
+        break;
+
+      case CEvaluationNode::SubType::MAX:
+      case CEvaluationNode::SubType::MIN:
+      {
+        const CEvaluationNode * pB = static_cast< const CEvaluationNode * >(pA->getSibling());
+
+        if (pB == NULL) return NULL;
+
+        CEvaluationNode * pDA = deriveBranch(pA, pVariable);
+
+        if (pDA == NULL) return NULL;
+
+        CEvaluationNode * pDB = deriveBranch(pB, pVariable);
+
+        if (pDB == NULL)
+          {
+            CDerive::deleteBranch(pDA);
+            return NULL;
+          }
+
+        // if(a ge b, a', b') for max and if(a le b, a', b') for min
+        CEvaluationNode * pCondition = (pNode->subType() == CEvaluationNode::SubType::MAX) ?
+                                       new CEvaluationNodeLogical(CEvaluationNode::SubType::GE, "ge") :
+                                       new CEvaluationNodeLogical(CEvaluationNode::SubType::LE, "le");
+        pCondition->addChild(pA->copyBranch());
+        pCondition->addChild(pB->copyBranch());
+
+        CEvaluationNode * pChoice = new CEvaluationNodeChoice(CEvaluationNode::SubType::IF, "if");
+        pChoice->addChild(pCondition);
+        pChoice->addChild(pDA);
+        pChoice->addChild(pDB);
+
+        return pChoice;
+      }
+      break;
+
+      default:
+        break;
     }
-  else //not mass action
+
+  CEvaluationNode * pDA = deriveBranch(pA, pVariable);
+
+  if (pDA == NULL) return NULL;
+
+  CEvaluationNode * pTmp = NULL;
+
+  switch (pNode->subType())
     {
-      //create call environment for the kinetic function
-      //do we have to call something on CReaction to make sure that the map is uptodate?
-      std::vector<const CEvaluationNode*> env;
-      size_t i, imax = pReaction->getMap().getObjects().size();
-      env.resize(imax);
+      case CEvaluationNode::SubType::PLUS:
+        return pDA;
+        break;
+
+      case CEvaluationNode::SubType::MINUS:
+        pTmp = new CEvaluationNodeFunction(CEvaluationNode::SubType::MINUS, "-");
+        pTmp->addChild(pDA);
+        return pTmp;
+        break;
+
+      case CEvaluationNode::SubType::EXP:
+        // exp(a) * a'
+        return mDerive.multiply(pNode->copyBranch(), pDA);
+        break;
+
+      case CEvaluationNode::SubType::LOG:
+        // a' / a
+        return mDerive.divide(pDA, pA->copyBranch());
+        break;
+
+      case CEvaluationNode::SubType::LOG10:
+        // a' / (a * log(10))
+        return mDerive.divide(pDA, mDerive.multiply(pA->copyBranch(), new CEvaluationNodeNumber(log(10.0))));
+        break;
+
+      case CEvaluationNode::SubType::SQRT:
+        // a' / (2 * sqrt(a))
+        return mDerive.divide(pDA, mDerive.multiply(new CEvaluationNodeNumber(CEvaluationNode::SubType::INTEGER, "2"),
+                              pNode->copyBranch()));
+        break;
+
+      case CEvaluationNode::SubType::SIN:
+        // cos(a) * a'
+        pTmp = new CEvaluationNodeFunction(CEvaluationNode::SubType::COS, "cos");
+        pTmp->addChild(pA->copyBranch());
+        return mDerive.multiply(pTmp, pDA);
+        break;
+
+      case CEvaluationNode::SubType::COS:
+      {
+        // -(sin(a) * a')
+        pTmp = new CEvaluationNodeFunction(CEvaluationNode::SubType::SIN, "sin");
+        pTmp->addChild(pA->copyBranch());
+
+        CEvaluationNode * pMinus = new CEvaluationNodeFunction(CEvaluationNode::SubType::MINUS, "-");
+        pMinus->addChild(mDerive.multiply(pTmp, pDA));
+        return pMinus;
+      }
+      break;
+
+      case CEvaluationNode::SubType::TAN:
+        // a' / cos(a)^2
+        pTmp = new CEvaluationNodeFunction(CEvaluationNode::SubType::COS, "cos");
+        pTmp->addChild(pA->copyBranch());
+        return mDerive.divide(pDA, mDerive.power(pTmp, new CEvaluationNodeNumber(CEvaluationNode::SubType::INTEGER, "2")));
+        break;
+
+      case CEvaluationNode::SubType::SINH:
+        // cosh(a) * a'
+        pTmp = new CEvaluationNodeFunction(CEvaluationNode::SubType::COSH, "cosh");
+        pTmp->addChild(pA->copyBranch());
+        return mDerive.multiply(pTmp, pDA);
+        break;
+
+      case CEvaluationNode::SubType::COSH:
+        // sinh(a) * a'
+        pTmp = new CEvaluationNodeFunction(CEvaluationNode::SubType::SINH, "sinh");
+        pTmp->addChild(pA->copyBranch());
+        return mDerive.multiply(pTmp, pDA);
+        break;
+
+      case CEvaluationNode::SubType::TANH:
+        // a' / cosh(a)^2
+        pTmp = new CEvaluationNodeFunction(CEvaluationNode::SubType::COSH, "cosh");
+        pTmp->addChild(pA->copyBranch());
+        return mDerive.divide(pDA, mDerive.power(pTmp, new CEvaluationNodeNumber(CEvaluationNode::SubType::INTEGER, "2")));
+        break;
+
+      case CEvaluationNode::SubType::ARCSIN:
+      case CEvaluationNode::SubType::ARCCOS:
+      {
+        // +/- a' / sqrt(1 - a^2)
+        pTmp = new CEvaluationNodeFunction(CEvaluationNode::SubType::SQRT, "sqrt");
+        pTmp->addChild(mDerive.subtract(new CEvaluationNodeNumber(CEvaluationNode::SubType::INTEGER, "1"),
+                                        mDerive.power(pA->copyBranch(), new CEvaluationNodeNumber(CEvaluationNode::SubType::INTEGER, "2"))));
+        pTmp = mDerive.divide(pDA, pTmp);
+
+        if (pNode->subType() == CEvaluationNode::SubType::ARCSIN)
+          return pTmp;
+
+        CEvaluationNode * pMinus = new CEvaluationNodeFunction(CEvaluationNode::SubType::MINUS, "-");
+        pMinus->addChild(pTmp);
+        return pMinus;
+      }
+      break;
+
+      case CEvaluationNode::SubType::ARCTAN:
+        // a' / (1 + a^2)
+        return mDerive.divide(pDA, mDerive.add(new CEvaluationNodeNumber(CEvaluationNode::SubType::INTEGER, "1"),
+                                               mDerive.power(pA->copyBranch(), new CEvaluationNodeNumber(CEvaluationNode::SubType::INTEGER, "2"))));
+        break;
+
+      case CEvaluationNode::SubType::ABS:
+        // sign(a) * a'
+        pTmp = new CEvaluationNodeFunction(CEvaluationNode::SubType::SIGN, "sign");
+        pTmp->addChild(pA->copyBranch());
+        return mDerive.multiply(pTmp, pDA);
+        break;
+
+      default:
+        break;
+    }
 
-      for (i = 0; i < imax; ++i)
-        {
-          const CDataObject* tmpObj = pReaction->getMap().getObjects()[i].value;
-          //if we have a metab, its always the concentration
-          const CMetab* tmpMetab = dynamic_cast<const CMetab*>(tmpObj);
+  // Random functions and the remaining functions are not supported
+  CDerive::deleteBranch(pDA);
 
-          if (tmpMetab)
-            tmpObj = tmpMetab->getConcentrationReference();
+  return NULL;
+}
 
-          std::string tmpstr = tmpObj ? "<" + tmpObj->getCN() + ">" : "<>";
-          CEvaluationNodeObject* tmpENO = new CEvaluationNodeObject(CEvaluationNode::SubType::CN, tmpstr);
-          env[i] = tmpENO;
-          tmpENO->compile(derivExp); //this uses derivExp as a dummy expression (so that the node has a context for the compile()
-        }
+CEvaluationNode * CMathDerive::deriveChoice(const CEvaluationNode * pNode, const C_FLOAT64 * pVariable)
+{
+  const CEvaluationNode * pCondition = static_cast< const CEvaluationNode * >(pNode->getChild());
 
-      tmp = CDerive::deriveBranch(pReaction->getFunction()->getRoot(), pVarObj, env, derivExp, simplify);
+  if (pCondition == NULL) return NULL;
 
-      for (int l = (int)env.size() - 1; l >= 0; l--)
-        {
-          delete const_cast<CEvaluationNode*>(env[l]);
-        }
+  const CEvaluationNode * pTrue = static_cast< const CEvaluationNode * >(pCondition->getSibling());
+
+  if (pTrue == NULL) return NULL;
+
+  const CEvaluationNode * pFalse = static_cast< const CEvaluationNode * >(pTrue->getSibling());
+
+  if (pFalse == NULL) return NULL;
+
+  CEvaluationNode * pDTrue = deriveBranch(pTrue, pVariable);
 
-      env.clear();
+  if (pDTrue == NULL) return NULL;
+
+  CEvaluationNode * pDFalse = deriveBranch(pFalse, pVariable);
+
+  if (pDFalse == NULL)
+    {
+      CDerive::deleteBranch(pDTrue);
+      return NULL;
     }
 
-  derivExp->setRoot(tmp);
-  derivExp->compile();
+  if (CDerive::isZero(pDTrue) && CDerive::isZero(pDFalse))
+    {
+      CDerive::deleteBranch(pDFalse);
+      return pDTrue;
+    }
 
-  //tmp->printRecursively(std::cout);
-  return tmp;
-}
+  // if(c, a', b')
+  CEvaluationNode * pChoice = new CEvaluationNodeChoice(CEvaluationNode::SubType::IF, "if");
+  pChoice->addChild(pCondition->copyBranch());
+  pChoice->addChild(pDTrue);
+  pChoice->addChild(pDFalse);
 
-#endif
+  return pChoice;
+}
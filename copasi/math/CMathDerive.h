@@ -1,7 +1,15 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
 
 #ifndef COPASI_CMathDerive
 #define COPASI_CMathDerive
 
+#include <cstddef>
+
+#include "copasi/function/CDerive.h"
+
 class CMathContainer;
 class CEvaluationNode;
 
@@ -9,38 +17,66 @@ class CEvaluationNode;
  * This class contains all the information that is needed to calculate derivatives in a CMathContainer.
  * When initialised (through a constructor) it sets up the expression for symbolic derivatives and also determines
  * whether the derivative is constant (so that it is not reevaluated during simulations)
+ *
+ * The derivatives are partial derivatives of the expression trees of the math container, i.e., each
+ * object node (value pointer) is treated as an independent variable. Chaining through the
+ * dependencies of the container is the responsibility of the caller (see CMathJacobian).
  */
 class CMathDerive
 {
 public:
-  
+  /**
+   * Default constructor
+   */
+  CMathDerive();
+
   CMathDerive(const CMathContainer* pContainer, size_t fun, size_t var);
-  
+
+  /**
+   * Destructor
+   */
+  ~CMathDerive();
+
   ///just for testing
   const CEvaluationNode* getRootNode();
-  
-private:
 
-  void initOneVar(size_t fun, size_t var);
-  
-  
-  
-  const CMathContainer* mpContainer;
-  
-  CEvaluationNode* mpRootNode;
+  /**
+   * Create the partial derivative of the branch starting at pNode with respect to the
+   * value pointed to by pVariable. The caller is responsible for deleting the returned branch.
+   * NULL is returned if the derivative can not be created symbolically, e.g., for delays,
+   * random functions, or modulus which depend on the variable.
+   * @param const CEvaluationNode * pNode
+   * @param const C_FLOAT64 * pVariable
+   * @return CEvaluationNode * pDerivative
+   */
+  CEvaluationNode * deriveBranch(const CEvaluationNode * pNode, const C_FLOAT64 * pVariable);
 
+  /**
+   * Check whether the branch starting at pNode contains an object node pointing to pVariable
+   * @param const CEvaluationNode * pNode
+   * @param const C_FLOAT64 * pVariable
+   * @return bool dependsOn
+   */
+  static bool dependsOn(const CEvaluationNode * pNode, const C_FLOAT64 * pVariable);
 
+private:
 
-};
+  void initOneVar(size_t fun, size_t var);
 
+  CEvaluationNode * deriveOperator(const CEvaluationNode * pNode, const C_FLOAT64 * pVariable);
 
+  CEvaluationNode * deriveFunction(const CEvaluationNode * pNode, const C_FLOAT64 * pVariable);
 
-#endif
+  CEvaluationNode * deriveChoice(const CEvaluationNode * pNode, const C_FLOAT64 * pVariable);
 
-/*
-TODOs:
+  const CMathContainer* mpContainer;
 
-- Make sure all valid functions can be derived (or implement a fallback)
--
+  CEvaluationNode* mpRootNode;
+
+  /**
+   * The helper providing simplifying arithmetic operations
+   */
+  CDerive mDerive;
+};
 
-*/
+#endif
@@ -28,22 +28,28 @@
 
 #define pMathContainer static_cast< const CMathContainer * >(getObjectParent())
 
+// static
+bool CMathExpression::mUseBytecode = true;
+
 CMathExpression::CMathExpression():
   CEvaluationTree(),
-  mPrerequisites()
+  mPrerequisites(),
+  mBytecode()
 {}
 
 CMathExpression::CMathExpression(const std::string & name,
                                  CMathContainer & container):
   CEvaluationTree(name, &container, CEvaluationTree::MathExpression),
-  mPrerequisites()
+  mPrerequisites(),
+  mBytecode()
 {}
 
 CMathExpression::CMathExpression(const CExpression & src,
                                  CMathContainer & container,
                                  const bool & replaceDiscontinuousNodes):
   CEvaluationTree(src.getObjectName(), &container, CEvaluationTree::MathExpression),
-  mPrerequisites()
+  mPrerequisites(),
+  mBytecode()
 {
   clearNodes();
 
@@ -58,7 +64,8 @@ CMathExpression::CMathExpression(const CFunction & src,
                                  CMathContainer & container,
                                  const bool & replaceDiscontinuousNodes):
   CEvaluationTree(src.getObjectName(), &container, CEvaluationTree::MathExpression),
-  mPrerequisites()
+  mPrerequisites(),
+  mBytecode()
 {
   clearNodes();
 
@@ -180,15 +187,42 @@ void CMathExpression::relocate(const CMathContainer * pContainer,
 
   mInfix = mpRootNode != NULL ? mpRootNode->buildInfix() : "";
   pContainer->relocateObjectSet(mPrerequisites, relocations);
+
+  // The bytecode refers to the relocated values directly.
+  mBytecode.compile(mpRootNode, mCalculationSequence);
 }
 
 const C_FLOAT64 & CMathExpression::value()
 {
-  calculate();
+  if (mUseBytecode && mBytecode.isValid())
+    {
+      mValue = mBytecode.calculate();
+    }
+  else
+    {
+      calculate();
+    }
 
   return mValue;
 }
 
+// static
+void CMathExpression::setUseBytecode(const bool & useBytecode)
+{
+  mUseBytecode = useBytecode;
+}
+
+// static
+const bool & CMathExpression::getUseBytecode()
+{
+  return mUseBytecode;
+}
+
+const CMathBytecode & CMathExpression::getBytecode() const
+{
+  return mBytecode;
+}
+
 // virtual
 const CObjectInterface::ObjectSet & CMathExpression::getPrerequisites() const
 {
@@ -206,6 +240,7 @@ CIssue CMathExpression::compile()
       mpNodeList == NULL)
     {
       mCalculationSequence.resize(0);
+      mBytecode.clear();
 
       return firstWorstIssue;
     }
@@ -243,6 +278,7 @@ CIssue CMathExpression::compile()
     }
 
   buildCalculationSequence();
+  mBytecode.compile(mpRootNode, mCalculationSequence);
 
   return firstWorstIssue;
 }
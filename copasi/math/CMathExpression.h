@@ -15,6 +15,7 @@
 #include <vector>
 
 #include "copasi/math/CMathObject.h"
+#include "copasi/math/CMathBytecode.h"
 #include "copasi/function/CEvaluationTree.h"
 
 class CExpression;
@@ -109,6 +110,25 @@ public:
    */
   bool convertToInitialExpression();
 
+  /**
+   * Set whether expressions are evaluated using their compiled bytecode (default) or
+   * by traversing the calculation sequence of the tree.
+   * @param const bool & useBytecode
+   */
+  static void setUseBytecode(const bool & useBytecode);
+
+  /**
+   * Check whether expressions are evaluated using their compiled bytecode
+   * @return const bool & useBytecode
+   */
+  static const bool & getUseBytecode();
+
+  /**
+   * Retrieve the compiled bytecode
+   * @return const CMathBytecode & bytecode
+   */
+  const CMathBytecode & getBytecode() const;
+
 private:
   /**
    * Sets the root node of the tree.
@@ -140,6 +160,16 @@ private:
    * The prerequisites for calculating the expression.
    */
   CObjectInterface::ObjectSet mPrerequisites;
+
+  /**
+   * The bytecode compiled from the calculation sequence
+   */
+  CMathBytecode mBytecode;
+
+  /**
+   * Indicates whether the bytecode is used for evaluation
+   */
+  static bool mUseBytecode;
 };
 
 #endif // COPASI_CMathExpression
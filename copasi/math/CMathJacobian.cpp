@@ -0,0 +1,453 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#include <map>
+#include <set>
+
+#include "copasi/copasi.h"
+
+#include "copasi/math/CMathJacobian.h"
+
+#include "copasi/math/CMathContainer.h"
+#include "copasi/math/CMathExpression.h"
+#include "copasi/math/CMathObject.h"
+#include "copasi/math/CMathDerive.h"
+#include "copasi/function/CEvaluationNode.h"
+
+CMathJacobian::CMathJacobian():
+  mValid(false),
+  mSize(0),
+  mNumParameters(0),
+  mLowerBandwidth(0),
+  mUpperBandwidth(0),
+  mPartials(),
+  mPartialIndex(),
+  mPartialValues(),
+  mDerivatives(),
+  mOperations(),
+  mColumnOperations(),
+  mResetNodes(),
+  mColumnResetNodes(),
+  mRowNodes(),
+  mEntries(),
+  mColumnEntries(),
+  mValues()
+{}
+
+CMathJacobian::~CMathJacobian()
+{
+  clear();
+}
+
+void CMathJacobian::clear()
+{
+  std::vector< CMathExpression * >::iterator it = mPartials.begin();
+  std::vector< CMathExpression * >::iterator end = mPartials.end();
+
+  for (; it != end; ++it)
+    {
+      pdelete(*it);
+    }
+
+  mPartials.clear();
+  mPartialIndex.clear();
+  mOperations.clear();
+  mColumnOperations.clear();
+  mResetNodes.clear();
+  mColumnResetNodes.clear();
+  mRowNodes.clear();
+  mEntries.clear();
+  mColumnEntries.clear();
+
+  mValid = false;
+  mSize = 0;
+  mNumParameters = 0;
+  mLowerBandwidth = 0;
+  mUpperBandwidth = 0;
+}
+
+bool CMathJacobian::compile(CMathContainer & container, const bool & reduced, const bool & includeTime)
+{
+  return compile(container, reduced, includeTime, CVector< C_FLOAT64 * >(), CCore::CUpdateSequence());
+}
+
+bool CMathJacobian::compile(CMathContainer & container, const bool & reduced, const bool & includeTime,
+                            const CVectorCore< C_FLOAT64 * > & parameters,
+                            const CCore::CUpdateSequence & parameterSequence)
+{
+  clear();
+  mValid = true;
+
+  size_t FirstState = container.getCountFixedEventTargets() + (includeTime ? 0 : 1);
+  const CVectorCore< C_FLOAT64 > & State = container.getState(reduced);
+  const C_FLOAT64 * pState = State.array() + FirstState;
+  const C_FLOAT64 * pRate = container.getRate(reduced).array() + FirstState;
+
+  mSize = State.size() - FirstState;
+  mNumParameters = parameters.size();
+
+  // The columns are the state variables and the parameters.
+  size_t Columns = mSize + mNumParameters;
+
+  // The nodes are the columns followed by the calculated values in the order of calculation.
+  std::map< const C_FLOAT64 *, size_t > NodeIndex;
+  size_t i;
+
+  for (i = 0; i < mSize; ++i)
+    {
+      NodeIndex[pState + i] = i;
+    }
+
+  for (i = 0; i < mNumParameters; ++i)
+    {
+      if (parameters[i] == NULL) continue;
+
+      // We cannot distinguish columns which refer to the same value.
+      if (!NodeIndex.insert(std::make_pair((const C_FLOAT64 *) parameters[i], mSize + i)).second)
+        {
+          clear();
+          return false;
+        }
+    }
+
+  // Values depending on the parameters which are not calculated during simulation are
+  // calculated before all simulated values.
+  const CCore::CUpdateSequence & SimulationSequence = container.getSimulationValuesSequence(reduced);
+  std::set< const CObjectInterface * > Simulated(SimulationSequence.begin(), SimulationSequence.end());
+  std::vector< const CObjectInterface * > Sequence;
+
+  CCore::CUpdateSequence::const_iterator itSequence = parameterSequence.begin();
+  CCore::CUpdateSequence::const_iterator endSequence = parameterSequence.end();
+
+  for (; itSequence != endSequence; ++itSequence)
+    if (Simulated.find(*itSequence) == Simulated.end())
+      {
+        Sequence.push_back(*itSequence);
+      }
+
+  Sequence.insert(Sequence.end(), SimulationSequence.begin(), SimulationSequence.end());
+
+  std::vector< std::vector< std::pair< size_t, size_t > > > Edges(Columns);
+  std::vector< C_FLOAT64 > PartialValues;
+
+  CMathDerive Derive;
+
+  std::vector< const CObjectInterface * >::const_iterator it = Sequence.begin();
+  std::vector< const CObjectInterface * >::const_iterator end = Sequence.end();
+
+  for (; it != end && mValid; ++it)
+    {
+      const CMathObject * pObject = dynamic_cast< const CMathObject * >(*it);
+
+      if (pObject == NULL ||
+          NodeIndex.find((const C_FLOAT64 *) pObject->getValuePointer()) != NodeIndex.end()) continue;
+
+      const CMathExpression * pExpression = pObject->getExpressionPtr();
+
+      if (pExpression == NULL || pExpression->getRoot() == NULL)
+        {
+          mValid = false;
+          break;
+        }
+
+      std::vector< std::pair< size_t, size_t > > NodeEdges;
+      std::set< const C_FLOAT64 * > Variables;
+
+      std::vector< CEvaluationNode * >::const_iterator itNode = pExpression->getNodeList().begin();
+      std::vector< CEvaluationNode * >::const_iterator endNode = pExpression->getNodeList().end();
+
+      for (; itNode != endNode && mValid; ++itNode)
+        {
+          if ((*itNode)->mainType() != CEvaluationNode::MainType::OBJECT ||
+              (*itNode)->subType() != CEvaluationNode::SubType::POINTER)
+            continue;
+
+          const C_FLOAT64 * pVariable = static_cast< const CEvaluationNodeObject * >(*itNode)->getObjectValuePtr();
+          std::map< const C_FLOAT64 *, size_t >::const_iterator found = NodeIndex.find(pVariable);
+
+          // Values which are not calculated during simulation are constant.
+          if (found == NodeIndex.end() ||
+              !Variables.insert(pVariable).second)
+            continue;
+
+          CEvaluationNode * pDerivative = Derive.deriveBranch(pExpression->getRoot(), pVariable);
+
+          if (pDerivative == NULL)
+            {
+              mValid = false;
+              break;
+            }
+
+          if (CDerive::isZero(pDerivative))
+            {
+              CDerive::deleteBranch(pDerivative);
+              continue;
+            }
+
+          if (pDerivative->mainType() == CEvaluationNode::MainType::NUMBER)
+            {
+              NodeEdges.push_back(std::make_pair(found->second, PartialValues.size()));
+              PartialValues.push_back(*pDerivative->getValuePointer());
+              CDerive::deleteBranch(pDerivative);
+              continue;
+            }
+
+          CMathExpression * pPartial = new CMathExpression("Partial Derivative", container);
+          pPartial->setInfix(pDerivative->buildInfix());
+          CDerive::deleteBranch(pDerivative);
+
+          if (!pPartial->compile())
+            {
+              pdelete(pPartial);
+              mValid = false;
+              break;
+            }
+
+          NodeEdges.push_back(std::make_pair(found->second, PartialValues.size()));
+
+          if (pPartial->getPrerequisites().empty())
+            {
+              PartialValues.push_back(pPartial->value());
+              pdelete(pPartial);
+            }
+          else
+            {
+              mPartialIndex.push_back(PartialValues.size());
+              mPartials.push_back(pPartial);
+              PartialValues.push_back(0.0);
+            }
+        }
+
+      NodeIndex[(const C_FLOAT64 *) pObject->getValuePointer()] = Edges.size();
+      Edges.push_back(NodeEdges);
+    }
+
+  if (!mValid)
+    {
+      clear();
+      return false;
+    }
+
+  mPartialValues.resize(PartialValues.size());
+
+  if (!PartialValues.empty())
+    memcpy(mPartialValues.array(), &PartialValues[0], PartialValues.size() * sizeof(C_FLOAT64));
+
+  mDerivatives.resize(Edges.size());
+  mDerivatives = 0.0;
+
+  mRowNodes.resize(mSize);
+
+  for (i = 0; i < mSize; ++i)
+    {
+      std::map< const C_FLOAT64 *, size_t >::const_iterator found = NodeIndex.find(pRate + i);
+      mRowNodes[i] = (found != NodeIndex.end() && found->second >= Columns) ? found->second : C_INVALID_INDEX;
+    }
+
+  // Determine for each column the nodes reached and the operations needed to propagate the derivative.
+  std::vector< bool > Reached(Edges.size());
+  sOperation Operation;
+  sEntry Entry;
+
+  for (Entry.column = 0; Entry.column < Columns; ++Entry.column)
+    {
+      mColumnOperations.push_back(mOperations.size());
+      mColumnResetNodes.push_back(mResetNodes.size());
+      mColumnEntries.push_back(mEntries.size());
+
+      Reached.assign(Edges.size(), false);
+      Reached[Entry.column] = true;
+      mResetNodes.push_back(Entry.column);
+
+      for (Operation.target = Columns; Operation.target < Edges.size(); ++Operation.target)
+        {
+          std::vector< std::pair< size_t, size_t > >::const_iterator itEdge = Edges[Operation.target].begin();
+          std::vector< std::pair< size_t, size_t > >::const_iterator endEdge = Edges[Operation.target].end();
+
+          for (; itEdge != endEdge; ++itEdge)
+            if (Reached[itEdge->first])
+              {
+                Operation.source = itEdge->first;
+                Operation.partial = itEdge->second;
+                mOperations.push_back(Operation);
+
+                if (!Reached[Operation.target])
+                  {
+                    Reached[Operation.target] = true;
+                    mResetNodes.push_back(Operation.target);
+                  }
+              }
+        }
+
+      for (Entry.row = 0; Entry.row < mSize; ++Entry.row)
+        if (mRowNodes[Entry.row] != C_INVALID_INDEX &&
+            Reached[mRowNodes[Entry.row]])
+          {
+            mEntries.push_back(Entry);
+
+            if (Entry.column >= mSize)
+              continue;
+
+            if (Entry.row > Entry.column)
+              mLowerBandwidth = std::max(mLowerBandwidth, Entry.row - Entry.column);
+            else
+              mUpperBandwidth = std::max(mUpperBandwidth, Entry.column - Entry.row);
+          }
+    }
+
+  mColumnOperations.push_back(mOperations.size());
+  mColumnResetNodes.push_back(mResetNodes.size());
+  mColumnEntries.push_back(mEntries.size());
+
+  mValues.resize(mEntries.size());
+  mValues = 0.0;
+
+  return mValid;
+}
+
+const bool & CMathJacobian::isValid() const
+{
+  return mValid;
+}
+
+void CMathJacobian::calculate()
+{
+  if (!mValid) return;
+
+  std::vector< CMathExpression * >::iterator itPartial = mPartials.begin();
+  std::vector< CMathExpression * >::iterator endPartial = mPartials.end();
+  std::vector< size_t >::const_iterator itIndex = mPartialIndex.begin();
+
+  for (; itPartial != endPartial; ++itPartial, ++itIndex)
+    {
+      mPartialValues[*itIndex] = (*itPartial)->value();
+    }
+
+  C_FLOAT64 * pDerivatives = mDerivatives.array();
+  const C_FLOAT64 * pPartialValues = mPartialValues.array();
+  C_FLOAT64 * pValue = mValues.array();
+
+  std::vector< sOperation >::const_iterator itOperation = mOperations.begin();
+  std::vector< size_t >::const_iterator itReset = mResetNodes.begin();
+  std::vector< sEntry >::const_iterator itEntry = mEntries.begin();
+
+  for (size_t Column = 0, Columns = mSize + mNumParameters; Column < Columns; ++Column)
+    {
+      pDerivatives[Column] = 1.0;
+
+      std::vector< sOperation >::const_iterator endOperation = mOperations.begin() + mColumnOperations[Column + 1];
+
+      for (; itOperation != endOperation; ++itOperation)
+        {
+          pDerivatives[itOperation->target] += pPartialValues[itOperation->partial] * pDerivatives[itOperation->source];
+        }
+
+      std::vector< sEntry >::const_iterator endEntry = mEntries.begin() + mColumnEntries[Column + 1];
+
+      for (; itEntry != endEntry; ++itEntry, ++pValue)
+        {
+          *pValue = pDerivatives[mRowNodes[itEntry->row]];
+        }
+
+      std::vector< size_t >::const_iterator endReset = mResetNodes.begin() + mColumnResetNodes[Column + 1];
+
+      for (; itReset != endReset; ++itReset)
+        {
+          pDerivatives[*itReset] = 0.0;
+        }
+    }
+}
+
+const size_t & CMathJacobian::size() const
+{
+  return mSize;
+}
+
+const size_t & CMathJacobian::getNumParameters() const
+{
+  return mNumParameters;
+}
+
+const std::vector< CMathJacobian::sEntry > & CMathJacobian::getEntries() const
+{
+  return mEntries;
+}
+
+const CVector< C_FLOAT64 > & CMathJacobian::getValues() const
+{
+  return mValues;
+}
+
+const size_t & CMathJacobian::getLowerBandwidth() const
+{
+  return mLowerBandwidth;
+}
+
+const size_t & CMathJacobian::getUpperBandwidth() const
+{
+  return mUpperBandwidth;
+}
+
+void CMathJacobian::getDense(CMatrix< C_FLOAT64 > & jacobian) const
+{
+  jacobian.resize(mSize, mSize);
+  jacobian = 0.0;
+
+  if (!mValid) return;
+
+  std::vector< sEntry >::const_iterator it = mEntries.begin();
+  std::vector< sEntry >::const_iterator end = mEntries.begin() + mColumnEntries[mSize];
+  const C_FLOAT64 * pValue = mValues.array();
+
+  for (; it != end; ++it, ++pValue)
+    {
+      jacobian(it->row, it->column) = *pValue;
+    }
+}
+
+void CMathJacobian::getColumnMajor(C_FLOAT64 * pd, const size_t & nRowPD) const
+{
+  if (!mValid) return;
+
+  std::vector< sEntry >::const_iterator it = mEntries.begin();
+  std::vector< sEntry >::const_iterator end = mEntries.begin() + mColumnEntries[mSize];
+  const C_FLOAT64 * pValue = mValues.array();
+
+  for (; it != end; ++it, ++pValue)
+    {
+      pd[it->row + it->column * nRowPD] = *pValue;
+    }
+}
+
+void CMathJacobian::getBanded(C_FLOAT64 * pd, const size_t & mu, const size_t & nRowPD) const
+{
+  if (!mValid) return;
+
+  std::vector< sEntry >::const_iterator it = mEntries.begin();
+  std::vector< sEntry >::const_iterator end = mEntries.begin() + mColumnEntries[mSize];
+  const C_FLOAT64 * pValue = mValues.array();
+
+  for (; it != end; ++it, ++pValue)
+    {
+      pd[it->row + mu - it->column + it->column * nRowPD] = *pValue;
+    }
+}
+
+void CMathJacobian::getParameterDerivatives(CMatrix< C_FLOAT64 > & derivatives) const
+{
+  derivatives.resize(mSize, mNumParameters);
+  derivatives = 0.0;
+
+  if (!mValid) return;
+
+  std::vector< sEntry >::const_iterator it = mEntries.begin() + mColumnEntries[mSize];
+  std::vector< sEntry >::const_iterator end = mEntries.end();
+  const C_FLOAT64 * pValue = mValues.array() + mColumnEntries[mSize];
+
+  for (; it != end; ++it, ++pValue)
+    {
+      derivatives(it->row, it->column - mSize) = *pValue;
+    }
+}
@@ -0,0 +1,268 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#ifndef COPASI_CMathJacobian
+#define COPASI_CMathJacobian
+
+#include <vector>
+#include <cstddef>
+
+#include "copasi/core/CVector.h"
+#include "copasi/core/CMatrix.h"
+#include "copasi/math/CMathUpdateSequence.h"
+
+class CMathContainer;
+class CMathExpression;
+
+/**
+ * This class calculates the Jacobian of the rates of the state variables of a math container
+ * analytically. The partial derivatives of each simulated value with respect to the values it directly
+ * depends on are created symbolically (see CMathDerive) when compiled and chained according to the
+ * simulation update sequence of the container. Only the structurally non-zero entries are calculated.
+ */
+class CMathJacobian
+{
+public:
+  /**
+   * A structural non-zero entry of the Jacobian
+   */
+  struct sEntry
+  {
+    size_t row;
+    size_t column;
+  };
+
+private:
+  /**
+   * A single accumulation step: derivative[target] += partial[partial] * derivative[source]
+   */
+  struct sOperation
+  {
+    size_t target;
+    size_t source;
+    size_t partial;
+  };
+
+  /**
+   * Hidden copy constructor
+   */
+  CMathJacobian(const CMathJacobian & src);
+
+  /**
+   * Hidden assignment operator
+   */
+  CMathJacobian & operator = (const CMathJacobian & rhs);
+
+public:
+  /**
+   * Default constructor
+   */
+  CMathJacobian();
+
+  /**
+   * Destructor
+   */
+  ~CMathJacobian();
+
+  /**
+   * Compile the Jacobian for the given container. The columns (and rows) of the Jacobian
+   * correspond to the state variables excluding fixed event targets. If includeTime is false
+   * the time is not considered a state variable.
+   * @param CMathContainer & container
+   * @param const bool & reduced
+   * @param const bool & includeTime
+   * @return bool success
+   */
+  bool compile(CMathContainer & container, const bool & reduced, const bool & includeTime);
+
+  /**
+   * Compile the Jacobian for the given container extended by the derivatives of the rates with
+   * respect to the given parameters. The parameter columns follow the state columns. Values which
+   * depend on the parameters but are not calculated during simulation must be contained in the
+   * parameter sequence. A NULL parameter results in a zero column.
+   * @param CMathContainer & container
+   * @param const bool & reduced
+   * @param const bool & includeTime
+   * @param const CVectorCore< C_FLOAT64 * > & parameters
+   * @param const CCore::CUpdateSequence & parameterSequence
+   * @return bool success
+   */
+  bool compile(CMathContainer & container, const bool & reduced, const bool & includeTime,
+               const CVectorCore< C_FLOAT64 * > & parameters,
+               const CCore::CUpdateSequence & parameterSequence);
+
+  /**
+   * Check whether all derivatives could be created symbolically
+   * @return const bool & isValid
+   */
+  const bool & isValid() const;
+
+  /**
+   * Calculate the non-zero entries of the Jacobian. It is assumed that the simulated values
+   * of the container are up to date.
+   */
+  void calculate();
+
+  /**
+   * Retrieve the dimension of the (square) Jacobian
+   * @return const size_t & size
+   */
+  const size_t & size() const;
+
+  /**
+   * Retrieve the number of parameter columns
+   * @return const size_t & numParameters
+   */
+  const size_t & getNumParameters() const;
+
+  /**
+   * Retrieve the structural non-zero entries ordered by column. The entries of the parameter
+   * columns (column >= size()) follow the ones of the state columns.
+   * @return const std::vector< sEntry > & entries
+   */
+  const std::vector< sEntry > & getEntries() const;
+
+  /**
+   * Retrieve the values of the non-zero entries in the order of the entries
+   * @return const CVector< C_FLOAT64 > & values
+   */
+  const CVector< C_FLOAT64 > & getValues() const;
+
+  /**
+   * Retrieve the number of sub diagonals
+   * @return const size_t & lowerBandwidth
+   */
+  const size_t & getLowerBandwidth() const;
+
+  /**
+   * Retrieve the number of super diagonals
+   * @return const size_t & upperBandwidth
+   */
+  const size_t & getUpperBandwidth() const;
+
+  /**
+   * Copy the calculated values of the state columns into a dense row major matrix
+   * @param CMatrix< C_FLOAT64 > & jacobian
+   */
+  void getDense(CMatrix< C_FLOAT64 > & jacobian) const;
+
+  /**
+   * Copy the calculated values of the state columns into a column major array with leading dimension nRowPD as
+   * expected by LSODA for a full Jacobian. The array must be initialized to zero.
+   * @param C_FLOAT64 * pd
+   * @param const size_t & nRowPD
+   */
+  void getColumnMajor(C_FLOAT64 * pd, const size_t & nRowPD) const;
+
+  /**
+   * Copy the calculated values of the state columns into a column major banded array with leading dimension nRowPD
+   * as expected by LSODA for a banded Jacobian, i.e., J(i, j) is stored in pd[i - j + mu + j * nRowPD].
+   * The array must be initialized to zero.
+   * @param C_FLOAT64 * pd
+   * @param const size_t & mu
+   * @param const size_t & nRowPD
+   */
+  void getBanded(C_FLOAT64 * pd, const size_t & mu, const size_t & nRowPD) const;
+
+  /**
+   * Copy the calculated derivatives of the rates with respect to the parameters into a dense
+   * row major matrix
+   * @param CMatrix< C_FLOAT64 > & derivatives
+   */
+  void getParameterDerivatives(CMatrix< C_FLOAT64 > & derivatives) const;
+
+private:
+  /**
+   * Destroy the compiled partial derivatives
+   */
+  void clear();
+
+  /**
+   * Indicates whether all derivatives could be created
+   */
+  bool mValid;
+
+  /**
+   * The dimension of the Jacobian
+   */
+  size_t mSize;
+
+  /**
+   * The number of parameter columns
+   */
+  size_t mNumParameters;
+
+  /**
+   * The number of sub diagonals
+   */
+  size_t mLowerBandwidth;
+
+  /**
+   * The number of super diagonals
+   */
+  size_t mUpperBandwidth;
+
+  /**
+   * The partial derivatives which need to be evaluated during calculate
+   */
+  std::vector< CMathExpression * > mPartials;
+
+  /**
+   * The index of each partial derivative in mPartialValues
+   */
+  std::vector< size_t > mPartialIndex;
+
+  /**
+   * The values of the partial derivatives, constant ones are only calculated during compile.
+   */
+  CVector< C_FLOAT64 > mPartialValues;
+
+  /**
+   * The derivatives of all nodes with respect to the current column
+   */
+  CVector< C_FLOAT64 > mDerivatives;
+
+  /**
+   * The accumulation steps for all columns
+   */
+  std::vector< sOperation > mOperations;
+
+  /**
+   * The first operation of each column, the last element marks the end.
+   */
+  std::vector< size_t > mColumnOperations;
+
+  /**
+   * The nodes which need to be reset for each column
+   */
+  std::vector< size_t > mResetNodes;
+
+  /**
+   * The first reset node of each column, the last element marks the end.
+   */
+  std::vector< size_t > mColumnResetNodes;
+
+  /**
+   * The node index of the rate of each row, C_INVALID_INDEX if the rate is constant
+   */
+  std::vector< size_t > mRowNodes;
+
+  /**
+   * The structural non-zero entries ordered by column
+   */
+  std::vector< sEntry > mEntries;
+
+  /**
+   * The first entry of each column, the last element marks the end.
+   */
+  std::vector< size_t > mColumnEntries;
+
+  /**
+   * The values of the non-zero entries
+   */
+  CVector< C_FLOAT64 > mValues;
+};
+
+#endif // COPASI_CMathJacobian
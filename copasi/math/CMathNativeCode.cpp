@@ -0,0 +1,790 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#include <fstream>
+#include <iomanip>
+#include <locale>
+#include <cmath>
+#include <cstdlib>
+
+#ifndef WIN32
+# include <cerrno>
+# include <dlfcn.h>
+# include <unistd.h>
+# include <sys/stat.h>
+# include <sys/types.h>
+# include <sys/wait.h>
+#endif // not WIN32
+
+#include "copasi/copasi.h"
+
+#include "copasi/math/CMathNativeCode.h"
+
+#include "copasi/math/CMathUpdateSequence.h"
+#include "copasi/math/CMathExpression.h"
+#include "copasi/function/CEvaluationNode.h"
+#include "copasi/commandline/COptions.h"
+#include "copasi/commandline/CLocaleString.h"
+#include "copasi/utilities/CDirEntry.h"
+#include "copasi/utilities/CCopasiMessage.h"
+
+// Helper functions reproducing the semantics of CEvaluationNodeFunction, CEvaluationNodeOperator,
+// and CEvaluationNodeLogical
+static const char * NativeCodePrologue =
+  "/* Generated by COPASI */\n"
+  "#include <math.h>\n"
+  "\n"
+  "static double copasi_sec(double x) {return 1.0 / cos(x);}\n"
+  "static double copasi_csc(double x) {return 1.0 / sin(x);}\n"
+  "static double copasi_cot(double x) {return 1.0 / tan(x);}\n"
+  "static double copasi_sech(double x) {return 1.0 / cosh(x);}\n"
+  "static double copasi_csch(double x) {return 1.0 / sinh(x);}\n"
+  "static double copasi_coth(double x) {return 1.0 / tanh(x);}\n"
+  "static double copasi_arcsec(double x) {return acos(1.0 / x);}\n"
+  "static double copasi_arccsc(double x) {return asin(1.0 / x);}\n"
+  "static double copasi_arccot(double x) {return atan(1.0 / x);}\n"
+  "static double copasi_asech(double x) {return acosh(1.0 / x);}\n"
+  "static double copasi_acsch(double x) {return asinh(1.0 / x);}\n"
+  "static double copasi_acoth(double x) {return atanh(1.0 / x);}\n"
+  "static double copasi_sign(double x) {return (x < 0.0) ? -1.0 : (x > 0.0) ? 1.0 : 0.0;}\n"
+  "static double copasi_not(double x) {return (x != 0.0) ? 0.0 : 1.0;}\n"
+  "static double copasi_max(double x, double y) {return (x < y) ? y : x;}\n"
+  "static double copasi_min(double x, double y) {return (y < x) ? y : x;}\n"
+  "static double copasi_xor(double x, double y)\n"
+  "{\n"
+  "  return ((x > 0.5 && y < 0.5) || (x < 0.5 && y > 0.5)) ? 1.0 : 0.0;\n"
+  "}\n"
+  "static double copasi_modulus(double x, double y)\n"
+  "{\n"
+  "  if ((int) y == 0) return NAN;\n"
+  "  return (double)(((int) x) % ((int) y));\n"
+  "}\n"
+  "static double copasi_factorial(double x)\n"
+  "{\n"
+  "  double Value = 1.0, Result = 1.0;\n"
+  "  if (x < 0.0 || x != ceil(x)) return NAN;\n"
+  "  if (x > 170) return INFINITY;\n"
+  "  if (x == 0.0) return 1.0;\n"
+  "  while (Value < x) Result *= ++Value;\n"
+  "  return Result;\n"
+  "}\n"
+  "\n";
+
+CMathNativeCode::CMathNativeCode():
+  mpValues(NULL),
+  mSize(0),
+  mSource(),
+  mFunctionNames(),
+  mFunctions(),
+  mpHandle(NULL)
+{}
+
+CMathNativeCode::~CMathNativeCode()
+{
+  clear();
+}
+
+void CMathNativeCode::clear()
+{
+#ifndef WIN32
+
+  if (mpHandle != NULL)
+    {
+      dlclose(mpHandle);
+    }
+
+#endif // not WIN32
+
+  mpHandle = NULL;
+  mpValues = NULL;
+  mSize = 0;
+  mSource.clear();
+  mFunctionNames.clear();
+  mFunctions.clear();
+}
+
+// static
+bool CMathNativeCode::isSupported()
+{
+#ifdef WIN32
+  return false;
+#else
+  return true;
+#endif // WIN32
+}
+
+bool CMathNativeCode::compile(const CVectorCore< C_FLOAT64 > & values,
+                              const std::vector< const CMathUpdateSequence * > & sequences)
+{
+  clear();
+
+  mpValues = values.array();
+  mSize = values.size();
+
+  std::ostringstream Source;
+  Source.imbue(std::locale::classic());
+  Source << NativeCodePrologue;
+
+  bool Compiled = false;
+
+  for (size_t i = 0; i < sequences.size(); ++i)
+    {
+      std::ostringstream Body;
+      Body.imbue(std::locale::classic());
+
+      if (sequences[i] == NULL ||
+          !isSupported() ||
+          !generateSequence(*sequences[i], Body))
+        {
+          mFunctionNames.push_back("");
+          continue;
+        }
+
+      std::ostringstream Name;
+      Name << "copasi_sequence_" << i;
+      mFunctionNames.push_back(Name.str());
+
+      Source << "void " << Name.str() << "(double * v)" << std::endl;
+      Source << "{" << std::endl;
+      Source << Body.str();
+      Source << "}" << std::endl << std::endl;
+
+      Compiled = true;
+    }
+
+  mSource = Source.str();
+  mFunctions.resize(mFunctionNames.size(), NULL);
+
+  if (!Compiled || !load())
+    {
+      clear();
+      return false;
+    }
+
+  return true;
+}
+
+CMathNativeCode::Function CMathNativeCode::getFunction(const size_t & index) const
+{
+  if (index < mFunctions.size())
+    return mFunctions[index];
+
+  return NULL;
+}
+
+const std::string & CMathNativeCode::getSource() const
+{
+  return mSource;
+}
+
+bool CMathNativeCode::generateSequence(const CMathUpdateSequence & sequence, std::ostringstream & body) const
+{
+  if (!sequence.isFrozen())
+    {
+      sequence.freeze();
+    }
+
+  std::vector< CMathUpdateSequence::sOperation >::const_iterator it = sequence.getOperations().begin();
+  std::vector< CMathUpdateSequence::sOperation >::const_iterator end = sequence.getOperations().end();
+
+  for (; it != end; ++it)
+    {
+      std::ostringstream Code;
+      Code.imbue(std::locale::classic());
+
+      bool success = true;
+
+      switch (it->type)
+        {
+          case CMathUpdateSequence::OperationType::Expression:
+            success &= generateNode(it->pExpression->getRoot(), Code);
+            break;
+
+          case CMathUpdateSequence::OperationType::ExtensiveValue:
+            Code << "(";
+            success &= generateValue(it->pArg1, Code);
+            Code << " * ";
+            success &= generateValue(it->pArg2, Code);
+            Code << ") * ";
+            success &= generateValue(it->pArg3, Code);
+            break;
+
+          case CMathUpdateSequence::OperationType::IntensiveValue:
+            success &= generateValue(it->pArg1, Code);
+            Code << " / (";
+            success &= generateValue(it->pArg2, Code);
+            Code << " * ";
+            success &= generateValue(it->pArg3, Code);
+            Code << ")";
+            break;
+
+          case CMathUpdateSequence::OperationType::ParticleFlux:
+            success &= generateValue(it->pArg1, Code);
+            Code << " * ";
+            success &= generateValue(it->pArg3, Code);
+            break;
+
+          case CMathUpdateSequence::OperationType::ExtensiveReactionRate:
+            Code << "0.0";
+
+            for (size_t i = 0; i < it->count; ++i)
+              {
+                Code << " + ";
+                generateNumber(it->pStoichiometry[i], Code);
+                Code << " * ";
+                success &= generateValue(it->ppRates[i], Code);
+              }
+
+            break;
+
+          case CMathUpdateSequence::OperationType::Propensity:
+            Code << "copasi_max(0.0, ";
+            success &= generateValue(it->pArg1, Code);
+            Code << ")";
+            break;
+
+          case CMathUpdateSequence::OperationType::Generic:
+            success = false;
+            break;
+        }
+
+      if (!success)
+        return false;
+
+      body << "  ";
+
+      if (!generateValue(it->pResult, body))
+        return false;
+
+      body << " = " << Code.str() << ";" << std::endl;
+    }
+
+  return true;
+}
+
+bool CMathNativeCode::generateNode(const CEvaluationNode * pNode, std::ostringstream & code) const
+{
+  if (pNode == NULL)
+    return false;
+
+  const CEvaluationNode * pChild1 = static_cast< const CEvaluationNode * >(pNode->getChild());
+  const CEvaluationNode * pChild2 = pChild1 != NULL ? static_cast< const CEvaluationNode * >(pChild1->getSibling()) : NULL;
+  const CEvaluationNode * pChild3 = pChild2 != NULL ? static_cast< const CEvaluationNode * >(pChild2->getSibling()) : NULL;
+
+  const char * Function = NULL;
+  const char * Operator = NULL;
+  bool success = true;
+
+  switch (pNode->mainType())
+    {
+      case CEvaluationNode::MainType::NUMBER:
+      case CEvaluationNode::MainType::CONSTANT:
+        generateNumber(*pNode->getValuePointer(), code);
+        return true;
+
+      case CEvaluationNode::MainType::OBJECT:
+        if (pNode->subType() != CEvaluationNode::SubType::POINTER)
+          return false;
+
+        return generateValue(static_cast< const CEvaluationNodeObject * >(pNode)->getObjectValuePtr(), code);
+
+      case CEvaluationNode::MainType::OPERATOR:
+        if (pChild2 == NULL)
+          return false;
+
+        switch (pNode->subType())
+          {
+            case CEvaluationNode::SubType::PLUS:
+              Operator = " + ";
+              break;
+
+            case CEvaluationNode::SubType::MINUS:
+              Operator = " - ";
+              break;
+
+            case CEvaluationNode::SubType::MULTIPLY:
+              Operator = " * ";
+              break;
+
+            case CEvaluationNode::SubType::DIVIDE:
+              Operator = " / ";
+              break;
+
+            case CEvaluationNode::SubType::POWER:
+              Function = "pow";
+              break;
+
+            case CEvaluationNode::SubType::MODULUS:
+              Function = "copasi_modulus";
+              break;
+
+            case CEvaluationNode::SubType::REMAINDER:
+              Function = "fmod";
+              break;
+
+            default:
+              return false;
+          }
+
+        break;
+
+      case CEvaluationNode::MainType::FUNCTION:
+        switch (pNode->subType())
+          {
+            case CEvaluationNode::SubType::LOG:
+              Function = "log";
+              break;
+
+            case CEvaluationNode::SubType::LOG10:
+              Function = "log10";
+              break;
+
+            case CEvaluationNode::SubType::EXP:
+              Function = "exp";
+              break;
+
+            case CEvaluationNode::SubType::SIN:
+              Function = "sin";
+              break;
+
+            case CEvaluationNode::SubType::COS:
+              Function = "cos";
+              break;
+
+            case CEvaluationNode::SubType::TAN:
+              Function = "tan";
+              break;
+
+            case CEvaluationNode::SubType::SEC:
+              Function = "copasi_sec";
+              break;
+
+            case CEvaluationNode::SubType::CSC:
+              Function = "copasi_csc";
+              break;
+
+            case CEvaluationNode::SubType::COT:
+              Function = "copasi_cot";
+              break;
+
+            case CEvaluationNode::SubType::SINH:
+              Function = "sinh";
+              break;
+
+            case CEvaluationNode::SubType::COSH:
+              Function = "cosh";
+              break;
+
+            case CEvaluationNode::SubType::TANH:
+              Function = "tanh";
+              break;
+
+            case CEvaluationNode::SubType::SECH:
+              Function = "copasi_sech";
+              break;
+
+            case CEvaluationNode::SubType::CSCH:
+              Function = "copasi_csch";
+              break;
+
+            case CEvaluationNode::SubType::COTH:
+              Function = "copasi_coth";
+              break;
+
+            case CEvaluationNode::SubType::ARCSIN:
+              Function = "asin";
+              break;
+
+            case CEvaluationNode::SubType::ARCCOS:
+              Function = "acos";
+              break;
+
+            case CEvaluationNode::SubType::ARCTAN:
+              Function = "atan";
+              break;
+
+            case CEvaluationNode::SubType::ARCSEC:
+              Function = "copasi_arcsec";
+              break;
+
+            case CEvaluationNode::SubType::ARCCSC:
+              Function = "copasi_arccsc";
+              break;
+
+            case CEvaluationNode::SubType::ARCCOT:
+              Function = "copasi_arccot";
+              break;
+
+            case CEvaluationNode::SubType::ARCSINH:
+              Function = "asinh";
+              break;
+
+            case CEvaluationNode::SubType::ARCCOSH:
+              Function = "acosh";
+              break;
+
+            case CEvaluationNode::SubType::ARCTANH:
+              Function = "atanh";
+              break;
+
+            case CEvaluationNode::SubType::ARCSECH:
+              Function = "copasi_asech";
+              break;
+
+            case CEvaluationNode::SubType::ARCCSCH:
+              Function = "copasi_acsch";
+              break;
+
+            case CEvaluationNode::SubType::ARCCOTH:
+              Function = "copasi_acoth";
+              break;
+
+            case CEvaluationNode::SubType::SIGN:
+              Function = "copasi_sign";
+              break;
+
+            case CEvaluationNode::SubType::SQRT:
+              Function = "sqrt";
+              break;
+
+            case CEvaluationNode::SubType::ABS:
+              Function = "fabs";
+              break;
+
+            case CEvaluationNode::SubType::FLOOR:
+              Function = "floor";
+              break;
+
+            case CEvaluationNode::SubType::CEIL:
+              Function = "ceil";
+              break;
+
+            case CEvaluationNode::SubType::FACTORIAL:
+              Function = "copasi_factorial";
+              break;
+
+            case CEvaluationNode::SubType::MINUS:
+              Function = "-";
+              break;
+
+            case CEvaluationNode::SubType::PLUS:
+              Function = "";
+              break;
+
+            case CEvaluationNode::SubType::NOT:
+              Function = "copasi_not";
+              break;
+
+            case CEvaluationNode::SubType::MAX:
+              Function = "copasi_max";
+              break;
+
+            case CEvaluationNode::SubType::MIN:
+              Function = "copasi_min";
+              break;
+
+            default:
+              // Random number generators must use the generator of the container
+              return false;
+          }
+
+        break;
+
+      case CEvaluationNode::MainType::CHOICE:
+        if (pChild3 == NULL)
+          return false;
+
+        code << "((";
+        success &= generateNode(pChild1, code);
+        code << " > 0.5) ? ";
+        success &= generateNode(pChild2, code);
+        code << " : ";
+        success &= generateNode(pChild3, code);
+        code << ")";
+
+        return success;
+
+      case CEvaluationNode::MainType::LOGICAL:
+        if (pChild2 == NULL)
+          return false;
+
+        code << "((";
+
+        switch (pNode->subType())
+          {
+            case CEvaluationNode::SubType::OR:
+              success &= generateNode(pChild1, code);
+              code << " > 0.5 || ";
+              success &= generateNode(pChild2, code);
+              code << " > 0.5";
+              break;
+
+            case CEvaluationNode::SubType::XOR:
+              code << "copasi_xor(";
+              success &= generateNode(pChild1, code);
+              code << ", ";
+              success &= generateNode(pChild2, code);
+              code << ") != 0.0";
+              break;
+
+            case CEvaluationNode::SubType::AND:
+              success &= generateNode(pChild1, code);
+              code << " > 0.5 && ";
+              success &= generateNode(pChild2, code);
+              code << " > 0.5";
+              break;
+
+            case CEvaluationNode::SubType::EQ:
+              Operator = " == ";
+              break;
+
+            case CEvaluationNode::SubType::NE:
+              Operator = " != ";
+              break;
+
+            case CEvaluationNode::SubType::GT:
+              Operator = " > ";
+              break;
+
+            case CEvaluationNode::SubType::GE:
+              Operator = " >= ";
+              break;
+
+            case CEvaluationNode::SubType::LT:
+              Operator = " < ";
+              break;
+
+            case CEvaluationNode::SubType::LE:
+              Operator = " <= ";
+              break;
+
+            default:
+              return false;
+          }
+
+        if (Operator != NULL)
+          {
+            success &= generateNode(pChild1, code);
+            code << Operator;
+            success &= generateNode(pChild2, code);
+          }
+
+        code << ") ? 1.0 : 0.0)";
+
+        return success;
+
+      default:
+        // Delays, calls, vectors, and other nodes are not supported.
+        return false;
+    }
+
+  if (Operator != NULL)
+    {
+      code << "(";
+      success &= generateNode(pChild1, code);
+      code << Operator;
+      success &= generateNode(pChild2, code);
+      code << ")";
+
+      return success;
+    }
+
+  if (pChild1 == NULL)
+    return false;
+
+  code << "(" << Function << "(";
+  success &= generateNode(pChild1, code);
+
+  if (pChild2 != NULL)
+    {
+      code << ", ";
+      success &= generateNode(pChild2, code);
+    }
+
+  code << "))";
+
+  return success;
+}
+
+bool CMathNativeCode::generateValue(const C_FLOAT64 * pValue, std::ostringstream & code) const
+{
+  if (pValue < mpValues ||
+      pValue >= mpValues + mSize)
+    return false;
+
+  code << "v[" << pValue - mpValues << "]";
+
+  return true;
+}
+
+// static
+void CMathNativeCode::generateNumber(const C_FLOAT64 & value, std::ostringstream & code)
+{
+  if (std::isnan(value))
+    {
+      code << "NAN";
+    }
+  else if (std::isinf(value))
+    {
+      code << (value > 0 ? "INFINITY" : "(-INFINITY)");
+    }
+  else
+    {
+      code << "(" << std::scientific << std::setprecision(17) << value << ")";
+    }
+}
+
+// static
+bool CMathNativeCode::isPrivate(const std::string & path, const bool & isDirectory)
+{
+#ifdef WIN32
+  return false;
+#else
+  struct stat Status;
+
+  // We do not follow symbolic links
+  if (lstat(path.c_str(), &Status) != 0)
+    return false;
+
+  if (isDirectory ? !S_ISDIR(Status.st_mode) : !S_ISREG(Status.st_mode))
+    return false;
+
+  if (Status.st_uid != getuid())
+    return false;
+
+  // The directory must not be accessible and the object must not be writable by others.
+  if (isDirectory)
+    return (Status.st_mode & (S_IRWXG | S_IRWXO)) == 0;
+
+  return (Status.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+#endif // WIN32
+}
+
+bool CMathNativeCode::load()
+{
+#ifdef WIN32
+  return false;
+#else
+  // The key of the cache is a FNV-1a hash of the source
+  unsigned C_INT64 Hash = 14695981039346656037ULL;
+  std::string::const_iterator it = mSource.begin();
+  std::string::const_iterator end = mSource.end();
+
+  for (; it != end; ++it)
+    {
+      Hash ^= (unsigned char) *it;
+      Hash *= 1099511628211ULL;
+    }
+
+  std::string Dir;
+  COptions::getValue("Tmp", Dir);
+
+  if (Dir.empty())
+    Dir = "/tmp";
+
+  // The cache is private to the user since its content is loaded into the process.
+  std::ostringstream User;
+  User << getuid();
+
+  Dir += CDirEntry::Separator + "copasi-native-" + User.str();
+
+  if (mkdir(Dir.c_str(), S_IRWXU) != 0 &&
+      errno != EEXIST)
+    return false;
+
+  if (!isPrivate(Dir, true))
+    {
+      CCopasiMessage(CCopasiMessage::WARNING, "Native code cache '%s' is not private to the user.", Dir.c_str());
+      return false;
+    }
+
+  std::ostringstream Key;
+  Key << std::hex << std::setw(16) << std::setfill('0') << Hash;
+
+  std::string SharedObject = Dir + CDirEntry::Separator + "model-" + Key.str() + ".so";
+
+  if (!CDirEntry::exist(SharedObject))
+    {
+      std::string TmpName = CDirEntry::createTmpName(Dir, "");
+      std::string SourceFile = TmpName + ".c";
+      std::string TmpObject = TmpName + ".so";
+
+      std::ofstream os(CLocaleString::fromUtf8(SourceFile).c_str());
+
+      if (os.fail())
+        return false;
+
+      os << mSource;
+      os.close();
+
+      // COPASI_CC may only name the compiler, the arguments are passed without a shell.
+      const char * pCompiler = getenv("COPASI_CC");
+
+      if (pCompiler == NULL || *pCompiler == 0)
+        pCompiler = "cc";
+
+      const char * Arguments[] =
+      {
+        pCompiler, "-O2", "-shared", "-fPIC", "-o", TmpObject.c_str(), SourceFile.c_str(), "-lm", NULL
+      };
+
+      bool Success = false;
+      pid_t Pid = fork();
+
+      if (Pid == 0)
+        {
+          execvp(pCompiler, const_cast< char * const * >(Arguments));
+          _exit(127);
+        }
+      else if (Pid > 0)
+        {
+          int Status = 0;
+
+          while (waitpid(Pid, &Status, 0) < 0 && errno == EINTR) {}
+
+          Success = WIFEXITED(Status) && WEXITSTATUS(Status) == 0;
+        }
+
+      CDirEntry::remove(SourceFile);
+
+      if (!Success ||
+          !CDirEntry::exist(TmpObject) ||
+          chmod(TmpObject.c_str(), S_IRWXU) != 0)
+        {
+          CDirEntry::remove(TmpObject);
+          CCopasiMessage(CCopasiMessage::WARNING, "Compilation of native code failed: %s", pCompiler);
+          return false;
+        }
+
+      // Another process may have created the same object concurrently which is fine.
+      if (!CDirEntry::move(TmpObject, SharedObject))
+        {
+          CDirEntry::remove(TmpObject);
+        }
+    }
+
+  if (!isPrivate(SharedObject, false))
+    {
+      CCopasiMessage(CCopasiMessage::WARNING, "Native code '%s' is not private to the user.", SharedObject.c_str());
+      return false;
+    }
+
+  mpHandle = dlopen(SharedObject.c_str(), RTLD_NOW | RTLD_LOCAL);
+
+  if (mpHandle == NULL)
+    {
+      CCopasiMessage(CCopasiMessage::WARNING, "Loading of native code failed: %s", dlerror());
+      return false;
+    }
+
+  for (size_t i = 0; i < mFunctionNames.size(); ++i)
+    if (!mFunctionNames[i].empty())
+      {
+        mFunctions[i] = (Function) dlsym(mpHandle, mFunctionNames[i].c_str());
+      }
+
+  return true;
+#endif // WIN32
+}
@@ -0,0 +1,168 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#ifndef COPASI_CMathNativeCode
+#define COPASI_CMathNativeCode
+
+#include <vector>
+#include <string>
+#include <sstream>
+
+#include "copasi/core/CVector.h"
+
+class CMathUpdateSequence;
+class CEvaluationNode;
+
+/**
+ * This class translates update sequences of a math container into C code. The code is
+ * compiled with the system compiler into a shared object which is loaded into the process.
+ * The generated functions operate on the values of the container, i.e., they remain valid
+ * as long as the container is not compiled or relocated. Shared objects are cached in the
+ * temporary directory keyed by a hash of the generated code, i.e., of the mathematics of
+ * the model, so that the compile cost is only paid once per model.
+ *
+ * The compiler is given by the environment variable COPASI_CC (default: cc). Sequences
+ * which can not be translated, e.g., due to random number generators or delays, are
+ * not compiled and must be applied as usual.
+ */
+class CMathNativeCode
+{
+public:
+  typedef void (*Function)(C_FLOAT64 * pValues);
+
+private:
+  /**
+   * Hidden copy constructor
+   */
+  CMathNativeCode(const CMathNativeCode & src);
+
+  /**
+   * Hidden assignment operator
+   */
+  CMathNativeCode & operator = (const CMathNativeCode & rhs);
+
+public:
+  /**
+   * Default constructor
+   */
+  CMathNativeCode();
+
+  /**
+   * Destructor
+   */
+  ~CMathNativeCode();
+
+  /**
+   * Generate, compile, and load a function for each sequence.
+   * @param const CVectorCore< C_FLOAT64 > & values
+   * @param const std::vector< const CMathUpdateSequence * > & sequences
+   * @return bool success (true if at least one sequence is compiled)
+   */
+  bool compile(const CVectorCore< C_FLOAT64 > & values,
+               const std::vector< const CMathUpdateSequence * > & sequences);
+
+  /**
+   * Unload the shared object
+   */
+  void clear();
+
+  /**
+   * Retrieve the function for the sequence with the given index.
+   * @param const size_t & index
+   * @return Function function (NULL if the sequence could not be compiled)
+   */
+  Function getFunction(const size_t & index) const;
+
+  /**
+   * Retrieve the generated source code
+   * @return const std::string & source
+   */
+  const std::string & getSource() const;
+
+  /**
+   * Check whether native code can be compiled and loaded on this platform
+   * @return bool isSupported
+   */
+  static bool isSupported();
+
+private:
+  /**
+   * Generate the body of the function for the sequence
+   * @param const CMathUpdateSequence & sequence
+   * @param std::ostringstream & body
+   * @return bool success
+   */
+  bool generateSequence(const CMathUpdateSequence & sequence, std::ostringstream & body) const;
+
+  /**
+   * Generate the C code for the evaluation tree with the given root.
+   * @param const CEvaluationNode * pNode
+   * @param std::ostringstream & code
+   * @return bool success
+   */
+  bool generateNode(const CEvaluationNode * pNode, std::ostringstream & code) const;
+
+  /**
+   * Generate the reference to the value
+   * @param const C_FLOAT64 * pValue
+   * @param std::ostringstream & code
+   * @return bool success
+   */
+  bool generateValue(const C_FLOAT64 * pValue, std::ostringstream & code) const;
+
+  /**
+   * Generate a double literal
+   * @param const C_FLOAT64 & value
+   * @param std::ostringstream & code
+   */
+  static void generateNumber(const C_FLOAT64 & value, std::ostringstream & code);
+
+  /**
+   * Check whether the path is a directory or regular file owned by the user
+   * which can not be modified by others. Symbolic links are rejected.
+   * @param const std::string & path
+   * @param const bool & isDirectory
+   * @return bool isPrivate
+   */
+  static bool isPrivate(const std::string & path, const bool & isDirectory);
+
+  /**
+   * Compile the source into a shared object in the private cache of the user and load it.
+   * @return bool success
+   */
+  bool load();
+
+  /**
+   * The values of the container the code refers to
+   */
+  const C_FLOAT64 * mpValues;
+
+  /**
+   * The number of values of the container
+   */
+  size_t mSize;
+
+  /**
+   * The generated source
+   */
+  std::string mSource;
+
+  /**
+   * The names of the generated functions (empty if the sequence is not compiled)
+   */
+  std::vector< std::string > mFunctionNames;
+
+  /**
+   * The loaded functions
+   */
+  std::vector< Function > mFunctions;
+
+  /**
+   * The handle of the loaded shared object
+   */
+  void * mpHandle;
+};
+
+#endif // COPASI_CMathNativeCode
@@ -29,6 +29,7 @@ class CEvaluationNode;
 class CMathObject: public CObjectInterface
 {
   friend std::ostream &operator<<(std::ostream &os, const CMathObject & o);
+  friend class CMathUpdateSequence;
 
 public:
   typedef void (CMathObject::*calculate)();
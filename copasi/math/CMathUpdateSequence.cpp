@@ -13,19 +13,30 @@
 // of Manchester.
 // All rights reserved.
 
+#include <algorithm>
+
 #include "CMathUpdateSequence.h"
 #include "CMathContainer.h"
+#include "CMathObject.h"
+#include "CMathExpression.h"
+
+// static
+bool CMathUpdateSequence::mUseFrozen = true;
 
 CMathUpdateSequence::CMathUpdateSequence(CMathContainer * pContainer):
   CVector< CObjectInterface * >(),
-  mpContainer(NULL)
+  mpContainer(NULL),
+  mOperations(),
+  mFrozen(false)
 {
   setMathContainer(pContainer);
 }
 
 CMathUpdateSequence::CMathUpdateSequence(const CMathUpdateSequence & src, CMathContainer * pContainer):
   CVector< CObjectInterface * >(src),
-  mpContainer(NULL)
+  mpContainer(NULL),
+  mOperations(),
+  mFrozen(false)
 {
   if (pContainer != NULL)
     {
@@ -50,6 +61,7 @@ CMathUpdateSequence & CMathUpdateSequence::operator = (const CMathUpdateSequence
   if (this == &rhs)
     return *this;
 
+  thaw();
   CVector< CObjectInterface * >::operator = (rhs);
   setMathContainer(rhs.mpContainer);
 
@@ -58,6 +70,7 @@ CMathUpdateSequence & CMathUpdateSequence::operator = (const CMathUpdateSequence
 
 CMathUpdateSequence & CMathUpdateSequence::operator = (const std::vector< CObjectInterface * > & rhs)
 {
+  thaw();
   resize(rhs.size(), false);
 
   iterator itThis = begin();
@@ -75,6 +88,8 @@ CMathUpdateSequence & CMathUpdateSequence::operator = (const std::vector< CObjec
 
 void CMathUpdateSequence::insert(const CMathUpdateSequence::iterator & loc, const CObjectInterface * pObject)
 {
+  thaw();
+
   std::vector< CObjectInterface * > Insert(1, const_cast< CObjectInterface * >(pObject));
 
   insert(loc, Insert.begin(), Insert.end());
@@ -84,6 +99,8 @@ void CMathUpdateSequence::setMathContainer(CMathContainer * pContainer)
 {
   if (pContainer == mpContainer) return;
 
+  thaw();
+
   if (mpContainer != NULL)
     {
       mpContainer->deregisterUpdateSequence(this);
@@ -99,11 +116,16 @@ void CMathUpdateSequence::setMathContainer(CMathContainer * pContainer)
 
 CMathUpdateSequence::iterator CMathUpdateSequence::begin()
 {
+  // The objects may be modified through the iterator.
+  thaw();
+
   return CVectorCore< CObjectInterface * >::mpBuffer;
 }
 
 CMathUpdateSequence::iterator CMathUpdateSequence::end()
 {
+  thaw();
+
   return CVectorCore< CObjectInterface * >::mpBuffer + CVectorCore< CObjectInterface * >::mSize;
 }
 
@@ -129,5 +151,173 @@ bool CMathUpdateSequence::empty() const
 
 void CMathUpdateSequence::clear()
 {
+  thaw();
   resize(0);
 }
+
+void CMathUpdateSequence::apply() const
+{
+  if (!mUseFrozen)
+    {
+      const_iterator it = begin();
+      const_iterator itEnd = end();
+
+      for (; it != itEnd; ++it)
+        {
+          (*it)->calculateValue();
+        }
+
+      return;
+    }
+
+  if (!mFrozen)
+    {
+      freeze();
+    }
+
+  std::vector< sOperation >::const_iterator it = mOperations.begin();
+  std::vector< sOperation >::const_iterator itEnd = mOperations.end();
+
+  for (; it != itEnd; ++it)
+    {
+      switch (it->type)
+        {
+          case OperationType::Expression:
+            *it->pResult = it->pExpression->value();
+            break;
+
+          case OperationType::ExtensiveValue:
+            *it->pResult = *it->pArg1 * *it->pArg2 * *it->pArg3;
+            break;
+
+          case OperationType::IntensiveValue:
+            *it->pResult = *it->pArg1 / (*it->pArg2 * *it->pArg3);
+            break;
+
+          case OperationType::ParticleFlux:
+            *it->pResult = *it->pArg1 * *it->pArg3;
+            break;
+
+          case OperationType::ExtensiveReactionRate:
+          {
+            C_FLOAT64 Value = 0.0;
+            const C_FLOAT64 * pStoi = it->pStoichiometry;
+            const C_FLOAT64 * const * ppRate = it->ppRates;
+            const C_FLOAT64 * const * ppRateEnd = ppRate + it->count;
+
+            for (; ppRate != ppRateEnd; ++ppRate, ++pStoi)
+              {
+                Value += *pStoi * **ppRate;
+              }
+
+            *it->pResult = Value;
+          }
+          break;
+
+          case OperationType::Propensity:
+            *it->pResult = std::max(0.0, *it->pArg1);
+            break;
+
+          case OperationType::Generic:
+            it->pObject->calculateValue();
+            break;
+        }
+    }
+}
+
+void CMathUpdateSequence::freeze() const
+{
+  mOperations.clear();
+  mOperations.reserve(size());
+
+  const_iterator it = begin();
+  const_iterator itEnd = end();
+
+  for (; it != itEnd; ++it)
+    {
+      sOperation Operation;
+      Operation.type = OperationType::Generic;
+      Operation.pResult = NULL;
+      Operation.pArg1 = NULL;
+      Operation.pArg2 = NULL;
+      Operation.pArg3 = NULL;
+      Operation.pExpression = NULL;
+      Operation.pStoichiometry = NULL;
+      Operation.ppRates = NULL;
+      Operation.count = 0;
+      Operation.pObject = *it;
+
+      CMathObject * pObject = dynamic_cast< CMathObject * >(*it);
+
+      if (pObject != NULL &&
+          pObject->mpCalculate != NULL)
+        {
+          Operation.pResult = pObject->mpValue;
+          Operation.pArg1 = pObject->mpCorrespondingPropertyValue;
+          Operation.pArg2 = pObject->mpCompartmentValue;
+          Operation.pArg3 = pObject->mpQuantity2NumberValue;
+
+          if (pObject->mpCalculate == &CMathObject::calculateExpression &&
+              pObject->mpExpression != NULL)
+            {
+              Operation.type = OperationType::Expression;
+              Operation.pExpression = pObject->mpExpression;
+            }
+          else if (pObject->mpCalculate == &CMathObject::calculateExtensiveValue)
+            {
+              Operation.type = OperationType::ExtensiveValue;
+            }
+          else if (pObject->mpCalculate == &CMathObject::calculateIntensiveValue)
+            {
+              Operation.type = OperationType::IntensiveValue;
+            }
+          else if (pObject->mpCalculate == &CMathObject::calculateParticleFlux)
+            {
+              Operation.type = OperationType::ParticleFlux;
+            }
+          else if (pObject->mpCalculate == &CMathObject::calculateExtensiveReactionRate)
+            {
+              Operation.type = OperationType::ExtensiveReactionRate;
+              Operation.pStoichiometry = pObject->mStoichiometryVector.array();
+              Operation.ppRates = pObject->mRateVector.array();
+              Operation.count = pObject->mRateVector.size();
+            }
+          else if (pObject->mpCalculate == &CMathObject::calculatePropensity)
+            {
+              Operation.type = OperationType::Propensity;
+            }
+        }
+
+      mOperations.push_back(Operation);
+    }
+
+  mFrozen = true;
+}
+
+void CMathUpdateSequence::thaw() const
+{
+  mFrozen = false;
+  mOperations.clear();
+}
+
+const bool & CMathUpdateSequence::isFrozen() const
+{
+  return mFrozen;
+}
+
+const std::vector< CMathUpdateSequence::sOperation > & CMathUpdateSequence::getOperations() const
+{
+  return mOperations;
+}
+
+// static
+void CMathUpdateSequence::setUseFrozen(const bool & useFrozen)
+{
+  mUseFrozen = useFrozen;
+}
+
+// static
+const bool & CMathUpdateSequence::getUseFrozen()
+{
+  return mUseFrozen;
+}
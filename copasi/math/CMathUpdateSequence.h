@@ -20,13 +20,46 @@
 class CMathContainer;
 class CObjectInterface;
 class CMathObject;
-
+class CMathExpression;
+
+/**
+ * An update sequence is a list of objects which are calculated in order. Before the first
+ * application the sequence is frozen into a contiguous program of typed operations which
+ * refer directly to the values involved. This avoids the virtual calculateValue call and the
+ * dispatch through the calculate member function pointer of each math object. Any modification
+ * of the sequence or a relocation of its container thaws the sequence.
+ */
 class CMathUpdateSequence : protected CVector< CObjectInterface * >
 {
 public:
   typedef CObjectInterface ** iterator;
   typedef CObjectInterface *const * const_iterator;
 
+  enum struct OperationType
+  {
+    Expression,
+    ExtensiveValue,
+    IntensiveValue,
+    ParticleFlux,
+    ExtensiveReactionRate,
+    Propensity,
+    Generic
+  };
+
+  struct sOperation
+  {
+    OperationType type;
+    C_FLOAT64 * pResult;
+    const C_FLOAT64 * pArg1;
+    const C_FLOAT64 * pArg2;
+    const C_FLOAT64 * pArg3;
+    CMathExpression * pExpression;
+    const C_FLOAT64 * pStoichiometry;
+    const C_FLOAT64 * const * ppRates;
+    size_t count;
+    CObjectInterface * pObject;
+  };
+
   /**
    * Default Constructor
    * @param CMathContainer * pContainer (default: NULL)
@@ -62,6 +95,8 @@ public:
   template < typename InputIterator >
   void insert(const iterator & loc, InputIterator first, InputIterator last)
   {
+    thaw();
+
     size_t ToBeInserted = 0;
 
     for (InputIterator it = first; it != last; ++it, ++ToBeInserted) {}
@@ -151,8 +186,64 @@ public:
   bool empty() const;
   void clear();
 
+  /**
+   * Calculate the values of all objects in the sequence in order.
+   */
+  void apply() const;
+
+  /**
+   * Create the frozen program of typed operations from the current objects.
+   */
+  void freeze() const;
+
+  /**
+   * Discard the frozen program. This must be called whenever an object of the sequence
+   * is recompiled.
+   */
+  void thaw() const;
+
+  /**
+   * Check whether the sequence is frozen
+   * @return const bool & isFrozen
+   */
+  const bool & isFrozen() const;
+
+  /**
+   * Retrieve the frozen program
+   * @return const std::vector< sOperation > & operations
+   */
+  const std::vector< sOperation > & getOperations() const;
+
+  /**
+   * Set whether sequences are applied using the frozen program (default) or by calling
+   * calculateValue for each object.
+   * @param const bool & useFrozen
+   */
+  static void setUseFrozen(const bool & useFrozen);
+
+  /**
+   * Check whether sequences are applied using the frozen program
+   * @return const bool & useFrozen
+   */
+  static const bool & getUseFrozen();
+
 private:
   CMathContainer * mpContainer;
+
+  /**
+   * The frozen program
+   */
+  mutable std::vector< sOperation > mOperations;
+
+  /**
+   * Indicates whether the frozen program reflects the current objects
+   */
+  mutable bool mFrozen;
+
+  /**
+   * Indicates whether the frozen program is used to apply sequences
+   */
+  static bool mUseFrozen;
 };
 
 #endif // CMathUpdateSequence
@@ -94,7 +94,9 @@ bool COptMethodDE::replicate()
 
   bool Continue = true;
 
-  for (i = mPopulationSize; i < 2 * mPopulationSize && Continue; i++)
+  // The candidates of a generation are created first and evaluated together which allows
+  // for parallel evaluation. The random numbers are drawn in the same order as before.
+  for (i = mPopulationSize; i < 2 * mPopulationSize; i++)
     {
       mpPermutation->shuffle(3);
 
@@ -129,11 +131,10 @@ bool COptMethodDE::replicate()
           // account of the value.
           *mContainerVariables[j] = mut;
         }
-
-      Continue &= evaluate(*mIndividuals[i]);
-      mValues[i] = mEvaluationValue;
     }
 
+  Continue &= mpOptProblem->calculate(mIndividuals, mPopulationSize, 2 * mPopulationSize, mValues);
+
   //CROSSOVER MUTATED GENERATION WITH THE CURRENT ONE
   for (i = 2 * mPopulationSize; i < 3 * mPopulationSize && Continue; i++)
     {
@@ -168,11 +169,11 @@ bool COptMethodDE::replicate()
 
           *mContainerVariables[j] = mut;
         }
-
-      Continue &= evaluate(*mIndividuals[i]);
-      mValues[i] = mEvaluationValue;
     }
 
+  if (Continue)
+    Continue &= mpOptProblem->calculate(mIndividuals, 2 * mPopulationSize, 3 * mPopulationSize, mValues);
+
   //SELECT NEXT GENERATION
   for (i = 2 * mPopulationSize; i < 3 * mPopulationSize && Continue; i++)
     {
@@ -262,7 +263,7 @@ bool COptMethodDE::creation(size_t first, size_t last)
 
   bool Continue = true;
 
-  for (i = first; i < Last && Continue; i++)
+  for (i = first; i < Last; i++)
     {
       // We do not want to loose the best individual;
       if (mBestIndex != i)
@@ -312,12 +313,12 @@ bool COptMethodDE::creation(size_t first, size_t last)
             // account of the value.
             *mContainerVariables[j] = mut;
           }
-
-      // calculate its fitness
-      Continue &= evaluate(*mIndividuals[i]);
-      mValues[i] = mEvaluationValue;
     }
 
+  // calculate their fitness
+  if (first < Last)
+    Continue &= mpOptProblem->calculate(mIndividuals, first, Last, mValues);
+
   return Continue;
 }
 
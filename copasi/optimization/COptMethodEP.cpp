@@ -424,12 +424,12 @@ bool COptMethodEP::creation()
           // Set the variance for this parameter.
           (*mVariance[i])[j] = fabs(mut) * 0.5;
         }
-
-      // calculate its fitness
-      Continue = evaluate(*mIndividuals[i]);
-      mValues[i] = mEvaluationValue;
     }
 
+  // calculate their fitness
+  if (Continue)
+    Continue = mpOptProblem->calculate(mIndividuals, 1, mPopulationSize, mValues);
+
   return Continue;
 }
 
@@ -515,7 +515,7 @@ bool COptMethodEP::replicate()
   bool Continue = true;
 
   // iterate over parents
-  for (i = 0; i < mPopulationSize && Continue; i++)
+  for (i = 0; i < mPopulationSize; i++)
     {
       // replicate them
       for (j = 0; j < mVariableSize; j++)
@@ -527,9 +527,12 @@ bool COptMethodEP::replicate()
       mValues[mPopulationSize + i] = mValues[i];
 
       // possibly mutate the offspring
-      Continue = mutate(mPopulationSize + i);
+      mutate(mPopulationSize + i);
     }
 
+  // calculate the fitness of the offspring, this may be done in parallel
+  Continue = mpOptProblem->calculate(mIndividuals, mPopulationSize, 2 * mPopulationSize, mValues);
+
   return Continue;
 }
 
@@ -581,11 +584,8 @@ bool COptMethodEP::mutate(size_t i)
       *mContainerVariables[j] = mut;
     }
 
-  // calculate its fitness
-  bool Continue = evaluate(Individual);
-  mValues[i] = mEvaluationValue;
-
-  return Continue;
+  // The fitness is calculated for all offspring together in replicate.
+  return true;
 }
 
 unsigned C_INT32 COptMethodEP::getMaxLogVerbosity() const
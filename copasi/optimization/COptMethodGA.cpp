@@ -230,12 +230,11 @@ bool COptMethodGA::replicate()
     *mIndividuals[2 * mPopulationSize - 1] = *mIndividuals[mPopulationSize - 1];
 
   // mutate the offspring
-  for (i = mPopulationSize; i < 2 * mPopulationSize && Continue; i++)
-    {
-      mutate(*mIndividuals[i]);
-      Continue &= evaluate(*mIndividuals[i]);
-      mValues[i] = mEvaluationValue;
-    }
+  for (i = mPopulationSize; i < 2 * mPopulationSize; i++)
+    mutate(*mIndividuals[i]);
+
+  // evaluate the offspring, this may be done in parallel
+  Continue &= mpOptProblem->calculate(mIndividuals, mPopulationSize, 2 * mPopulationSize, mValues);
 
   return Continue;
 }
@@ -353,7 +352,7 @@ bool COptMethodGA::creation(size_t first,
 
   bool Continue = true;
 
-  for (i = first; i < Last && Continue; i++)
+  for (i = first; i < Last; i++)
     {
       for (j = 0; j < mVariableSize; j++)
         {
@@ -401,12 +400,12 @@ bool COptMethodGA::creation(size_t first,
           // account of the value.
           *mContainerVariables[j] = mut;
         }
-
-      // calculate its fitness
-      Continue &= evaluate(*mIndividuals[i]);
-      mValues[i] = mEvaluationValue;
     }
 
+  // calculate their fitness
+  if (first < Last)
+    Continue &= mpOptProblem->calculate(mIndividuals, first, Last, mValues);
+
   return Continue;
 }
 
@@ -65,7 +65,10 @@ COptMethodLevenbergMarquardt::COptMethodLevenbergMarquardt(const CDataContainer
   mStopAfterStalledIterations(0),
   mContinue(true),
   mHaveResiduals(false),
-  mResidualJacobianT()
+  mResidualJacobianT(),
+  mCandidates(),
+  mCandidateValues(),
+  mCandidateViolations()
 {
   assertParameter("Iteration Limit", CCopasiParameter::Type::UINT, (unsigned C_INT32) 2000);
   assertParameter("Tolerance", CCopasiParameter::Type::DOUBLE, (C_FLOAT64) 1.e-006);
@@ -101,7 +104,10 @@ COptMethodLevenbergMarquardt::COptMethodLevenbergMarquardt(const COptMethodLeven
   mStopAfterStalledIterations(0),
   mContinue(true),
   mHaveResiduals(false),
-  mResidualJacobianT()
+  mResidualJacobianT(),
+  mCandidates(),
+  mCandidateValues(),
+  mCandidateViolations()
 {initObjects();}
 
 COptMethodLevenbergMarquardt::~COptMethodLevenbergMarquardt()
@@ -529,6 +535,14 @@ bool COptMethodLevenbergMarquardt::optimise()
 
 bool COptMethodLevenbergMarquardt::cleanup()
 {
+  std::vector< CVector< C_FLOAT64 > * >::iterator it = mCandidates.begin();
+  std::vector< CVector< C_FLOAT64 > * >::iterator end = mCandidates.end();
+
+  for (; it != end; ++it)
+    pdelete(*it);
+
+  mCandidates.clear();
+
   return true;
 }
 
@@ -609,7 +623,17 @@ bool COptMethodLevenbergMarquardt::initialize()
       mResidualJacobianT.resize(mVariableSize, pFitProblem->getResiduals().size());
     }
   else
-    mHaveResiduals = false;
+    {
+      mHaveResiduals = false;
+
+      mCandidates.resize(mVariableSize);
+
+      for (size_t i = 0; i < mVariableSize; i++)
+        mCandidates[i] = new CVector< C_FLOAT64 >(mVariableSize);
+
+      mCandidateValues.resize(mVariableSize);
+      mCandidateViolations.resize(mVariableSize);
+    }
 
   if (getParameter("Stop after # stalled iterations"))
     mStopAfterStalledIterations = getValue <unsigned C_INT32>("Stop after # stalled iterations");
@@ -630,24 +654,44 @@ void COptMethodLevenbergMarquardt::gradient()
 
   y = evaluate();
 
-  for (i = 0; i < mVariableSize && mContinue; i++)
+  if (!mContinue) return;
+
+  for (i = 0; i < mVariableSize; i++)
     {
+      CVector< C_FLOAT64 > & Candidate = *mCandidates[i];
+      Candidate = mCurrent;
+
 //REVIEW:START
       if ((x = mCurrent[i]) != 0.0)
-        {
-          *mContainerVariables[i] = (x * mod1);
-          mGradient[i] = (evaluate() - y) / (x * mModulation);
-        }
-
+        Candidate[i] = x * mod1;
       else
-        {
-          *mContainerVariables[i] = (mModulation);
-          mGradient[i] = (evaluate() - y) / mModulation;
-        }
+        Candidate[i] = mModulation;
 
 //REVIEW:END
-      *mContainerVariables[i] = (x);
     }
+
+  // The perturbed points are independent and may be evaluated concurrently.
+  mContinue &= mpOptProblem->calculate(mCandidates, 0, mVariableSize, mCandidateValues, &mCandidateViolations);
+
+  for (i = 0; i < mVariableSize; i++)
+    {
+      C_FLOAT64 Value = mCandidateValues[i];
+
+      // Apply the same penalty as evaluate() when leaving the parameter or functional domain.
+      if (Value < mBestValue &&
+          ((*mpOptItem)[i]->checkConstraint((*mCandidates[i])[i]) ||
+           mCandidateViolations[i] > 0.0))
+        Value = mBestValue + mBestValue - Value;
+
+      if ((x = mCurrent[i]) != 0.0)
+        mGradient[i] = (Value - y) / (x * mModulation);
+      else
+        mGradient[i] = (Value - y) / mModulation;
+    }
+
+  // The sequential evaluation leaves the last candidate in the container variables.
+  for (i = 0; i < mVariableSize; i++)
+    *mContainerVariables[i] = mCurrent[i];
 }
 
 //evaluate the Hessian
@@ -675,7 +719,6 @@ void COptMethodLevenbergMarquardt::hessian()
 
       const C_FLOAT64 * pCurrentResiduals;
       const C_FLOAT64 * pEnd = CurrentResiduals.array() + ResidualSize;
-      const C_FLOAT64 * pResiduals;
 
       if (!bUseTimeSens)
         {
@@ -683,31 +726,35 @@ void COptMethodLevenbergMarquardt::hessian()
           C_FLOAT64 Delta;
           C_FLOAT64 x;
 
-          for (i = 0; i < mVariableSize && mContinue; i++)
+          CVector< C_FLOAT64 > PerturbedValues(mVariableSize);
+          CVector< C_FLOAT64 > Values(mVariableSize);
+
+          for (i = 0; i < mVariableSize; i++)
             {
               //REVIEW:START
               if ((x = mCurrent[i]) != 0.0)
-                {
-                  Delta = 1.0 / (x * mModulation);
-                  *mContainerVariables[i] = (x * mod1);
-                }
+                PerturbedValues[i] = x * mod1;
+              else
+                PerturbedValues[i] = mModulation;
+
+              //REVIEW:END
+            }
 
+          // The perturbed residuals are written directly to the rows of the Jacobian,
+          // which may be calculated concurrently.
+          mContinue &= pFit->calculatePerturbations(PerturbedValues, Values, &mResidualJacobianT);
+
+          for (i = 0; i < mVariableSize && mContinue; i++)
+            {
+              if ((x = mCurrent[i]) != 0.0)
+                Delta = 1.0 / (x * mModulation);
               else
-                {
-                  Delta = 1.0 / mModulation;
-                  *mContainerVariables[i] = (mModulation);
-                  //REVIEW:END
-                }
+                Delta = 1.0 / mModulation;
 
-              // evaluate another column of the Jacobian
-              evaluate();
               pCurrentResiduals = CurrentResiduals.array();
-              pResiduals = Residuals.array();
-
-              for (; pCurrentResiduals != pEnd; pCurrentResiduals++, pResiduals++, pJacobianT++)
-                *pJacobianT = (*pResiduals - *pCurrentResiduals) * Delta;
 
-              *mContainerVariables[i] = (x);
+              for (; pCurrentResiduals != pEnd; pCurrentResiduals++, pJacobianT++)
+                *pJacobianT = (*pJacobianT - *pCurrentResiduals) * Delta;
             }
 
 #ifdef XXXX
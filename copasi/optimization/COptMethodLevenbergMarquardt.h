@@ -221,6 +221,22 @@ private:
    */
   CMatrix< C_FLOAT64 > mResidualJacobianT;
 
+  /**
+   * The perturbed points of the finite difference gradient, which are evaluated together
+   * if no residuals are available.
+   */
+  std::vector< CVector< C_FLOAT64 > * > mCandidates;
+
+  /**
+   * The objective values of the perturbed points
+   */
+  CVector< C_FLOAT64 > mCandidateValues;
+
+  /**
+   * The functional constraint violations of the perturbed points
+   */
+  CVector< C_FLOAT64 > mCandidateViolations;
+
   C_FLOAT64 mInitialLamda;
   C_FLOAT64 mLambdaUp;
   C_FLOAT64 mLambdaDown;
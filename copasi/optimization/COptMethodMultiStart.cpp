@@ -0,0 +1,668 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#include <cmath>
+#include <limits>
+
+#include "copasi/copasi.h"
+
+#ifdef USE_OMP
+# include <omp.h>
+#endif // USE_OMP
+
+#include "copasi/optimization/COptMethodMultiStart.h"
+#include "copasi/optimization/COptProblem.h"
+#include "copasi/optimization/COptItem.h"
+#include "copasi/optimization/COptTask.h"
+#include "copasi/parameterFitting/CFitProblem.h"
+#include "copasi/parameterFitting/CFitTask.h"
+
+#include "copasi/core/CMatrix.h"
+#include "copasi/randomGenerator/CRandom.h"
+#include "copasi/utilities/CProcessReport.h"
+#include "copasi/utilities/CSort.h"
+
+// The local methods which may be run from the start points
+static const CTaskEnum::Method LocalMethods[] =
+{
+  CTaskEnum::Method::LevenbergMarquardt,
+  CTaskEnum::Method::NL2SOL,
+  CTaskEnum::Method::TruncatedNewton,
+  CTaskEnum::Method::HookeJeeves,
+  CTaskEnum::Method::NelderMead,
+  CTaskEnum::Method::Praxis,
+  CTaskEnum::Method::SteepestDescent,
+  CTaskEnum::Method::UnsetMethod
+};
+
+/**
+ * A worker runs the local method for start points of the multi-start method. It is the
+ * process report of its problem and thereby stops hopeless local searches early.
+ */
+class COptMultiStartWorker : public CProcessReport
+{
+private:
+  /**
+   * Hidden copy constructor
+   */
+  COptMultiStartWorker(const COptMultiStartWorker & src);
+
+  /**
+   * Hidden assignment operator
+   */
+  COptMultiStartWorker & operator = (const COptMultiStartWorker & rhs);
+
+public:
+  /**
+   * Specific constructor
+   * @param const COptMethodMultiStart & method
+   */
+  COptMultiStartWorker(const COptMethodMultiStart & method);
+
+  /**
+   * Destructor
+   */
+  virtual ~COptMultiStartWorker();
+
+  /**
+   * Initialize the worker. An independent worker operates on its own copy of the math
+   * container and can be used concurrently with other independent workers.
+   * @param const COptProblem & problem
+   * @param COptTask * pParentTask
+   * @param const CTaskEnum::Method & localMethod
+   * @param const bool & independent
+   * @return bool success
+   */
+  bool initialize(const COptProblem & problem,
+                  COptTask * pParentTask,
+                  const CTaskEnum::Method & localMethod,
+                  const bool & independent);
+
+  /**
+   * Run the local method from the start point
+   * @param const CVector< C_FLOAT64 > & start
+   */
+  void optimise(const CVector< C_FLOAT64 > & start);
+
+  /**
+   * Retrieve the best value of the last local search (always minimized)
+   * @return C_FLOAT64 value
+   */
+  C_FLOAT64 getSolutionValue() const;
+
+  /**
+   * Retrieve the parameters of the best value of the last local search
+   * @return const CVector< C_FLOAT64 > & solution
+   */
+  const CVector< C_FLOAT64 > & getSolutionVariables() const;
+
+  /**
+   * Retrieve the number of evaluations of the last local search
+   * @return const unsigned C_INT32 & evaluations
+   */
+  const unsigned C_INT32 & getFunctionEvaluations() const;
+
+  /**
+   * Report process on item handle. The local search is stopped if it is hopeless
+   * or the multi-start method is interrupted.
+   * @param const size_t & handle
+   * @param bool continue
+   */
+  virtual bool progressItem(const size_t & handle);
+
+private:
+  /**
+   * The multi-start method
+   */
+  const COptMethodMultiStart & mMethod;
+
+  /**
+   * The private task of an independent worker owning the problem
+   */
+  COptTask * mpTask;
+
+  /**
+   * The problem of the local searches
+   */
+  COptProblem * mpProblem;
+
+  /**
+   * The local method
+   */
+  COptMethod * mpMethod;
+};
+
+COptMultiStartWorker::COptMultiStartWorker(const COptMethodMultiStart & method):
+  CProcessReport(),
+  mMethod(method),
+  mpTask(NULL),
+  mpProblem(NULL),
+  mpMethod(NULL)
+{}
+
+COptMultiStartWorker::~COptMultiStartWorker()
+{
+  pdelete(mpMethod);
+
+  if (mpTask != NULL)
+    {
+      // The private task owns the problem and is not a child of its parent, see initialize.
+      mpTask->setObjectParent(NULL);
+      pdelete(mpTask);
+      mpProblem = NULL;
+    }
+
+  pdelete(mpProblem);
+}
+
+bool COptMultiStartWorker::initialize(const COptProblem & problem,
+                                      COptTask * pParentTask,
+                                      const CTaskEnum::Method & localMethod,
+                                      const bool & independent)
+{
+  const CDataContainer * pMethodParent = pParentTask;
+
+  if (independent)
+    {
+      // The local method writes its output through its parent task, which must therefore
+      // be private. It needs an ancestor to find the data model, however the task list must
+      // not know about it.
+      CFitTask * pFitTask = dynamic_cast< CFitTask * >(pParentTask);
+
+      if (pFitTask != NULL)
+        mpTask = new CFitTask(*pFitTask, NO_PARENT);
+      else
+        mpTask = new COptTask(*pParentTask, NO_PARENT);
+
+      mpTask->setObjectParent(pParentTask->getObjectParent());
+      mpProblem = static_cast< COptProblem * >(mpTask->getProblem());
+
+      if (!mpProblem->initializeSubtaskBeforeOutput() ||
+          !mpProblem->initializeIndependent())
+        return false;
+
+      pMethodParent = mpTask;
+    }
+  else
+    {
+      const CFitProblem * pFitProblem = dynamic_cast< const CFitProblem * >(&problem);
+
+      if (pFitProblem != NULL)
+        mpProblem = new CFitProblem(*pFitProblem, pParentTask);
+      else
+        mpProblem = new COptProblem(problem, pParentTask);
+
+      mpProblem->initializeSubtaskBeforeOutput();
+
+      if (!mpProblem->initialize())
+        return false;
+    }
+
+  mpProblem->setCallBack(this);
+  // no statistics to be calculated in the local problems
+  mpProblem->setCalculateStatistics(false);
+  // do not randomize the initial values
+  mpProblem->setRandomizeStartValues(false);
+
+  mpMethod = static_cast< COptMethod * >(CCopasiMethod::createMethod(pMethodParent, localMethod, mMethod.getType()));
+
+  if (mpMethod == NULL)
+    return false;
+
+  mpMethod->setProblem(mpProblem);
+
+  return true;
+}
+
+void COptMultiStartWorker::optimise(const CVector< C_FLOAT64 > & start)
+{
+  mpProblem->reset();
+
+  const std::vector< COptItem * > & OptItems = mpProblem->getOptItemList();
+  std::vector< COptItem * >::const_iterator it = OptItems.begin();
+  std::vector< COptItem * >::const_iterator end = OptItems.end();
+  const C_FLOAT64 * pStart = start.array();
+
+  for (; it != end; ++it, ++pStart)
+    {
+      (*it)->setStartValue(*pStart);
+    }
+
+  mpProblem->resetEvaluations();
+  mpMethod->optimise();
+}
+
+C_FLOAT64 COptMultiStartWorker::getSolutionValue() const
+{
+  return mpProblem->maximize() ? -mpProblem->getSolutionValue() : mpProblem->getSolutionValue();
+}
+
+const CVector< C_FLOAT64 > & COptMultiStartWorker::getSolutionVariables() const
+{
+  return mpProblem->getSolutionVariables();
+}
+
+const unsigned C_INT32 & COptMultiStartWorker::getFunctionEvaluations() const
+{
+  return mpProblem->getFunctionEvaluations();
+}
+
+// virtual
+bool COptMultiStartWorker::progressItem(const size_t & /* handle */)
+{
+  return mMethod.proceedLocalSearch(mpProblem->getFunctionEvaluations(), getSolutionValue());
+}
+
+COptMethodMultiStart::COptMethodMultiStart(const CDataContainer * pParent,
+    const CTaskEnum::Method & methodType,
+    const CTaskEnum::Task & taskType):
+  COptPopulationMethod(pParent, methodType, taskType),
+  mLocalMethod(CTaskEnum::Method::LevenbergMarquardt),
+  mEarlyStopEvaluations(0),
+  mWorkers(),
+  mBestValue(std::numeric_limits< C_FLOAT64 >::infinity()),
+  mBest(),
+  mImproved(false),
+  mContinue(true),
+  mFinishedSearches(0),
+  mPendingSearches(0),
+  mPendingEvaluations(0),
+  mhFinishedSearches(C_INVALID_INDEX)
+{
+  initializeParameter();
+  initObjects();
+}
+
+COptMethodMultiStart::COptMethodMultiStart(const COptMethodMultiStart & src,
+    const CDataContainer * pParent):
+  COptPopulationMethod(src, pParent),
+  mLocalMethod(src.mLocalMethod),
+  mEarlyStopEvaluations(src.mEarlyStopEvaluations),
+  mWorkers(),
+  mBestValue(std::numeric_limits< C_FLOAT64 >::infinity()),
+  mBest(),
+  mImproved(false),
+  mContinue(true),
+  mFinishedSearches(0),
+  mPendingSearches(0),
+  mPendingEvaluations(0),
+  mhFinishedSearches(C_INVALID_INDEX)
+{
+  initializeParameter();
+  initObjects();
+}
+
+COptMethodMultiStart::~COptMethodMultiStart()
+{
+  cleanup();
+}
+
+void COptMethodMultiStart::initializeParameter()
+{
+  assertParameter("Number of Starts", CCopasiParameter::Type::UINT, (unsigned C_INT32) 20);
+  assertParameter("Local Method", CCopasiParameter::Type::STRING, CTaskEnum::MethodName[CTaskEnum::Method::LevenbergMarquardt]);
+  assertParameter("Early Stop Evaluations", CCopasiParameter::Type::UINT, (unsigned C_INT32) 500, eUserInterfaceFlag::editable);
+  assertParameter("Random Number Generator", CCopasiParameter::Type::UINT, (unsigned C_INT32) CRandom::mt19937, eUserInterfaceFlag::editable);
+  assertParameter("Seed", CCopasiParameter::Type::UINT, (unsigned C_INT32) 0, eUserInterfaceFlag::editable);
+
+  CCopasiParameter * pParm = getParameter("Local Method");
+
+  if (pParm != NULL)
+    {
+      std::vector< std::pair< std::string, std::string > > ValidValues;
+
+      for (const CTaskEnum::Method * pMethod = LocalMethods; *pMethod != CTaskEnum::Method::UnsetMethod; ++pMethod)
+        ValidValues.push_back(std::make_pair(CTaskEnum::MethodName[*pMethod], CTaskEnum::MethodName[*pMethod]));
+
+      pParm->setValidValues(ValidValues);
+    }
+}
+
+void COptMethodMultiStart::initObjects()
+{
+  addObjectReference("Finished Local Searches", mFinishedSearches, CDataObject::ValueInt);
+}
+
+bool COptMethodMultiStart::initialize()
+{
+  cleanup();
+
+  if (!COptPopulationMethod::initialize())
+    return false;
+
+  mPopulationSize = getValue< unsigned C_INT32 >("Number of Starts");
+  mLocalMethod = CTaskEnum::MethodName.toEnum(getValue< std::string >("Local Method"), CTaskEnum::Method::LevenbergMarquardt);
+  mEarlyStopEvaluations = getValue< unsigned C_INT32 >("Early Stop Evaluations");
+
+  if (mPopulationSize < 1)
+    mPopulationSize = 1;
+
+  mFinishedSearches = 0;
+  mPendingSearches = 0;
+  mPendingEvaluations = 0;
+
+  if (mpCallBack)
+    mhFinishedSearches =
+      mpCallBack->addItem("Finished Local Searches",
+                          mFinishedSearches,
+                          & mPopulationSize);
+
+  mIndividuals.resize(mPopulationSize);
+
+  for (size_t i = 0; i < mPopulationSize; ++i)
+    mIndividuals[i] = new CVector< C_FLOAT64 >(mVariableSize);
+
+  mValues.resize(mPopulationSize);
+  mValues = std::numeric_limits< C_FLOAT64 >::infinity();
+
+  mBestValue = std::numeric_limits< C_FLOAT64 >::infinity();
+  mBest.resize(mVariableSize);
+  mImproved = false;
+  mContinue = true;
+
+  return initializeWorkers();
+}
+
+bool COptMethodMultiStart::initializeWorkers()
+{
+  size_t Threads = 1;
+  bool Independent = false;
+
+#ifdef USE_OMP
+  Threads = omp_get_max_threads();
+
+  // The local methods translated from Fortran keep their state in static variables.
+  Independent = Threads > 1 &&
+                mPopulationSize > 1 &&
+                mLocalMethod != CTaskEnum::Method::NL2SOL &&
+                mLocalMethod != CTaskEnum::Method::Praxis;
+#endif // USE_OMP
+
+  if (Independent)
+    {
+      mWorkers.resize(std::min(Threads, (size_t) mPopulationSize), NULL);
+
+      std::vector< COptMultiStartWorker * >::iterator it = mWorkers.begin();
+      std::vector< COptMultiStartWorker * >::iterator end = mWorkers.end();
+
+      for (; it != end; ++it)
+        {
+          *it = new COptMultiStartWorker(*this);
+
+          if (!(*it)->initialize(*mpOptProblem, mpParentTask, mLocalMethod, true))
+            {
+              // The local searches must be done serially.
+              Independent = false;
+              break;
+            }
+        }
+    }
+
+  if (!Independent)
+    {
+      for (size_t i = 0; i < mWorkers.size(); ++i)
+        pdelete(mWorkers[i]);
+
+      mWorkers.resize(1);
+      mWorkers[0] = new COptMultiStartWorker(*this);
+
+      if (!mWorkers[0]->initialize(*mpOptProblem, mpParentTask, mLocalMethod, false))
+        return false;
+    }
+
+  return true;
+}
+
+bool COptMethodMultiStart::cleanup()
+{
+  for (size_t i = 0; i < mWorkers.size(); ++i)
+    pdelete(mWorkers[i]);
+
+  mWorkers.clear();
+
+  return COptPopulationMethod::cleanup();
+}
+
+bool COptMethodMultiStart::creation()
+{
+  size_t i, j;
+
+  // Each variable is divided into as many strata as there are start points and each
+  // stratum is used exactly once.
+  CMatrix< size_t > Strata(mVariableSize, mPopulationSize);
+
+  for (j = 0; j < mVariableSize; j++)
+    {
+      size_t * pStratum = Strata[j];
+
+      for (i = 0; i < mPopulationSize; i++)
+        pStratum[i] = i;
+
+      for (i = mPopulationSize - 1; i > 0; i--)
+        std::swap(pStratum[i], pStratum[mpRandom->getRandomU((unsigned C_INT32) i)]);
+    }
+
+  C_FLOAT64 mn;
+  C_FLOAT64 mx;
+  C_FLOAT64 la;
+
+  for (i = 0; i < mPopulationSize; i++)
+    for (j = 0; j < mVariableSize; j++)
+      {
+        // calculate lower and upper bounds
+        COptItem & OptItem = *(*mpOptItem)[j];
+        mn = *OptItem.getLowerBoundValue();
+        mx = *OptItem.getUpperBoundValue();
+
+        C_FLOAT64 & mut = (*mIndividuals[i])[j];
+        C_FLOAT64 Position = (Strata(j, i) + mpRandom->getRandomCO()) / mPopulationSize;
+
+        try
+          {
+            // determine if linear or log scale
+            if ((mn < 0.0) || (mx <= 0.0))
+              mut = mn + Position * (mx - mn);
+            else
+              {
+                la = log10(mx) - log10(std::max(mn, std::numeric_limits< C_FLOAT64 >::min()));
+
+                if (la < 1.8)
+                  mut = mn + Position * (mx - mn);
+                else
+                  mut = pow(10.0, log10(std::max(mn, std::numeric_limits< C_FLOAT64 >::min())) + la * Position);
+              }
+          }
+
+        catch (...)
+          {
+            mut = (mx + mn) * 0.5;
+          }
+
+        // force it to be within the bounds
+        switch (OptItem.checkConstraint(mut))
+          {
+            case - 1:
+              mut = *OptItem.getLowerBoundValue();
+              break;
+
+            case 1:
+              mut = *OptItem.getUpperBoundValue();
+              break;
+          }
+
+        // We need to set the value here so that further checks take
+        // account of the value.
+        *mContainerVariables[j] = mut;
+      }
+
+  // calculate their fitness
+  return mpOptProblem->calculate(mIndividuals, 0, mPopulationSize, mValues);
+}
+
+bool COptMethodMultiStart::optimise()
+{
+  if (!initialize())
+    {
+      if (mpCallBack)
+        mpCallBack->finishItem(mhFinishedSearches);
+
+      return false;
+    }
+
+  mContinue = creation();
+
+  // The local searches are started from the most promising start points first.
+  CVector< size_t > Pivot;
+  sortWithPivot(mValues.array(), mValues.array() + mPopulationSize, Pivot);
+
+  mBestValue = mValues[Pivot[0]];
+  mBest = *mIndividuals[Pivot[0]];
+  mImproved = true;
+
+  reportProgress();
+
+  C_INT32 Starts = (C_INT32) mPopulationSize;
+
+#ifdef USE_OMP
+  #pragma omp parallel for schedule(dynamic) num_threads(mWorkers.size())
+#endif // USE_OMP
+
+  for (C_INT32 i = 0; i < Starts; ++i)
+    {
+#ifdef USE_OMP
+      size_t Thread = omp_get_thread_num();
+#else
+      size_t Thread = 0;
+#endif // USE_OMP
+
+      localSearch(*mWorkers[Thread], Pivot[i]);
+
+      // Only the thread which started the optimization may report.
+      if (Thread == 0)
+        reportProgress();
+    }
+
+  reportProgress();
+
+  if (mpCallBack)
+    mpCallBack->finishItem(mhFinishedSearches);
+
+  return true;
+}
+
+void COptMethodMultiStart::localSearch(COptMultiStartWorker & worker, const size_t & index)
+{
+  bool Continue = true;
+
+#ifdef USE_OMP
+#pragma omp critical (COptMethodMultiStart_Best)
+#endif // USE_OMP
+  {
+    Continue = mContinue;
+  }
+
+  if (!Continue)
+    return;
+
+  worker.optimise(*mIndividuals[index]);
+
+  C_FLOAT64 Value = worker.getSolutionValue();
+
+#ifdef USE_OMP
+#pragma omp critical (COptMethodMultiStart_Best)
+#endif // USE_OMP
+  {
+    mPendingEvaluations += worker.getFunctionEvaluations();
+    mPendingSearches++;
+
+    if (Value < mBestValue)
+      {
+        mBestValue = Value;
+        mBest = worker.getSolutionVariables();
+        mImproved = true;
+      }
+  }
+}
+
+bool COptMethodMultiStart::proceedLocalSearch(const unsigned C_INT32 & evaluations,
+    const C_FLOAT64 & value) const
+{
+  bool Continue = true;
+  C_FLOAT64 BestValue = std::numeric_limits< C_FLOAT64 >::infinity();
+
+#ifdef USE_OMP
+#pragma omp critical (COptMethodMultiStart_Best)
+#endif // USE_OMP
+  {
+    Continue = mContinue;
+    BestValue = mBestValue;
+  }
+
+  if (!Continue)
+    return false;
+
+  if (mEarlyStopEvaluations == 0 ||
+      evaluations < mEarlyStopEvaluations)
+    return true;
+
+  // A local search is hopeless if it is further from the best value than its magnitude.
+  return value <= BestValue + fabs(BestValue);
+}
+
+bool COptMethodMultiStart::reportProgress()
+{
+  bool Continue = true;
+  bool Improved = false;
+  C_FLOAT64 BestValue = std::numeric_limits< C_FLOAT64 >::infinity();
+  CVector< C_FLOAT64 > Best;
+  unsigned C_INT32 Evaluations = 0;
+  unsigned C_INT32 Searches = 0;
+
+#ifdef USE_OMP
+#pragma omp critical (COptMethodMultiStart_Best)
+#endif // USE_OMP
+  {
+    Continue = mContinue;
+    Improved = mImproved;
+    mImproved = false;
+
+    if (Improved)
+      {
+        BestValue = mBestValue;
+        Best = mBest;
+      }
+
+    Evaluations = mPendingEvaluations;
+    mPendingEvaluations = 0;
+    Searches = mPendingSearches;
+    mPendingSearches = 0;
+  }
+
+  mpOptProblem->incrementEvaluations(Evaluations);
+  mFinishedSearches += Searches;
+
+  if (Improved)
+    {
+      Continue &= mpOptProblem->setSolution(BestValue, Best);
+
+      // We found a new best value lets report it.
+      mpParentTask->output(COutputInterface::DURING);
+    }
+
+  if (mpCallBack)
+    Continue &= mpCallBack->progressItem(mhFinishedSearches);
+
+  if (!Continue)
+    {
+#ifdef USE_OMP
+#pragma omp critical (COptMethodMultiStart_Best)
+#endif // USE_OMP
+      {
+        mContinue = false;
+      }
+    }
+
+  return Continue;
+}
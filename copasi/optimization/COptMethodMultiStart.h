@@ -0,0 +1,191 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+/**
+ * COptMethodMultiStart class
+ */
+
+#ifndef COPASI_COptMethodMultiStart
+#define COPASI_COptMethodMultiStart
+
+#include <vector>
+
+#include "copasi/core/CVector.h"
+#include "copasi/optimization/COptPopulationMethod.h"
+
+class COptMultiStartWorker;
+
+/**
+ * The multi-start method draws start points from a Latin hypercube within the bounds
+ * of the optimization items. Items with positive bounds spanning more than 1.8 decades
+ * are sampled on a logarithmic scale. The start points are evaluated together and a local
+ * method is run from each of them in the order of their objective values.
+ *
+ * If COPASI is built with OpenMP and the subtask of the problem can be evaluated
+ * concurrently (see COptWorker) the local searches are run in parallel, each on its own
+ * copy of the math container. Otherwise they are run one after the other.
+ *
+ * The best value found so far is shared between the local searches. A local search which
+ * after "Early Stop Evaluations" evaluations has not come closer to the best value than
+ * its absolute value is considered hopeless and stopped.
+ */
+class COptMethodMultiStart : public COptPopulationMethod
+{
+private:
+  /**
+   * Default Constructor
+   */
+  COptMethodMultiStart();
+
+public:
+  /**
+   * Specific constructor
+   * @param const CDataContainer * pParent
+   * @param const CTaskEnum::Method & methodType (default: MultiStart)
+   * @param const CTaskEnum::Task & taskType (default: optimization)
+   */
+  COptMethodMultiStart(const CDataContainer * pParent,
+                       const CTaskEnum::Method & methodType = CTaskEnum::Method::MultiStart,
+                       const CTaskEnum::Task & taskType = CTaskEnum::Task::optimization);
+
+  /**
+   * Copy Constructor
+   * @param const COptMethodMultiStart & src
+   * @param const CDataContainer * pParent (default: NULL)
+   */
+  COptMethodMultiStart(const COptMethodMultiStart & src,
+                       const CDataContainer * pParent);
+
+  /**
+   * Destructor
+   */
+  virtual ~COptMethodMultiStart();
+
+  /**
+   * Execute the optimization algorithm calling simulation routine
+   * when needed. It is noted that this procedure can give feedback
+   * of its progress by the callback function set with SetCallback.
+   * @ return success;
+   */
+  virtual bool optimise();
+
+  /**
+   * Check whether a local search with the given number of evaluations and best value
+   * shall be continued. This is called concurrently by the local searches.
+   * @param const unsigned C_INT32 & evaluations
+   * @param const C_FLOAT64 & value
+   * @return bool continue
+   */
+  bool proceedLocalSearch(const unsigned C_INT32 & evaluations,
+                          const C_FLOAT64 & value) const;
+
+private:
+  /**
+   * Initialize the method parameter
+   */
+  void initializeParameter();
+
+  /**
+   * Initialize contained objects.
+   */
+  void initObjects();
+
+  /**
+   * Initialize arrays and pointer.
+   * @return bool success
+   */
+  virtual bool initialize();
+
+  /**
+   * Cleanup arrays and pointers.
+   * @return bool success
+   */
+  virtual bool cleanup();
+
+  /**
+   * Create the workers running the local searches
+   * @return bool success
+   */
+  bool initializeWorkers();
+
+  /**
+   * Draw the start points from a Latin hypercube and evaluate them.
+   * @return bool continue
+   */
+  bool creation();
+
+  /**
+   * Run the local search from the start point with the given index
+   * @param COptMultiStartWorker & worker
+   * @param const size_t & index
+   */
+  void localSearch(COptMultiStartWorker & worker, const size_t & index);
+
+  /**
+   * Report improvements and the progress. This must only be called by the
+   * thread which started the optimization.
+   * @return bool continue
+   */
+  bool reportProgress();
+
+  // Attributes
+  /**
+   * The local method run from each start point
+   */
+  CTaskEnum::Method mLocalMethod;
+
+  /**
+   * The number of evaluations after which a hopeless local search is stopped
+   * (0 disables early stopping)
+   */
+  unsigned C_INT32 mEarlyStopEvaluations;
+
+  /**
+   * The workers running the local searches, one per thread
+   */
+  std::vector< COptMultiStartWorker * > mWorkers;
+
+  /**
+   * The best value found so far
+   */
+  C_FLOAT64 mBestValue;
+
+  /**
+   * The parameters of the best value
+   */
+  CVector< C_FLOAT64 > mBest;
+
+  /**
+   * Indicates whether the best value has changed since it was last reported
+   */
+  bool mImproved;
+
+  /**
+   * Indicates whether the optimization shall continue
+   */
+  bool mContinue;
+
+  /**
+   * The number of finished local searches
+   */
+  unsigned C_INT32 mFinishedSearches;
+
+  /**
+   * The number of local searches finished since the last report
+   */
+  unsigned C_INT32 mPendingSearches;
+
+  /**
+   * The number of evaluations of the local searches finished since the last report
+   */
+  unsigned C_INT32 mPendingEvaluations;
+
+  /**
+   * Handle to the process report item "Finished Local Searches"
+   */
+  size_t mhFinishedSearches;
+};
+
+#endif  // COPASI_COptMethodMultiStart
@@ -102,13 +102,11 @@ const C_FLOAT64 & COptMethodPS::evaluate()
 }
 
 // move an individual
-bool COptMethodPS::move(const size_t & index)
+void COptMethodPS::move(const size_t & index)
 {
   const C_FLOAT64 w = 1 / (2 * log(2.0));
   const C_FLOAT64 c = 0.5 + log(2.0);
 
-  bool Improved = false;
-
   C_FLOAT64 * pIndividual = mIndividuals[index]->array();
   C_FLOAT64 * pEnd = pIndividual + mVariableSize;
   C_FLOAT64 * pVelocity = mVelocities[index];
@@ -160,21 +158,24 @@ bool COptMethodPS::move(const size_t & index)
       // account of the value.
       **ppContainerVariable = *pIndividual;
     }
+}
 
-  // calculate its fitness
-  mValues[index] = evaluate();
+// update the best values after the fitness of an individual has been calculated
+bool COptMethodPS::update(const size_t & index)
+{
+  bool Improved = false;
 
   // Check if we improved individually
-  if (mEvaluationValue < mBestValues[index])
+  if (mValues[index] < mBestValues[index])
     {
       Improved = true;
 
       // Save the individually best value;
-      mBestValues[index] = mEvaluationValue;
+      mBestValues[index] = mValues[index];
       memcpy(mBestPositions[index], mIndividuals[index]->array(), sizeof(C_FLOAT64) * mVariableSize);
 
       // Check if we improved globally
-      if (mEvaluationValue < mBestValues[mBestIndex])
+      if (mBestValues[index] < mBestValues[mBestIndex])
         {
           // and store that value
           mBestIndex = index;
@@ -189,7 +190,7 @@ bool COptMethodPS::move(const size_t & index)
 }
 
 // initialise an individual
-bool COptMethodPS::create(const size_t & index)
+void COptMethodPS::create(const size_t & index)
 {
   C_FLOAT64 * pIndividual = mIndividuals[index]->array();
   C_FLOAT64 * pEnd = pIndividual + mVariableSize;
@@ -301,20 +302,8 @@ bool COptMethodPS::create(const size_t & index)
       **ppContainerVariable = *pIndividual;
     }
 
-  // calculate its fitness
-  mBestValues[index] = mValues[index] = evaluate();
-
-  if (mBestValues[index] < mBestValues[mBestIndex])
-    {
-      // and store that value
-      mBestIndex = index;
-      mContinue &= mpOptProblem->setSolution(mBestValues[index], *mIndividuals[index]);
-
-      // We found a new best value lets report it.
-      mpParentTask->output(COutputInterface::DURING);
-    }
-
-  return mContinue;
+  // The individual has no best value yet, it is determined in update.
+  mBestValues[index] = std::numeric_limits< C_FLOAT64 >::infinity();
 }
 
 void COptMethodPS::initObjects()
@@ -580,13 +569,20 @@ bool COptMethodPS::optimise()
   mpParentTask->output(COutputInterface::DURING);
 
   // the others are random
-  for (i = 1; i < mPopulationSize && mContinue; i++)
+  for (i = 1; i < mPopulationSize; i++)
     create(i);
 
+  // The fitness of the swarm is calculated together, which allows for parallel evaluation.
+  mContinue &= mpOptProblem->calculate(mIndividuals, 1, mPopulationSize, mValues);
+
+  for (i = 1; i < mPopulationSize && mContinue; i++)
+    update(i);
+
   // create the informant list
   buildInformants();
 
   bool Improved;
+  bool UseWorkers = mpOptProblem->useWorkers();
 
   size_t Stalled = 0;
 
@@ -599,8 +595,28 @@ bool COptMethodPS::optimise()
       Improved = false;
       size_t oldIndex = mBestIndex;
 
-      for (i = 0; i < mPopulationSize && mContinue; i++)
-        Improved |= move(i);
+      if (UseWorkers)
+        {
+          // All particles move based on the best values of the previous iteration
+          // (synchronous update), which allows for parallel evaluation.
+          for (i = 0; i < mPopulationSize; i++)
+            move(i);
+
+          mContinue &= mpOptProblem->calculate(mIndividuals, 0, mPopulationSize, mValues);
+
+          for (i = 0; i < mPopulationSize && mContinue; i++)
+            Improved |= update(i);
+        }
+      else
+        {
+          // Each particle moves based on the latest best values (asynchronous update).
+          for (i = 0; i < mPopulationSize && mContinue; i++)
+            {
+              move(i);
+              mContinue &= mpOptProblem->calculate(mIndividuals, i, i + 1, mValues);
+              Improved |= update(i);
+            }
+        }
 
       if (!Improved)
         {
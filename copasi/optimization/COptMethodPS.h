@@ -109,16 +109,22 @@ private:
   /**
    * Move the indexed individual in the swarm
    * @param const size_t & index
-   * @return bool continue
    */
-  bool move(const size_t & index);
+  void move(const size_t & index);
+
+  /**
+   * Update the individual and global best values for the indexed individual
+   * after its fitness has been calculated
+   * @param const size_t & index
+   * @return bool improved
+   */
+  bool update(const size_t & index);
 
   /**
    * Create the indexed individual in the swarm
    * @param const size_t & index
-   * @return bool continue
    */
-  bool create(const size_t & index);
+  void create(const size_t & index);
 
   /**
    * create the informant for each individual
@@ -165,15 +165,13 @@ bool COptMethodSRES::mutate()
   std::vector< CVector < C_FLOAT64 > * >::iterator itVariance = mVariance.begin() + mPopulationSize;
 
   C_FLOAT64 * pVariable, * pVariableEnd, * pVariance, * pMaxVariance;
-  C_FLOAT64 * pPhi = mPhi.array() + mPopulationSize;
-  C_FLOAT64 * pValue = mValues.array() + mPopulationSize;
 
   bool Continue = true;
   size_t i, j;
   C_FLOAT64 v1;
 
   // Mutate each new individual
-  for (i = mPopulationSize; it != end && Continue; ++it, ++itVariance, ++i)
+  for (i = mPopulationSize; it != end; ++it, ++itVariance, ++i)
     {
       pVariable = (*it)->array();
       pVariableEnd = pVariable + mVariableSize;
@@ -219,13 +217,14 @@ bool COptMethodSRES::mutate()
           // account of the value.
           *mContainerVariables[j] = (mut);
         }
-
-      // calculate its fitness
-      Continue = evaluate(**it);
-      *pValue++ = mEvaluationValue;
-      *pPhi++ = phi(i);
     }
 
+  // calculate the fitness of all new individuals, this may be done in parallel
+  Continue = mpOptProblem->calculate(mIndividuals, mPopulationSize, mIndividuals.size(), mValues, &mConstraintViolations);
+
+  for (i = mPopulationSize; i < mIndividuals.size(); ++i)
+    mPhi[i] = phi(i);
+
   return Continue;
 }
 
@@ -309,8 +308,6 @@ bool COptMethodSRES::creation(size_t first)
     mVariance.begin() + first;
 
   C_FLOAT64 * pVariable, * pVariableEnd, * pVariance, * pMaxVariance;
-  C_FLOAT64 * pPhi = mPhi.array() + first;
-  C_FLOAT64 * pValue = mValues.array() + first;
 
   // set the first individual to the initial guess
   if (it == mIndividuals.begin())
@@ -374,9 +371,8 @@ bool COptMethodSRES::creation(size_t first)
       if (!pointInParameterDomain && (mLogVerbosity > 0))
         mMethodLog.enterLogEntry(COptLogEntry("Initial point outside parameter domain."));
 
-      Continue = evaluate(**it);
-      *pValue++ = mEvaluationValue;
-      *pPhi++ = phi(0);
+      Continue = mpOptProblem->calculate(mIndividuals, 0, 1, mValues, &mConstraintViolations);
+      mPhi[0] = phi(0);
 
       ++it;
       ++itVariance;
@@ -489,13 +485,15 @@ bool COptMethodSRES::creation(size_t first)
           // Set the variance for this parameter.
           *pVariance = std::min(*OptItem.getUpperBoundValue() - mut, mut - *OptItem.getLowerBoundValue()) / sqrt(double(mVariableSize));
         }
-
-      // calculate its fitness
-      Continue = evaluate(**it);
-      *pValue++ = mEvaluationValue;
-      *pPhi++ = phi(i);
     }
 
+  // calculate their fitness, this may be done in parallel
+  if (first < mPopulationSize)
+    Continue = mpOptProblem->calculate(mIndividuals, first, mPopulationSize, mValues, &mConstraintViolations);
+
+  for (i = first; i < mPopulationSize; ++i)
+    mPhi[i] = phi(i);
+
   return Continue;
 }
 
@@ -556,6 +554,8 @@ bool COptMethodSRES::initialize()
   mBestValue = std::numeric_limits<C_FLOAT64>::infinity();
 
   mPhi.resize(childrate * mPopulationSize);
+  mConstraintViolations.resize(childrate * mPopulationSize);
+  mConstraintViolations = 0.0;
 
   try
     {
@@ -604,7 +604,7 @@ C_FLOAT64 COptMethodSRES::phi(size_t indivNum)
 
   for (; it != end; ++it, pValue++)
     {
-      switch ((*it)->checkConstraint())
+      switch ((*it)->checkConstraint(*pValue))
         {
           case - 1:
             phiCalc = *(*it)->getLowerBoundValue() - *pValue;
@@ -618,16 +618,9 @@ C_FLOAT64 COptMethodSRES::phi(size_t indivNum)
         }
     }
 
-  it = mpOptContraints->begin();
-  end = mpOptContraints->end();
-
-  for (; it != end; ++it)
-    {
-      phiCalc = (*it)->getConstraintViolation();
-
-      if (phiCalc > 0.0)
-        phiVal += phiCalc * phiCalc;
-    }
+  // The squared violations of the functional constraints are determined when the
+  // individual is evaluated.
+  phiVal += mConstraintViolations[indivNum];
 
   return phiVal;
 }
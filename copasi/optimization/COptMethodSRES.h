@@ -161,6 +161,11 @@ private:
    */
   CVector < C_FLOAT64 > mPhi;
 
+  /**
+   * The sum of the squared violations of the functional constraints for the individuals
+   */
+  CVector < C_FLOAT64 > mConstraintViolations;
+
   /**
    * for array of variances w/ variance values for the parameters
    */
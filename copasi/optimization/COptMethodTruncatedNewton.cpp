@@ -336,6 +336,31 @@ C_INT COptMethodTruncatedNewton::sFun(C_INT* n, C_FLOAT64* x, C_FLOAT64* f, C_FL
 
         }
     }
+  else if (pFit && pFit->getConstraintList().empty())
+    {
+      // Without functional constraints the perturbed points of a fit can be
+      // evaluated together, which allows to distribute them over the fit workers.
+      CVector< C_FLOAT64 > PerturbedValues(*n);
+      CVector< C_FLOAT64 > Values(*n);
+
+      for (i = 0; i < *n; i++)
+        PerturbedValues[i] = x[i] != 0.0 ? x[i] * 1.001 : 1e-7;
+
+      mContinue = pFit->calculatePerturbations(PerturbedValues, Values, NULL);
+
+      for (i = 0; i < *n; i++)
+        {
+          // Apply the same penalty as evaluate() when leaving the parameter domain.
+          if (Values[i] < mBestValue &&
+              (*mpOptItem)[i]->checkConstraint(PerturbedValues[i]))
+            Values[i] = mBestValue + mBestValue - Values[i];
+
+          if (x[i] != 0.0)
+            g[i] = (Values[i] - *f) / (x[i] * 0.001);
+          else
+            g[i] = (Values[i] - *f) / 1e-7;
+        }
+    }
   else
     {
 
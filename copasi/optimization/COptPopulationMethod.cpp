@@ -59,7 +59,8 @@ COptPopulationMethod::~COptPopulationMethod()
 
 void COptPopulationMethod::initObjects()
 {
-  if (getSubType() != CTaskEnum::Method::ParticleSwarm && getSubType() != CTaskEnum::Method::ScatterSearch)
+  if (getSubType() != CTaskEnum::Method::ParticleSwarm && getSubType() != CTaskEnum::Method::ScatterSearch
+      && getSubType() != CTaskEnum::Method::MultiStart)
     addObjectReference("Current Generation", mCurrentGeneration, CDataObject::ValueInt);
 }
 
@@ -79,7 +80,8 @@ COptPopulationMethod::initialize()
     mGenerations = getValue< unsigned C_INT32 >("Number of Generations");
 
   if (mpCallBack
-      && (getSubType() != CTaskEnum::Method::ParticleSwarm && getSubType() != CTaskEnum::Method::ScatterSearch))
+      && (getSubType() != CTaskEnum::Method::ParticleSwarm && getSubType() != CTaskEnum::Method::ScatterSearch
+          && getSubType() != CTaskEnum::Method::MultiStart))
     {
       mhGenerations =
         mpCallBack->addItem("Current Generation",
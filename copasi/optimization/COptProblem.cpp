@@ -34,9 +34,15 @@
 #include <cmath>
 
 #include "copasi/copasi.h"
+
+#ifdef USE_OMP
+# include <omp.h>
+#endif // USE_OMP
+
 #include "COptTask.h"
 #include "COptProblem.h"
 #include "COptItem.h"
+#include "COptWorker.h"
 
 #include "copasi/function/CFunctionDB.h"
 
@@ -113,7 +119,11 @@ COptProblem::COptProblem(const CTaskEnum::Task & type,
   mhCounter(C_INVALID_INDEX),
   mStoreResults(false),
   mHaveStatistics(false),
-  mGradient(0)
+  mGradient(0),
+  mWorkers(),
+  mWorkersInitialized(false),
+  mpIndependentContainer(NULL),
+  mpIndependentSubtask(NULL)
 {
   initializeParameter();
   initObjects();
@@ -154,7 +164,11 @@ COptProblem::COptProblem(const COptProblem& src,
   mhCounter(C_INVALID_INDEX),
   mStoreResults(src.mStoreResults),
   mHaveStatistics(src.mHaveStatistics),
-  mGradient(src.mGradient)
+  mGradient(src.mGradient),
+  mWorkers(),
+  mWorkersInitialized(false),
+  mpIndependentContainer(NULL),
+  mpIndependentSubtask(NULL)
 {
   initializeParameter();
   initObjects();
@@ -162,7 +176,10 @@ COptProblem::COptProblem(const COptProblem& src,
 
 // Destructor
 COptProblem::~COptProblem()
-{}
+{
+  cleanupWorkers();
+  cleanupIndependent();
+}
 
 void COptProblem::initializeParameter()
 {
@@ -331,6 +348,62 @@ bool COptProblem::initializeSubtaskBeforeOutput()
   return true;
 }
 
+bool COptProblem::initializeIndependent()
+{
+  if (mpIndependentSubtask != NULL ||
+      mpContainer == NULL ||
+      !COptWorker::isSupportedSubtask(mpSubtask))
+    return false;
+
+  mpIndependentContainer = new CMathContainer(*mpContainer);
+  mpIndependentSubtask = COptWorker::createSubtask(*mpSubtask, mpIndependentContainer);
+
+  if (mpIndependentSubtask == NULL)
+    {
+      cleanupIndependent();
+      return false;
+    }
+
+  setMathContainer(mpIndependentContainer);
+  mpSubtask = mpIndependentSubtask;
+
+  if (!initialize())
+    return false;
+
+  // All values the problem changes or depends on must belong to the copy.
+  const C_FLOAT64 * pValuesBegin = mpContainer->getValues().array();
+  const C_FLOAT64 * pValuesEnd = pValuesBegin + mpContainer->getValues().size();
+
+  CObjectInterface::ObjectSet Objects = mpMathObjectiveExpression->getPrerequisites();
+  std::vector< COptItem * >::const_iterator it = mpOptItems->begin();
+  std::vector< COptItem * >::const_iterator end = mpOptItems->end();
+
+  for (; it != end; ++it)
+    Objects.insert((*it)->getObject());
+
+  for (it = mpConstraintItems->begin(), end = mpConstraintItems->end(); it != end; ++it)
+    Objects.insert((*it)->getObject());
+
+  CObjectInterface::ObjectSet::const_iterator itObject = Objects.begin();
+  CObjectInterface::ObjectSet::const_iterator endObject = Objects.end();
+
+  for (; itObject != endObject; ++itObject)
+    {
+      const C_FLOAT64 * pValue = (*itObject != NULL) ? (const C_FLOAT64 *)(*itObject)->getValuePointer() : NULL;
+
+      if (pValue < pValuesBegin || pValuesEnd <= pValue)
+        return false;
+    }
+
+  return true;
+}
+
+void COptProblem::cleanupIndependent()
+{
+  COptWorker::destroySubtask(mpIndependentSubtask);
+  pdelete(mpIndependentContainer);
+}
+
 bool COptProblem::initialize()
 {
   mWorstValue = std::numeric_limits<C_FLOAT64>::infinity();
@@ -342,6 +415,9 @@ bool COptProblem::initialize()
 
   if (mpContainer == NULL) return false;
 
+  // The workers are created on demand since they depend on the compiled objective function.
+  cleanupWorkers();
+
   bool success = true;
 
   mpReport = NULL;
@@ -430,7 +506,6 @@ bool COptProblem::initialize()
 
   mCPUTime.start();
 
-  // TODO CRITICAL PARRELIZATION Add the objective expression to the math container
   if (mpObjectiveExpression == NULL ||
       mpObjectiveExpression->getInfix() == "" ||
       !mpObjectiveExpression->compile(ContainerList))
@@ -465,6 +540,8 @@ bool COptProblem::restore(const bool & updateModel)
 {
   bool success = true;
 
+  cleanupWorkers();
+
   if (mpSubtask != NULL)
     {
       bool update = mpSubtask->isUpdateModel();
@@ -530,6 +607,24 @@ bool COptProblem::checkFunctionalConstraints()
   return true;
 }
 
+C_FLOAT64 COptProblem::calculateConstraintViolation()
+{
+  C_FLOAT64 Violation = 0.0;
+
+  std::vector< COptItem * >::const_iterator it = mpConstraintItems->begin();
+  std::vector< COptItem * >::const_iterator end = mpConstraintItems->end();
+
+  for (; it != end; ++it)
+    {
+      C_FLOAT64 Current = (*it)->getConstraintViolation();
+
+      if (Current > 0.0)
+        Violation += Current * Current;
+    }
+
+  return Violation;
+}
+
 /**
  * calculate() decides whether the problem is a steady state problem or a
  * trajectory problem based on whether the pointer to that type of problem
@@ -564,7 +659,6 @@ bool COptProblem::calculate()
 
       mpContainer->applyUpdateSequence(mUpdateObjectiveFunction);
 
-      // TODO CRITICAL PARRELIZATION We need to point to the created container objective function
       mCalculateValue = *mpParmMaximize ? -mpMathObjectiveExpression->value() : mpMathObjectiveExpression->value();
     }
 
@@ -606,6 +700,152 @@ bool COptProblem::calculate()
   return true;
 }
 
+bool COptProblem::calculate(const std::vector< CVector< C_FLOAT64 > * > & candidates,
+                            const size_t & first, const size_t & last,
+                            CVectorCore< C_FLOAT64 > & values,
+                            CVectorCore< C_FLOAT64 > * pConstraintViolations)
+{
+  if (!mWorkersInitialized)
+    {
+      initializeWorkers();
+    }
+
+  bool Continue = true;
+
+  if (mWorkers.empty() ||
+      last <= first)
+    {
+      for (size_t i = first; i < last && Continue; ++i)
+        {
+          C_FLOAT64 ** ppContainerVariable = mContainerVariables.array();
+          C_FLOAT64 ** ppContainerVariableEnd = ppContainerVariable + mContainerVariables.size();
+          const C_FLOAT64 * pCandidate = candidates[i]->array();
+
+          for (; ppContainerVariable != ppContainerVariableEnd; ++ppContainerVariable, ++pCandidate)
+            {
+              **ppContainerVariable = *pCandidate;
+            }
+
+          Continue &= calculate();
+
+          if (pConstraintViolations != NULL)
+            {
+              values[i] = mCalculateValue;
+              (*pConstraintViolations)[i] = calculateConstraintViolation();
+            }
+          else if (!checkFunctionalConstraints())
+            values[i] = std::numeric_limits< C_FLOAT64 >::infinity();
+          else
+            values[i] = mCalculateValue;
+        }
+
+      return Continue;
+    }
+
+#ifdef USE_OMP
+  // Each candidate is evaluated independently, i.e., the assignment of candidates to
+  // workers does not influence the result.
+  C_INT32 Last = (C_INT32) last;
+
+  #pragma omp parallel for schedule(dynamic) num_threads(mWorkers.size())
+
+  for (C_INT32 i = (C_INT32) first; i < Last; ++i)
+    {
+      COptWorker * pWorker = mWorkers[omp_get_thread_num()];
+      C_FLOAT64 Violation = 0.0;
+
+      values[i] = pWorker->calculate(*candidates[i]);
+
+      if (pConstraintViolations != NULL)
+        {
+          pWorker->checkFunctionalConstraints(Violation);
+          (*pConstraintViolations)[i] = Violation;
+        }
+      else if (!pWorker->checkFunctionalConstraints(Violation))
+        {
+          values[i] = std::numeric_limits< C_FLOAT64 >::infinity();
+        }
+    }
+
+#endif // USE_OMP
+
+  mCounter += (unsigned C_INT32)(last - first);
+
+  std::vector< COptWorker * >::iterator itWorker = mWorkers.begin();
+  std::vector< COptWorker * >::iterator endWorker = mWorkers.end();
+
+  for (; itWorker != endWorker; ++itWorker)
+    {
+      (*itWorker)->collectCounters(mFailedCounterException, mFailedCounterNaN, mConstraintCounter, mFailedConstraintCounter);
+    }
+
+  if (pConstraintViolations == NULL)
+    mCalculateValue = values[last - 1];
+
+  if (mpCallBack) return mpCallBack->progressItem(mhCounter);
+
+  return Continue;
+}
+
+bool COptProblem::useWorkers()
+{
+  if (!mWorkersInitialized)
+    {
+      initializeWorkers();
+    }
+
+  return !mWorkers.empty();
+}
+
+void COptProblem::initializeWorkers()
+{
+  cleanupWorkers();
+  mWorkersInitialized = true;
+
+#ifdef USE_OMP
+  if (mpSubtask == NULL)
+    return;
+
+  // We create workers even for a single thread so that the results do not depend on the
+  // number of threads.
+  size_t Threads = omp_get_max_threads();
+
+  mWorkers.resize(Threads, NULL);
+
+  std::vector< COptWorker * >::iterator it = mWorkers.begin();
+  std::vector< COptWorker * >::iterator end = mWorkers.end();
+
+  for (; it != end; ++it)
+    {
+      *it = new COptWorker();
+
+      if (!(*it)->initialize(*this))
+        {
+          // The problem can not be evaluated in parallel.
+          cleanupWorkers();
+          mWorkersInitialized = true;
+
+          return;
+        }
+    }
+
+#endif // USE_OMP
+}
+
+void COptProblem::cleanupWorkers()
+{
+  std::vector< COptWorker * >::iterator it = mWorkers.begin();
+  std::vector< COptWorker * >::iterator end = mWorkers.end();
+
+  for (; it != end; ++it)
+    {
+      pdelete(*it);
+    }
+
+  mWorkers.clear();
+  mWorkersInitialized = false;
+}
+
 bool COptProblem::calculateStatistics(const C_FLOAT64 & factor,
                                       const C_FLOAT64 & resolution)
 {
@@ -49,6 +49,7 @@
 class CSteadyStateTask;
 class CTrajectoryTask;
 class COptItem;
+class COptWorker;
 class CMathExpression;
 
 enum ProblemType
@@ -116,6 +117,17 @@ public:
    */
   virtual bool initializeSubtaskBeforeOutput();
 
+  /**
+   * Initialize the problem on copies of the math container and of the subtask
+   * which are owned by the problem. Afterwards the problem can be evaluated concurrently
+   * with the problem it has been copied from. This is only possible for the subtasks
+   * supported by COptWorker and if all items and the objective function refer to values
+   * of the container. The subtask must have been initialized before. If the initialization
+   * fails the problem must not be used anymore.
+   * @result bool success
+   */
+  virtual bool initializeIndependent();
+
   /**
    * Do the calculating based on CalculateVariables and fill
    * CalculateResults with the results.
@@ -123,6 +135,33 @@ public:
    */
   virtual bool calculate();
 
+  /**
+   * Calculate the objective values of the candidates with indices in [first, last).
+   * The candidates are distributed over independent copies of the container and the subtask
+   * if the problem supports this and OpenMP is enabled, otherwise they are calculated
+   * sequentially with calculate(). Workers are used even for a single thread, i.e., the
+   * result does not depend on the number of threads.
+   * If pConstraintViolations is NULL the value of candidates which do not fulfill the functional
+   * constraints is infinity, otherwise the sum of the squared constraint violations is returned.
+   * @param const std::vector< CVector< C_FLOAT64 > * > & candidates
+   * @param const size_t & first
+   * @param const size_t & last
+   * @param CVectorCore< C_FLOAT64 > & values
+   * @param CVectorCore< C_FLOAT64 > * pConstraintViolations (default: NULL)
+   * @result bool continue
+   */
+  bool calculate(const std::vector< CVector< C_FLOAT64 > * > & candidates,
+                 const size_t & first, const size_t & last,
+                 CVectorCore< C_FLOAT64 > & values,
+                 CVectorCore< C_FLOAT64 > * pConstraintViolations = NULL);
+
+  /**
+   * Check whether candidates are evaluated concurrently by workers. The workers
+   * are created if needed.
+   * @return bool useWorkers
+   */
+  bool useWorkers();
+
   /**
    * Reset counters and objective value.
    */
@@ -148,6 +187,13 @@ public:
    */
   virtual bool checkFunctionalConstraints();
 
+  /**
+   * Calculate the sum of the squared violations of the functional constraints
+   * based on their current values. The values are not refreshed.
+   * @result C_FLOAT64 violation
+   */
+  C_FLOAT64 calculateConstraintViolation();
+
   /**
    * Calculate the statistics for the problem
    * @param const C_FLOAT64 & factor (Default: 1.0e-003)
@@ -370,6 +416,8 @@ public:
    */
   friend std::ostream &operator<<(std::ostream &os, const COptProblem & o);
 
+  friend class COptWorker;
+
   /**
    * This is the output method for any result of a problem. The default implementation
    * provided with CCopasiProblem. Does only print "Not implemented." To override this
@@ -570,6 +618,43 @@ protected:
    * The gradient vector for the parameters
    */
   CVector< C_FLOAT64 > mGradient;
+
+private:
+  /**
+   * Create a worker for each thread, including a single one, if the problem can be
+   * evaluated in parallel.
+   */
+  void initializeWorkers();
+
+  /**
+   * Destroy the workers
+   */
+  void cleanupWorkers();
+
+  /**
+   * Destroy the container and subtask copies created by initializeIndependent
+   */
+  void cleanupIndependent();
+
+  /**
+   * The workers evaluating candidates in parallel, one per thread.
+   */
+  std::vector< COptWorker * > mWorkers;
+
+  /**
+   * Indicates whether the creation of workers has been attempted.
+   */
+  bool mWorkersInitialized;
+
+  /**
+   * The container copy owned by the problem, see initializeIndependent
+   */
+  CMathContainer * mpIndependentContainer;
+
+  /**
+   * The subtask copy owned by the problem, see initializeIndependent
+   */
+  CCopasiTask * mpIndependentSubtask;
 };
 
 #endif  // the end
@@ -54,6 +54,7 @@ const CTaskEnum::Method COptTask::ValidMethods[]  =
   CTaskEnum::Method::GeneticAlgorithmSR,
   CTaskEnum::Method::HookeJeeves,
   CTaskEnum::Method::LevenbergMarquardt,
+  CTaskEnum::Method::MultiStart,
   CTaskEnum::Method::NelderMead,
   CTaskEnum::Method::ParticleSwarm,
   CTaskEnum::Method::Praxis,
@@ -0,0 +1,364 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#include <cmath>
+#include <limits>
+
+#include "copasi/copasi.h"
+
+#include "copasi/optimization/COptWorker.h"
+#include "copasi/optimization/COptProblem.h"
+#include "copasi/optimization/COptItem.h"
+
+#include "copasi/math/CMathContainer.h"
+#include "copasi/math/CMathExpression.h"
+#include "copasi/steadystate/CSteadyStateTask.h"
+#include "copasi/trajectory/CTrajectoryTask.h"
+#include "copasi/trajectory/CTrajectoryProblem.h"
+#include "copasi/utilities/CCopasiException.h"
+
+COptWorker::COptWorker():
+  mpSourceValues(NULL),
+  mpContainer(NULL),
+  mpSubtask(NULL),
+  mpObjectiveExpression(NULL),
+  mMaximize(false),
+  mContainerVariables(),
+  mConstraintValues(),
+  mInitialRefreshSequence(),
+  mUpdateObjectiveFunction(),
+  mUpdateConstraints(),
+  mpConstraintItems(NULL),
+  mCalculateValue(std::numeric_limits< C_FLOAT64 >::infinity()),
+  mFailedCounterException(0),
+  mFailedCounterNaN(0),
+  mConstraintCounter(0),
+  mFailedConstraintCounter(0)
+{}
+
+COptWorker::~COptWorker()
+{
+  cleanup();
+}
+
+void COptWorker::cleanup()
+{
+  pdelete(mpObjectiveExpression);
+  destroySubtask(mpSubtask);
+
+  mInitialRefreshSequence.clear();
+  mUpdateObjectiveFunction.clear();
+  mUpdateConstraints.clear();
+
+  pdelete(mpContainer);
+
+  mpSourceValues = NULL;
+  mpConstraintItems = NULL;
+  mContainerVariables.resize(0);
+  mConstraintValues.resize(0);
+}
+
+// static
+bool COptWorker::isSupportedSubtask(const CCopasiTask * pSubtask)
+{
+  if (pSubtask == NULL)
+    return false;
+
+  // Only deterministic subtasks which are known to be reentrant are supported.
+  switch (pSubtask->getType())
+    {
+      case CTaskEnum::Task::timeCourse:
+        return pSubtask->getMethod()->getSubType() == CTaskEnum::Method::deterministic &&
+               !static_cast< const CTrajectoryProblem * >(pSubtask->getProblem())->getStartInSteadyState();
+        break;
+
+      case CTaskEnum::Task::steadyState:
+        return pSubtask->getMethod()->getSubType() == CTaskEnum::Method::Newton;
+        break;
+
+      default:
+        break;
+    }
+
+  return false;
+}
+
+// static
+CCopasiTask * COptWorker::createSubtask(const CCopasiTask & subtask, CMathContainer * pContainer)
+{
+  CCopasiTask * pSubtask = NULL;
+
+  // Create the subtask copy. It needs an ancestor to find the data model, however the task
+  // list must not know about it.
+  if (subtask.getType() == CTaskEnum::Task::timeCourse)
+    pSubtask = new CTrajectoryTask(*static_cast< const CTrajectoryTask * >(&subtask), NO_PARENT);
+  else
+    pSubtask = new CSteadyStateTask(*static_cast< const CSteadyStateTask * >(&subtask), NO_PARENT);
+
+  pSubtask->setObjectParent(subtask.getObjectParent());
+  pSubtask->setMathContainer(pContainer);
+
+  bool success = false;
+
+  try
+    {
+      success = pSubtask->initialize(CCopasiTask::NO_OUTPUT, NULL, NULL);
+    }
+
+  catch (...)
+    {
+      success = false;
+    }
+
+  if (!success)
+    destroySubtask(pSubtask);
+
+  return pSubtask;
+}
+
+// static
+void COptWorker::destroySubtask(CCopasiTask *& pSubtask)
+{
+  if (pSubtask != NULL)
+    {
+      // The subtask is not a child of its parent, see createSubtask.
+      pSubtask->setObjectParent(NULL);
+      pdelete(pSubtask);
+    }
+}
+
+bool COptWorker::initialize(const COptProblem & problem)
+{
+  cleanup();
+
+  const CCopasiTask * pSubtask = problem.mpSubtask;
+
+  if (!isSupportedSubtask(pSubtask) ||
+      problem.mpContainer == NULL ||
+      problem.mpMathObjectiveExpression == NULL)
+    {
+      return false;
+    }
+
+  mpSourceValues = problem.mpContainer->getValues().array();
+  mpContainer = new CMathContainer(*problem.mpContainer);
+
+  if (mpContainer->getValues().size() != problem.mpContainer->getValues().size())
+    {
+      cleanup();
+      return false;
+    }
+
+  // Map the optimization items
+  mContainerVariables.resize(problem.mContainerVariables.size());
+  C_FLOAT64 ** ppVariable = mContainerVariables.array();
+  C_FLOAT64 ** ppVariableEnd = ppVariable + mContainerVariables.size();
+  C_FLOAT64 * const * ppSourceVariable = problem.mContainerVariables.array();
+
+  CObjectInterface::ObjectSet ChangedObjects;
+
+  for (; ppVariable != ppVariableEnd; ++ppVariable, ++ppSourceVariable)
+    {
+      *ppVariable = mapValue(*ppSourceVariable);
+
+      if (*ppVariable == NULL)
+        {
+          cleanup();
+          return false;
+        }
+
+      ChangedObjects.insert(mpContainer->getMathObject(*ppVariable));
+    }
+
+  ChangedObjects.erase(NULL);
+  mpContainer->getInitialDependencies().getUpdateSequence(mInitialRefreshSequence, CCore::SimulationContext::UpdateMoieties, ChangedObjects, mpContainer->getInitialStateObjects());
+
+  // Map the constraint items
+  mpConstraintItems = problem.mpConstraintItems;
+  mConstraintValues.resize(mpConstraintItems->size());
+  const C_FLOAT64 ** ppConstraintValue = mConstraintValues.array();
+  std::vector< COptItem * >::const_iterator it = mpConstraintItems->begin();
+  std::vector< COptItem * >::const_iterator end = mpConstraintItems->end();
+
+  CObjectInterface::ObjectSet Objects;
+
+  for (; it != end; ++it, ++ppConstraintValue)
+    {
+      *ppConstraintValue = mapValue((*it)->getObjectValue());
+
+      if (*ppConstraintValue == NULL)
+        {
+          cleanup();
+          return false;
+        }
+
+      Objects.insert(mpContainer->getMathObject(*ppConstraintValue));
+    }
+
+  Objects.erase(NULL);
+  mpContainer->getTransientDependencies().getUpdateSequence(mUpdateConstraints, CCore::SimulationContext::Default, mpContainer->getStateObjects(false), Objects, mpContainer->getSimulationUpToDateObjects());
+
+  // Compile the objective function for the copy. All prerequisites must be values of the copy,
+  // objects outside the container, e.g., results of the subtask, are not supported.
+  mMaximize = problem.maximize();
+  mpObjectiveExpression = new CMathExpression(*problem.mpObjectiveExpression, *mpContainer, false);
+
+  const C_FLOAT64 * pValuesBegin = mpContainer->getValues().array();
+  const C_FLOAT64 * pValuesEnd = pValuesBegin + mpContainer->getValues().size();
+
+  Objects = mpObjectiveExpression->getPrerequisites();
+  CObjectInterface::ObjectSet::const_iterator itObject = Objects.begin();
+  CObjectInterface::ObjectSet::const_iterator endObject = Objects.end();
+
+  for (; itObject != endObject; ++itObject)
+    {
+      const C_FLOAT64 * pValue = (const C_FLOAT64 *)(*itObject)->getValuePointer();
+
+      if (pValue < pValuesBegin || pValuesEnd <= pValue)
+        {
+          cleanup();
+          return false;
+        }
+    }
+
+  mpContainer->getTransientDependencies().getUpdateSequence(mUpdateObjectiveFunction, CCore::SimulationContext::Default, mpContainer->getStateObjects(false), Objects, mpContainer->getSimulationUpToDateObjects());
+
+  mpSubtask = createSubtask(*pSubtask, mpContainer);
+
+  if (mpSubtask == NULL)
+    {
+      cleanup();
+      return false;
+    }
+
+  mFailedCounterException = 0;
+  mFailedCounterNaN = 0;
+  mConstraintCounter = 0;
+  mFailedConstraintCounter = 0;
+
+  return true;
+}
+
+const C_FLOAT64 & COptWorker::calculate(const CVectorCore< C_FLOAT64 > & candidate)
+{
+  C_FLOAT64 ** ppVariable = mContainerVariables.array();
+  C_FLOAT64 ** ppVariableEnd = ppVariable + mContainerVariables.size();
+  const C_FLOAT64 * pCandidate = candidate.array();
+
+  for (; ppVariable != ppVariableEnd; ++ppVariable, ++pCandidate)
+    {
+      **ppVariable = *pCandidate;
+    }
+
+  bool success = false;
+
+  try
+    {
+      // Update all initial values which depend on the optimization items.
+      mpContainer->applyUpdateSequence(mInitialRefreshSequence);
+
+      success = mpSubtask->process(true);
+
+      mpContainer->applyUpdateSequence(mUpdateObjectiveFunction);
+      mCalculateValue = mMaximize ? -mpObjectiveExpression->value() : mpObjectiveExpression->value();
+    }
+
+  catch (CCopasiException & /*Exception*/)
+    {
+      // We do not want to clog the message cue.
+      CCopasiMessage::getLastMessage();
+
+      success = false;
+    }
+
+  catch (...)
+    {
+      success = false;
+    }
+
+  if (!success)
+    {
+      mFailedCounterException++;
+      mCalculateValue = std::numeric_limits< C_FLOAT64 >::infinity();
+    }
+
+  if (std::isnan(mCalculateValue))
+    {
+      mFailedCounterNaN++;
+      mCalculateValue = std::numeric_limits< C_FLOAT64 >::infinity();
+    }
+
+  return mCalculateValue;
+}
+
+bool COptWorker::checkFunctionalConstraints(C_FLOAT64 & violation)
+{
+  // Make sure the constraint values are up to date.
+  mpContainer->applyUpdateSequence(mUpdateConstraints);
+
+  std::vector< COptItem * >::const_iterator it = mpConstraintItems->begin();
+  std::vector< COptItem * >::const_iterator end = mpConstraintItems->end();
+  const C_FLOAT64 * const * ppConstraintValue = mConstraintValues.array();
+
+  mConstraintCounter++;
+
+  bool Fulfilled = true;
+  violation = 0.0;
+
+  for (; it != end; ++it, ++ppConstraintValue)
+    {
+      C_FLOAT64 Violation = 0.0;
+
+      switch ((*it)->checkConstraint(**ppConstraintValue))
+        {
+          case - 1:
+            Violation = *(*it)->getLowerBoundValue() - **ppConstraintValue;
+            Fulfilled = false;
+            break;
+
+          case 1:
+            Violation = **ppConstraintValue - *(*it)->getUpperBoundValue();
+            Fulfilled = false;
+            break;
+        }
+
+      violation += Violation * Violation;
+    }
+
+  if (!Fulfilled)
+    {
+      mFailedConstraintCounter++;
+    }
+
+  return Fulfilled;
+}
+
+void COptWorker::collectCounters(unsigned C_INT32 & failedCounterException,
+                                 unsigned C_INT32 & failedCounterNaN,
+                                 unsigned C_INT32 & constraintCounter,
+                                 unsigned C_INT32 & failedConstraintCounter)
+{
+  failedCounterException += mFailedCounterException;
+  failedCounterNaN += mFailedCounterNaN;
+  constraintCounter += mConstraintCounter;
+  failedConstraintCounter += mFailedConstraintCounter;
+
+  mFailedCounterException = 0;
+  mFailedCounterNaN = 0;
+  mConstraintCounter = 0;
+  mFailedConstraintCounter = 0;
+}
+
+C_FLOAT64 * COptWorker::mapValue(const C_FLOAT64 * pSourceValue) const
+{
+  if (pSourceValue == NULL ||
+      pSourceValue < mpSourceValues ||
+      mpSourceValues + mpContainer->getValues().size() <= pSourceValue)
+    {
+      return NULL;
+    }
+
+  return mpContainer->getValues().array() + (pSourceValue - mpSourceValues);
+}
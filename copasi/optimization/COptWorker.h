@@ -0,0 +1,205 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#ifndef COPASI_COptWorker
+#define COPASI_COptWorker
+
+#include <vector>
+
+#include "copasi/core/CVector.h"
+#include "copasi/math/CMathUpdateSequence.h"
+
+class COptProblem;
+class COptItem;
+class CCopasiTask;
+class CMathContainer;
+class CMathExpression;
+
+/**
+ * A worker evaluates the objective function and the functional constraints of an
+ * optimization problem for candidate solutions. It owns an independently compiled copy
+ * of the math container, a copy of the subtask operating on this container, and the update
+ * sequences and objective expression of the problem relocated to the copy. Different workers
+ * do not share any mutable state and can therefore be used concurrently.
+ *
+ * Since each evaluation starts from the initial state the result of an evaluation only depends
+ * on the candidate. This is only assured for deterministic subtasks, i.e., workers can only be
+ * created for time courses using LSODA which do not start in a steady state and for steady states
+ * determined with the Newton method.
+ */
+class COptWorker
+{
+private:
+  /**
+   * Hidden copy constructor
+   */
+  COptWorker(const COptWorker & src);
+
+  /**
+   * Hidden assignment operator
+   */
+  COptWorker & operator = (const COptWorker & rhs);
+
+public:
+  /**
+   * Default constructor
+   */
+  COptWorker();
+
+  /**
+   * Destructor
+   */
+  ~COptWorker();
+
+  /**
+   * Check whether the subtask is deterministic and known to be reentrant.
+   * @param const CCopasiTask * pSubtask
+   * @return bool isSupported
+   */
+  static bool isSupportedSubtask(const CCopasiTask * pSubtask);
+
+  /**
+   * Create an initialized copy of a supported subtask operating on the given container.
+   * @param const CCopasiTask & subtask
+   * @param CMathContainer * pContainer
+   * @return CCopasiTask * pSubtask (NULL on failure)
+   */
+  static CCopasiTask * createSubtask(const CCopasiTask & subtask, CMathContainer * pContainer);
+
+  /**
+   * Destroy a subtask created with createSubtask
+   * @param CCopasiTask *& pSubtask
+   */
+  static void destroySubtask(CCopasiTask *& pSubtask);
+
+  /**
+   * Initialize the worker for the given problem. The problem must be initialized.
+   * @param const COptProblem & problem
+   * @return bool success (false if the problem can not be evaluated by the worker)
+   */
+  bool initialize(const COptProblem & problem);
+
+  /**
+   * Release the container copy and the subtask
+   */
+  void cleanup();
+
+  /**
+   * Calculate the objective value for the candidate. Failed or invalid calculations
+   * result in an infinite value.
+   * @param const CVectorCore< C_FLOAT64 > & candidate
+   * @return const C_FLOAT64 & value
+   */
+  const C_FLOAT64 & calculate(const CVectorCore< C_FLOAT64 > & candidate);
+
+  /**
+   * Check whether the functional constraints are fulfilled for the last calculated candidate.
+   * @param C_FLOAT64 & violation (sum of the squared violations)
+   * @return bool fulfilled
+   */
+  bool checkFunctionalConstraints(C_FLOAT64 & violation);
+
+  /**
+   * Retrieve the counters and reset them to zero.
+   * @param unsigned C_INT32 & failedCounterException
+   * @param unsigned C_INT32 & failedCounterNaN
+   * @param unsigned C_INT32 & constraintCounter
+   * @param unsigned C_INT32 & failedConstraintCounter
+   */
+  void collectCounters(unsigned C_INT32 & failedCounterException,
+                       unsigned C_INT32 & failedCounterNaN,
+                       unsigned C_INT32 & constraintCounter,
+                       unsigned C_INT32 & failedConstraintCounter);
+
+private:
+  /**
+   * Map a value of the source container to the value of the copy
+   * @param const C_FLOAT64 * pSourceValue
+   * @return C_FLOAT64 * pValue (NULL if the value does not belong to the source container)
+   */
+  C_FLOAT64 * mapValue(const C_FLOAT64 * pSourceValue) const;
+
+  /**
+   * The values of the source container
+   */
+  const C_FLOAT64 * mpSourceValues;
+
+  /**
+   * The independent copy of the container
+   */
+  CMathContainer * mpContainer;
+
+  /**
+   * The copy of the subtask operating on mpContainer
+   */
+  CCopasiTask * mpSubtask;
+
+  /**
+   * The objective expression compiled for mpContainer
+   */
+  CMathExpression * mpObjectiveExpression;
+
+  /**
+   * Indicates whether the objective is maximized
+   */
+  bool mMaximize;
+
+  /**
+   * Pointers to the values of the optimization items in mpContainer
+   */
+  CVector< C_FLOAT64 * > mContainerVariables;
+
+  /**
+   * Pointers to the values of the constraint items in mpContainer
+   */
+  CVector< const C_FLOAT64 * > mConstraintValues;
+
+  /**
+   * The update sequence for initial values depending on the optimization items
+   */
+  CCore::CUpdateSequence mInitialRefreshSequence;
+
+  /**
+   * The update sequence required to calculate the objective function
+   */
+  CCore::CUpdateSequence mUpdateObjectiveFunction;
+
+  /**
+   * The update sequence required to calculate the constraint values
+   */
+  CCore::CUpdateSequence mUpdateConstraints;
+
+  /**
+   * The pointer to the constraint items of the problem
+   */
+  const std::vector< COptItem * > * mpConstraintItems;
+
+  /**
+   * The value of the last calculation
+   */
+  C_FLOAT64 mCalculateValue;
+
+  /**
+   * Counter of failed evaluations (throwing Exception)
+   */
+  unsigned C_INT32 mFailedCounterException;
+
+  /**
+   * Counter of failed evaluations (result NaN)
+   */
+  unsigned C_INT32 mFailedCounterNaN;
+
+  /**
+   * Counter of constraint checks
+   */
+  unsigned C_INT32 mConstraintCounter;
+
+  /**
+   * Counter of failed constraint checks
+   */
+  unsigned C_INT32 mFailedConstraintCounter;
+};
+
+#endif // COPASI_COptWorker
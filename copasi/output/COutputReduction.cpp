@@ -0,0 +1,415 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#include <set>
+
+#include "copasi/copasi.h"
+
+#include "copasi/output/COutputReduction.h"
+
+#include "copasi/core/CDataObject.h"
+#include "copasi/math/CMathContainer.h"
+#include "copasi/math/CMathObject.h"
+
+// static
+const CEnumAnnotation< std::string, COutputReduction::Mode > COutputReduction::ModeName(
+{
+  "None",
+  "Every k-th Step",
+  "Time Grid",
+  "Envelope",
+  "Mean"});
+
+COutputReduction::COutputReduction():
+  COutputHandler(),
+  mMode(None),
+  mParameter(0.0),
+  mValues(),
+  mCurrent(),
+  mReduced(),
+  mSaved(),
+  mFirst(),
+  mSecond(),
+  mCount(0),
+  mPending(false),
+  mNextTime(0.0)
+{}
+
+COutputReduction::COutputReduction(const Mode & mode, const C_FLOAT64 & parameter):
+  COutputHandler(),
+  mMode(None),
+  mParameter(0.0),
+  mValues(),
+  mCurrent(),
+  mReduced(),
+  mSaved(),
+  mFirst(),
+  mSecond(),
+  mCount(0),
+  mPending(false),
+  mNextTime(0.0)
+{
+  setMode(mode, parameter);
+}
+
+COutputReduction::COutputReduction(const COutputReduction & src):
+  COutputHandler(src),
+  mMode(src.mMode),
+  mParameter(src.mParameter),
+  mValues(),
+  mCurrent(),
+  mReduced(),
+  mSaved(),
+  mFirst(),
+  mSecond(),
+  mCount(0),
+  mPending(false),
+  mNextTime(0.0)
+{}
+
+// virtual
+COutputReduction::~COutputReduction()
+{}
+
+void COutputReduction::setMode(const Mode & mode, const C_FLOAT64 & parameter)
+{
+  mMode = mode;
+  mParameter = parameter;
+
+  // Invalid parameters disable the reduction.
+  if (mMode == Step)
+    {
+      mParameter = floor(mParameter);
+
+      if (mParameter < 2.0)
+        mMode = None;
+    }
+  else if (!(mParameter > 0.0))
+    {
+      mMode = None;
+    }
+
+  reset();
+}
+
+const COutputReduction::Mode & COutputReduction::getMode() const
+{
+  return mMode;
+}
+
+const C_FLOAT64 & COutputReduction::getParameter() const
+{
+  return mParameter;
+}
+
+// virtual
+bool COutputReduction::compile(CObjectInterface::ContainerList listOfContainer)
+{
+  bool success = COutputHandler::compile(listOfContainer);
+
+  if (mpContainer == NULL)
+    return false;
+
+  // The model time is always reduced and located first.
+  C_FLOAT64 * pTime = const_cast< C_FLOAT64 * >(mpContainer->getState(false).array()) + mpContainer->getCountFixedEventTargets();
+
+  std::vector< C_FLOAT64 * > Values;
+  Values.push_back(pTime);
+
+  std::set< C_FLOAT64 * > Unique;
+  Unique.insert(pTime);
+
+  CObjectInterface::ObjectSet::const_iterator it = mObjects.begin();
+  CObjectInterface::ObjectSet::const_iterator end = mObjects.end();
+
+  for (; it != end; ++it)
+    {
+      const CDataObject * pDataObject = dynamic_cast< const CDataObject * >(*it);
+
+      // Only numerical values can be reduced.
+      if (dynamic_cast< const CMathObject * >(*it) == NULL &&
+          (pDataObject == NULL || !pDataObject->hasFlag(CDataObject::ValueDbl)))
+        continue;
+
+      C_FLOAT64 * pValue = static_cast< C_FLOAT64 * >((*it)->getValuePointer());
+
+      if (pValue != NULL &&
+          Unique.insert(pValue).second)
+        Values.push_back(pValue);
+    }
+
+  mValues.resize(Values.size());
+
+  if (!Values.empty())
+    memcpy(mValues.array(), &Values[0], Values.size() * sizeof(C_FLOAT64 *));
+
+  mCurrent.resize(mValues.size());
+  mReduced.resize(mValues.size());
+  mSaved.resize(mValues.size());
+  mFirst.resize(mValues.size());
+  mSecond.resize(mValues.size());
+
+  reset();
+
+  return success;
+}
+
+// virtual
+void COutputReduction::output(const Activity & activity)
+{
+  if (mpMaster == NULL)
+    applyUpdateSequence();
+
+  if (activity != DURING ||
+      mMode == None)
+    {
+      if (activity == AFTER)
+        flush();
+
+      forward(activity);
+      return;
+    }
+
+  getCurrentValues(mCurrent);
+
+  switch (mMode)
+    {
+      case Step:
+        reduceStep();
+        break;
+
+      case TimeGrid:
+        reduceTimeGrid();
+        break;
+
+      case Envelope:
+      case Mean:
+        reduceBucket();
+        break;
+
+      case None:
+      case __SIZE:
+        break;
+    }
+}
+
+// virtual
+void COutputReduction::separate(const Activity & activity)
+{
+  flush();
+  COutputHandler::separate(activity);
+}
+
+// virtual
+void COutputReduction::finish()
+{
+  flush();
+  COutputHandler::finish();
+}
+
+void COutputReduction::reset()
+{
+  mCount = 0;
+  mPending = false;
+  mNextTime = 0.0;
+}
+
+void COutputReduction::forward(const Activity & activity)
+{
+  std::set< COutputInterface *>::iterator it = mInterfaces.begin();
+  std::set< COutputInterface *>::iterator end = mInterfaces.end();
+
+  for (; it != end; ++it)
+    (*it)->output(activity);
+}
+
+void COutputReduction::forward(const CVectorCore< C_FLOAT64 > & values)
+{
+  getCurrentValues(mSaved);
+
+  C_FLOAT64 ** ppValue = mValues.array();
+  C_FLOAT64 ** ppValueEnd = ppValue + mValues.size();
+  const C_FLOAT64 * pReduced = values.array();
+
+  for (; ppValue != ppValueEnd; ++ppValue, ++pReduced)
+    **ppValue = *pReduced;
+
+  forward(DURING);
+
+  const C_FLOAT64 * pSaved = mSaved.array();
+
+  for (ppValue = mValues.array(); ppValue != ppValueEnd; ++ppValue, ++pSaved)
+    **ppValue = *pSaved;
+}
+
+void COutputReduction::getCurrentValues(CVectorCore< C_FLOAT64 > & values) const
+{
+  C_FLOAT64 * const * ppValue = mValues.array();
+  C_FLOAT64 * const * ppValueEnd = ppValue + mValues.size();
+  C_FLOAT64 * pCurrent = values.array();
+
+  for (; ppValue != ppValueEnd; ++ppValue, ++pCurrent)
+    *pCurrent = **ppValue;
+}
+
+void COutputReduction::flush()
+{
+  switch (mMode)
+    {
+      case Step:
+      case TimeGrid:
+
+        if (mPending)
+          forward(mFirst);
+
+        break;
+
+      case Envelope:
+      case Mean:
+
+        if (mCount > 0)
+          forwardBucket();
+
+        break;
+
+      case None:
+      case __SIZE:
+        break;
+    }
+
+  reset();
+}
+
+void COutputReduction::reduceStep()
+{
+  if (mCount % (size_t) mParameter == 0)
+    {
+      forward(DURING);
+      mPending = false;
+    }
+  else
+    {
+      mFirst = mCurrent;
+      mPending = true;
+    }
+
+  mCount++;
+}
+
+void COutputReduction::reduceTimeGrid()
+{
+  const C_FLOAT64 & Time = mCurrent[0];
+
+  // The time is reset, e.g., by a subtask, which starts a new segment.
+  if (mCount > 0 && Time < mFirst[0])
+    flush();
+
+  if (mCount == 0)
+    {
+      forward(DURING);
+
+      mFirst = mCurrent;
+      mPending = false;
+      mNextTime = Time + mParameter;
+      mCount++;
+
+      return;
+    }
+
+  const C_FLOAT64 & PreviousTime = mFirst[0];
+
+  // Outputs at the same time, e.g., caused by events, are not interpolated.
+  if (Time > PreviousTime)
+    {
+      mPending = true;
+
+      for (; mNextTime <= Time; mNextTime += mParameter)
+        {
+          C_FLOAT64 Weight = (mNextTime - PreviousTime) / (Time - PreviousTime);
+
+          C_FLOAT64 * pReduced = mReduced.array();
+          C_FLOAT64 * pReducedEnd = pReduced + mReduced.size();
+          const C_FLOAT64 * pFirst = mFirst.array();
+          const C_FLOAT64 * pCurrent = mCurrent.array();
+
+          for (; pReduced != pReducedEnd; ++pReduced, ++pFirst, ++pCurrent)
+            *pReduced = *pFirst + Weight * (*pCurrent - *pFirst);
+
+          mReduced[0] = mNextTime;
+          forward(mReduced);
+
+          mPending = (mNextTime < Time);
+        }
+    }
+
+  mFirst = mCurrent;
+  mCount++;
+}
+
+void COutputReduction::reduceBucket()
+{
+  const C_FLOAT64 & Time = mCurrent[0];
+
+  if (mCount > 0 &&
+      (Time >= mNextTime || Time < mNextTime - mParameter))
+    {
+      forwardBucket();
+      mCount = 0;
+    }
+
+  if (mCount == 0)
+    {
+      mFirst = mCurrent;
+      mSecond = mCurrent;
+      mNextTime = Time + mParameter;
+      mCount++;
+
+      return;
+    }
+
+  C_FLOAT64 * pFirst = mFirst.array();
+  C_FLOAT64 * pFirstEnd = pFirst + mFirst.size();
+  C_FLOAT64 * pSecond = mSecond.array();
+  const C_FLOAT64 * pCurrent = mCurrent.array();
+
+  if (mMode == Envelope)
+    {
+      for (; pFirst != pFirstEnd; ++pFirst, ++pSecond, ++pCurrent)
+        {
+          if (*pCurrent < *pFirst) *pFirst = *pCurrent;
+
+          if (*pCurrent > *pSecond) *pSecond = *pCurrent;
+        }
+    }
+  else
+    {
+      for (; pFirst != pFirstEnd; ++pFirst, ++pCurrent)
+        *pFirst += *pCurrent;
+    }
+
+  mCount++;
+}
+
+void COutputReduction::forwardBucket()
+{
+  if (mMode == Envelope)
+    {
+      forward(mFirst);
+
+      if (mCount > 1)
+        forward(mSecond);
+    }
+  else
+    {
+      C_FLOAT64 * pReduced = mReduced.array();
+      C_FLOAT64 * pReducedEnd = pReduced + mReduced.size();
+      const C_FLOAT64 * pSum = mFirst.array();
+
+      for (; pReduced != pReducedEnd; ++pReduced, ++pSum)
+        *pReduced = *pSum / mCount;
+
+      forward(mReduced);
+    }
+}
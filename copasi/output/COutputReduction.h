@@ -0,0 +1,225 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#ifndef COPASI_COutputReduction
+#define COPASI_COutputReduction
+
+#include "copasi/output/COutputHandler.h"
+#include "copasi/core/CVector.h"
+#include "copasi/core/CEnumAnnotation.h"
+
+/**
+ * An output reduction is an output handler which passes a reduced stream of the
+ * output during a task to its interfaces. It is added to an output handler in place
+ * of the throttled interfaces (e.g., plots, reports, or time series), which are added
+ * to the reduction instead. The task still outputs at full resolution. A task inserts
+ * a reduction in front of its output handler if its problem has the parameters
+ * "Output Reduction" and "Output Reduction Parameter", see CCopasiTask::initialize.
+ *
+ * The reduction is applied to the numerical values of all objects of the interfaces and
+ * the model time. Reduced values are written to the container before the interfaces are
+ * called and restored afterwards. Output before and after the task is passed on unchanged.
+ *
+ * The modes are:
+ *   Step:     every k-th output is passed on (parameter: k)
+ *   TimeGrid: values are linearly interpolated on a fixed time grid (parameter: interval)
+ *   Envelope: the minimum and the maximum of each time bucket are passed on as two
+ *             outputs (parameter: bucket width)
+ *   Mean:     the mean of each time bucket is passed on (parameter: bucket width)
+ *
+ * The last output of a segment (see separate) is always passed on for the modes Step
+ * and TimeGrid, pending buckets are passed on for the modes Envelope and Mean.
+ */
+class COutputReduction: public COutputHandler
+{
+public:
+  enum Mode
+  {
+    None = 0,
+    Step,
+    TimeGrid,
+    Envelope,
+    Mean,
+    __SIZE
+  };
+
+  /**
+   * The names of the modes as used by the parameter "Output Reduction" of a problem
+   */
+  static const CEnumAnnotation< std::string, Mode > ModeName;
+
+  /**
+   * Default constructor
+   */
+  COutputReduction();
+
+  /**
+   * Specific constructor
+   * @param const Mode & mode
+   * @param const C_FLOAT64 & parameter
+   */
+  COutputReduction(const Mode & mode, const C_FLOAT64 & parameter);
+
+  /**
+   * Copy constructor
+   * @param const COutputReduction & src
+   */
+  COutputReduction(const COutputReduction & src);
+
+  /**
+   * Destructor
+   */
+  virtual ~COutputReduction();
+
+  /**
+   * Set the mode and its parameter
+   * @param const Mode & mode
+   * @param const C_FLOAT64 & parameter
+   */
+  void setMode(const Mode & mode, const C_FLOAT64 & parameter);
+
+  /**
+   * Retrieve the mode
+   * @return const Mode & mode
+   */
+  const Mode & getMode() const;
+
+  /**
+   * Retrieve the parameter of the mode
+   * @return const C_FLOAT64 & parameter
+   */
+  const C_FLOAT64 & getParameter() const;
+
+  /**
+   * compile the object list from name vector
+   * @param CObjectInterface::ContainerList listOfContainer
+   * @return bool success
+   */
+  virtual bool compile(CObjectInterface::ContainerList listOfContainer);
+
+  /**
+   * Perform an output event for the current activity
+   * @param const Activity & activity
+   */
+  virtual void output(const Activity & activity);
+
+  /**
+   * Introduce an additional separator into the output
+   * @param const Activity & activity
+   */
+  virtual void separate(const Activity & activity);
+
+  /**
+   * Finish the output
+   */
+  virtual void finish();
+
+private:
+  /**
+   * Reset the reduction state for a new segment
+   */
+  void reset();
+
+  /**
+   * Pass on the output of the current values to all interfaces
+   * @param const Activity & activity
+   */
+  void forward(const Activity & activity);
+
+  /**
+   * Pass on the given values to all interfaces
+   * @param const CVectorCore< C_FLOAT64 > & values
+   */
+  void forward(const CVectorCore< C_FLOAT64 > & values);
+
+  /**
+   * Retrieve the current values
+   * @param CVectorCore< C_FLOAT64 > & values
+   */
+  void getCurrentValues(CVectorCore< C_FLOAT64 > & values) const;
+
+  /**
+   * Pass on pending output at the end of a segment
+   */
+  void flush();
+
+  /**
+   * Reduce the current output for the mode Step
+   */
+  void reduceStep();
+
+  /**
+   * Reduce the current output for the mode TimeGrid
+   */
+  void reduceTimeGrid();
+
+  /**
+   * Reduce the current output for the modes Envelope and Mean
+   */
+  void reduceBucket();
+
+  /**
+   * Pass on the current bucket for the modes Envelope and Mean
+   */
+  void forwardBucket();
+
+  /**
+   * The mode
+   */
+  Mode mMode;
+
+  /**
+   * The parameter of the mode
+   */
+  C_FLOAT64 mParameter;
+
+  /**
+   * Pointers to the reduced values, the first is the model time
+   */
+  CVector< C_FLOAT64 * > mValues;
+
+  /**
+   * Buffer for the current values
+   */
+  CVector< C_FLOAT64 > mCurrent;
+
+  /**
+   * Buffer for the values which are passed on
+   */
+  CVector< C_FLOAT64 > mReduced;
+
+  /**
+   * Buffer for the values of the container while reduced values are passed on
+   */
+  CVector< C_FLOAT64 > mSaved;
+
+  /**
+   * The values of the previous output (Step, TimeGrid), the minimum (Envelope) or
+   * the sum (Mean) of the current bucket
+   */
+  CVector< C_FLOAT64 > mFirst;
+
+  /**
+   * The maximum of the current bucket (Envelope)
+   */
+  CVector< C_FLOAT64 > mSecond;
+
+  /**
+   * The number of outputs in the current segment (Step, TimeGrid) or bucket (Envelope, Mean)
+   */
+  size_t mCount;
+
+  /**
+   * Indicates whether the previous output has not been passed on (Step, TimeGrid)
+   */
+  bool mPending;
+
+  /**
+   * The next time of the grid (TimeGrid) or the end of the current bucket (Envelope, Mean)
+   */
+  C_FLOAT64 mNextTime;
+};
+
+#endif // COPASI_COutputReduction
@@ -431,17 +431,24 @@ void CExperiment::updateFittedPointValuesFromExtendedTimeSeries(const size_t & i
 
 C_FLOAT64 CExperiment::sumOfSquares(const size_t & index,
                                     C_FLOAT64 *& residuals) const
+{
+  mpContainer->applyUpdateSequence(mDependentUpdateSequence);
+
+  return sumOfSquares(index, residuals, mDependentValues);
+}
+
+C_FLOAT64 CExperiment::sumOfSquares(const size_t & index,
+                                    C_FLOAT64 *& residuals,
+                                    const CVectorCore< C_FLOAT64 * > & dependentValues) const
 {
   C_FLOAT64 Residual;
   C_FLOAT64 s = 0.0;
 
   C_FLOAT64 const * pDataDependent = mDataDependent[index];
   C_FLOAT64 const * pEnd = pDataDependent + mDataDependent.numCols();
-  C_FLOAT64 * const * ppDependentValues = mDependentValues.array();
+  C_FLOAT64 * const * ppDependentValues = dependentValues.array();
   C_FLOAT64 const * pScale = mScale[index];
 
-  mpContainer->applyUpdateSequence(mDependentUpdateSequence);
-
   if (mMissingData)
     {
       if (residuals)
@@ -1698,6 +1705,16 @@ const CObjectInterface::ObjectSet & CExperiment::getIndependentObjects() const
   return mIndependentObjects;
 }
 
+const CVector< C_FLOAT64 * > & CExperiment::getIndependentValues() const
+{
+  return mIndependentValues;
+}
+
+const CVector< C_FLOAT64 * > & CExperiment::getDependentValues() const
+{
+  return mDependentValues;
+}
+
 void CExperiment::initializeScalingMatrix()
 {
   mScale.resize(mDataDependent.numRows(), mDataDependent.numCols());
@@ -223,6 +223,21 @@ public:
   C_FLOAT64 sumOfSquares(const size_t & index,
                          C_FLOAT64 *& residuals) const;
 
+  /**
+   * Calculate the sum of squares for the indexed row of the experiment
+   * for the given simulated values of the dependent objects. The values
+   * must be up to date and ordered like the values returned by getDependentValues.
+   * If residuals is not NULL residuals will contain the differences
+   * between the calculated and the experiment values.
+   * @param const size_t & index
+   * @param C_FLOAT64 *& residuals (may be NULL)
+   * @param const CVectorCore< C_FLOAT64 * > & dependentValues
+   * @return C_FLOAT64 sumOfSquares
+   */
+  C_FLOAT64 sumOfSquares(const size_t & index,
+                         C_FLOAT64 *& residuals,
+                         const CVectorCore< C_FLOAT64 * > & dependentValues) const;
+
   /**
    * Calculate the sum of squares for the indexed row of the experiment.
    * On return dependentValues contains the calculated values. If
@@ -595,6 +610,20 @@ public:
    */
   const CObjectInterface::ObjectSet & getIndependentObjects() const;
 
+  /**
+   * Retrieve the pointers to the values of the independent objects in the
+   * order of the columns of the independent data
+   * @return const CVector< C_FLOAT64 * > & independentValues
+   */
+  const CVector< C_FLOAT64 * > & getIndependentValues() const;
+
+  /**
+   * Retrieve the pointers to the values of the dependent objects in the
+   * order of the columns of the dependent data
+   * @return const CVector< C_FLOAT64 * > & dependentValues
+   */
+  const CVector< C_FLOAT64 * > & getDependentValues() const;
+
   /**
    * Fix files written with Version 4.10.55, which wrote the square root of user defined weights for the
    * parameter fitting task
@@ -22,15 +22,21 @@
 // Properties, Inc. and EML Research, gGmbH.
 // All rights reserved.
 
+#include <algorithm>
 #include <cmath>
 
 #include "copasi/copasi.h"
 
+#ifdef USE_OMP
+# include <omp.h>
+#endif // USE_OMP
+
 #include "CFitProblem.h"
 #include "CFitItem.h"
 #include "CFitTask.h"
 #include "CExperimentSet.h"
 #include "CExperiment.h"
+#include "CFitWorker.h"
 
 #include "copasi/CopasiDataModel/CDataModel.h"
 #include "copasi/core/CRootContainer.h"
@@ -115,7 +121,11 @@ CFitProblem::CFitProblem(const CTaskEnum::Task & type,
   mpTimeSens(NULL),
   mpTimeSensProblem(NULL),
   mJacTimeSens(),
-  mpParmTimeSensCN(NULL)
+  mTimeSensTargetOffsets(),
+  mpParmTimeSensCN(NULL),
+  mFitWorkers(),
+  mFitWorkersInitialized(false),
+  mIndependent(false)
 
 {
   initObjects();
@@ -181,7 +191,11 @@ CFitProblem::CFitProblem(const CFitProblem& src,
   mpTimeSens(NULL),
   mpTimeSensProblem(NULL),
   mJacTimeSens(),
-  mpParmTimeSensCN(NULL)
+  mTimeSensTargetOffsets(),
+  mpParmTimeSensCN(NULL),
+  mFitWorkers(),
+  mFitWorkersInitialized(false),
+  mIndependent(false)
 {
   initObjects();
   initializeParameter();
@@ -211,6 +225,8 @@ CFitProblem::~CFitProblem()
   pdelete(mpCorrelationMatrix);
 
   pdelete(mpTimeSensProblem);
+
+  cleanupFitWorkers();
 }
 
 void CFitProblem::initObjects()
@@ -493,6 +509,9 @@ bool CFitProblem::initialize()
 
   mHaveStatistics = false;
   mStoreResults = false;
+  mIndependent = false;
+
+  cleanupFitWorkers();
 
   if (!COptProblem::initialize())
     {
@@ -887,13 +906,79 @@ bool CFitProblem::initialize()
       mpTimeSens->initialize(CCopasiTask::NO_OUTPUT, NULL, NULL);
 
       mJacTimeSens.resize(mSolutionVariables.size(), mpExperimentSet->getDataPointCount());
+
+      // Determine for each experiment the offsets of the sensitivities of the dependent values
+      // with respect to the fit items in the target result. This avoids the lookup by common
+      // name during the calculation.
+      const CDataArray * pTargetsResultAnnotated = pProblem->getTargetsResultAnnotated();
+      const CArray & TargetsResult = pProblem->getTargetsResult();
+
+      mTimeSensTargetOffsets.resize(mpExperimentSet->getExperimentCount());
+
+      for (i = 0, imax = mpExperimentSet->getExperimentCount(); i < imax; i++)
+        {
+          const std::map< const CObjectInterface *, size_t > & Dependents = mpExperimentSet->getExperiment(i)->getDependentObjectsMap();
+          CMatrix< size_t > & Offsets = mTimeSensTargetOffsets[i];
+
+          Offsets.resize(mpOptItems->size(), Dependents.size());
+          Offsets = C_INVALID_INDEX;
+
+          std::map< const CObjectInterface *, size_t >::const_iterator itDependent = Dependents.begin();
+          std::map< const CObjectInterface *, size_t >::const_iterator endDependent = Dependents.end();
+
+          for (; itDependent != endDependent; ++itDependent)
+            {
+              std::string DependentCN = itDependent->first->getCN();
+
+              for (j = 0; j < mpOptItems->size(); ++j)
+                {
+                  Offsets(j, itDependent->second) =
+                    TargetsResult.offset(pTargetsResultAnnotated->cnToIndex({DependentCN, (*mpOptItems)[j]->getObjectCN()}));
+                }
+            }
+        }
     }
   else
-    mpTimeSens = NULL;
+    {
+      mpTimeSens = NULL;
+      mTimeSensTargetOffsets.clear();
+    }
 
   return success;
 }
 
+bool CFitProblem::initializeIndependent()
+{
+#ifdef USE_OMP
+
+  if (!initialize())
+    return false;
+
+  // Time sensitivities and constraints are calculated on the shared container.
+  if (mpTimeSens != NULL ||
+      !mpConstraintItems->empty())
+    return false;
+
+  // The fit worker owns copies of the container and the subtasks.
+  mFitWorkersInitialized = true;
+
+  CFitWorker * pWorker = new CFitWorker();
+  mFitWorkers.push_back(pWorker);
+
+  if (!pWorker->initialize(*this))
+    {
+      cleanupFitWorkers();
+      return false;
+    }
+
+  mIndependent = true;
+
+  return true;
+#else
+  return false;
+#endif // USE_OMP
+}
+
 bool CFitProblem::checkFunctionalConstraints()
 {
   std::vector< COptItem * >::const_iterator it = mpConstraintItems->begin();
@@ -979,9 +1064,15 @@ bool CFitProblem::calculate()
   CFitConstraint **ppConstraint = mExperimentConstraints.array();
   CFitConstraint **ppConstraintEnd;
 
+  // Independent experiments may be evaluated concurrently on copies of the container.
+  bool UseFitWorkers = useFitWorkers(false);
+
+  if (UseFitWorkers)
+    mCalculateValue = calculateWithFitWorkers(false);
+
   try
     {
-      for (i = 0; i < imax && Continue; i++) // For each experiment
+      for (i = 0; i < imax && Continue && !UseFitWorkers; i++) // For each experiment
         {
           pExp = mpExperimentSet->getExperiment(i);
 
@@ -996,31 +1087,6 @@ bool CFitProblem::calculate()
 
           kmax = pExp->getNumDataRows();
 
-          const std::map< const CObjectInterface*, size_t >& map = pExp->getDependentObjectsMap();
-          std::map<size_t, const CObjectInterface*> reverseObjectMap;
-          std::map< std::pair<std::string, std::string>, CDataArray::index_type > indexMap;
-          std::map<size_t, std::string> reverseCnMap;
-
-          if (*mpUseTimeSens)
-            {
-              for (auto it = map.begin(); it != map.end(); ++it)
-                {
-                  reverseObjectMap[it->second] = it->first;
-                  reverseCnMap[it->second] = it->first->getCN();
-                }
-
-              for (size_t i = 0; i < mpOptItems->size(); ++i)
-                {
-                  std::string paramCn = mpOptItems->operator [](i)->getObjectCN();
-
-                  for (size_t k = 0; k < reverseCnMap.size(); ++k)
-                    {
-                      std::string dependenCn = reverseCnMap[k];
-                      indexMap[std::make_pair(dependenCn, paramCn)] = static_cast<CTimeSensProblem*>(mpTimeSens->getProblem())->getTargetsResultAnnotated()->cnToIndex({dependenCn, paramCn });
-                    }
-                }
-            }
-
           switch (pExp->getExperimentType())
             {
               case CTaskEnum::Task::steadyState:
@@ -1171,29 +1237,31 @@ bool CFitProblem::calculate()
                             // copy results to problem
                             CTimeSensMethod* pMethod = static_cast<CTimeSensMethod*>(mpTimeSens->getMethod());
                             pMethod->copySensitivitiesToResultMatrix();
-                            CTimeSensProblem* pProblem = static_cast<CTimeSensProblem*>(mpTimeSens->getProblem());
                             // get current target result
-                            CDataArray* pCurrentResult = pProblem->getTargetsResultAnnotated();
+                            const C_FLOAT64 * pTargetsResult = static_cast<CTimeSensProblem*>(mpTimeSens->getProblem())->getTargetsResult().array();
 
-                            auto it = mpOptItems->begin();
+                            // The offsets of the sensitivities are determined in initialize.
+                            const CMatrix< size_t > & Offsets = mTimeSensTargetOffsets[i];
+                            const C_FLOAT64 * pMeasurementBegin = pExp->getDependentData()[j];
+                            const C_FLOAT64 * pScaleBegin = pExp->getScalingMatrix()[j];
+                            size_t Item, ItemMax = Offsets.numRows();
 
-                            for (size_t i = 0 ; i < mpOptItems->size(); ++i)
+                            for (Item = 0; Item < ItemMax; ++Item)
                               {
-                                std::string paramCn = mpOptItems->operator [](i)->getObjectCN();
+                                const size_t * pOffset = Offsets[Item];
+                                const size_t * pOffsetEnd = pOffset + Offsets.numCols();
+                                const C_FLOAT64 * pMeasurement = pMeasurementBegin;
+                                const C_FLOAT64 * pScale = pScaleBegin;
+                                C_FLOAT64 * pJacobian = mJacTimeSens[Item] + pos;
 
-                                for (size_t k = 0; k < reverseObjectMap.size(); ++k)
+                                for (; pOffset != pOffsetEnd; ++pOffset, ++pMeasurement, ++pScale, ++pJacobian)
                                   {
-                                    const CObjectInterface* pObj = reverseObjectMap[k];
-                                    std::string dependenCn = reverseCnMap[k];
-                                    //double value = pCurrentResult->operator[](CDataArray::name_index_type({dependenCn, paramCn}));
-                                    double value = pCurrentResult->getArray()->operator[](indexMap[std::make_pair(dependenCn, paramCn)]);
-                                    size_t index = map.find(pObj)->second;
-                                    double meassurement = pExp->getDependentData()(j, index);
-
-                                    if (meassurement != meassurement)
-                                      mJacTimeSens(i, pos + k) = 0; // missing data
+                                    if (std::isnan(*pMeasurement))
+                                      *pJacobian = 0; // missing data
+                                    else if (*pOffset == C_INVALID_INDEX)
+                                      *pJacobian = std::numeric_limits< C_FLOAT64 >::quiet_NaN();
                                     else
-                                      mJacTimeSens(i, pos + k) = value * pExp->getScalingMatrix()(j, index);
+                                      *pJacobian = pTargetsResult[*pOffset] **pScale;
                                   }
                               }
                           }
@@ -1257,6 +1325,8 @@ bool CFitProblem::restore(const bool& updateModel, CExperiment* pExp)
 {
   bool success = true;
 
+  cleanupFitWorkers();
+
   if (mpTrajectory != NULL)
     {
       success &= mpTrajectory->restore();
@@ -2086,28 +2156,35 @@ bool CFitProblem::calculateStatistics(const C_FLOAT64 & factor,
       C_FLOAT64 Current;
       C_FLOAT64 Delta;
 
-      // Calculate the gradient
+      // The perturbed values and the resulting objective values and residuals
+      CVector< C_FLOAT64 > PerturbedValues(imax);
+      CVector< C_FLOAT64 > PerturbedObjectives(imax);
+      CMatrix< C_FLOAT64 > PerturbedResiduals;
+
       for (i = 0; i < imax; i++)
         {
           Current = mSolutionVariables[i];
 
           if (fabs(Current) > resolution)
-            {
-              *mContainerVariables[i] = Current * (1.0 + factor);
-              Delta = 1.0 / (Current * factor);
-            }
+            PerturbedValues[i] = Current * (1.0 + factor);
           else
-            {
-              *mContainerVariables[i] = resolution;
-              Delta = 1.0 / resolution;
-            }
+            PerturbedValues[i] = resolution;
+        }
+
+      // All columns of the Jacobian are calculated at once.
+      calculatePerturbations(PerturbedValues, PerturbedObjectives, CalculateFIM ? &PerturbedResiduals : NULL);
 
-          calculate();
+      // Calculate the gradient
+      for (i = 0; i < imax; i++)
+        {
+          Current = mSolutionVariables[i];
 
-          mGradient[i] = (mCalculateValue - mSolutionValue) * Delta;
+          if (fabs(Current) > resolution)
+            Delta = 1.0 / (Current * factor);
+          else
+            Delta = 1.0 / resolution;
 
-          //C_FLOAT64 * pSolutionResidual = SolutionResiduals.array();
-          //C_FLOAT64 * pResidual = mResiduals.array();
+          mGradient[i] = (PerturbedObjectives[i] - mSolutionValue) * Delta;
 
           if (CalculateFIM)
             {
@@ -2119,7 +2196,7 @@ bool CFitProblem::calculateStatistics(const C_FLOAT64 & factor,
                   for (dep_index = 0; dep_index < mpExperimentSet->getExperiment(exp_index)->getDependentObjectsMap().size(); ++dep_index)
                     {
                       C_FLOAT64 * pSolutionResidual = SolutionResiduals.array() + ExperimentStartInResiduals[exp_index] + dep_index;
-                      C_FLOAT64 * pResidual = mResiduals.array() + ExperimentStartInResiduals[exp_index] + dep_index;
+                      C_FLOAT64 * pResidual = PerturbedResiduals[i] + ExperimentStartInResiduals[exp_index] + dep_index;
 
                       for (row_index = 0; row_index < mpExperimentSet->getExperiment(exp_index)->getNumDataRows(); row_index++, ++pDeltaResidualDeltaParameter, ++pDeltaResidualDeltaParameterScaled, pSolutionResidual += mpExperimentSet->getExperiment(exp_index)->getDependentObjectsMap().size(), pResidual += mpExperimentSet->getExperiment(exp_index)->getDependentObjectsMap().size())
                         {
@@ -2129,9 +2206,6 @@ bool CFitProblem::calculateStatistics(const C_FLOAT64 & factor,
                     }
                 }
             }
-
-          // Restore the value
-          *mContainerVariables[i] = Current;
         }
 
       if (!CalculateFIM)
@@ -2350,10 +2424,10 @@ bool CFitProblem::calculateCrossValidation()
   C_FLOAT64 * Residuals = NULL;
   C_FLOAT64 * DependentValues = mCrossValidationDependentValues.array();
 
-  C_FLOAT64 ** pUpdate = mExperimentValues.array();
+  C_FLOAT64 ** pUpdate = mCrossValidationValues.array();
 
-  C_FLOAT64 * pSolution = mSolutionVariables.array();
-  C_FLOAT64 * pSolutionEnd = pSolution + mSolutionVariables.size();
+  C_FLOAT64 * pSolution;
+  C_FLOAT64 * pSolutionEnd = mSolutionVariables.array() + mSolutionVariables.size();
 
   std::vector<COptItem *>::iterator itConstraint;
   std::vector<COptItem *>::iterator endConstraint = mpConstraintItems->end();
@@ -2368,14 +2442,20 @@ bool CFitProblem::calculateCrossValidation()
   CFitConstraint **ppConstraint = mCrossValidationConstraints.array();
   CFitConstraint **ppConstraintEnd;
 
+  // Independent experiments may be evaluated concurrently on copies of the container.
+  bool UseFitWorkers = useFitWorkers(true);
+
+  if (UseFitWorkers)
+    CalculateValue = calculateWithFitWorkers(true);
+
   try
     {
-      for (i = 0; i < imax && Continue; i++) // For each CrossValidation
+      for (i = 0; i < imax && Continue && !UseFitWorkers; i++) // For each CrossValidation
         {
           pExp = mpCrossValidationSet->getExperiment(i);
 
           // set the global and CrossValidation local fit item values.
-          for (; pSolution != pSolutionEnd; pSolution++, pUpdate++)
+          for (pSolution = mSolutionVariables.array(); pSolution != pSolutionEnd; pSolution++, pUpdate++)
             {
               if (*pUpdate)
                 {
@@ -2598,6 +2678,274 @@ bool CFitProblem::calculateCrossValidation()
   return Continue;
 }
 
+#ifdef USE_OMP
+bool CFitProblem::useFitWorkers(const bool & crossValidation)
+{
+  if (!mFitWorkersInitialized)
+    initializeFitWorkers();
+
+  // Stored results, time sensitivities, and constraints require the serial evaluation.
+  if (mFitWorkers.empty() ||
+      mStoreResults ||
+      mpTimeSens != NULL)
+    return false;
+
+  // An independent problem must not use the shared container.
+  if (mIndependent)
+    return true;
+
+  if (crossValidation)
+    return mpCrossValidationSet->getExperimentCount() > 1;
+
+  return mpConstraintItems->empty() &&
+         mpExperimentSet->getExperimentCount() > 1;
+}
+#else
+bool CFitProblem::useFitWorkers(const bool & /* crossValidation */)
+{
+  return false;
+}
+#endif // USE_OMP
+
+C_FLOAT64 CFitProblem::calculateWithFitWorkers(const bool & crossValidation)
+{
+  const CExperimentSet & Set = crossValidation ? *mpCrossValidationSet : *mpExperimentSet;
+  size_t i, imax = Set.getExperimentCount();
+
+  // The values of the fit items
+  CVector< C_FLOAT64 > ItemValues;
+
+  if (crossValidation)
+    ItemValues = mSolutionVariables;
+  else
+    {
+      ItemValues.resize(mpOptItems->size());
+      C_FLOAT64 * pItemValue = ItemValues.array();
+      std::vector< COptItem * >::const_iterator itItem = mpOptItems->begin();
+      std::vector< COptItem * >::const_iterator endItem = mpOptItems->end();
+
+      for (; itItem != endItem; ++itItem, ++pItemValue)
+        *pItemValue = static_cast< CFitItem * >(*itItem)->getLocalValue();
+    }
+
+  // Each experiment writes its residuals to its own block.
+  std::vector< C_FLOAT64 * > Residuals(imax, NULL);
+
+  if (!crossValidation && mResiduals.size() > 0)
+    {
+      C_FLOAT64 * pResiduals = mResiduals.array();
+
+      for (i = 0; i < imax; i++)
+        {
+          Residuals[i] = pResiduals;
+          pResiduals += Set.getExperiment(i)->getDependentData().numRows() * Set.getExperiment(i)->getDependentData().numCols();
+        }
+    }
+
+  CVector< C_FLOAT64 > Values(imax);
+  CVector< bool > Success(imax);
+  Success = true;
+
+#ifdef USE_OMP
+  C_INT32 Last = (C_INT32) imax;
+
+  #pragma omp parallel for schedule(dynamic) num_threads(mFitWorkers.size())
+
+  for (C_INT32 k = 0; k < Last; ++k)
+    {
+      CFitWorker * pWorker = mFitWorkers[omp_get_thread_num()];
+
+      Success[k] = pWorker->calculate(crossValidation, k, ItemValues, Residuals[k], Values[k]);
+    }
+
+#endif // USE_OMP
+
+  // Reduce the contributions in the order of the experiments.
+  C_FLOAT64 Value = 0.0;
+
+  for (i = 0; i < imax; i++)
+    {
+      if (!Success[i])
+        {
+          mFailedCounterException++;
+          return mWorstValue;
+        }
+
+      Value += Values[i];
+    }
+
+  return Value;
+}
+
+bool CFitProblem::calculatePerturbations(const CVectorCore< C_FLOAT64 > & perturbedValues,
+    CVectorCore< C_FLOAT64 > & values,
+    CMatrix< C_FLOAT64 > * pResiduals)
+{
+  size_t i, imax = mContainerVariables.size();
+
+  if (pResiduals != NULL)
+    pResiduals->resize(imax, mResiduals.size());
+
+  // Each perturbation and experiment is independent of all others. Thus even a single
+  // experiment with more than one fit item benefits from the fit workers.
+  bool UseFitWorkers = false;
+
+#ifdef USE_OMP
+
+  if (!mFitWorkersInitialized)
+    initializeFitWorkers();
+
+  UseFitWorkers = !mFitWorkers.empty() &&
+                  !mStoreResults &&
+                  mpTimeSens == NULL &&
+                  mpConstraintItems->empty() &&
+                  imax * mpExperimentSet->getExperimentCount() > 1;
+
+#endif // USE_OMP
+
+  if (!UseFitWorkers)
+    {
+      bool Continue = true;
+
+      for (i = 0; i < imax && Continue; i++)
+        {
+          C_FLOAT64 Current = *mContainerVariables[i];
+          *mContainerVariables[i] = perturbedValues[i];
+
+          Continue &= calculate();
+
+          values[i] = mCalculateValue;
+
+          if (pResiduals != NULL)
+            std::copy(mResiduals.array(), mResiduals.array() + mResiduals.size(), (*pResiduals)[i]);
+
+          // Restore the value
+          *mContainerVariables[i] = Current;
+        }
+
+      return Continue;
+    }
+
+  size_t j, jmax = mpExperimentSet->getExperimentCount();
+
+  // Each item value vector differs from the current values in a single item.
+  CMatrix< C_FLOAT64 > ItemValues(imax, imax);
+
+  for (i = 0; i < imax; i++)
+    {
+      for (j = 0; j < imax; j++)
+        ItemValues(i, j) = *mContainerVariables[j];
+
+      ItemValues(i, i) = perturbedValues[i];
+    }
+
+  // The residuals of each experiment are written to the same block as in calculate().
+  std::vector< size_t > Offsets(jmax, 0);
+  size_t Offset = 0;
+
+  for (j = 0; j < jmax; j++)
+    {
+      Offsets[j] = Offset;
+      Offset += mpExperimentSet->getExperiment(j)->getDependentData().numRows() * mpExperimentSet->getExperiment(j)->getDependentData().numCols();
+    }
+
+  CMatrix< C_FLOAT64 > Values(imax, jmax);
+  CVector< bool > Success(imax * jmax);
+  Success = true;
+
+#ifdef USE_OMP
+  C_INT32 Last = (C_INT32)(imax * jmax);
+
+  #pragma omp parallel for schedule(dynamic) num_threads(mFitWorkers.size())
+
+  for (C_INT32 k = 0; k < Last; ++k)
+    {
+      CFitWorker * pWorker = mFitWorkers[omp_get_thread_num()];
+      size_t Item = k / jmax;
+      size_t Experiment = k % jmax;
+      const CVectorCore< C_FLOAT64 > ItemVector(imax, ItemValues[Item]);
+
+      Success[k] = pWorker->calculate(false, Experiment, ItemVector,
+                                      pResiduals != NULL ? (*pResiduals)[Item] + Offsets[Experiment] : NULL,
+                                      Values(Item, Experiment));
+    }
+
+#endif // USE_OMP
+
+  // Reduce the contributions in the order of the experiments.
+  for (i = 0; i < imax; i++)
+    {
+      C_FLOAT64 & Value = values[i];
+      Value = 0.0;
+
+      for (j = 0; j < jmax; j++)
+        {
+          if (!Success[i * jmax + j])
+            {
+              mFailedCounterException++;
+              Value = mWorstValue;
+              break;
+            }
+
+          Value += Values(i, j);
+        }
+
+      if (std::isnan(Value))
+        {
+          mFailedCounterNaN++;
+          Value = mWorstValue;
+        }
+    }
+
+  mCounter += (unsigned C_INT32) imax;
+
+  if (mpCallBack) return mpCallBack->progressItem(mhCounter);
+
+  return true;
+}
+
+void CFitProblem::initializeFitWorkers()
+{
+  cleanupFitWorkers();
+  mFitWorkersInitialized = true;
+
+#ifdef USE_OMP
+  // Time sensitivities are calculated serially.
+  if (mpTimeSens != NULL) return;
+
+  // We create workers even for a single thread so that the results do not depend on the
+  // number of threads.
+  int Threads = omp_get_max_threads();
+
+  for (int i = 0; i < Threads; ++i)
+    {
+      CFitWorker * pWorker = new CFitWorker();
+      mFitWorkers.push_back(pWorker);
+
+      if (!pWorker->initialize(*this))
+        {
+          cleanupFitWorkers();
+          mFitWorkersInitialized = true;
+
+          return;
+        }
+    }
+
+#endif // USE_OMP
+}
+
+void CFitProblem::cleanupFitWorkers()
+{
+  std::vector< CFitWorker * >::iterator it = mFitWorkers.begin();
+  std::vector< CFitWorker * >::iterator end = mFitWorkers.end();
+
+  for (; it != end; ++it)
+    pdelete(*it);
+
+  mFitWorkers.clear();
+  mFitWorkersInitialized = false;
+}
+
 void CFitProblem::fixBuild55()
 {
   if (mpExperimentSet != NULL)
@@ -38,6 +38,7 @@ class CDataArray;
 class CExperiment;
 class CTimeSensTask;
 class CTimeSensProblem;
+class CFitWorker;
 
 template < class CMatrixType > class CMatrixInterface;
 
@@ -87,6 +88,16 @@ public:
    */
   virtual bool initialize();
 
+  /**
+   * Initialize the problem so that it can be evaluated concurrently with the problem
+   * it has been copied from. All experiments are evaluated by a single private fit worker,
+   * i.e., the shared container and subtasks are not used by calculate. This is not possible
+   * for time sensitivities and constraints. If the initialization fails the problem must
+   * not be used anymore.
+   * @result bool success
+   */
+  virtual bool initializeIndependent();
+
   /**
    * Do the calculation based on CalculateVariables and fill
    * CalculateResults with the results.
@@ -127,6 +138,8 @@ public:
    */
   friend std::ostream &operator<<(std::ostream &os, const CFitProblem & o);
 
+  friend class CFitWorker;
+
   /**
    * This is the output method for any result of a problem. The default implementation
    * provided with CCopasiProblem. Does only print "Not implemented." To override this
@@ -188,6 +201,20 @@ public:
   virtual bool calculateStatistics(const C_FLOAT64 & factor = 1.0e-003,
                                    const C_FLOAT64 & resolution = 1.0e-009);
 
+  /**
+   * Calculate the objective value and the residuals for each fit item with its current value
+   * replaced by the perturbed value, i.e., the columns needed for a forward difference Jacobian.
+   * The perturbed points are distributed over the fit workers if possible, otherwise they are
+   * calculated sequentially with calculate(). The current values of the fit items are preserved.
+   * @param const CVectorCore< C_FLOAT64 > & perturbedValues
+   * @param CVectorCore< C_FLOAT64 > & values
+   * @param CMatrix< C_FLOAT64 > * pResiduals (one row per fit item, may be NULL)
+   * @return bool continue
+   */
+  bool calculatePerturbations(const CVectorCore< C_FLOAT64 > & perturbedValues,
+                              CVectorCore< C_FLOAT64 > & values,
+                              CMatrix< C_FLOAT64 > * pResiduals);
+
   /**
    * Retrieve the root mean square of the objective value.
    * @return const C_FLOAT64 & RMS
@@ -377,6 +404,33 @@ private:
    */
   bool calculateCrossValidation();
 
+  /**
+   * Check whether the experiments of the experiment or cross validation set
+   * are evaluated concurrently by the fit workers. The workers are created if needed.
+   * @param const bool & crossValidation
+   * @return bool useFitWorkers
+   */
+  bool useFitWorkers(const bool & crossValidation);
+
+  /**
+   * Calculate the sum of squares of all experiments of the experiment or cross validation set
+   * with the fit workers. The contributions of the experiments are added in the order of the
+   * experiments, i.e., the result does not depend on the number of workers.
+   * @param const bool & crossValidation
+   * @return C_FLOAT64 value
+   */
+  C_FLOAT64 calculateWithFitWorkers(const bool & crossValidation);
+
+  /**
+   * Create one fit worker for each thread
+   */
+  void initializeFitWorkers();
+
+  /**
+   * Destroy the fit workers
+   */
+  void cleanupFitWorkers();
+
 private:
   // Attributes
   /**
@@ -605,7 +659,28 @@ private:
 
   CMatrix< C_FLOAT64 > mJacTimeSens;
 
+  /**
+   * For each experiment the offsets of the sensitivities of the dependent values (columns)
+   * with respect to the fit items (rows) in the target result of the time sensitivities problem
+   */
+  std::vector< CMatrix< size_t > > mTimeSensTargetOffsets;
+
   std::string* mpParmTimeSensCN;
+
+  /**
+   * The workers evaluating experiments concurrently
+   */
+  std::vector< CFitWorker * > mFitWorkers;
+
+  /**
+   * Indicates whether the creation of the fit workers has been attempted
+   */
+  bool mFitWorkersInitialized;
+
+  /**
+   * Indicates whether the problem is evaluated by its private fit worker only, see initializeIndependent
+   */
+  bool mIndependent;
 };
 
 #endif  // COPASI_CFitProblem
@@ -50,6 +50,7 @@ const CTaskEnum::Method CFitTask::ValidMethods[]  =
   CTaskEnum::Method::GeneticAlgorithmSR,
   CTaskEnum::Method::HookeJeeves,
   CTaskEnum::Method::LevenbergMarquardt,
+  CTaskEnum::Method::MultiStart,
   CTaskEnum::Method::NL2SOL,
   CTaskEnum::Method::NelderMead,
   CTaskEnum::Method::ParticleSwarm,
@@ -0,0 +1,371 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#include <cmath>
+#include <limits>
+
+#include "copasi/copasi.h"
+
+#include "copasi/parameterFitting/CFitWorker.h"
+#include "copasi/parameterFitting/CFitProblem.h"
+#include "copasi/parameterFitting/CExperiment.h"
+#include "copasi/parameterFitting/CExperimentSet.h"
+
+#include "copasi/math/CMathContainer.h"
+#include "copasi/steadystate/CSteadyStateTask.h"
+#include "copasi/trajectory/CTrajectoryTask.h"
+#include "copasi/trajectory/CTrajectoryProblem.h"
+#include "copasi/utilities/CCopasiException.h"
+
+CFitWorker::CFitWorker():
+  mpProblem(NULL),
+  mpSourceValues(NULL),
+  mpContainer(NULL),
+  mpTrajectory(NULL),
+  mpSteadyState(NULL),
+  mpInitialStateTime(NULL),
+  mExperiments(),
+  mCrossValidations()
+{}
+
+CFitWorker::~CFitWorker()
+{
+  cleanup();
+}
+
+void CFitWorker::cleanup()
+{
+  std::vector< sExperiment * >::iterator it = mExperiments.begin();
+  std::vector< sExperiment * >::iterator end = mExperiments.end();
+
+  for (; it != end; ++it)
+    pdelete(*it);
+
+  mExperiments.clear();
+
+  for (it = mCrossValidations.begin(), end = mCrossValidations.end(); it != end; ++it)
+    pdelete(*it);
+
+  mCrossValidations.clear();
+
+  // The tasks are not children of their parent, see initialize.
+  if (mpTrajectory != NULL)
+    {
+      mpTrajectory->setObjectParent(NULL);
+      pdelete(mpTrajectory);
+    }
+
+  if (mpSteadyState != NULL)
+    {
+      mpSteadyState->setObjectParent(NULL);
+      pdelete(mpSteadyState);
+    }
+
+  pdelete(mpContainer);
+
+  mpProblem = NULL;
+  mpSourceValues = NULL;
+  mpInitialStateTime = NULL;
+}
+
+bool CFitWorker::initialize(const CFitProblem & problem)
+{
+  cleanup();
+
+  if (problem.mpContainer == NULL ||
+      problem.mpInitialStateTime == NULL)
+    {
+      return false;
+    }
+
+  // Only methods which are known to be reentrant are supported.
+  if (problem.mpTrajectory != NULL &&
+      problem.mpTrajectory->getMethod()->getSubType() != CTaskEnum::Method::deterministic)
+    {
+      return false;
+    }
+
+  if (problem.mpSteadyState != NULL &&
+      problem.mpSteadyState->getMethod()->getSubType() != CTaskEnum::Method::Newton)
+    {
+      return false;
+    }
+
+  mpProblem = &problem;
+  mpSourceValues = problem.mpContainer->getValues().array();
+  mpContainer = new CMathContainer(*problem.mpContainer);
+
+  if (mpContainer->getValues().size() != problem.mpContainer->getValues().size())
+    {
+      cleanup();
+      return false;
+    }
+
+  mpInitialStateTime = mapValue(problem.mpInitialStateTime);
+
+  if (mpInitialStateTime == NULL ||
+      !initializeExperiments(*problem.mpExperimentSet, problem.mExperimentValues, mExperiments) ||
+      !initializeExperiments(*problem.mpCrossValidationSet, problem.mCrossValidationValues, mCrossValidations))
+    {
+      cleanup();
+      return false;
+    }
+
+  // Create the task copies. They need an ancestor to find the data model, however the task
+  // list must not know about them.
+  bool success = true;
+
+  try
+    {
+      if (problem.mpTrajectory != NULL)
+        {
+          mpTrajectory = new CTrajectoryTask(*problem.mpTrajectory, NO_PARENT);
+          mpTrajectory->setObjectParent(problem.mpTrajectory->getObjectParent());
+          mpTrajectory->setMathContainer(mpContainer);
+          success &= mpTrajectory->initialize(CCopasiTask::NO_OUTPUT, NULL, NULL);
+        }
+
+      if (problem.mpSteadyState != NULL)
+        {
+          mpSteadyState = new CSteadyStateTask(*problem.mpSteadyState, NO_PARENT);
+          mpSteadyState->setObjectParent(problem.mpSteadyState->getObjectParent());
+          mpSteadyState->setMathContainer(mpContainer);
+          success &= mpSteadyState->initialize(CCopasiTask::NO_OUTPUT, NULL, NULL);
+        }
+    }
+
+  catch (...)
+    {
+      success = false;
+    }
+
+  if (!success)
+    {
+      cleanup();
+      return false;
+    }
+
+  return true;
+}
+
+bool CFitWorker::initializeExperiments(const CExperimentSet & set,
+                                       const CMatrix< C_FLOAT64 * > & itemValues,
+                                       std::vector< sExperiment * > & experiments)
+{
+  size_t i, imax = set.getExperimentCount();
+
+  if (itemValues.numRows() != imax)
+    return false;
+
+  experiments.resize(imax, NULL);
+
+  for (i = 0; i < imax; i++)
+    {
+      sExperiment * pExperiment = new sExperiment;
+      experiments[i] = pExperiment;
+
+      pExperiment->pExperiment = set.getExperiment(i);
+
+      // The values of the fit items. Not all items apply to each experiment.
+      pExperiment->ItemValues.resize(itemValues.numCols());
+      C_FLOAT64 * const * ppSource = itemValues[i];
+      C_FLOAT64 ** ppValue = pExperiment->ItemValues.array();
+      C_FLOAT64 ** ppValueEnd = ppValue + pExperiment->ItemValues.size();
+      CObjectInterface::ObjectSet Objects;
+
+      for (; ppValue != ppValueEnd; ++ppValue, ++ppSource)
+        {
+          *ppValue = NULL;
+
+          if (*ppSource == NULL) continue;
+
+          *ppValue = mapValue(*ppSource);
+
+          if (*ppValue == NULL) return false;
+
+          Objects.insert(mpContainer->getMathObject(*ppValue));
+        }
+
+      Objects.erase(NULL);
+      mpContainer->getInitialDependencies().getUpdateSequence(pExperiment->InitialUpdates, CCore::SimulationContext::UpdateMoieties, Objects, mpContainer->getInitialStateObjects());
+
+      Objects.clear();
+
+      if (!mapValues(pExperiment->pExperiment->getIndependentValues(), pExperiment->IndependentValues, Objects))
+        return false;
+
+      mpContainer->getInitialDependencies().getUpdateSequence(pExperiment->IndependentUpdates, CCore::SimulationContext::UpdateMoieties, Objects, mpContainer->getInitialStateObjects());
+
+      Objects.clear();
+
+      if (!mapValues(pExperiment->pExperiment->getDependentValues(), pExperiment->DependentValues, Objects))
+        return false;
+
+      mpContainer->getTransientDependencies().getUpdateSequence(pExperiment->DependentUpdates, CCore::SimulationContext::Default, mpContainer->getStateObjects(false), Objects, mpContainer->getSimulationUpToDateObjects());
+    }
+
+  return true;
+}
+
+bool CFitWorker::calculate(const bool & crossValidation,
+                           const size_t & index,
+                           const CVectorCore< C_FLOAT64 > & itemValues,
+                           C_FLOAT64 * residuals,
+                           C_FLOAT64 & value)
+{
+  sExperiment & Experiment = *(crossValidation ? mCrossValidations : mExperiments)[index];
+  const CExperiment & Exp = *Experiment.pExperiment;
+
+  bool success = true;
+  value = 0.0;
+
+  try
+    {
+      // Each experiment starts from the initial state of the problem.
+      mpContainer->setCompleteInitialState(mpProblem->mCompleteInitialState);
+
+      // set the global and experiment local fit item values.
+      C_FLOAT64 * const * ppValue = Experiment.ItemValues.array();
+      C_FLOAT64 * const * ppValueEnd = ppValue + Experiment.ItemValues.size();
+      const C_FLOAT64 * pItemValue = itemValues.array();
+
+      for (; ppValue != ppValueEnd; ++ppValue, ++pItemValue)
+        if (*ppValue != NULL)
+          {
+            **ppValue = *pItemValue;
+          }
+
+      mpContainer->applyUpdateSequence(Experiment.InitialUpdates);
+
+      size_t j, kmax = Exp.getNumDataRows();
+
+      switch (Exp.getExperimentType())
+        {
+          case CTaskEnum::Task::steadyState:
+            for (j = 0; j < kmax && success; j++) // For each data row;
+              {
+                // set independent data
+                C_FLOAT64 * const * ppIndependent = Experiment.IndependentValues.array();
+                C_FLOAT64 * const * ppIndependentEnd = ppIndependent + Experiment.IndependentValues.size();
+                const C_FLOAT64 * pData = Exp.getIndependentData()[j];
+
+                for (; ppIndependent != ppIndependentEnd; ++ppIndependent, ++pData)
+                  **ppIndependent = *pData;
+
+                mpContainer->applyUpdateSequence(Experiment.IndependentUpdates);
+
+                success = mpSteadyState->process(true);
+
+                if (!success) break;
+
+                mpContainer->applyUpdateSequence(Experiment.DependentUpdates);
+                value += Exp.sumOfSquares(j, residuals, Experiment.DependentValues);
+              }
+
+            break;
+
+          case CTaskEnum::Task::timeCourse:
+          {
+            C_FLOAT64 LastTime = std::numeric_limits< C_FLOAT64 >::quiet_NaN();
+
+            for (j = 0; j < kmax; j++) // For each data row;
+              {
+                if (j)
+                  {
+                    C_FLOAT64 NextTime = Exp.getTimeData()[j];
+
+                    if (NextTime != LastTime)
+                      {
+                        mpTrajectory->processStep(NextTime);
+                        LastTime = NextTime;
+                      }
+                  }
+                else
+                  {
+                    // Set independent data. A time course only has one set of
+                    // independent data.
+                    C_FLOAT64 * const * ppIndependent = Experiment.IndependentValues.array();
+                    C_FLOAT64 * const * ppIndependentEnd = ppIndependent + Experiment.IndependentValues.size();
+                    const C_FLOAT64 * pData = Exp.getIndependentData()[0];
+
+                    for (; ppIndependent != ppIndependentEnd; ++ppIndependent, ++pData)
+                      **ppIndependent = *pData;
+
+                    mpContainer->applyUpdateSequence(Experiment.IndependentUpdates);
+
+                    static_cast< CTrajectoryProblem * >(mpTrajectory->getProblem())->setStepNumber(1);
+                    mpTrajectory->processStart(true);
+
+                    C_FLOAT64 NextTime = Exp.getTimeData()[0];
+
+                    if (NextTime != *mpInitialStateTime)
+                      {
+                        mpTrajectory->processStep(NextTime);
+                        LastTime = NextTime;
+                      }
+                  }
+
+                mpContainer->applyUpdateSequence(Experiment.DependentUpdates);
+                value += Exp.sumOfSquares(j, residuals, Experiment.DependentValues);
+              }
+          }
+          break;
+
+          default:
+            break;
+        }
+    }
+
+  catch (CCopasiException &)
+    {
+      // We do not want to clog the message cue.
+      CCopasiMessage::getLastMessage();
+
+      success = false;
+    }
+
+  catch (...)
+    {
+      success = false;
+    }
+
+  return success;
+}
+
+bool CFitWorker::mapValues(const CVectorCore< C_FLOAT64 * > & sourceValues,
+                           CVector< C_FLOAT64 * > & values,
+                           CObjectInterface::ObjectSet & objects) const
+{
+  values.resize(sourceValues.size());
+
+  C_FLOAT64 * const * ppSource = sourceValues.array();
+  C_FLOAT64 ** ppValue = values.array();
+  C_FLOAT64 ** ppValueEnd = ppValue + values.size();
+
+  for (; ppValue != ppValueEnd; ++ppValue, ++ppSource)
+    {
+      *ppValue = mapValue(*ppSource);
+
+      if (*ppValue == NULL) return false;
+
+      objects.insert(mpContainer->getMathObject(*ppValue));
+    }
+
+  objects.erase(NULL);
+
+  return true;
+}
+
+C_FLOAT64 * CFitWorker::mapValue(const C_FLOAT64 * pSourceValue) const
+{
+  if (pSourceValue == NULL ||
+      pSourceValue < mpSourceValues ||
+      mpSourceValues + mpContainer->getValues().size() <= pSourceValue)
+    {
+      return NULL;
+    }
+
+  return mpContainer->getValues().array() + (pSourceValue - mpSourceValues);
+}
@@ -0,0 +1,168 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#ifndef COPASI_CFitWorker
+#define COPASI_CFitWorker
+
+#include <vector>
+
+#include "copasi/core/CVector.h"
+#include "copasi/core/CMatrix.h"
+#include "copasi/core/CObjectInterface.h"
+#include "copasi/math/CMathUpdateSequence.h"
+
+class CFitProblem;
+class CExperiment;
+class CExperimentSet;
+class CMathContainer;
+class CTrajectoryTask;
+class CSteadyStateTask;
+
+/**
+ * A fit worker calculates the contribution of single experiments to the objective value
+ * of a parameter estimation problem. It owns an independently compiled copy of the math
+ * container, copies of the trajectory and steady-state tasks operating on this container,
+ * and the values and update sequences of the experiments relocated to the copy. Different
+ * workers do not share any mutable state and can therefore evaluate different experiments
+ * concurrently.
+ *
+ * Each experiment starts from the initial state of the problem, i.e., its contribution only
+ * depends on the values of the fit items. Workers can only be created if the tasks are
+ * deterministic and reentrant, i.e., time courses must use LSODA.
+ */
+class CFitWorker
+{
+private:
+  struct sExperiment
+  {
+    const CExperiment * pExperiment;
+    CVector< C_FLOAT64 * > ItemValues;
+    CCore::CUpdateSequence InitialUpdates;
+    CVector< C_FLOAT64 * > IndependentValues;
+    CCore::CUpdateSequence IndependentUpdates;
+    CVector< C_FLOAT64 * > DependentValues;
+    CCore::CUpdateSequence DependentUpdates;
+  };
+
+  /**
+   * Hidden copy constructor
+   */
+  CFitWorker(const CFitWorker & src);
+
+  /**
+   * Hidden assignment operator
+   */
+  CFitWorker & operator = (const CFitWorker & rhs);
+
+public:
+  /**
+   * Default constructor
+   */
+  CFitWorker();
+
+  /**
+   * Destructor
+   */
+  ~CFitWorker();
+
+  /**
+   * Initialize the worker for the given problem. The problem must be initialized.
+   * @param const CFitProblem & problem
+   * @return bool success (false if the problem can not be evaluated by the worker)
+   */
+  bool initialize(const CFitProblem & problem);
+
+  /**
+   * Release the container copy and the tasks
+   */
+  void cleanup();
+
+  /**
+   * Calculate the sum of squares of the indexed experiment of the experiment or cross validation set.
+   * @param const bool & crossValidation
+   * @param const size_t & index
+   * @param const CVectorCore< C_FLOAT64 > & itemValues (values of the fit items)
+   * @param C_FLOAT64 * residuals (may be NULL)
+   * @param C_FLOAT64 & value
+   * @return bool success
+   */
+  bool calculate(const bool & crossValidation,
+                 const size_t & index,
+                 const CVectorCore< C_FLOAT64 > & itemValues,
+                 C_FLOAT64 * residuals,
+                 C_FLOAT64 & value);
+
+private:
+  /**
+   * Relocate the values and update sequences of the experiments of the set
+   * @param const CExperimentSet & set
+   * @param const CMatrix< C_FLOAT64 * > & itemValues
+   * @param std::vector< sExperiment * > & experiments
+   * @return bool success
+   */
+  bool initializeExperiments(const CExperimentSet & set,
+                             const CMatrix< C_FLOAT64 * > & itemValues,
+                             std::vector< sExperiment * > & experiments);
+
+  /**
+   * Map the values of the source container to the values of the copy
+   * @param const CVectorCore< C_FLOAT64 * > & sourceValues
+   * @param CVector< C_FLOAT64 * > & values
+   * @param CObjectInterface::ObjectSet & objects (the math objects of the mapped values are added)
+   * @return bool success
+   */
+  bool mapValues(const CVectorCore< C_FLOAT64 * > & sourceValues,
+                 CVector< C_FLOAT64 * > & values,
+                 CObjectInterface::ObjectSet & objects) const;
+
+  /**
+   * Map a value of the source container to the value of the copy
+   * @param const C_FLOAT64 * pSourceValue
+   * @return C_FLOAT64 * pValue (NULL if the value does not belong to the source container)
+   */
+  C_FLOAT64 * mapValue(const C_FLOAT64 * pSourceValue) const;
+
+  /**
+   * The problem
+   */
+  const CFitProblem * mpProblem;
+
+  /**
+   * The values of the source container
+   */
+  const C_FLOAT64 * mpSourceValues;
+
+  /**
+   * The independent copy of the container
+   */
+  CMathContainer * mpContainer;
+
+  /**
+   * The copy of the trajectory task operating on mpContainer
+   */
+  CTrajectoryTask * mpTrajectory;
+
+  /**
+   * The copy of the steady-state task operating on mpContainer
+   */
+  CSteadyStateTask * mpSteadyState;
+
+  /**
+   * Pointer to the initial time of the copy
+   */
+  const C_FLOAT64 * mpInitialStateTime;
+
+  /**
+   * The relocated experiments of the experiment set
+   */
+  std::vector< sExperiment * > mExperiments;
+
+  /**
+   * The relocated experiments of the cross validation set
+   */
+  std::vector< sExperiment * > mCrossValidations;
+};
+
+#endif // COPASI_CFitWorker
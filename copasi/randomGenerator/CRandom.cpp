@@ -50,6 +50,7 @@ const std::string CRandom::TypeName[] =
   "r250",
   "Mersenne Twister",
   "Mersenne Twister (HR)",
+  "Philox 4x32-10",
   ""
 };
 
@@ -58,6 +59,7 @@ const char * CRandom::XMLType[] =
   "r250",
   "MersenneTwister",
   "MersenneTwisterHR",
+  "Philox4x32",
   NULL
 };
 
@@ -86,6 +88,11 @@ CRandom * CRandom::createGenerator(CRandom::Type type,
         RandomGenerator->mType = type;
         break;
 
+      case philox4x32:
+        RandomGenerator = new Cphilox4x32(seed);
+        RandomGenerator->mType = type;
+        break;
+
       default:
         RandomGenerator = new Cmt19937(seed);
         RandomGenerator->mType = type;
@@ -102,7 +109,9 @@ CRandom::CRandom():
   mType(CRandom::unkown),
   mModulus(1),
   mModulusInv(1.0),
-  mModulusInv1(1.0)
+  mModulusInv1(1.0),
+  mHaveSavedNormal(false),
+  mSavedNormal(0.0)
 {
   varp.a0 = -0.5;
   varp.a1 = 0.3333333;
@@ -275,15 +284,16 @@ C_FLOAT64 CRandom::getRandomOO()
 
 C_FLOAT64 CRandom::getRandomNormal01()
 {
-  static bool HaveValue = true;
-  static C_FLOAT64 SavedValue;
   C_FLOAT64 a, b, s;
 
-  /* negate the flag */
-  HaveValue = !HaveValue;
-
   /* return the stored number (if one is there) */
-  if (HaveValue) return SavedValue;
+  if (mHaveSavedNormal)
+    {
+      mHaveSavedNormal = false;
+      return mSavedNormal;
+    }
+
+  mHaveSavedNormal = true;
 
   do
     {
@@ -296,7 +306,7 @@ C_FLOAT64 CRandom::getRandomNormal01()
   s = sqrt(-2.0 * log(s) / s);
 
   // save one of the numbers for the next time
-  SavedValue = s * a;
+  mSavedNormal = s * a;
 
   // and return the other
   return s * b;
@@ -565,3 +575,149 @@ C_FLOAT64 CRandom::getRandomGamma(C_FLOAT64 shape, C_FLOAT64 scale)
 {
   return scale * getRandomStdGamma(shape);
 }
+
+C_FLOAT64 CRandom::getRandomBinomial(const C_FLOAT64 & trials, const C_FLOAT64 & probability)
+{
+  C_FLOAT64 n = floor(trials + 0.5);
+  C_FLOAT64 p = probability;
+
+  if (!(n > 0.0) || !(p > 0.0)) return 0.0;
+
+  if (p >= 1.0) return n;
+
+  if (p > 0.5)
+    return n - getRandomBinomial(n, 1.0 - p);
+
+  C_FLOAT64 k = 0.0;
+
+  // Reduce large numbers of trials with the beta splitting of Knuth (TAOCP Vol. 2, 3.4.1 F),
+  // which is exact and needs a logarithmic number of gamma variates.
+  while (n * p > 30.0)
+    {
+      C_FLOAT64 a = 1.0 + floor(0.5 * n);
+      C_FLOAT64 b = n + 1.0 - a;
+      C_FLOAT64 Ga = getRandomStdGamma(a);
+      C_FLOAT64 X = Ga / (Ga + getRandomStdGamma(b));
+
+      if (X >= p)
+        {
+          n = a - 1.0;
+          p /= X;
+        }
+      else
+        {
+          k += a;
+          n = b - 1.0;
+          p = (p - X) / (1.0 - X);
+        }
+    }
+
+  // Inversion for small means
+  C_FLOAT64 q = 1.0 - p;
+  C_FLOAT64 s = p / q;
+  C_FLOAT64 a = (n + 1.0) * s;
+  C_FLOAT64 r = pow(q, n);
+  C_FLOAT64 u = getRandomOO();
+  C_FLOAT64 x = 0.0;
+
+  while (u > r && x < n)
+    {
+      u -= r;
+      x += 1.0;
+      r *= a / x - s;
+    }
+
+  return k + x;
+}
+
+// virtual
+void CRandom::fillRandomU(unsigned C_INT32 * pValues, const size_t & size)
+{
+  unsigned C_INT32 * pValuesEnd = pValues + size;
+
+  for (; pValues != pValuesEnd; ++pValues)
+    *pValues = getRandomU();
+}
+
+// virtual
+void CRandom::fillRandomCC(C_FLOAT64 * pValues, const size_t & size)
+{
+  C_FLOAT64 * pValuesEnd = pValues + size;
+
+  for (; pValues != pValuesEnd; ++pValues)
+    *pValues = getRandomCC();
+}
+
+// virtual
+void CRandom::fillRandomCO(C_FLOAT64 * pValues, const size_t & size)
+{
+  C_FLOAT64 * pValuesEnd = pValues + size;
+
+  for (; pValues != pValuesEnd; ++pValues)
+    *pValues = getRandomCO();
+}
+
+// virtual
+void CRandom::fillRandomOO(C_FLOAT64 * pValues, const size_t & size)
+{
+  C_FLOAT64 * pValuesEnd = pValues + size;
+
+  for (; pValues != pValuesEnd; ++pValues)
+    *pValues = getRandomOO();
+}
+
+// virtual
+void CRandom::fillRandomExp(C_FLOAT64 * pValues, const size_t & size)
+{
+  fillRandomOO(pValues, size);
+
+  // The loop has no dependencies and may be vectorized.
+  for (size_t i = 0; i < size; ++i)
+    pValues[i] = -log(pValues[i]);
+}
+
+// virtual
+void CRandom::fillRandomNormal01(C_FLOAT64 * pValues, const size_t & size)
+{
+  size_t Pairs = size / 2;
+
+  fillRandomOO(pValues, 2 * Pairs);
+
+  // The loop has no dependencies and may be vectorized.
+  for (size_t i = 0; i < Pairs; ++i)
+    {
+      C_FLOAT64 r = sqrt(-2.0 * log(pValues[2 * i]));
+      C_FLOAT64 phi = 2.0 * M_PI * pValues[2 * i + 1];
+
+      pValues[2 * i] = r * cos(phi);
+      pValues[2 * i + 1] = r * sin(phi);
+    }
+
+  // For an odd size the second number of the last pair is discarded.
+  if (2 * Pairs < size)
+    {
+      C_FLOAT64 u[2];
+      fillRandomOO(u, 2);
+
+      pValues[size - 1] = sqrt(-2.0 * log(u[0])) * cos(2.0 * M_PI * u[1]);
+    }
+}
+
+// virtual
+void CRandom::fillRandomPoisson(C_FLOAT64 * pValues, const C_FLOAT64 * pMeans, const size_t & size)
+{
+  C_FLOAT64 * pValuesEnd = pValues + size;
+
+  for (; pValues != pValuesEnd; ++pValues, ++pMeans)
+    *pValues = getRandomPoisson(*pMeans);
+}
+
+// virtual
+void CRandom::fillRandomBinomial(C_FLOAT64 * pValues, const C_FLOAT64 * pTrials,
+                                 const C_FLOAT64 * pProbabilities, const size_t & size)
+{
+  C_FLOAT64 * pValuesEnd = pValues + size;
+
+  for (; pValues != pValuesEnd; ++pValues, ++pTrials, ++pProbabilities)
+    *pValues = getRandomBinomial(*pTrials, *pProbabilities);
+}
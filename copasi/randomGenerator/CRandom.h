@@ -57,6 +57,7 @@ public:
     r250 = 0,
     mt19937,
     mt19937HR,
+    philox4x32,
     unkown
   };
 
@@ -107,6 +108,17 @@ protected:
    */
   C_FLOAT64 mModulusInv1;
 
+  /**
+   * Indicates whether the second normally distributed number of the last
+   * pair is available. Generators must reset this in initialize.
+   */
+  bool mHaveSavedNormal;
+
+  /**
+   * The second normally distributed number of the last pair
+   */
+  C_FLOAT64 mSavedNormal;
+
 private:
 
   PoissonVars varp;
@@ -255,6 +267,87 @@ public:
   virtual C_FLOAT64 getRandomGamma(C_FLOAT64 shape, C_FLOAT64 scale);
   virtual C_FLOAT64 getRandomStdGamma(C_FLOAT64 shape);
 
+  /**
+   * Produces a binomially distributed random number, i.e., the number of successes
+   * in trials independent experiments with the given success probability.
+   * @param const C_FLOAT64 & trials
+   * @param const C_FLOAT64 & probability
+   * @return C_FLOAT64 random
+   */
+  virtual C_FLOAT64 getRandomBinomial(const C_FLOAT64 & trials, const C_FLOAT64 & probability);
+
+  /**
+   * Fill the buffer with random numbers in 0 <= n <= Modulus.
+   * The default draws each number with getRandomU()
+   * @param unsigned C_INT32 * pValues
+   * @param const size_t & size
+   */
+  virtual void fillRandomU(unsigned C_INT32 * pValues, const size_t & size);
+
+  /**
+   * Fill the buffer with uniformly distributed random numbers in 0 <= x <= 1.
+   * The default draws each number with getRandomCC()
+   * @param C_FLOAT64 * pValues
+   * @param const size_t & size
+   */
+  virtual void fillRandomCC(C_FLOAT64 * pValues, const size_t & size);
+
+  /**
+   * Fill the buffer with uniformly distributed random numbers in 0 <= x < 1.
+   * The default draws each number with getRandomCO()
+   * @param C_FLOAT64 * pValues
+   * @param const size_t & size
+   */
+  virtual void fillRandomCO(C_FLOAT64 * pValues, const size_t & size);
+
+  /**
+   * Fill the buffer with uniformly distributed random numbers in 0 < x < 1.
+   * The default draws each number with getRandomOO()
+   * @param C_FLOAT64 * pValues
+   * @param const size_t & size
+   */
+  virtual void fillRandomOO(C_FLOAT64 * pValues, const size_t & size);
+
+  /**
+   * Fill the buffer with exponentially distributed random numbers with mean 1.
+   * The numbers are calculated by inversion from fillRandomOO, i.e., the sequence
+   * differs from the one of getRandomExp().
+   * @param C_FLOAT64 * pValues
+   * @param const size_t & size
+   */
+  virtual void fillRandomExp(C_FLOAT64 * pValues, const size_t & size);
+
+  /**
+   * Fill the buffer with normally distributed random numbers with mean 0 and SD 1.
+   * The numbers are calculated with the Box-Muller transform from fillRandomOO, i.e.,
+   * the sequence differs from the one of getRandomNormal01().
+   * @param C_FLOAT64 * pValues
+   * @param const size_t & size
+   */
+  virtual void fillRandomNormal01(C_FLOAT64 * pValues, const size_t & size);
+
+  /**
+   * Fill the buffer with Poisson distributed random numbers for the given means.
+   * The default draws each number with getRandomPoisson(), i.e., the sequence is
+   * identical. The values and means may be the same buffer.
+   * @param C_FLOAT64 * pValues
+   * @param const C_FLOAT64 * pMeans
+   * @param const size_t & size
+   */
+  virtual void fillRandomPoisson(C_FLOAT64 * pValues, const C_FLOAT64 * pMeans, const size_t & size);
+
+  /**
+   * Fill the buffer with binomially distributed random numbers for the given trials
+   * and probabilities. The default draws each number with getRandomBinomial().
+   * The values may be the same buffer as the trials or the probabilities.
+   * @param C_FLOAT64 * pValues
+   * @param const C_FLOAT64 * pTrials
+   * @param const C_FLOAT64 * pProbabilities
+   * @param const size_t & size
+   */
+  virtual void fillRandomBinomial(C_FLOAT64 * pValues, const C_FLOAT64 * pTrials,
+                                  const C_FLOAT64 * pProbabilities, const size_t & size);
+
 protected:
 
   /**
@@ -267,5 +360,6 @@ protected:
 
 #include "Cr250.h"
 #include "Cmt19937.h"
+#include "Cphilox4x32.h"
 
 #endif // COPASI_CRandom
@@ -112,6 +112,7 @@ void Cmt19937::initialize(unsigned C_INT32 seed)
     }
 
   mLeft = 1;
+  mHaveSavedNormal = false;
 }
 
 /* initialize by an array with array-length */
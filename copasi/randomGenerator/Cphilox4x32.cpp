@@ -0,0 +1,212 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#include <algorithm>
+
+#include "copasi/copasi.h"
+#include "CRandom.h"
+
+#define Cphilox4x32_M0 0xD2511F53UL
+#define Cphilox4x32_M1 0xCD9E8D57UL
+#define Cphilox4x32_W0 0x9E3779B9UL
+#define Cphilox4x32_W1 0xBB67AE85UL
+#define Cphilox4x32_CHUNK 256
+
+Cphilox4x32::Cphilox4x32(unsigned C_INT32 seed):
+  CRandom()
+{
+  setModulus(0xffffffffUL);
+  initialize(seed);
+}
+
+Cphilox4x32::~Cphilox4x32() {}
+
+void Cphilox4x32::initialize(unsigned C_INT32 seed)
+{
+  mKey[0] = seed & 0xffffffffUL;
+  mKey[1] = 0;
+
+  mCounter[0] = mCounter[1] = mCounter[2] = mCounter[3] = 0;
+
+  // The buffer is empty
+  mBufferIndex = 4;
+  mHaveSavedNormal = false;
+}
+
+void Cphilox4x32::setStream(const unsigned C_INT32 & stream)
+{
+  mKey[1] = stream & 0xffffffffUL;
+
+  mCounter[0] = mCounter[1] = mCounter[2] = mCounter[3] = 0;
+  mBufferIndex = 4;
+  mHaveSavedNormal = false;
+}
+
+void Cphilox4x32::skipAhead(const unsigned C_INT64 & blocks)
+{
+  advanceCounter(blocks);
+  mBufferIndex = 4;
+}
+
+// static
+void Cphilox4x32::calculateBlock(const unsigned C_INT32 * counter,
+                                 const unsigned C_INT32 * key,
+                                 unsigned C_INT32 * block)
+{
+  unsigned C_INT32 c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+  unsigned C_INT32 k0 = key[0], k1 = key[1];
+
+  for (int i = 0; i < 10; ++i)
+    {
+      unsigned C_INT64 p0 = (unsigned C_INT64) Cphilox4x32_M0 * c0;
+      unsigned C_INT64 p1 = (unsigned C_INT64) Cphilox4x32_M1 * c2;
+
+      unsigned C_INT32 hi0 = (unsigned C_INT32)(p0 >> 32);
+      unsigned C_INT32 lo0 = (unsigned C_INT32) p0;
+      unsigned C_INT32 hi1 = (unsigned C_INT32)(p1 >> 32);
+      unsigned C_INT32 lo1 = (unsigned C_INT32) p1;
+
+      c0 = hi1 ^ c1 ^ k0;
+      c1 = lo1;
+      c2 = hi0 ^ c3 ^ k1;
+      c3 = lo0;
+
+      // Bump the key (Weyl sequence)
+      k0 = (unsigned C_INT32)(k0 + Cphilox4x32_W0);
+      k1 = (unsigned C_INT32)(k1 + Cphilox4x32_W1);
+    }
+
+  block[0] = c0;
+  block[1] = c1;
+  block[2] = c2;
+  block[3] = c3;
+}
+
+void Cphilox4x32::advanceCounter(const unsigned C_INT64 & blocks)
+{
+  unsigned C_INT64 Low = ((unsigned C_INT64) mCounter[1] << 32) | mCounter[0];
+  unsigned C_INT64 NewLow = Low + blocks;
+
+  mCounter[0] = (unsigned C_INT32) NewLow;
+  mCounter[1] = (unsigned C_INT32)(NewLow >> 32);
+
+  // Carry into the upper 64 bit
+  if (NewLow < Low && ++mCounter[2] == 0)
+    ++mCounter[3];
+}
+
+unsigned C_INT32 Cphilox4x32::getRandomU()
+{
+  if (mBufferIndex > 3)
+    {
+      calculateBlock(mCounter, mKey, mBuffer);
+      advanceCounter(1);
+      mBufferIndex = 0;
+    }
+
+  mNumberU = mBuffer[mBufferIndex++];
+
+  return mNumberU;
+}
+
+C_INT32 Cphilox4x32::getRandomS()
+{
+  return getRandomU() >> 1;
+}
+
+C_FLOAT64 Cphilox4x32::getRandomCC()
+{
+  return ((C_FLOAT64) getRandomU()) * (1.0 / 4294967295.0);
+  /* divided by 2^32-1 */
+}
+
+C_FLOAT64 Cphilox4x32::getRandomCO()
+{
+  return ((C_FLOAT64) getRandomU()) * (1.0 / 4294967296.0);
+  /* divided by 2^32 */
+}
+
+C_FLOAT64 Cphilox4x32::getRandomOO()
+{
+  return (((C_FLOAT64) getRandomU()) + 0.5) * (1.0 / 4294967296.0);
+  /* divided by 2^32 */
+}
+
+void Cphilox4x32::fillRandomU(unsigned C_INT32 * pValues, const size_t & size)
+{
+  unsigned C_INT32 * pValuesEnd = pValues + size;
+
+  // Drain the current block first to preserve the sequence.
+  for (; mBufferIndex < 4 && pValues != pValuesEnd; ++pValues)
+    *pValues = mBuffer[mBufferIndex++];
+
+  size_t Blocks = (pValuesEnd - pValues) / 4;
+
+  if (Blocks > 0)
+    {
+      unsigned C_INT64 Low = ((unsigned C_INT64) mCounter[1] << 32) | mCounter[0];
+
+      // Each block only depends on its counter, i.e., the iterations are independent.
+      for (size_t i = 0; i < Blocks; ++i)
+        {
+          unsigned C_INT64 BlockLow = Low + i;
+          unsigned C_INT32 Counter[4];
+
+          Counter[0] = (unsigned C_INT32) BlockLow;
+          Counter[1] = (unsigned C_INT32)(BlockLow >> 32);
+          Counter[2] = mCounter[2];
+          Counter[3] = mCounter[3];
+
+          // Carry into the upper 64 bit
+          if (BlockLow < Low && ++Counter[2] == 0)
+            ++Counter[3];
+
+          calculateBlock(Counter, mKey, pValues + 4 * i);
+        }
+
+      advanceCounter(Blocks);
+      pValues += 4 * Blocks;
+    }
+
+  for (; pValues != pValuesEnd; ++pValues)
+    *pValues = getRandomU();
+
+  if (size > 0)
+    mNumberU = *(pValuesEnd - 1);
+}
+
+void Cphilox4x32::fillScaled(C_FLOAT64 * pValues, const size_t & size,
+                             const C_FLOAT64 & offset, const C_FLOAT64 & scale)
+{
+  unsigned C_INT32 Chunk[Cphilox4x32_CHUNK];
+  size_t Remaining = size;
+
+  while (Remaining > 0)
+    {
+      size_t Size = std::min(Remaining, (size_t) Cphilox4x32_CHUNK);
+      fillRandomU(Chunk, Size);
+
+      for (size_t i = 0; i < Size; ++i)
+        pValues[i] = (((C_FLOAT64) Chunk[i]) + offset) * scale;
+
+      pValues += Size;
+      Remaining -= Size;
+    }
+}
+
+void Cphilox4x32::fillRandomCC(C_FLOAT64 * pValues, const size_t & size)
+{
+  fillScaled(pValues, size, 0.0, 1.0 / 4294967295.0);
+}
+
+void Cphilox4x32::fillRandomCO(C_FLOAT64 * pValues, const size_t & size)
+{
+  fillScaled(pValues, size, 0.0, 1.0 / 4294967296.0);
+}
+
+void Cphilox4x32::fillRandomOO(C_FLOAT64 * pValues, const size_t & size)
+{
+  fillScaled(pValues, size, 0.5, 1.0 / 4294967296.0);
+}
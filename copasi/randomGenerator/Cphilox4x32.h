@@ -0,0 +1,170 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+/**
+ * Cphilox4x32 class implementing the counter-based Philox4x32-10 random number
+ * generator of Salmon, Moraes, Dror, and Shaw, "Parallel random numbers: as easy
+ * as 1, 2, 3", SC '11.
+ *
+ * The n-th block of four random numbers is a bijective function of the counter n
+ * and the key. The key is derived from the seed and the stream, i.e., different
+ * streams of the same seed are independent. Blocks do not depend on each other
+ * which allows to skip ahead in constant time and to fill buffers in loops
+ * without carried dependencies.
+ */
+
+#ifndef COPASI_Cphilox4x32
+#define COPASI_Cphilox4x32
+
+class Cphilox4x32 : public CRandom
+  {
+    friend CRandom * CRandom::createGenerator(CRandom::Type type,
+        unsigned C_INT32 seed);
+
+    // Attributes
+  private:
+    /**
+     * The key consisting of the seed and the stream
+     */
+    unsigned C_INT32 mKey[2];
+
+    /**
+     * The 128 bit counter of the next block, least significant word first
+     */
+    unsigned C_INT32 mCounter[4];
+
+    /**
+     * The current block
+     */
+    unsigned C_INT32 mBuffer[4];
+
+    /**
+     * The index of the next unused number in the current block
+     */
+    size_t mBufferIndex;
+
+    // Operations
+  protected:
+    /**
+     * Default/Named constructor.
+     * Seeds the random number generator with the given seed.
+     * @param C_INT32 seed
+     */
+    Cphilox4x32(unsigned C_INT32 seed);
+
+  public:
+    /**
+     * The destructor.
+     */
+    ~Cphilox4x32();
+
+    /**
+     * Initialize or reinitialize the random number generator with
+     * the given seed. The stream is reset to 0.
+     * @param unsigned C_INT32 seed (default system seed)
+     */
+    void initialize(unsigned C_INT32 seed = CRandom::getSystemSeed());
+
+    /**
+     * Select the stream of the current seed and restart it from its beginning.
+     * @param const unsigned C_INT32 & stream
+     */
+    void setStream(const unsigned C_INT32 & stream);
+
+    /**
+     * Skip the given number of blocks of four random numbers. Numbers remaining
+     * in the current block are discarded.
+     * @param const unsigned C_INT64 & blocks
+     */
+    void skipAhead(const unsigned C_INT64 & blocks);
+
+    /**
+     * Get a random number in 0 <= n <= Modulus
+     * @return unsigned C_INT32 random
+     */
+    unsigned C_INT32 getRandomU();
+
+    /**
+     * Get a random number in 0 <= n <= (Modulus & 0x7ffffff)
+     * @return C_INT32 random
+     */
+    C_INT32 getRandomS();
+
+    /**
+     * Produces a uniformly distributed random number in 0 <= x <= 1.
+     * @return C_FLOAT64 random
+     */
+    C_FLOAT64 getRandomCC();
+
+    /**
+     * Produces a uniformly distributed random number in 0 <= x < 1.
+     * Note: 0 < x <= 1 may be achieved by 1.0 - getRandomCO().
+     * @return const C_FLOAT64 & random
+     */
+    C_FLOAT64 getRandomCO();
+
+    /**
+     * Produces a uniformly distributed random number in 0 < x < 1.
+     * @return const C_FLOAT64 & random
+     */
+    C_FLOAT64 getRandomOO();
+
+    /**
+     * Fill the buffer with random numbers in 0 <= n <= Modulus.
+     * The sequence is identical to the one of getRandomU().
+     * @param unsigned C_INT32 * pValues
+     * @param const size_t & size
+     */
+    void fillRandomU(unsigned C_INT32 * pValues, const size_t & size);
+
+    /**
+     * Fill the buffer with uniformly distributed random numbers in 0 <= x <= 1.
+     * @param C_FLOAT64 * pValues
+     * @param const size_t & size
+     */
+    void fillRandomCC(C_FLOAT64 * pValues, const size_t & size);
+
+    /**
+     * Fill the buffer with uniformly distributed random numbers in 0 <= x < 1.
+     * @param C_FLOAT64 * pValues
+     * @param const size_t & size
+     */
+    void fillRandomCO(C_FLOAT64 * pValues, const size_t & size);
+
+    /**
+     * Fill the buffer with uniformly distributed random numbers in 0 < x < 1.
+     * @param C_FLOAT64 * pValues
+     * @param const size_t & size
+     */
+    void fillRandomOO(C_FLOAT64 * pValues, const size_t & size);
+
+  private:
+    /**
+     * Calculate the block for the given counter and key with 10 Philox rounds
+     * @param const unsigned C_INT32 * counter
+     * @param const unsigned C_INT32 * key
+     * @param unsigned C_INT32 * block
+     */
+    static void calculateBlock(const unsigned C_INT32 * counter,
+                               const unsigned C_INT32 * key,
+                               unsigned C_INT32 * block);
+
+    /**
+     * Advance the counter by the given number of blocks
+     * @param const unsigned C_INT64 & blocks
+     */
+    void advanceCounter(const unsigned C_INT64 & blocks);
+
+    /**
+     * Fill the buffer with (n + offset) * scale for random numbers n
+     * @param C_FLOAT64 * pValues
+     * @param const size_t & size
+     * @param const C_FLOAT64 & offset
+     * @param const C_FLOAT64 & scale
+     */
+    void fillScaled(C_FLOAT64 * pValues, const size_t & size,
+                    const C_FLOAT64 & offset, const C_FLOAT64 & scale);
+  };
+#endif // COPASI_Cphilox4x32
@@ -82,6 +82,7 @@ void Cr250::initialize(unsigned C_INT32 seed)
 
   mIndex = 0;
   mSeed = seed;
+  mHaveSavedNormal = false;
 
   /* Fill the r250 buffer with 15-bit values */
   for (j = 0; j < 250; j++)
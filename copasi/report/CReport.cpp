@@ -22,6 +22,8 @@
 // Properties, Inc. and EML Research, gGmbH.
 // All rights reserved.
 
+#include <limits>
+
 #include "copasi/copasi.h"
 
 #include "CReportDefinition.h"
@@ -36,6 +38,13 @@
 #include "copasi/utilities/CDirEntry.h"
 #include "copasi/utilities/utility.h"
 #include "copasi/commandline/CLocaleString.h"
+#include "copasi/math/CMathObject.h"
+
+// The size of the buffer used for buffered and binary report targets.
+#define REPORT_BUFFER_SIZE 1048576
+
+// The version of the binary report format
+#define BINARY_REPORT_VERSION 1
 
 //////////////////////////////////////////////////
 //
@@ -57,7 +66,13 @@ CReport::CReport():
   mpHeader(NULL),
   mpBody(NULL),
   mpFooter(NULL),
-  mState(Invalid)
+  mState(Invalid),
+  mFormat(Format::Text),
+  mBuffer(),
+  mBinary(false),
+  mBinaryObjectList(),
+  mBinaryValues(),
+  mBinaryHeaderWritten(false)
 {}
 
 CReport::CReport(const CReport & src):
@@ -75,7 +90,13 @@ CReport::CReport(const CReport & src):
   mpHeader(src.mpHeader),
   mpBody(src.mpBody),
   mpFooter(src.mpFooter),
-  mState(Invalid)
+  mState(Invalid),
+  mFormat(src.mFormat),
+  mBuffer(),
+  mBinary(false),
+  mBinaryObjectList(),
+  mBinaryValues(),
+  mBinaryHeaderWritten(false)
 {}
 
 CReport::~CReport()
@@ -131,6 +152,16 @@ void CReport::setConfirmOverwrite(const bool & confirmOverwrite)
   mConfirmOverwrite = confirmOverwrite;
 }
 
+const CReport::Format & CReport::getFormat() const
+{
+  return mFormat;
+}
+
+void CReport::setFormat(const CReport::Format & format)
+{
+  mFormat = format;
+}
+
 void CReport::output(const Activity & activity)
 {
   switch (activity)
@@ -153,7 +184,20 @@ void CReport::separate(const Activity & /* activity */)
 {
   if (!mpOstream) return;
 
-  (*mpOstream) << std::endl;
+  // A separator is a row of NaN values in the binary format.
+  if (mBinary)
+    {
+      writeBinaryHeader();
+
+      C_FLOAT64 NaN = std::numeric_limits< C_FLOAT64 >::quiet_NaN();
+
+      for (size_t i = 0; i < mBinaryObjectList.size(); ++i)
+        mpOstream->write(reinterpret_cast< const char * >(&NaN), sizeof(C_FLOAT64));
+
+      return;
+    }
+
+  endRow();
 }
 
 void CReport::finish()
@@ -162,6 +206,10 @@ void CReport::finish()
 
   printFooter();
 
+  // Rows are not flushed individually for buffered and binary formats.
+  if (mpOstream != NULL && mFormat != Format::Text)
+    mpOstream->flush();
+
   pdelete(mpHeader);
   pdelete(mpBody);
   pdelete(mpFooter);
@@ -175,12 +223,29 @@ void CReport::close()
 
   mpOstream = NULL;
   mStreamOwner = false;
+
+  // The buffer must outlive the stream using it.
+  std::vector< char >().swap(mBuffer);
+}
+
+void CReport::endRow()
+{
+  if (mFormat == Format::Text)
+    (*mpOstream) << std::endl;
+  else
+    (*mpOstream) << '\n';
 }
 
 void CReport::printHeader()
 {
   if (!mpOstream) return;
 
+  if (mBinary)
+    {
+      writeBinaryHeader();
+      return;
+    }
+
   if (mpHeader)
     switch (mState)
       {
@@ -217,13 +282,19 @@ void CReport::printHeader()
 
   for (; it != end; ++it)(*it)->print(mpOstream);
 
-  (*mpOstream) << std::endl;
+  endRow();
 }
 
 void CReport::printBody()
 {
   if (!mpOstream) return;
 
+  if (mBinary)
+    {
+      printBinaryBody();
+      return;
+    }
+
   // Close the header part
   if (mState < HeaderFooter)
     {
@@ -271,13 +342,20 @@ void CReport::printBody()
       (*it)->print(mpOstream);
     }
 
-  (*mpOstream) << std::endl;
+  endRow();
 }
 
 void CReport::printFooter()
 {
   if (!mpOstream) return;
 
+  // The binary format has no footer, however the header must be present even if no rows were written.
+  if (mBinary)
+    {
+      writeBinaryHeader();
+      return;
+    }
+
   // Close the body part
   if (mState < BodyFooter)
     {
@@ -320,7 +398,94 @@ void CReport::printFooter()
 
   for (; it != end; ++it)(*it)->print(mpOstream);
 
-  (*mpOstream) << std::endl;
+  endRow();
+}
+
+void CReport::writeBinaryHeader()
+{
+  if (mBinaryHeaderWritten) return;
+
+  mBinaryHeaderWritten = true;
+
+  const char Magic[] = "COPASIRB";
+  mpOstream->write(Magic, 8);
+
+  unsigned C_INT32 Header[3];
+  Header[0] = BINARY_REPORT_VERSION;
+  Header[1] = 0x01020304; // Byte order mark
+  Header[2] = (unsigned C_INT32) mBinaryObjectList.size();
+  mpOstream->write(reinterpret_cast< const char * >(Header), sizeof(Header));
+
+  std::vector< CObjectInterface * >::const_iterator it = mBinaryObjectList.begin();
+  std::vector< CObjectInterface * >::const_iterator end = mBinaryObjectList.end();
+
+  for (; it != end; ++it)
+    {
+      std::string CN = (*it)->getCN();
+
+      unsigned C_INT32 Column[2];
+      Column[0] = 0; // C_FLOAT64
+      Column[1] = (unsigned C_INT32) CN.size();
+      mpOstream->write(reinterpret_cast< const char * >(Column), sizeof(Column));
+      mpOstream->write(CN.c_str(), CN.size());
+    }
+}
+
+void CReport::printBinaryBody()
+{
+  writeBinaryHeader();
+
+  // The values are written directly from their location, i.e., values of the math container
+  // are written with a single write per contiguous run.
+  std::vector< std::pair< const C_FLOAT64 *, size_t > >::const_iterator it = mBinaryValues.begin();
+  std::vector< std::pair< const C_FLOAT64 *, size_t > >::const_iterator end = mBinaryValues.end();
+
+  for (; it != end; ++it)
+    mpOstream->write(reinterpret_cast< const char * >(it->first), it->second * sizeof(C_FLOAT64));
+}
+
+bool CReport::compileBinary()
+{
+  mBinaryObjectList.clear();
+  mBinaryValues.clear();
+  mBinaryHeaderWritten = false;
+
+  if (mpHeader != NULL || mpBody != NULL || mpFooter != NULL)
+    return false;
+
+  // Only numeric values are written, separators and text are ignored.
+  std::vector< CObjectInterface * >::const_iterator it = mBodyObjectList.begin();
+  std::vector< CObjectInterface * >::const_iterator end = mBodyObjectList.end();
+
+  for (; it != end; ++it)
+    {
+      const C_FLOAT64 * pValue = NULL;
+
+      if (dynamic_cast< const CMathObject * >(*it) != NULL)
+        {
+          pValue = (const C_FLOAT64 *)(*it)->getValuePointer();
+        }
+      else
+        {
+          const CDataObject * pDataObject = CObjectInterface::DataObject(*it);
+
+          if (pDataObject != NULL &&
+              pDataObject->hasFlag(CDataObject::ValueDbl))
+            pValue = (const C_FLOAT64 *)(*it)->getValuePointer();
+        }
+
+      if (pValue == NULL) continue;
+
+      mBinaryObjectList.push_back(*it);
+
+      if (!mBinaryValues.empty() &&
+          mBinaryValues.back().first + mBinaryValues.back().second == pValue)
+        mBinaryValues.back().second++;
+      else
+        mBinaryValues.push_back(std::make_pair(pValue, (size_t) 1));
+    }
+
+  return !mBinaryObjectList.empty();
 }
 
 // Compile the List of Report Objects;
@@ -355,6 +520,16 @@ bool CReport::compile(CObjectInterface::ContainerList listOfContainer)
   if (mpFooter)
     success &= compileChildReport(mpFooter, listOfContainer);
 
+  mBinary = false;
+
+  if (mFormat == Format::Binary)
+    {
+      mBinary = compileBinary();
+
+      if (!mBinary)
+        CCopasiMessage(CCopasiMessage::WARNING, "The report '%s' can not be written in binary format, text is written instead.", mpReportDef->getObjectName().c_str());
+    }
+
   mState = Compiled;
 
   return success;
@@ -390,17 +565,28 @@ std::ostream * CReport::open(const CDataModel * pDataModel,
       mpOstream = new std::ofstream;
       mStreamOwner = true;
 
-      if (mAppend)
+      std::ios_base::openmode Mode = std::ios_base::out;
+
+      if (mFormat != Format::Text)
         {
-          ((std::ofstream *) mpOstream)->
-          open(CLocaleString::fromUtf8(mTarget).c_str(), std::ios_base::out | std::ios_base::app);
+          // The buffer must be set before the file is opened.
+          mBuffer.resize(REPORT_BUFFER_SIZE);
+          ((std::ofstream *) mpOstream)->rdbuf()->pubsetbuf(mBuffer.data(), mBuffer.size());
         }
-      else
+
+      // A binary report has a single header, i.e., it is never appended.
+      if (mFormat == Format::Binary)
+        {
+          Mode |= std::ios_base::binary;
+        }
+      else if (mAppend)
         {
-          ((std::ofstream *) mpOstream)->
-          open(CLocaleString::fromUtf8(mTarget).c_str(), std::ios_base::out);
+          Mode |= std::ios_base::app;
         }
 
+      ((std::ofstream *) mpOstream)->
+      open(CLocaleString::fromUtf8(mTarget).c_str(), Mode);
+
       if (!((std::ofstream *) mpOstream)->is_open())
         {
           CCopasiMessage(CCopasiMessage::ERROR, MCDirEntry + 3, mTarget.c_str());
@@ -455,6 +641,8 @@ void CReport::generateObjectsFromName(const CObjectInterface::ContainerList & li
 
 bool CReport::compileChildReport(CReport * pReport, CObjectInterface::ContainerList listOfContainer)
 {
+  // Nested reports are always written as text.
+  pReport->setFormat(mFormat == Format::Text ? Format::Text : Format::BufferedText);
   pReport->open(mpDataModel, mpOstream);
   bool success = pReport->compile(listOfContainer);
 
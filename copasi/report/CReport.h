@@ -47,6 +47,22 @@ class CReportTable;
 
 class CReport : public COutputInterface
 {
+public:
+  /**
+   * Enumeration of the formats in which the report is written to its target.
+   * Text: each row is terminated with std::endl, i.e., the stream is flushed per row.
+   * BufferedText: the target file uses a large buffer and rows are not flushed.
+   * Binary: a header with the CNs and types of the numeric body columns followed by
+   * the raw C_FLOAT64 values of each row (see writeBinaryHeader).
+   */
+  enum struct Format
+  {
+    Text,
+    BufferedText,
+    Binary
+  };
+
+private:
   /**
    * Enumeration of the report states.
    */
@@ -85,6 +101,34 @@ private:
 
   State mState;
 
+  Format mFormat;
+
+  /**
+   * The buffer of the owned target stream for buffered and binary formats
+   */
+  std::vector< char > mBuffer;
+
+  /**
+   * Indicates whether the body is written in binary format. This is only possible
+   * if the report definition does not contain nested reports.
+   */
+  bool mBinary;
+
+  /**
+   * The numeric objects of the body written in binary format
+   */
+  std::vector< CObjectInterface * > mBinaryObjectList;
+
+  /**
+   * The contiguous runs of values of the binary objects, which are written without copying
+   */
+  std::vector< std::pair< const C_FLOAT64 *, size_t > > mBinaryValues;
+
+  /**
+   * Indicates whether the binary header has been written
+   */
+  bool mBinaryHeaderWritten;
+
 public:
   /**
    * Default constructor.
@@ -201,6 +245,19 @@ public:
    */
   void setConfirmOverwrite(const bool & confirmOverwrite);
 
+  /**
+   * Retrieve the format in which the report is written
+   * @return const Format & format
+   */
+  const Format & getFormat() const;
+
+  /**
+   * Set the format in which the report is written. The format must be set
+   * before the report is opened.
+   * @param const Format & format
+   */
+  void setFormat(const Format & format);
+
 private:
   /**
    * to print header
@@ -217,6 +274,30 @@ private:
    */
   void printFooter();
 
+  /**
+   * Terminate a row of text output, the stream is only flushed for the format Text
+   */
+  void endRow();
+
+  /**
+   * Write the header of the binary format if it has not been written yet.
+   * The header consists of the magic string "COPASIRB", the format version, a byte order
+   * mark, and the number of columns (each an unsigned 32 bit integer) followed by the type
+   * (0: C_FLOAT64) and the length prefixed CN of each column.
+   */
+  void writeBinaryHeader();
+
+  /**
+   * Write the values of the current row in binary format
+   */
+  void printBinaryBody();
+
+  /**
+   * Determine the numeric body objects and their contiguous value runs
+   * @return bool success
+   */
+  bool compileBinary();
+
   /**
    * transfer every individual object list from name vector
    */
@@ -33,6 +33,11 @@
 #include <cmath>
 
 #include "copasi/copasi.h"
+
+#ifdef USE_OMP
+# include <omp.h>
+#endif // USE_OMP
+
 #include "copasi/model/CModel.h"
 #include "copasi/model/CState.h"
 #include "copasi/utilities/CReadConfig.h"
@@ -41,17 +46,33 @@
 #include "CScanProblem.h"
 #include "CScanMethod.h"
 #include "CScanTask.h"
+#include "CScanWorker.h"
 
 #include "copasi/math/CMathContainer.h"
+#include "copasi/output/COutputHandler.h"
 #include "copasi/CopasiDataModel/CDataModel.h"
 #include "copasi/core/CRootContainer.h"
 #include "copasi/utilities/CCopasiMessage.h"
 #include "copasi/utilities/CParameterEstimationUtils.h"
+#include "copasi/utilities/CLeastSquareSolution.h"
 #include <copasi/utilities/CCopasiException.h>
 
 // Uncomment this line below to get debug print out.
 // #define DEBUG_OUTPUT 1
 
+// The relative perturbation of the continuation parameter used to calculate df/dp
+#define PREDICTOR_DERIVATION_FACTOR 1.0e-6
+
+// The derivation factor used to calculate the Jacobian for the prediction
+#define PREDICTOR_JACOBIAN_FACTOR 1.0e-3
+
+// The maximal predicted relative change of the state variables. Larger changes indicate
+// that we are close to a fold and the parameter step is halved.
+#define PREDICTOR_MAX_CHANGE 0.5
+
+// The maximal number of halvings of the parameter step between two scan points
+#define PREDICTOR_MAX_HALVINGS 8
+
 // this will have to be defined somewhere else with the
 // values of other distribution types
 //#define SD_UNIFORM 0
@@ -408,13 +429,23 @@ CScanMethod::CScanMethod(const CDataContainer * pParent,
   mTotalSteps(1),
   mLastNestingItem(C_INVALID_INDEX),
   mContinueFromCurrentState(false),
-  mFailCounter(0)
+  mFailCounter(0),
+  mWorkers(),
+  mGridValues(),
+  mGridSeparators(),
+  mPredictSteadyStates(false),
+  mPredictorParameters(),
+  mPredictorItemValues(),
+  mPredictorState(),
+  mHavePredictorState(false),
+  mPredictorJacobian()
 {
   mpRandomGenerator = CRandom::createGenerator(CRandom::r250);
 }
 
 CScanMethod::~CScanMethod()
 {
+  cleanupWorkers();
   cleanupScanItems();
   delete mpRandomGenerator;
   mpRandomGenerator = NULL;
@@ -452,6 +483,13 @@ bool CScanMethod::init()
   size_t i, imax = mpProblem->getNumberOfScanItems();
   mContinueFromCurrentState = mpProblem->getContinueFromCurrentState();
 
+  // Prediction is only possible if the steady state continues from the last result
+  mPredictSteadyStates = mContinueFromCurrentState &&
+                         mpProblem->getPredictSteadyStates() &&
+                         mpProblem->getSubtask() == CTaskEnum::Task::steadyState;
+  mPredictorParameters.clear();
+  mHavePredictorState = false;
+
   for (i = 0; i < imax; ++i)
     {
       CScanItem * pItem = CScanItem::createScanItemFromParameterGroup(mpProblem->getScanItem(i),
@@ -464,6 +502,7 @@ bool CScanMethod::init()
 
       mScanItems.push_back(pItem);
       mTotalSteps *= pItem->getNumSteps() + 1;
+      mPredictorParameters.push_back(NULL);
 
       const CObjectInterface * pObject = pItem->getObject();
 
@@ -478,6 +517,16 @@ bool CScanMethod::init()
                 {
                   pObject += Offset;
                 }
+
+              // Only fixed values may serve as continuation parameter
+              const CMathObject * pMathObject = static_cast< const CMathObject * >(pObject);
+
+              if (mPredictSteadyStates &&
+                  pMathObject->getValueType() == CMath::ValueType::Value &&
+                  pMathObject->getSimulationType() == CMath::SimulationType::Fixed)
+                {
+                  mPredictorParameters.back() = (C_FLOAT64 *) pObject->getValuePointer();
+                }
             }
 
           ObjectSet.insert(pObject);
@@ -530,10 +579,18 @@ bool CScanMethod::scan()
     mScanItems[i]->storeValue();
 
   mFailCounter = 0;
+  mHavePredictorState = false;
 
   //Do the scan...
   if (imax) //there are scan items
-    success = loop(0);
+    {
+      if (initializeWorkers())
+        success = parallelScan();
+      else
+        success = loop(0);
+
+      cleanupWorkers();
+    }
   else
     success = calculate(); //nothing to scan, only one call to the subtask
 
@@ -587,6 +644,11 @@ bool CScanMethod::calculate()
 
   mpContainer->applyUpdateSequence(mInitialUpdates);
 
+  if (mPredictSteadyStates)
+    {
+      predictSteadyState();
+    }
+
 #ifdef DEBUG_OUTPUT
   std::cout << "CScanMethod::calculate State 2: " << mpContainer->getValues() << std::endl;
 #endif // DEBUG_OUTPUT
@@ -605,6 +667,11 @@ bool CScanMethod::calculate()
       CCopasiMessage::getLastMessage();
     }
 
+  if (mPredictSteadyStates)
+    {
+      storeSteadyState(success);
+    }
+
   if (!success)
     {
       ++mFailCounter;
@@ -617,6 +684,403 @@ bool CScanMethod::calculate()
   return success;
 }
 
+void CScanMethod::predictSteadyState()
+{
+  if (!mHavePredictorState) return;
+
+  CSteadyStateTask * pSubtask = dynamic_cast< CSteadyStateTask * >(mpTask->getSubtask());
+
+  if (pSubtask == NULL) return;
+
+  // We predict only if exactly one continuation parameter changed since the last steady state.
+  size_t Changed = C_INVALID_INDEX;
+  size_t i, imax = mScanItems.size();
+
+  for (i = 0; i < imax; ++i)
+    {
+      const CObjectInterface * pObject = mScanItems[i]->getObject();
+
+      if (pObject == NULL ||
+          *(const C_FLOAT64 *) pObject->getValuePointer() == mPredictorItemValues[i])
+        continue;
+
+      if (Changed != C_INVALID_INDEX ||
+          mPredictorParameters[i] == NULL)
+        return;
+
+      Changed = i;
+    }
+
+  if (Changed == C_INVALID_INDEX) return;
+
+  C_FLOAT64 * pParameter = mPredictorParameters[Changed];
+  C_FLOAT64 ParameterValue = *pParameter;
+  CVector< C_FLOAT64 > StartState = mpContainer->getState(true);
+
+  C_FLOAT64 Target = *(const C_FLOAT64 *) mScanItems[Changed]->getObject()->getValuePointer();
+  C_FLOAT64 Current = mPredictorItemValues[Changed];
+  C_FLOAT64 Step = Target - Current;
+
+  // Intermediate steady states can only be calculated if the subtask does not create output.
+  size_t MaxHalvings = mpProblem->getOutputInSubtask() ? 0 : PREDICTOR_MAX_HALVINGS;
+  size_t Halvings = 0;
+
+  size_t Offset = mpContainer->getCountFixedEventTargets() + 1;
+  CVector< C_FLOAT64 > State = mPredictorState;
+  CVector< C_FLOAT64 > Predicted;
+  CVector< C_FLOAT64 > Tangent;
+  bool success = false;
+
+  while (calculateTangent(pParameter, Current, State, Tangent))
+    {
+      bool Last = fabs(Step) >= fabs(Target - Current);
+
+      if (Last)
+        {
+          Step = Target - Current;
+        }
+
+      // The largest relative change of the state variables per unit of the parameter
+      C_FLOAT64 Sensitivity = 0.0;
+      const C_FLOAT64 * pTangent = Tangent.array();
+      const C_FLOAT64 * pTangentEnd = pTangent + Tangent.size();
+      const C_FLOAT64 * pState = State.array() + Offset;
+
+      for (; pTangent != pTangentEnd; ++pTangent, ++pState)
+        {
+          Sensitivity = std::max(Sensitivity, fabs(*pTangent) / std::max(fabs(*pState), 1.0));
+        }
+
+      if (std::isnan(Sensitivity)) break;
+
+      // A large predicted change indicates that we are close to a fold.
+      while (fabs(Step) * Sensitivity > PREDICTOR_MAX_CHANGE &&
+             Halvings < MaxHalvings)
+        {
+          Step *= 0.5;
+          ++Halvings;
+          Last = false;
+        }
+
+      if (fabs(Step) * Sensitivity > PREDICTOR_MAX_CHANGE) break;
+
+      Predicted = State;
+      C_FLOAT64 * pPredicted = Predicted.array() + Offset;
+
+      for (pTangent = Tangent.array(); pTangent != pTangentEnd; ++pTangent, ++pPredicted)
+        {
+          *pPredicted += *pTangent * Step;
+        }
+
+      if (Last)
+        {
+          success = true;
+          break;
+        }
+
+      // Calculate the intermediate steady state without output.
+      *pParameter = Current + Step;
+      mpContainer->setState(Predicted);
+      mpContainer->applyUpdateSequence(mInitialUpdates);
+
+      try
+        {
+          pSubtask->process(false);
+        }
+      catch (const CCopasiException &)
+        {
+          CCopasiMessage::getLastMessage();
+          break;
+        }
+
+      if (pSubtask->getResult() != CSteadyStateMethod::found &&
+          pSubtask->getResult() != CSteadyStateMethod::foundEquilibrium)
+        break;
+
+      Current += Step;
+      State = mpContainer->getState(true);
+
+      // Try to recover the original step size.
+      Step *= 2.0;
+    }
+
+  mpContainer->setState(success ? Predicted : StartState);
+  *pParameter = ParameterValue;
+  mpContainer->applyUpdateSequence(mInitialUpdates);
+}
+
+bool CScanMethod::calculateTangent(C_FLOAT64 * pParameter,
+                                   const C_FLOAT64 & value,
+                                   const CVector< C_FLOAT64 > & state,
+                                   CVector< C_FLOAT64 > & tangent)
+{
+  size_t Offset = mpContainer->getCountFixedEventTargets() + 1;
+  size_t Dimension = state.size() - Offset;
+
+  if (Dimension == 0) return false;
+
+  mpContainer->setState(state);
+
+  // Calculate df/dp by central differences.
+  C_FLOAT64 Delta = (value != 0.0 ? fabs(value) : 1.0) * PREDICTOR_DERIVATION_FACTOR;
+  const CVectorCore< C_FLOAT64 > & Rates = mpContainer->getRate(true);
+
+  *pParameter = value + Delta;
+  mpContainer->applyUpdateSequence(mInitialUpdates);
+  mpContainer->updateSimulatedValues(true);
+  CVector< C_FLOAT64 > RatesPlus = Rates;
+
+  *pParameter = value - Delta;
+  mpContainer->applyUpdateSequence(mInitialUpdates);
+  mpContainer->updateSimulatedValues(true);
+
+  // The tangent solves J * dx/dp = - df/dp
+  CVector< C_FLOAT64 > Derivative(Dimension);
+  C_FLOAT64 * pDerivative = Derivative.array();
+  C_FLOAT64 * pDerivativeEnd = pDerivative + Dimension;
+  const C_FLOAT64 * pPlus = RatesPlus.array() + Offset;
+  const C_FLOAT64 * pMinus = Rates.array() + Offset;
+
+  for (; pDerivative != pDerivativeEnd; ++pDerivative, ++pPlus, ++pMinus)
+    {
+      *pDerivative = (*pMinus - *pPlus) / (2.0 * Delta);
+    }
+
+  *pParameter = value;
+  mpContainer->applyUpdateSequence(mInitialUpdates);
+  mpContainer->updateSimulatedValues(true);
+  mpContainer->calculateJacobian(mPredictorJacobian, PREDICTOR_JACOBIAN_FACTOR, true);
+
+  // A singular Jacobian indicates that we are at a fold.
+  if (CLeastSquareSolution::solve(mPredictorJacobian, CVectorCore< const C_FLOAT64 >(Dimension, Derivative.array()), tangent) != Dimension)
+    return false;
+
+  return tangent.size() == Dimension;
+}
+
+void CScanMethod::storeSteadyState(const bool & success)
+{
+  const CSteadyStateTask * pSubtask = dynamic_cast< const CSteadyStateTask * >(mpTask->getSubtask());
+
+  mHavePredictorState = success &&
+                        pSubtask != NULL &&
+                        (pSubtask->getResult() == CSteadyStateMethod::found ||
+                         pSubtask->getResult() == CSteadyStateMethod::foundEquilibrium);
+
+  if (!mHavePredictorState) return;
+
+  mPredictorState = mpContainer->getState(true);
+  mPredictorItemValues.resize(mScanItems.size());
+
+  size_t i, imax = mScanItems.size();
+
+  for (i = 0; i < imax; ++i)
+    {
+      const CObjectInterface * pObject = mScanItems[i]->getObject();
+      mPredictorItemValues[i] = pObject != NULL ? *(const C_FLOAT64 *) pObject->getValuePointer() : 0.0;
+    }
+}
+
+bool CScanMethod::initializeWorkers()
+{
+  cleanupWorkers();
+
+#ifdef USE_OMP
+  size_t Threads = omp_get_max_threads();
+
+  if (Threads < 2 ||
+      mTotalSteps < 2 ||
+      mContinueFromCurrentState ||
+      mpProblem->getOutputInSubtask() ||
+      !CScanWorker::isSupportedSubtask(mpTask->getSubtask()))
+    return false;
+
+  // Only the values of the container are copied back from the workers. Output objects outside
+  // the container, e.g., eigenvalues or other results of the subtask, would be stale.
+  if (mpTask->getOutputHandler() != NULL)
+    {
+      const C_FLOAT64 * pValuesBegin = mpContainer->getValues().array();
+      const C_FLOAT64 * pValuesEnd = pValuesBegin + mpContainer->getValues().size();
+
+      const CObjectInterface::ObjectSet & Objects = mpTask->getOutputHandler()->getObjects();
+      CObjectInterface::ObjectSet::const_iterator itObject = Objects.begin();
+      CObjectInterface::ObjectSet::const_iterator endObject = Objects.end();
+
+      for (; itObject != endObject; ++itObject)
+        {
+          const C_FLOAT64 * pValue = (const C_FLOAT64 *)(*itObject)->getValuePointer();
+
+          if (pValuesBegin <= pValue && pValue < pValuesEnd) continue;
+
+          // Static strings and display names do not change during the scan.
+          const CDataObject * pDataObject = dynamic_cast< const CDataObject * >(*itObject);
+
+          if (pDataObject != NULL &&
+              (pDataObject->hasFlag(CDataObject::StaticString) ||
+               pDataObject->hasFlag(CDataObject::DisplayName)))
+            continue;
+
+          return false;
+        }
+    }
+
+  std::vector< C_FLOAT64 * > ItemValues;
+  std::vector< CScanItem * >::const_iterator itItem = mScanItems.begin();
+  std::vector< CScanItem * >::const_iterator endItem = mScanItems.end();
+
+  for (; itItem != endItem; ++itItem)
+    {
+      const CObjectInterface * pObject = (*itItem)->getObject();
+      ItemValues.push_back(pObject != NULL ? (C_FLOAT64 *) pObject->getValuePointer() : NULL);
+    }
+
+  mWorkers.resize(Threads, NULL);
+
+  std::vector< CScanWorker * >::iterator it = mWorkers.begin();
+  std::vector< CScanWorker * >::iterator end = mWorkers.end();
+
+  for (; it != end; ++it)
+    {
+      *it = new CScanWorker();
+
+      if (!(*it)->initialize(*mpContainer, *mpTask->getSubtask(), ItemValues))
+        {
+          // The scan must be done serially.
+          cleanupWorkers();
+          return false;
+        }
+    }
+
+  return true;
+#else
+  return false;
+#endif // USE_OMP
+}
+
+void CScanMethod::cleanupWorkers()
+{
+  std::vector< CScanWorker * >::iterator it = mWorkers.begin();
+  std::vector< CScanWorker * >::iterator end = mWorkers.end();
+
+  for (; it != end; ++it)
+    {
+      pdelete(*it);
+    }
+
+  mWorkers.clear();
+  mGridValues.clear();
+  mGridSeparators.clear();
+}
+
+void CScanMethod::enumerate(size_t level)
+{
+  bool isLastMasterItem = (level == (mScanItems.size() - 1));
+
+  CScanItem* currentSI = mScanItems[level];
+
+  for (currentSI->reset(); !currentSI->isFinished(); currentSI->step())
+    {
+      if (isLastMasterItem)
+        {
+          std::vector< CScanItem * >::const_iterator it = mScanItems.begin();
+          std::vector< CScanItem * >::const_iterator end = mScanItems.end();
+
+          for (; it != end; ++it)
+            {
+              const CObjectInterface * pObject = (*it)->getObject();
+              mGridValues.push_back(pObject != NULL ? *(C_FLOAT64 *) pObject->getValuePointer() : 0.0);
+            }
+        }
+      else
+        {
+          enumerate(level + 1);
+        }
+
+      if (currentSI->isNesting())
+        mGridSeparators.push_back(std::make_pair(mGridValues.size() / mScanItems.size() - 1, level == mLastNestingItem));
+    }
+}
+
+bool CScanMethod::parallelScan()
+{
+#ifdef USE_OMP
+  // All grid points start from the initial state before the scan items are set.
+  CVector< C_FLOAT64 > InitialState = mpContainer->getCompleteInitialState();
+
+  // The random scan items are drawn in the same order as in the serial scan.
+  mGridValues.clear();
+  mGridSeparators.clear();
+  enumerate(0);
+
+  size_t Items = mScanItems.size();
+  size_t Points = mGridValues.size() / Items;
+  size_t ValueCount = mpContainer->getValues().size();
+
+  // Each grid point of a batch is stored until the whole batch is written to the output.
+  size_t BatchSize = 4 * mWorkers.size();
+  std::vector< CVector< C_FLOAT64 > > Results(BatchSize);
+  CVector< bool > Success(BatchSize);
+  CVector< bool > Exception(BatchSize);
+
+  std::vector< CVector< C_FLOAT64 > >::iterator itResult = Results.begin();
+  std::vector< CVector< C_FLOAT64 > >::iterator endResult = Results.end();
+
+  for (; itResult != endResult; ++itResult)
+    {
+      itResult->resize(ValueCount);
+    }
+
+  std::vector< std::pair< size_t, bool > >::const_iterator itSeparator = mGridSeparators.begin();
+  std::vector< std::pair< size_t, bool > >::const_iterator endSeparator = mGridSeparators.end();
+
+  for (size_t First = 0; First < Points; First += BatchSize)
+    {
+      size_t Last = std::min(First + BatchSize, Points);
+      C_INT32 iLast = (C_INT32) Last;
+
+      #pragma omp parallel for schedule(dynamic) num_threads(mWorkers.size())
+
+      for (C_INT32 i = (C_INT32) First; i < iLast; ++i)
+        {
+          CScanWorker * pWorker = mWorkers[omp_get_thread_num()];
+          bool IsException = false;
+
+          Success[i - First] = pWorker->calculate(InitialState, &mGridValues[i * Items], IsException);
+          Exception[i - First] = IsException;
+          memcpy(Results[i - First].array(), pWorker->getValues().array(), ValueCount * sizeof(C_FLOAT64));
+        }
+
+      // The output is done in the order of the serial scan.
+      for (size_t i = First; i < Last; ++i)
+        {
+          bool success = false;
+
+          if (!Exception[i - First])
+            {
+              memcpy(mpContainer->getValues().array(), Results[i - First].array(), ValueCount * sizeof(C_FLOAT64));
+              success = mpTask->outputCallback(Success[i - First]);
+            }
+
+          if (!success)
+            {
+              ++mFailCounter;
+              success = mpProblem->getContinueOnError();
+            }
+
+          if (!success)
+            return false;
+
+          for (; itSeparator != endSeparator && itSeparator->first == i; ++itSeparator)
+            mpTask->outputSeparatorCallback(itSeparator->second);
+        }
+    }
+
+  return true;
+#else
+  return loop(0);
+#endif // USE_OMP
+}
+
 void CScanMethod::setProblem(CScanProblem * problem)
 {mpProblem = problem;}
 
@@ -39,6 +39,7 @@
 
 class CScanProblem;
 class CScanTask;
+class CScanWorker;
 class CSteadyStateTask;
 class CTrajectory;
 class CRandom;
@@ -214,6 +215,54 @@ protected:
    */
   size_t mFailCounter;
 
+  /**
+   * The workers calculating grid points in parallel
+   */
+  std::vector< CScanWorker * > mWorkers;
+
+  /**
+   * The values of the scan items for all grid points when scanning in parallel
+   */
+  std::vector< C_FLOAT64 > mGridValues;
+
+  /**
+   * The output separators when scanning in parallel. A separator with the
+   * given flag isLast is written after the output of the indexed grid point.
+   */
+  std::vector< std::pair< size_t, bool > > mGridSeparators;
+
+  /**
+   * Variable indicating whether the steady state of a scan point is predicted
+   * from the steady state of the previous scan point
+   */
+  bool mPredictSteadyStates;
+
+  /**
+   * The transient value of each scan item if it may be used as the continuation
+   * parameter of the prediction, and NULL otherwise
+   */
+  std::vector< C_FLOAT64 * > mPredictorParameters;
+
+  /**
+   * The values of the scan items at the last steady state
+   */
+  std::vector< C_FLOAT64 > mPredictorItemValues;
+
+  /**
+   * The reduced state of the last steady state
+   */
+  CVector< C_FLOAT64 > mPredictorState;
+
+  /**
+   * Indicates whether the last steady state is available for prediction
+   */
+  bool mHavePredictorState;
+
+  /**
+   * The reduced Jacobian used to calculate the tangent
+   */
+  CMatrix< C_FLOAT64 > mPredictorJacobian;
+
   // Operations
 private:
   /**
@@ -269,6 +318,60 @@ private:
 
   bool calculate();
 
+  /**
+   * Predict the steady state of the current scan point from the last steady state if
+   * exactly one continuation parameter changed. The prediction follows the tangent
+   * dx/dp = - J^-1 df/dp. If the predicted change is too large, e.g., close to a fold,
+   * the parameter step is halved and the intermediate steady states are calculated
+   * without output. If the prediction fails, the state is not changed.
+   */
+  void predictSteadyState();
+
+  /**
+   * Calculate the tangent dx/dp of the steady state curve for the given parameter
+   * at the given reduced state.
+   * @param C_FLOAT64 * pParameter
+   * @param const C_FLOAT64 & value
+   * @param const CVector< C_FLOAT64 > & state
+   * @param CVector< C_FLOAT64 > & tangent
+   * @return bool success (false if the Jacobian is singular)
+   */
+  bool calculateTangent(C_FLOAT64 * pParameter,
+                        const C_FLOAT64 & value,
+                        const CVector< C_FLOAT64 > & state,
+                        CVector< C_FLOAT64 > & tangent);
+
+  /**
+   * Store the state and scan item values if the subtask found a steady state.
+   * @param const bool & success
+   */
+  void storeSteadyState(const bool & success);
+
+  /**
+   * Create the workers for a parallel scan. This is only possible if the scan does not
+   * continue from the current state, the output is not done in the subtask, the
+   * subtask is supported by CScanWorker, and all output objects are values of the container.
+   * @return bool success
+   */
+  bool initializeWorkers();
+
+  /**
+   * Release the workers
+   */
+  void cleanupWorkers();
+
+  /**
+   * Enumerate the grid points and separators in the order of the serial scan
+   * @param size_t level
+   */
+  void enumerate(size_t level);
+
+  /**
+   * Calculate the grid points in parallel and do the output in the order of the serial scan.
+   * @return bool success
+   */
+  bool parallelScan();
+
   /**
    *  Set the value of the scan parameter based on the distribution
    *  @param size_t i where to start in the distribution
@@ -73,6 +73,7 @@ void CScanProblem::initializeParameter()
   assertParameter("Output in subtask", CCopasiParameter::Type::BOOL, true);
   assertParameter("Adjust initial conditions", CCopasiParameter::Type::BOOL, false);
   assertParameter("Continue on Error", CCopasiParameter::Type::BOOL, false);
+  assertParameter("Predict Steady States", CCopasiParameter::Type::BOOL, false);
 }
 
 //***********************************
@@ -115,6 +116,16 @@ void CScanProblem::setContinueOnError(bool coe)
   setValue("Continue on Error", coe);
 }
 
+bool CScanProblem::getPredictSteadyStates() const
+{
+  return getValue< bool >("Predict Steady States");
+}
+
+void CScanProblem::setPredictSteadyStates(bool pss)
+{
+  setValue("Predict Steady States", pss);
+}
+
 
 //************************************
 
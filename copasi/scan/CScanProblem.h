@@ -115,6 +115,19 @@ public:
    */
   void setContinueOnError(bool coe);
 
+  /**
+   *  Retrieve whether the steady state of the next scan point is predicted
+   *  from the previous one. This requires that the subtask continues with its
+   *  last result.
+   */
+  bool getPredictSteadyStates() const;
+
+  /**
+   *  Set whether the steady state of the next scan point is predicted
+   *  from the previous one.
+   */
+  void setPredictSteadyStates(bool pss);
+
   size_t getNumberOfScanItems() const;
 
   const CCopasiParameterGroup* getScanItem(size_t index) const;
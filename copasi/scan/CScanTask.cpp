@@ -219,6 +219,25 @@ bool CScanTask::processCallback()
   return true;
 }
 
+bool CScanTask::outputCallback(const bool & success)
+{
+  //do output
+  if (success && !mOutputInSubtask)
+    output(COutputInterface::DURING);
+
+  //do progress bar
+  ++mProgress;
+
+  if (mpCallBack) return mpCallBack->progressItem(mhProgress);
+
+  return true;
+}
+
+CCopasiTask * CScanTask::getSubtask() const
+{
+  return mpSubtask;
+}
+
 bool CScanTask::outputSeparatorCallback(bool isLast)
 {
   if ((!isLast) || mOutputInSubtask)
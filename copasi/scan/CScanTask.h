@@ -144,6 +144,20 @@ public:
    */
   bool processCallback();
 
+  /**
+   * Do the output for a grid point for which the subtask was calculated by a scan worker.
+   * The values of the container must have been set to the result of the subtask.
+   * @param const bool & success (the return value of the subtask)
+   * @return bool continue
+   */
+  bool outputCallback(const bool & success);
+
+  /**
+   * Retrieve the subtask
+   * @return CCopasiTask * pSubtask
+   */
+  CCopasiTask * getSubtask() const;
+
   /**
    * output separators
    * if isLast==true this method has to decide if a separator should
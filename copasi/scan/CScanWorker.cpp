@@ -0,0 +1,217 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#include "copasi/copasi.h"
+
+#include "copasi/scan/CScanWorker.h"
+
+#include "copasi/math/CMathContainer.h"
+#include "copasi/steadystate/CSteadyStateTask.h"
+#include "copasi/trajectory/CTrajectoryTask.h"
+#include "copasi/trajectory/CTrajectoryProblem.h"
+#include "copasi/utilities/CCopasiException.h"
+
+// static
+bool CScanWorker::isSupportedSubtask(const CCopasiTask * pSubtask)
+{
+  if (pSubtask == NULL ||
+      pSubtask->getMethod() == NULL)
+    {
+      return false;
+    }
+
+  // Only deterministic subtasks which are known to be reentrant are supported.
+  switch (pSubtask->getType())
+    {
+      case CTaskEnum::Task::timeCourse:
+      {
+        const CTrajectoryProblem * pProblem = static_cast< const CTrajectoryProblem * >(pSubtask->getProblem());
+
+        return pSubtask->getMethod()->getSubType() == CTaskEnum::Method::deterministic &&
+               !pProblem->getStartInSteadyState() &&
+               pProblem->getEnsembleSize() < 2;
+      }
+      break;
+
+      case CTaskEnum::Task::steadyState:
+        return pSubtask->getMethod()->getSubType() == CTaskEnum::Method::Newton;
+        break;
+
+      default:
+        break;
+    }
+
+  return false;
+}
+
+CScanWorker::CScanWorker():
+  mpSourceValues(NULL),
+  mpContainer(NULL),
+  mpSubtask(NULL),
+  mItemValues(),
+  mInitialUpdates()
+{}
+
+CScanWorker::~CScanWorker()
+{
+  cleanup();
+}
+
+void CScanWorker::cleanup()
+{
+  if (mpSubtask != NULL)
+    {
+      // The subtask is not a child of its parent, see initialize.
+      mpSubtask->setObjectParent(NULL);
+      pdelete(mpSubtask);
+    }
+
+  mInitialUpdates.clear();
+
+  pdelete(mpContainer);
+
+  mpSourceValues = NULL;
+  mItemValues.resize(0);
+}
+
+bool CScanWorker::initialize(const CMathContainer & container,
+                             const CCopasiTask & subtask,
+                             const std::vector< C_FLOAT64 * > & itemValues)
+{
+  cleanup();
+
+  if (!isSupportedSubtask(&subtask))
+    {
+      return false;
+    }
+
+  mpSourceValues = container.getValues().array();
+  mpContainer = new CMathContainer(container);
+
+  if (mpContainer->getValues().size() != container.getValues().size())
+    {
+      cleanup();
+      return false;
+    }
+
+  // Map the scanned values. Scan items without an object (repeat) are skipped.
+  mItemValues.resize(itemValues.size());
+  C_FLOAT64 ** ppValue = mItemValues.array();
+  std::vector< C_FLOAT64 * >::const_iterator it = itemValues.begin();
+  std::vector< C_FLOAT64 * >::const_iterator end = itemValues.end();
+
+  CObjectInterface::ObjectSet ChangedObjects;
+
+  for (; it != end; ++it, ++ppValue)
+    {
+      *ppValue = NULL;
+
+      if (*it == NULL) continue;
+
+      *ppValue = mapValue(*it);
+
+      if (*ppValue == NULL)
+        {
+          cleanup();
+          return false;
+        }
+
+      ChangedObjects.insert(mpContainer->getMathObject(*ppValue));
+    }
+
+  ChangedObjects.erase(NULL);
+  mpContainer->getInitialDependencies().getUpdateSequence(mInitialUpdates, CCore::SimulationContext::UpdateMoieties, ChangedObjects, mpContainer->getInitialStateObjects());
+
+  // Create the subtask copy. It needs an ancestor to find the data model, however the task
+  // list must not know about it.
+  if (subtask.getType() == CTaskEnum::Task::timeCourse)
+    mpSubtask = new CTrajectoryTask(static_cast< const CTrajectoryTask & >(subtask), NO_PARENT);
+  else
+    mpSubtask = new CSteadyStateTask(static_cast< const CSteadyStateTask & >(subtask), NO_PARENT);
+
+  mpSubtask->setObjectParent(subtask.getObjectParent());
+  mpSubtask->setMathContainer(mpContainer);
+
+  bool success = false;
+
+  try
+    {
+      success = mpSubtask->initialize(CCopasiTask::NO_OUTPUT, NULL, NULL);
+    }
+
+  catch (...)
+    {
+      success = false;
+    }
+
+  if (!success)
+    {
+      cleanup();
+      return false;
+    }
+
+  return true;
+}
+
+bool CScanWorker::calculate(const CVectorCore< C_FLOAT64 > & initialState,
+                            const C_FLOAT64 * pItemValues,
+                            bool & exception)
+{
+  exception = false;
+
+  mpContainer->setCompleteInitialState(initialState);
+
+  C_FLOAT64 ** ppValue = mItemValues.array();
+  C_FLOAT64 ** ppValueEnd = ppValue + mItemValues.size();
+
+  for (; ppValue != ppValueEnd; ++ppValue, ++pItemValues)
+    if (*ppValue != NULL)
+      {
+        **ppValue = *pItemValues;
+      }
+
+  mpContainer->applyUpdateSequence(mInitialUpdates);
+
+  bool success = false;
+
+  try
+    {
+      success = mpSubtask->process(true);
+    }
+
+  catch (CCopasiException &)
+    {
+      // We do not want to clog the message cue.
+      CCopasiMessage::getLastMessage();
+
+      exception = true;
+      success = false;
+    }
+
+  catch (...)
+    {
+      exception = true;
+      success = false;
+    }
+
+  return success;
+}
+
+const CVectorCore< C_FLOAT64 > & CScanWorker::getValues() const
+{
+  return mpContainer->getValues();
+}
+
+C_FLOAT64 * CScanWorker::mapValue(const C_FLOAT64 * pSourceValue) const
+{
+  if (pSourceValue == NULL ||
+      pSourceValue < mpSourceValues ||
+      mpSourceValues + mpContainer->getValues().size() <= pSourceValue)
+    {
+      return NULL;
+    }
+
+  return mpContainer->getValues().array() + (pSourceValue - mpSourceValues);
+}
@@ -0,0 +1,127 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#ifndef COPASI_CScanWorker
+#define COPASI_CScanWorker
+
+#include <vector>
+
+#include "copasi/core/CVector.h"
+#include "copasi/math/CMathUpdateSequence.h"
+
+class CCopasiTask;
+class CMathContainer;
+
+/**
+ * A scan worker calculates the subtask of a scan for single grid points. It owns an
+ * independently compiled copy of the math container and a copy of the subtask operating
+ * on this container. Different workers do not share any mutable state and can therefore
+ * calculate different grid points concurrently.
+ *
+ * Each grid point starts from the initial state of the scan, i.e., the result only depends
+ * on the values of the scan items. Workers can therefore only be created for scans which do
+ * not continue from the current state. Furthermore, the subtask must be deterministic and
+ * reentrant, i.e., time courses using LSODA which do not start in a steady state or steady
+ * states determined with the Newton method.
+ */
+class CScanWorker
+{
+private:
+  /**
+   * Hidden copy constructor
+   */
+  CScanWorker(const CScanWorker & src);
+
+  /**
+   * Hidden assignment operator
+   */
+  CScanWorker & operator = (const CScanWorker & rhs);
+
+public:
+  /**
+   * Check whether grid points of scans with the given subtask can be calculated by workers
+   * @param const CCopasiTask * pSubtask
+   * @return bool isSupported
+   */
+  static bool isSupportedSubtask(const CCopasiTask * pSubtask);
+
+  /**
+   * Default constructor
+   */
+  CScanWorker();
+
+  /**
+   * Destructor
+   */
+  ~CScanWorker();
+
+  /**
+   * Initialize the worker
+   * @param const CMathContainer & container
+   * @param const CCopasiTask & subtask
+   * @param const std::vector< C_FLOAT64 * > & itemValues (the scanned values of container, may contain NULL)
+   * @return bool success (false if the subtask can not be calculated by the worker)
+   */
+  bool initialize(const CMathContainer & container,
+                  const CCopasiTask & subtask,
+                  const std::vector< C_FLOAT64 * > & itemValues);
+
+  /**
+   * Release the container copy and the subtask
+   */
+  void cleanup();
+
+  /**
+   * Calculate the subtask for a grid point.
+   * @param const CVectorCore< C_FLOAT64 > & initialState (complete initial state of the scan)
+   * @param const C_FLOAT64 * pItemValues (values of the scan items at the grid point)
+   * @param bool & exception (indicates whether the subtask threw an exception)
+   * @return bool success
+   */
+  bool calculate(const CVectorCore< C_FLOAT64 > & initialState,
+                 const C_FLOAT64 * pItemValues,
+                 bool & exception);
+
+  /**
+   * Retrieve all values of the container copy
+   * @return const CVectorCore< C_FLOAT64 > & values
+   */
+  const CVectorCore< C_FLOAT64 > & getValues() const;
+
+private:
+  /**
+   * Map a value of the source container to the value of the copy
+   * @param const C_FLOAT64 * pSourceValue
+   * @return C_FLOAT64 * pValue (NULL if the value does not belong to the source container)
+   */
+  C_FLOAT64 * mapValue(const C_FLOAT64 * pSourceValue) const;
+
+  /**
+   * The values of the source container
+   */
+  const C_FLOAT64 * mpSourceValues;
+
+  /**
+   * The independent copy of the container
+   */
+  CMathContainer * mpContainer;
+
+  /**
+   * The copy of the subtask operating on mpContainer
+   */
+  CCopasiTask * mpSubtask;
+
+  /**
+   * Pointers to the values of the scan items in mpContainer
+   */
+  CVector< C_FLOAT64 * > mItemValues;
+
+  /**
+   * The update sequence for initial values depending on the scan items
+   */
+  CCore::CUpdateSequence mInitialUpdates;
+};
+
+#endif // COPASI_CScanWorker
@@ -43,6 +43,17 @@
 #include "copasi/utilities/utility.h"
 #include "copasi/utilities/CProcessReport.h"
 #include "copasi/utilities/CLeastSquareSolution.h"
+#include "copasi/lapack/lapackwrap.h"
+
+// The sparse LU factorization is used for Jacobians of at least this dimension
+// with at most this fraction of structural non-zeros.
+#define SPARSE_LU_MIN_DIMENSION 100
+#define SPARSE_LU_MAX_DENSITY 0.1
+
+// A reused factorization is refreshed after this many steps or if a step reduces
+// the target value by less than this factor.
+#define REUSE_MAX_AGE 10
+#define REUSE_STALL_RATIO 0.5
 
 // static
 const CEnumAnnotation< std::string, CNewtonMethod::eTargetCriterion > CNewtonMethod::TargetCriterion(
@@ -51,6 +62,13 @@ const CEnumAnnotation< std::string, CNewtonMethod::eTargetCriterion > CNewtonMet
   "Distance",
   "Rate"});
 
+// static
+const CEnumAnnotation< std::string, CNewtonMethod::eJacobianUpdate > CNewtonMethod::JacobianUpdate(
+{
+  "Newton",
+  "Chord",
+  "Broyden"});
+
 CNewtonMethod::CNewtonMethod(const CDataContainer * pParent,
                              const CTaskEnum::Method & methodType,
                              const CTaskEnum::Task & taskType)
@@ -76,6 +94,15 @@ CNewtonMethod::CNewtonMethod(const CDataContainer * pParent,
   , mTargetCriterion(eTargetCriterion::DistanceAndRate)
   , mTargetRate(std::numeric_limits< C_FLOAT64 >::infinity())
   , mTargetDistance(std::numeric_limits< C_FLOAT64 >::infinity())
+  , mUseSparseLU(false)
+  , mSparseLU()
+  , mJacobianUpdate(eJacobianUpdate::Newton)
+  , mHaveFactorization(false)
+  , mFactorizationAge(0)
+  , mDenseLU()
+  , mBroydenA()
+  , mBroydenS()
+  , mRatesOld()
 
 {
   initializeParameter();
@@ -105,6 +132,15 @@ CNewtonMethod::CNewtonMethod(const CNewtonMethod & src,
   , mTargetCriterion(src.mTargetCriterion)
   , mTargetRate(src.mTargetRate)
   , mTargetDistance(src.mTargetDistance)
+  , mUseSparseLU(false)
+  , mSparseLU(src.mSparseLU)
+  , mJacobianUpdate(src.mJacobianUpdate)
+  , mHaveFactorization(false)
+  , mFactorizationAge(0)
+  , mDenseLU()
+  , mBroydenA()
+  , mBroydenS()
+  , mRatesOld()
 
 {
   initializeParameter();
@@ -135,6 +171,12 @@ void CNewtonMethod::initializeParameter()
   if (pParm != NULL)
     pParm->setValidValues(TargetCriterion);
 
+  assertParameter("Jacobian Update", CCopasiParameter::Type::STRING, JacobianUpdate[0]);
+  pParm = getParameter("Jacobian Update");
+
+  if (pParm != NULL)
+    pParm->setValidValues(JacobianUpdate);
+
   // Check whether we have a method with the old parameter names
   if ((pParm = getParameter("Newton.UseNewton")) != NULL)
     {
@@ -444,9 +486,32 @@ CNewtonMethod::NewtonResultCode CNewtonMethod::doNewtonStep(C_FLOAT64 & currentV
 
   // DebugFile << "Iteration: " << k << std::endl;
 
-  calculateJacobian(currentValue, true);
+  bool Solved = false;
+
+  if (mJacobianUpdate != eJacobianUpdate::Newton)
+    {
+      if (!mHaveFactorization)
+        factorizeJacobian(currentValue);
+
+      Solved = mHaveFactorization && solveJacobian(mdxdt, mH);
+
+      if (mJacobianUpdate == eJacobianUpdate::Broyden)
+        memcpy(mRatesOld.array(), mdxdt.array(), mDimension * sizeof(C_FLOAT64));
+    }
+
+  if (!Solved)
+    {
+      mHaveFactorization = false;
+      calculateJacobian(currentValue, true);
+    }
 
-  if (CLeastSquareSolution::solve(*mpJacobian, mdxdt, mH) != mpJacobian->numCols())
+  // The sparse LU factorization is only applicable to regular Jacobians. Otherwise
+  // we fall back to the dense least square solution.
+  if (!Solved &&
+      !(mUseSparseLU &&
+        mSparseLU.factorize(*mpJacobian) &&
+        mSparseLU.solve(mdxdt, mH)) &&
+      CLeastSquareSolution::solve(*mpJacobian, mdxdt, mH) != mpJacobian->numCols())
     {
       // We need to check that mH != 0
       C_FLOAT64 * pH = mH.array();
@@ -501,6 +566,17 @@ CNewtonMethod::NewtonResultCode CNewtonMethod::doNewtonStep(C_FLOAT64 & currentV
       calculateDerivativesX();
       currentValue = targetFunction();
 
+      // A reused factorization may be outdated. We retry with a fresh one.
+      if (mHaveFactorization && mFactorizationAge > 0)
+        {
+          mHaveFactorization = false;
+
+          if (mKeepProtocol)
+            mMethodLog << "    Newton step failed with reused Jacobian. Jacobian updated.\n";
+
+          return doNewtonStep(currentValue);
+        }
+
       if (mKeepProtocol)
         mMethodLog << "    Newton step failed. Damping limit exceeded.\n";
 
@@ -524,6 +600,9 @@ CNewtonMethod::NewtonResultCode CNewtonMethod::doNewtonStep(C_FLOAT64 & currentV
       return CNewtonMethod::negativeValueFound;
     }
 
+  if (mHaveFactorization)
+    updateFactorization(currentValue, newValue, i);
+
   currentValue = newValue; //return the new target value
 
   if (mKeepProtocol)
@@ -538,6 +617,157 @@ CNewtonMethod::NewtonResultCode CNewtonMethod::doNewtonStep(C_FLOAT64 & currentV
   return CNewtonMethod::stepSuccesful;
 }
 
+bool CNewtonMethod::factorizeJacobian(const C_FLOAT64 & currentValue)
+{
+  calculateJacobian(currentValue, true);
+
+  mHaveFactorization = false;
+  mFactorizationAge = 0;
+  mBroydenA.clear();
+  mBroydenS.clear();
+
+  if (mUseSparseLU)
+    {
+      mHaveFactorization = mSparseLU.factorize(*mpJacobian);
+    }
+  else if (mDimension > 0)
+    {
+      // The row major Jacobian is the column major transpose, i.e., we factorize J^T.
+      mDenseLU = *mpJacobian;
+
+      C_INT N = (C_INT) mDimension;
+      C_INT Info = 0;
+
+      dgetrf_(&N, &N, mDenseLU.array(), &N, mIpiv, &Info);
+
+      mHaveFactorization = (Info == 0);
+    }
+
+  if (mKeepProtocol && mHaveFactorization)
+    mMethodLog << "    Jacobian calculated and factorized for reuse.\n";
+
+  return mHaveFactorization;
+}
+
+bool CNewtonMethod::solveJacobian(const CVectorCore< const C_FLOAT64 > & b, CVector< C_FLOAT64 > & x)
+{
+  if (mUseSparseLU)
+    {
+      if (!mSparseLU.solve(b, x))
+        return false;
+    }
+  else
+    {
+      x = * reinterpret_cast< const CVectorCore< C_FLOAT64 > * >(&b);
+
+      char T = 'T';
+      C_INT N = (C_INT) mDimension;
+      C_INT NRHS = 1;
+      C_INT Info = 0;
+
+      dgetrs_(&T, &N, &NRHS, mDenseLU.array(), &N, mIpiv, x.array(), &N, &Info);
+
+      if (Info != 0)
+        return false;
+    }
+
+  // Apply the rank-one updates in the order they were created.
+  std::vector< CVector< C_FLOAT64 > >::const_iterator itA = mBroydenA.begin();
+  std::vector< CVector< C_FLOAT64 > >::const_iterator endA = mBroydenA.end();
+  std::vector< CVector< C_FLOAT64 > >::const_iterator itS = mBroydenS.begin();
+
+  for (; itA != endA; ++itA, ++itS)
+    {
+      C_FLOAT64 Product = 0.0;
+      const C_FLOAT64 * pS = itS->array();
+      const C_FLOAT64 * pSEnd = pS + mDimension;
+      C_FLOAT64 * pX = x.array();
+
+      for (; pS != pSEnd; ++pS, ++pX)
+        Product += *pS * *pX;
+
+      const C_FLOAT64 * pA = itA->array();
+      pX = x.array();
+      C_FLOAT64 * pXEnd = pX + mDimension;
+
+      for (; pX != pXEnd; ++pX, ++pA)
+        *pX += *pA * Product;
+    }
+
+  C_FLOAT64 * pX = x.array();
+  C_FLOAT64 * pXEnd = pX + mDimension;
+
+  for (; pX != pXEnd; ++pX)
+    if (std::isnan(*pX))
+      return false;
+
+  return true;
+}
+
+void CNewtonMethod::updateFactorization(const C_FLOAT64 & oldValue,
+                                        const C_FLOAT64 & newValue,
+                                        const size_t & dampingSteps)
+{
+  ++mFactorizationAge;
+
+  // The factorization is refreshed if the step needed damping or did not reduce
+  // the target value sufficiently.
+  if (dampingSteps > 1 ||
+      newValue > REUSE_STALL_RATIO * oldValue ||
+      mFactorizationAge >= REUSE_MAX_AGE)
+    {
+      mHaveFactorization = false;
+      return;
+    }
+
+  if (mJacobianUpdate != eJacobianUpdate::Broyden)
+    return;
+
+  // Good Broyden update of the inverse H in product form:
+  //   H+ = (I + a s^T) H with a = (s - H y) / (s^T H y)
+  // where s is the step and y the change of the rates.
+  CVector< C_FLOAT64 > S(mDimension);
+  CVector< C_FLOAT64 > Y(mDimension);
+  size_t i;
+
+  for (i = 0; i < mDimension; ++i)
+    {
+      S[i] = mpX[i] - mXold[i];
+      Y[i] = mdxdt[i] - mRatesOld[i];
+    }
+
+  CVector< C_FLOAT64 > HY;
+
+  if (!solveJacobian(CVectorCore< const C_FLOAT64 >(mDimension, Y.array()), HY))
+    {
+      mHaveFactorization = false;
+      return;
+    }
+
+  C_FLOAT64 Denominator = 0.0;
+  C_FLOAT64 Norm = 0.0;
+
+  for (i = 0; i < mDimension; ++i)
+    {
+      Denominator += S[i] * HY[i];
+      Norm += S[i] * S[i];
+    }
+
+  if (!(fabs(Denominator) > 100.0 * std::numeric_limits< C_FLOAT64 >::epsilon() * Norm))
+    {
+      mHaveFactorization = false;
+      return;
+    }
+
+  CVector< C_FLOAT64 > A(mDimension);
+
+  for (i = 0; i < mDimension; ++i)
+    A[i] = (S[i] - HY[i]) / Denominator;
+
+  mBroydenA.push_back(A);
+  mBroydenS.push_back(S);
+}
+
 //************************************************************
 
 CNewtonMethod::NewtonResultCode CNewtonMethod::processNewton()
@@ -670,7 +900,10 @@ bool CNewtonMethod::isSteadyState(const C_FLOAT64 & value) const
 
 C_FLOAT64 CNewtonMethod::targetFunction()
 {
-  if (mTargetCriterion != eTargetCriterion::Rate)
+  // Chord and Broyden evaluate the distance with the kept factorization while it is valid,
+  // i.e., the Jacobian is only calculated when the factorization is refreshed.
+  if (mTargetCriterion != eTargetCriterion::Rate &&
+      !mHaveFactorization)
     {
       calculateJacobian(std::max(mTargetRate, mTargetDistance), true);
     }
@@ -744,12 +977,40 @@ C_FLOAT64 CNewtonMethod::targetFunctionDistance()
     return 0.0;
 
   CVector< C_FLOAT64 > Distance;
+  CLeastSquareSolution::ResultInfo Info;
+
+  // The factorization kept by Chord or Broyden approximates the Jacobian at the current state.
+  if (mHaveFactorization &&
+      !solveJacobian(mdxdt, Distance))
+    {
+      // The factorization is refreshed with the next step and we need the current Jacobian.
+      mHaveFactorization = false;
+      calculateJacobian(mTargetRate, true);
 
-  CLeastSquareSolution::ResultInfo Info = CLeastSquareSolution::solve(*mpJacobian, mdxdt, mAtol, mCompartmentVolumes, mpContainer->getQuantity2NumberFactor(), Distance);
+      mpContainer->updateSimulatedValues(true);
+      mpContainer->applyUpdateSequence(mUpdateConcentrations);
+    }
 
-  if (Info.rank == 0)
+  // The distance is the Newton step J^-1 dx/dt. For a regular Jacobian the sparse LU
+  // factorization solves the system exactly. The dense least square solution is only
+  // needed if the Jacobian is singular.
+  if (mHaveFactorization ||
+      (mUseSparseLU &&
+       mSparseLU.factorize(*mpJacobian) &&
+       mSparseLU.solve(mdxdt, Distance)))
+    {
+      Info.rank = mDimension;
+      Info.relativeError = 0.0;
+      Info.absoluteError = 0.0;
+    }
+  else
     {
-      return std::numeric_limits< C_FLOAT64 >::infinity();
+      Info = CLeastSquareSolution::solve(*mpJacobian, mdxdt, mAtol, mCompartmentVolumes, mpContainer->getQuantity2NumberFactor(), Distance);
+
+      if (Info.rank == 0)
+        {
+          return std::numeric_limits< C_FLOAT64 >::infinity();
+        }
     }
 
   // We look at all ODE determined entity and dependent species rates.
@@ -850,6 +1111,7 @@ bool CNewtonMethod::initialize(const CSteadyStateProblem * pProblem)
     mAcceptNegative = true;
 
   mTargetCriterion = TargetCriterion.toEnum(getValue< std::string >("Target Criterion"), eTargetCriterion::DistanceAndRate);
+  mJacobianUpdate = JacobianUpdate.toEnum(getValue< std::string >("Jacobian Update"), eJacobianUpdate::Newton);
   mTargetRate = std::numeric_limits< C_FLOAT64 >::infinity();
   mTargetDistance = std::numeric_limits< C_FLOAT64 >::infinity();
 
@@ -869,6 +1131,36 @@ bool CNewtonMethod::initialize(const CSteadyStateProblem * pProblem)
   mdxdt.initialize(mDimension, mpContainer->getRate(false).array() + mpContainer->getCountFixedEventTargets() + 1);
   mIpiv = new C_INT[mDimension];
 
+  // Large sparse Jacobians are factorized with a sparse LU factorization. The structure
+  // is analyzed once here and reused for all Newton steps.
+  mUseSparseLU = false;
+
+  if (mDimension >= SPARSE_LU_MIN_DIMENSION)
+    {
+      CMatrix< C_INT32 > Dependencies;
+      mpContainer->calculateJacobianDependencies(Dependencies, true);
+
+      size_t NonZeros = 0;
+      const C_INT32 * pDependency = Dependencies.array();
+      const C_INT32 * pDependencyEnd = pDependency + Dependencies.size();
+
+      for (; pDependency != pDependencyEnd; ++pDependency)
+        if (*pDependency != 0)
+          ++NonZeros;
+
+      if (NonZeros <= SPARSE_LU_MAX_DENSITY * mDimension * mDimension)
+        mUseSparseLU = mSparseLU.analyze(Dependencies);
+    }
+
+  // A reused factorization is kept between calls to process, e.g., for the points of a scan,
+  // until the method is initialized again.
+  mHaveFactorization = false;
+  mFactorizationAge = 0;
+  mDenseLU.resize(0, 0);
+  mBroydenA.clear();
+  mBroydenS.clear();
+  mRatesOld.resize(mDimension);
+
   mCompartmentVolumes.resize(mDimension + mpContainer->getCountDependentSpecies());
   mCompartmentVolumes = NULL;
 
@@ -885,6 +1177,9 @@ bool CNewtonMethod::initialize(const CSteadyStateProblem * pProblem)
       else
         mpTrajectory = new CTrajectoryTask(this);
 
+      // The trajectory must operate on our container, which may be a copy of the model's container.
+      mpTrajectory->setMathContainer(mpContainer);
+
       pTrajectoryProblem =
         dynamic_cast< CTrajectoryProblem * >(mpTrajectory->getProblem());
       assert(pTrajectoryProblem);
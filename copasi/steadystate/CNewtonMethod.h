@@ -33,8 +33,11 @@
 #ifndef COPASI_CNewtonMethod
 #define COPASI_CNewtonMethod
 
+#include <vector>
+
 #include "copasi/core/CMatrix.h"
 #include "copasi/core/CVector.h"
+#include "copasi/utilities/CSparseLU.h"
 
 class CTrajectoryTask;
 
@@ -51,6 +54,22 @@ public:
 
   static const CEnumAnnotation< std::string, eTargetCriterion > TargetCriterion;
 
+  /**
+   * The strategies for updating the Jacobian used for the Newton steps:
+   *   Newton: the Jacobian is calculated and factorized for each step.
+   *   Chord: the factorization is kept until convergence stalls.
+   *   Broyden: as Chord, but the inverse is improved by rank-one updates after each step.
+   */
+  enum struct eJacobianUpdate
+  {
+    Newton,
+    Chord,
+    Broyden,
+    __SIZE
+  };
+
+  static const CEnumAnnotation< std::string, eJacobianUpdate > JacobianUpdate;
+
   // Attributes
 private:
   enum NewtonResultCode
@@ -92,6 +111,45 @@ private:
   C_FLOAT64 mTargetDistance;
   C_FLOAT64 mTargetRate;
 
+  /**
+   * Indicates whether the Newton step is calculated with the sparse LU factorization
+   */
+  bool mUseSparseLU;
+
+  /**
+   * The sparse LU factorization of the reduced Jacobian
+   */
+  CSparseLU mSparseLU;
+
+  eJacobianUpdate mJacobianUpdate;
+
+  /**
+   * Indicates whether a reusable factorization of the Jacobian is available
+   */
+  bool mHaveFactorization;
+
+  /**
+   * The number of successful steps taken with the current factorization
+   */
+  unsigned C_INT32 mFactorizationAge;
+
+  /**
+   * The dense LU factorization of the Jacobian (used if mUseSparseLU is false)
+   */
+  CMatrix< C_FLOAT64 > mDenseLU;
+
+  /**
+   * The rank-one updates of the inverse Jacobian in product form, i.e.,
+   * H = (I + a_k s_k^T) ... (I + a_1 s_1^T) J^-1
+   */
+  std::vector< CVector< C_FLOAT64 > > mBroydenA;
+  std::vector< CVector< C_FLOAT64 > > mBroydenS;
+
+  /**
+   * The rates before the last step
+   */
+  CVector< C_FLOAT64 > mRatesOld;
+
   // Operations
 private:
   /**
@@ -198,6 +256,33 @@ private:
 
   CNewtonMethod::NewtonResultCode doIntegration(bool forward);
 
+  /**
+   * Calculate the Jacobian at the current state and factorize it for reuse
+   * in subsequent steps. The rank-one updates are discarded.
+   * @param const C_FLOAT64 & currentValue
+   * @return bool success (false if the Jacobian is singular)
+   */
+  bool factorizeJacobian(const C_FLOAT64 & currentValue);
+
+  /**
+   * Solve J * x = b with the reused factorization including the rank-one updates
+   * @param const CVectorCore< const C_FLOAT64 > & b
+   * @param CVector< C_FLOAT64 > & x
+   * @return bool success
+   */
+  bool solveJacobian(const CVectorCore< const C_FLOAT64 > & b, CVector< C_FLOAT64 > & x);
+
+  /**
+   * Decide after a successful step whether the factorization is kept and apply the
+   * Broyden update if requested.
+   * @param const C_FLOAT64 & oldValue
+   * @param const C_FLOAT64 & newValue
+   * @param const size_t & dampingSteps
+   */
+  void updateFactorization(const C_FLOAT64 & oldValue,
+                           const C_FLOAT64 & newValue,
+                           const size_t & dampingSteps);
+
   std::string targetValueToString() const;
 
   /**
@@ -49,6 +49,7 @@ CSteadyStateProblem::CSteadyStateProblem(const CDataContainer * pParent):
 {
   assertParameter("JacobianRequested", CCopasiParameter::Type::BOOL, true);
   assertParameter("StabilityAnalysisRequested", CCopasiParameter::Type::BOOL, true);
+  assertParameter("Use Compiled Model", CCopasiParameter::Type::BOOL, false);
   CONSTRUCTOR_TRACE;
 }
 
@@ -104,6 +105,20 @@ void CSteadyStateProblem::setStabilityAnalysisRequested(bool & stabilityAnalysis
 bool CSteadyStateProblem::isStabilityAnalysisRequested() const
 {return getValue< bool >("StabilityAnalysisRequested");}
 
+/**
+ * Set whether the model is compiled to native code.
+ * @param const bool & useCompiledModel
+ */
+void CSteadyStateProblem::setUseCompiledModel(const bool & useCompiledModel)
+{setValue("Use Compiled Model", useCompiledModel);}
+
+/**
+ * Retrieve whether the model is compiled to native code.
+ * @return bool useCompiledModel
+ */
+bool CSteadyStateProblem::getUseCompiledModel() const
+{return getValue< bool >("Use Compiled Model");}
+
 /**
  * Load a steadystate problem
  * @param "CReadConfig &" configBuffer
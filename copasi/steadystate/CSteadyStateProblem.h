@@ -105,6 +105,18 @@ public:
    */
   bool isStabilityAnalysisRequested() const;
 
+  /**
+   * Set whether the model is compiled to native code (see CMathNativeCode).
+   * @param const bool & useCompiledModel
+   */
+  void setUseCompiledModel(const bool & useCompiledModel);
+
+  /**
+   * Retrieve whether the model is compiled to native code.
+   * @return bool useCompiledModel
+   */
+  bool getUseCompiledModel() const;
+
   /**
    * Load a trajectory problem
    * @param "CReadConfig &" configBuffer
@@ -238,6 +238,8 @@ bool CSteadyStateTask::initialize(const OutputFlag & of,
 
   mSteadyState = mpContainer->getState(true);
 
+  mpContainer->setUseNativeCode(pProblem->getUseCompiledModel());
+
   success &= CCopasiTask::initialize(of, pOutputHandler, pOstream);
 
   return success;
@@ -387,6 +389,7 @@ bool CSteadyStateTask::restore()
 
       mpContainer->updateInitialValues(CCore::Framework::ParticleNumbers);
       mpContainer->pushInitialState();
+      mpContainer->setUseNativeCode(false);
     }
 
   return true;
@@ -50,6 +50,8 @@ CTimeSensLsodaMethod::CTimeSensLsodaMethod(const CDataContainer * pParent,
   mDWork(),
   mIWork(),
   mJType(),
+  mDerivatives(),
+  mAnalyticDerivatives(false),
   mRootMask(),
   mDiscreteRoots(),
   mRootMasking(CTimeSensLsodaMethod::NONE),
@@ -87,6 +89,8 @@ CTimeSensLsodaMethod::CTimeSensLsodaMethod(const CTimeSensLsodaMethod & src,
   mDWork(src.mDWork),
   mIWork(src.mIWork),
   mJType(src.mJType),
+  mDerivatives(),
+  mAnalyticDerivatives(false),
   mRootMask(src.mRootMask),
   mDiscreteRoots(),
   mRootMasking(src.mRootMasking),
@@ -506,6 +510,7 @@ void CTimeSensLsodaMethod::start()
 
   mTask = mpProblem == NULL ? 1 : mpProblem->getAutomaticStepSize() ? 5 : 1;
   mJType = 2;
+  mAnalyticDerivatives = false;
   mErrorMsg.str("");
 
   mTime = *mpContainerStateTime;
@@ -578,6 +583,33 @@ void CTimeSensLsodaMethod::start()
   mIWork[7] = 12;
   mIWork[8] = 5;
 
+  // The method with analytic derivatives evaluates the Jacobian and the derivatives with respect to the
+  // parameters symbolically. If any derivative can not be created we fall back to finite differences.
+  if (getSubType() == CTaskEnum::Method::timeSensLsodaAnalytic &&
+      mDerivatives.compile(*mpContainer, *mpReducedModel, false, mParameterTransientValuePointers, mSeq1) &&
+      mDerivatives.size() == mSystemSize)
+    {
+      mAnalyticDerivatives = true;
+
+      // The iteration matrix of the corrector is the block diagonal approximation of the Jacobian of the
+      // extended system, i.e., the second derivatives coupling the sensitivities to the state are neglected.
+      // This only affects the convergence of the corrector not the accuracy of the solution.
+      C_INT ml = (C_INT) mDerivatives.getLowerBandwidth();
+      C_INT mu = (C_INT) mDerivatives.getUpperBandwidth();
+
+      // A banded Jacobian is only beneficial if the band is narrow.
+      if (2 * ml + mu + 1 < mData.dim)
+        {
+          mJType = 4;
+          mIWork[0] = ml;
+          mIWork[1] = mu;
+        }
+      else
+        {
+          mJType = 1;
+        }
+    }
+
   if (mNumRoots > 0)
     {
       mLSODAR.setOstream(mErrorMsg);
@@ -617,6 +649,12 @@ void CTimeSensLsodaMethod::evalF(const C_FLOAT64 * t, const C_FLOAT64 * y, C_FLO
   memcpy(ydot, mpYdot, (mSystemSize + 1) * sizeof(C_FLOAT64));
 
   //calculate the RHS of the extended system
+  if (mAnalyticDerivatives)
+    {
+      evalSensitivities(y, ydot);
+      return;
+    }
+
   mpContainer->calculateJacobian(mJacobian, 1e-6, *mpReducedModel);
   calculate_dRate_dPar(mdRate_dPar, *mpReducedModel);
   //std::cout << mdRate_dPar;
@@ -648,6 +686,35 @@ void CTimeSensLsodaMethod::evalF(const C_FLOAT64 * t, const C_FLOAT64 * y, C_FLO
   return;
 }
 
+void CTimeSensLsodaMethod::evalSensitivities(const C_FLOAT64 * y, C_FLOAT64 * ydot)
+{
+  // We assume that the simulated values are up to date
+  mDerivatives.calculate();
+  mDerivatives.getParameterDerivatives(mdRate_dPar);
+
+  const std::vector< CMathJacobian::sEntry > & Entries = mDerivatives.getEntries();
+  std::vector< CMathJacobian::sEntry >::const_iterator itEntry;
+  std::vector< CMathJacobian::sEntry >::const_iterator endEntry = Entries.end();
+  const C_FLOAT64 * pValue;
+
+  size_t i, j;
+
+  for (i = 1; i <= mNumParameters; ++i)
+    {
+      C_FLOAT64 * pSensRate = ydot + 1 + i * mSystemSize;
+      const C_FLOAT64 * pSens = y + 1 + i * mSystemSize;
+
+      for (j = 0; j < mSystemSize; ++j)
+        pSensRate[j] = mdRate_dPar(j, i - 1);
+
+      // Only the structural non-zeros of the Jacobian contribute. The entries are ordered by column
+      // and the ones of the parameter columns follow the state columns.
+      for (itEntry = Entries.begin(), pValue = mDerivatives.getValues().array();
+           itEntry != endEntry && itEntry->column < mSystemSize; ++itEntry, ++pValue)
+        pSensRate[itEntry->row] += *pValue * pSens[itEntry->column];
+    }
+}
+
 void CTimeSensLsodaMethod::EvalR(const C_INT * n, const C_FLOAT64 * t, const C_FLOAT64 * y,
                                  const C_INT * nr, C_FLOAT64 * r)
 {static_cast<Data *>((void *) n)->pMethod->evalR(t, y, nr, r);}
@@ -683,9 +750,32 @@ void CTimeSensLsodaMethod::EvalJ(const C_INT * n, const C_FLOAT64 * t, const C_F
 
 // virtual
 void CTimeSensLsodaMethod::evalJ(const C_FLOAT64 * t, const C_FLOAT64 * y,
-                                 const C_INT * ml, const C_INT * mu, C_FLOAT64 * pd, const C_INT * nRowPD)
+                                 const C_INT * /* ml */, const C_INT * mu, C_FLOAT64 * pd, const C_INT * nRowPD)
 {
-  // TODO Implement me.
+  // Only the method with analytic derivatives provides a Jacobian
+  if (!mAnalyticDerivatives) return;
+
+  *mpContainerStateTime = *t;
+  memcpy(mpContainerStateTime, y, (mSystemSize + 1) * sizeof(C_FLOAT64));
+  mpContainer->updateSimulatedValues(*mpReducedModel);
+  mDerivatives.calculate();
+
+  // The state and each sensitivity block share the Jacobian of the rates on the diagonal.
+  // The time (first variable) does not contribute. LSODA initializes pd to zero.
+  size_t Offset = 1;
+  size_t i;
+
+  for (i = 0; i <= mNumParameters; ++i, Offset += mSystemSize)
+    {
+      if (mJType == 4)
+        {
+          mDerivatives.getBanded(pd + Offset * *nRowPD, *mu, *nRowPD);
+        }
+      else
+        {
+          mDerivatives.getColumnMajor(pd + Offset + Offset * *nRowPD, *nRowPD);
+        }
+    }
 }
 
 void CTimeSensLsodaMethod::maskRoots(CVectorCore< C_FLOAT64 > & rootValues)
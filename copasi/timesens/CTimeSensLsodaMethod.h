@@ -27,6 +27,7 @@
 #include "copasi/odepack++/CLSODA.h"
 #include "copasi/odepack++/CLSODAR.h"
 #include "copasi/model/CState.h"
+#include "copasi/math/CMathJacobian.h"
 
 class CModel;
 
@@ -177,6 +178,17 @@ private:
    */
   C_INT mJType;
 
+  /**
+   * The symbolic derivatives of the rates with respect to the state variables and the
+   * parameters. They are only compiled for the method with analytic derivatives.
+   */
+  CMathJacobian mDerivatives;
+
+  /**
+   * Indicates whether the symbolic derivatives are used
+   */
+  bool mAnalyticDerivatives;
+
 private:
   /**
    * A mask which hides all roots being constant and zero.
@@ -282,6 +294,14 @@ public:
 
   virtual void evalF(const C_FLOAT64 * t, const C_FLOAT64 * y, C_FLOAT64 * ydot);
 
+  /**
+   * This evaluates the RHS of the sensitivities using the symbolic derivatives.
+   * It is assumed that the simulated values are up to date.
+   * @param const C_FLOAT64 * y
+   * @param C_FLOAT64 * ydot
+   */
+  void evalSensitivities(const C_FLOAT64 * y, C_FLOAT64 * ydot);
+
   /**
    *  This evaluates the roots
    */
@@ -55,6 +55,7 @@ bool CTimeSensTask::bl(const C_FLOAT64 & d1, const C_FLOAT64 & d2)
 const CTaskEnum::Method CTimeSensTask::ValidMethods[] =
 {
   CTaskEnum::Method::timeSensLsoda,
+  CTaskEnum::Method::timeSensLsodaAnalytic,
   CTaskEnum::Method::UnsetMethod
 };
 
@@ -401,17 +401,38 @@ void CHybridMethod::updatePriorityQueue(size_t rIndex, C_FLOAT64 time)
         }
     }
 
-  std::vector< CHybridStochFlag >::const_iterator it = mReactionFlags.begin();
-  std::vector< CHybridStochFlag >::const_iterator end = mReactionFlags.end();
+  // Without deterministic reactions only the propensities depending on the fired reaction have changed.
+  if (rIndex != C_INVALID_INDEX &&
+      mFirstReactionFlag == NULL)
+    {
+      const size_t * pDependent = mDG.beginDependents(rIndex);
+      const size_t * pDependentEnd = mDG.endDependents(rIndex);
 
-  for (; it != end; ++it)
+      for (; pDependent != pDependentEnd; ++pDependent)
+        {
+          if (mReactionFlags[*pDependent].mpPrev == NULL) // reaction is stochastic!
+            {
+              mAmuOld[*pDependent] = mAmu[*pDependent];
+              mAmu[*pDependent] = * (C_FLOAT64 *) mReactions[*pDependent].getPropensityObject()->getValuePointer();
+
+              if (*pDependent != rIndex) updateTauMu(*pDependent, time);
+            }
+        }
+    }
+  else
     {
-      if (it->mpPrev == NULL) // reaction is stochastic!
+      std::vector< CHybridStochFlag >::const_iterator it = mReactionFlags.begin();
+      std::vector< CHybridStochFlag >::const_iterator end = mReactionFlags.end();
+
+      for (; it != end; ++it)
         {
-          mAmuOld[it->mIndex] = mAmu[it->mIndex];
-          mAmu[it->mIndex] = * (C_FLOAT64 *) mReactions[it->mIndex].getPropensityObject()->getValuePointer();
+          if (it->mpPrev == NULL) // reaction is stochastic!
+            {
+              mAmuOld[it->mIndex] = mAmu[it->mIndex];
+              mAmu[it->mIndex] = * (C_FLOAT64 *) mReactions[it->mIndex].getPropensityObject()->getValuePointer();
 
-          if (it->mIndex != rIndex) updateTauMu(it->mIndex, time);
+              if (it->mIndex != rIndex) updateTauMu(it->mIndex, time);
+            }
         }
     }
 
@@ -552,6 +573,8 @@ void CHybridMethod::setupDependencyGraph()
         }
     }
 
+  mDG.freeze();
+
   return;
 }
 
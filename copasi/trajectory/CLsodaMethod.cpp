@@ -47,6 +47,7 @@ CLsodaMethod::CLsodaMethod(const CDataContainer * pParent,
   mpAbsoluteTolerance(NULL),
   mpMaxInternalSteps(NULL),
   mpMaxInternalStepSize(NULL),
+  mpUseAnalyticJacobian(NULL),
   mData(),
   mpY(NULL),
   mpYdot(NULL),
@@ -64,6 +65,7 @@ CLsodaMethod::CLsodaMethod(const CDataContainer * pParent,
   mDWork(),
   mIWork(),
   mJType(),
+  mJacobian(),
   mRootMask(),
   mDiscreteRoots(),
   mRootMasking(CLsodaMethod::NONE),
@@ -84,6 +86,7 @@ CLsodaMethod::CLsodaMethod(const CLsodaMethod & src,
   mpAbsoluteTolerance(NULL),
   mpMaxInternalSteps(NULL),
   mpMaxInternalStepSize(NULL),
+  mpUseAnalyticJacobian(NULL),
   mData(src.mData),
   mpY(NULL),
   mpYdot(NULL),
@@ -101,6 +104,7 @@ CLsodaMethod::CLsodaMethod(const CLsodaMethod & src,
   mDWork(src.mDWork),
   mIWork(src.mIWork),
   mJType(src.mJType),
+  mJacobian(),
   mRootMask(src.mRootMask),
   mDiscreteRoots(),
   mRootMasking(src.mRootMasking),
@@ -132,6 +136,12 @@ void CLsodaMethod::initializeParameter()
   mpMaxInternalSteps = assertParameter("Max Internal Steps", CCopasiParameter::Type::UINT, (unsigned C_INT32) 100000);
   mpMaxInternalStepSize = assertParameter("Max Internal Step Size", CCopasiParameter::Type::UDOUBLE, (C_FLOAT64) 0.0);
 
+  // Derived methods integrate a different right hand side and must not use the analytic Jacobian.
+  if (getSubType() == CTaskEnum::Method::deterministic)
+    {
+      mpUseAnalyticJacobian = assertParameter("Use Analytic Jacobian", CCopasiParameter::Type::BOOL, (bool) false);
+    }
+
   // Check whether we have a method with the old parameter names
   if ((pParm = getParameter("LSODA.RelativeTolerance")) != NULL)
     {
@@ -647,6 +657,28 @@ void CLsodaMethod::start()
   mIWork[7] = 12;
   mIWork[8] = 5;
 
+  // Use the analytic Jacobian if requested and all derivatives are available.
+  if (mpUseAnalyticJacobian != NULL &&
+      *mpUseAnalyticJacobian &&
+      mJacobian.compile(*mpContainer, *mpReducedModel, true) &&
+      mJacobian.size() == (size_t) mData.dim)
+    {
+      C_INT ml = (C_INT) mJacobian.getLowerBandwidth();
+      C_INT mu = (C_INT) mJacobian.getUpperBandwidth();
+
+      // A banded Jacobian is only beneficial if the band is narrow.
+      if (2 * ml + mu + 1 < mData.dim)
+        {
+          mJType = 4;
+          mIWork[0] = ml;
+          mIWork[1] = mu;
+        }
+      else
+        {
+          mJType = 1;
+        }
+    }
+
   if (mNumRoots > 0)
     {
       mLSODAR.setOstream(mErrorMsg);
@@ -718,10 +750,31 @@ void CLsodaMethod::EvalJ(const C_INT * n, const C_FLOAT64 * t, const C_FLOAT64 *
 {static_cast<Data *>((void *) n)->pMethod->evalJ(t, y, ml, mu, pd, nRowPD);}
 
 // virtual
-void CLsodaMethod::evalJ(const C_FLOAT64 * t, const C_FLOAT64 * y,
-                         const C_INT * ml, const C_INT * mu, C_FLOAT64 * pd, const C_INT * nRowPD)
+void CLsodaMethod::evalJ(const C_FLOAT64 * t, const C_FLOAT64 * /* y */,
+                         const C_INT * /* ml */, const C_INT * mu, C_FLOAT64 * pd, const C_INT * nRowPD)
 {
-  // TODO Implement me.
+  *mpContainerStateTime = *t;
+
+  mpContainer->updateSimulatedValues(*mpReducedModel);
+  mJacobian.calculate();
+
+  // LSODA initializes pd to zero, i.e., we only need to set the structural non-zeros.
+  if (mJType == 4)
+    {
+      mJacobian.getBanded(pd, *mu, *nRowPD);
+    }
+  else
+    {
+      mJacobian.getColumnMajor(pd, *nRowPD);
+    }
+
+#ifdef DEBUG_NUMERICS
+  CMatrix< C_FLOAT64 > Jacobian;
+  mJacobian.getDense(Jacobian);
+  std::cout << "Jacobian:  " << Jacobian << std::endl;
+#endif // DEBUG_NUMERICS
+
+  return;
 }
 
 void CLsodaMethod::maskRoots(CVectorCore< C_FLOAT64 > & rootValues)
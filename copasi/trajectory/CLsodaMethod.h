@@ -27,6 +27,7 @@
 #include "copasi/odepack++/CLSODA.h"
 #include "copasi/odepack++/CLSODAR.h"
 #include "copasi/model/CState.h"
+#include "copasi/math/CMathJacobian.h"
 
 class CModel;
 
@@ -82,6 +83,11 @@ private:
    */
   C_FLOAT64 * mpMaxInternalStepSize;
 
+  /**
+   * A pointer to the value of "Use Analytic Jacobian", NULL if not applicable
+   */
+  bool * mpUseAnalyticJacobian;
+
 protected:
   /**
    * mData.dim is the dimension of the ODE system.
@@ -172,6 +178,11 @@ private:
    */
   C_INT mJType;
 
+  /**
+   * The analytic Jacobian of the ODE system
+   */
+  CMathJacobian mJacobian;
+
 private:
   /**
    * A mask which hides all roots being constant and zero.
@@ -329,27 +329,7 @@ C_FLOAT64 CStochDirectMethod::doSingleStep(C_FLOAT64 startTime, const C_FLOAT64
       mNextReactionTime = startTime - log(mpRandomGenerator->getRandomOO()) / mA0;
 
       // We are sure that we have at least 1 reaction
-      C_FLOAT64 rand = mpRandomGenerator->getRandomOO() * mA0;
-      const C_FLOAT64 * pAmu = mAmu.array();
-      size_t * idxProp = mPropensityIdx.array();
-      C_FLOAT64 sum = 0.0;
-      size_t temp_prop;
-
-      for (size_t i = 0; i != mNumReactions; ++idxProp, ++i)
-        {
-          sum += *(pAmu + * (idxProp));
-
-          if (sum > rand) break;
-
-          if (i != 0 && (*(pAmu + * (idxProp)) > *(pAmu + * (idxProp - 1))))
-            {
-              temp_prop = *(idxProp);
-              *(idxProp)  = *(idxProp - 1);
-              *(idxProp - 1) = temp_prop;
-            }
-        }
-
-      mNextReactionIndex = *(idxProp);
+      mNextReactionIndex = selectReaction(mpRandomGenerator->getRandomOO() * mA0);
     }
 
   *mpContainerStateTime = mNextReactionTime;
@@ -419,6 +399,42 @@ C_FLOAT64 CStochDirectMethod::doSingleStep(C_FLOAT64 startTime, const C_FLOAT64
   mReactions[mNextReactionIndex].fire();
   mpContainer->applyUpdateSequence(mUpdateSequences[mNextReactionIndex]);
 
+  updateTotalPropensity(mNextReactionIndex);
+
+  mNextReactionIndex = C_INVALID_INDEX;
+  mStatus = NORMAL;
+
+  return mNextReactionTime - startTime;
+}
+
+// virtual
+size_t CStochDirectMethod::selectReaction(const C_FLOAT64 & rand)
+{
+  const C_FLOAT64 * pAmu = mAmu.array();
+  size_t * idxProp = mPropensityIdx.array();
+  C_FLOAT64 sum = 0.0;
+  size_t temp_prop;
+
+  for (size_t i = 0; i != mNumReactions; ++idxProp, ++i)
+    {
+      sum += *(pAmu + * (idxProp));
+
+      if (sum > rand) break;
+
+      if (i != 0 && (*(pAmu + * (idxProp)) > *(pAmu + * (idxProp - 1))))
+        {
+          temp_prop = *(idxProp);
+          *(idxProp)  = *(idxProp - 1);
+          *(idxProp - 1) = temp_prop;
+        }
+    }
+
+  return *(idxProp);
+}
+
+// virtual
+void CStochDirectMethod::updateTotalPropensity(const size_t & /* reactionIndex */)
+{
   // calculate the total propensity
   mA0 = 0.0;
 
@@ -429,11 +445,6 @@ C_FLOAT64 CStochDirectMethod::doSingleStep(C_FLOAT64 startTime, const C_FLOAT64
     {
       mA0 += *pAmu;
     }
-
-  mNextReactionIndex = C_INVALID_INDEX;
-  mStatus = NORMAL;
-
-  return mNextReactionTime - startTime;
 }
 
 /**
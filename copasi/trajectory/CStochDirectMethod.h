@@ -55,6 +55,20 @@ protected:
    */
   C_FLOAT64 doSingleStep(C_FLOAT64 startTime, const C_FLOAT64 & endTime);
 
+  /**
+   * Select the reaction which fires next
+   * @param const C_FLOAT64 & rand (uniformly distributed in (0, mA0))
+   * @return size_t reactionIndex
+   */
+  virtual size_t selectReaction(const C_FLOAT64 & rand);
+
+  /**
+   * Update the total propensity mA0 after the reaction with the given index has fired
+   * and the dependent propensities have been recalculated.
+   * @param const size_t & reactionIndex
+   */
+  virtual void updateTotalPropensity(const size_t & reactionIndex);
+
 public:
   /**
    * Specific constructor
@@ -0,0 +1,161 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#include <vector>
+#include <string.h>
+
+#include "copasi/copasi.h"
+
+#include "copasi/trajectory/CStochLogDirectMethod.h"
+#include "copasi/math/CMathContainer.h"
+
+CStochLogDirectMethod::CStochLogDirectMethod(const CDataContainer * pParent,
+    const CTaskEnum::Method & methodType,
+    const CTaskEnum::Task & taskType):
+  CStochDirectMethod(pParent, methodType, taskType),
+  mTree(),
+  mFirstLeaf(1),
+  mDependencyStart(),
+  mDependencies()
+{}
+
+CStochLogDirectMethod::CStochLogDirectMethod(const CStochLogDirectMethod & src,
+    const CDataContainer * pParent):
+  CStochDirectMethod(src, pParent),
+  mTree(),
+  mFirstLeaf(1),
+  mDependencyStart(),
+  mDependencies()
+{}
+
+CStochLogDirectMethod::~CStochLogDirectMethod()
+{}
+
+// virtual
+void CStochLogDirectMethod::start()
+{
+  // The base class compiles the update sequences and calls stateChange which builds the tree.
+  CStochDirectMethod::start();
+
+  // Determine which propensities are recalculated by the update sequence of each reaction.
+  const C_FLOAT64 * pAmuBegin = mAmu.array();
+  const C_FLOAT64 * pAmuEnd = pAmuBegin + mNumReactions;
+
+  std::vector< size_t > Dependencies;
+  mDependencyStart.resize(mNumReactions + 1);
+
+  for (size_t i = 0; i < mNumReactions; ++i)
+    {
+      mDependencyStart[i] = Dependencies.size();
+
+      CCore::CUpdateSequence::const_iterator it = mUpdateSequences[i].begin();
+      CCore::CUpdateSequence::const_iterator end = mUpdateSequences[i].end();
+
+      for (; it != end; ++it)
+        {
+          const C_FLOAT64 * pValue = (const C_FLOAT64 *)(*it)->getValuePointer();
+
+          if (pAmuBegin <= pValue && pValue < pAmuEnd)
+            {
+              Dependencies.push_back(pValue - pAmuBegin);
+            }
+        }
+    }
+
+  mDependencyStart[mNumReactions] = Dependencies.size();
+  mDependencies.resize(Dependencies.size());
+
+  if (!Dependencies.empty())
+    {
+      memcpy(mDependencies.array(), Dependencies.data(), Dependencies.size() * sizeof(size_t));
+    }
+}
+
+// virtual
+void CStochLogDirectMethod::stateChange(const CMath::StateChange & change)
+{
+  CStochDirectMethod::stateChange(change);
+
+  if (change & (CMath::StateChange(CMath::eStateChange::FixedEventTarget) | CMath::eStateChange::State | CMath::eStateChange::ContinuousSimulation | CMath::eStateChange::EventSimulation))
+    {
+      buildTree();
+    }
+}
+
+// virtual
+size_t CStochLogDirectMethod::selectReaction(const C_FLOAT64 & rand)
+{
+  const C_FLOAT64 * pTree = mTree.array();
+  C_FLOAT64 Remainder = rand;
+  size_t Node = 1;
+
+  while (Node < mFirstLeaf)
+    {
+      Node *= 2;
+
+      // We never select a branch with zero propensity, which protects against
+      // round off errors when the random number is close to the total propensity.
+      if ((Remainder >= pTree[Node] && pTree[Node + 1] > 0.0) ||
+          pTree[Node] <= 0.0)
+        {
+          Remainder -= pTree[Node];
+          ++Node;
+        }
+    }
+
+  return Node - mFirstLeaf;
+}
+
+// virtual
+void CStochLogDirectMethod::updateTotalPropensity(const size_t & reactionIndex)
+{
+  const size_t * pDependency = mDependencies.array() + mDependencyStart[reactionIndex];
+  const size_t * pDependencyEnd = mDependencies.array() + mDependencyStart[reactionIndex + 1];
+
+  for (; pDependency != pDependencyEnd; ++pDependency)
+    {
+      updateLeaf(*pDependency);
+    }
+
+  mA0 = mTree[1];
+}
+
+void CStochLogDirectMethod::buildTree()
+{
+  mFirstLeaf = 1;
+
+  while (mFirstLeaf < mNumReactions)
+    {
+      mFirstLeaf *= 2;
+    }
+
+  mTree.resize(2 * mFirstLeaf);
+  mTree = 0.0;
+
+  C_FLOAT64 * pTree = mTree.array();
+  memcpy(pTree + mFirstLeaf, mAmu.array(), mNumReactions * sizeof(C_FLOAT64));
+
+  for (size_t Node = mFirstLeaf - 1; Node > 0; --Node)
+    {
+      pTree[Node] = pTree[2 * Node] + pTree[2 * Node + 1];
+    }
+
+  // The partial sums are always recalculated from the children, i.e., no round off
+  // error accumulates over the course of the simulation.
+  mA0 = pTree[1];
+}
+
+void CStochLogDirectMethod::updateLeaf(const size_t & index)
+{
+  C_FLOAT64 * pTree = mTree.array();
+  size_t Node = mFirstLeaf + index;
+
+  pTree[Node] = mAmu[index];
+
+  for (Node /= 2; Node > 0; Node /= 2)
+    {
+      pTree[Node] = pTree[2 * Node] + pTree[2 * Node + 1];
+    }
+}
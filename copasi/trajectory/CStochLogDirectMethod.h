@@ -0,0 +1,116 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#ifndef COPASI_CStochLogDirectMethod
+#define COPASI_CStochLogDirectMethod
+
+#include "copasi/trajectory/CStochDirectMethod.h"
+
+/**
+ * The logarithmic direct method is a variant of Gillespie's direct method which stores
+ * the propensities in the leaves of a complete binary sum tree. The next reaction is
+ * selected by descending the tree and after a reaction fired only the leaves of the
+ * propensities which are part of its update sequence are updated. Both operations have
+ * logarithmic cost in the number of reactions instead of the linear cost of the direct method.
+ *
+ * The time steps, the event and the root handling are identical to the direct method.
+ */
+class CStochLogDirectMethod : public CStochDirectMethod
+{
+private:
+  /**
+   * Default constructor.
+   */
+  CStochLogDirectMethod();
+
+protected:
+  /**
+   * Select the reaction which fires next
+   * @param const C_FLOAT64 & rand (uniformly distributed in (0, mA0))
+   * @return size_t reactionIndex
+   */
+  virtual size_t selectReaction(const C_FLOAT64 & rand);
+
+  /**
+   * Update the total propensity mA0 after the reaction with the given index has fired
+   * and the dependent propensities have been recalculated.
+   * @param const size_t & reactionIndex
+   */
+  virtual void updateTotalPropensity(const size_t & reactionIndex);
+
+public:
+  /**
+   * Specific constructor
+   * @param const CDataContainer * pParent
+   * @param const CTaskEnum::Method & methodType (default: logarithmicDirectMethod)
+   * @param const CTaskEnum::Task & taskType (default: timeCourse)
+   */
+  CStochLogDirectMethod(const CDataContainer * pParent,
+                        const CTaskEnum::Method & methodType = CTaskEnum::Method::logarithmicDirectMethod,
+                        const CTaskEnum::Task & taskType = CTaskEnum::Task::timeCourse);
+
+  /**
+   * Copy constructor.
+   * @param const CStochLogDirectMethod & src,
+   * @param const CDataContainer * pParent (Default: NULL)
+   */
+  CStochLogDirectMethod(const CStochLogDirectMethod & src,
+                        const CDataContainer * pParent);
+
+  /**
+   *  Destructor.
+   */
+  ~CStochLogDirectMethod();
+
+  /**
+   *  This instructs the method to prepare for integration
+   *  starting with the initialState given.
+   */
+  virtual void start();
+
+  /**
+   * Inform the trajectory method that the state has changed outside
+   * its control
+   * @param const CMath::StateChange & change
+   */
+  virtual void stateChange(const CMath::StateChange & change);
+
+private:
+  /**
+   * Rebuild the complete sum tree from the current propensities
+   */
+  void buildTree();
+
+  /**
+   * Copy the propensity of the indexed reaction into its leaf and update
+   * the partial sums of all its ancestors
+   * @param const size_t & index
+   */
+  void updateLeaf(const size_t & index);
+
+  /**
+   * The sum tree. The root is located at index 1, the children of node i are
+   * located at 2i and 2i + 1, and the propensity of reaction j is located at mFirstLeaf + j.
+   */
+  CVector< C_FLOAT64 > mTree;
+
+  /**
+   * The index of the first leaf, i.e., the smallest power of 2 not less than the number of reactions
+   */
+  size_t mFirstLeaf;
+
+  /**
+   * The indexes of the propensities updated after the reaction i fired are
+   * stored in mDependencies[mDependencyStart[i]] to mDependencies[mDependencyStart[i + 1] - 1]
+   */
+  CVector< size_t > mDependencyStart;
+
+  /**
+   * The concatenated indexes of the propensities depending on each reaction
+   */
+  CVector< size_t > mDependencies;
+};
+
+#endif // COPASI_CStochLogDirectMethod
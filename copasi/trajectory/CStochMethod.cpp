@@ -343,6 +343,9 @@ void CStochMethod::setupDependencyGraph()
             }
         }
     }
+
+  // The dependents are iterated after each reaction event.
+  mDG.freeze();
 }
 
 //virtual
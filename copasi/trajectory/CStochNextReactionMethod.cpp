@@ -107,10 +107,10 @@ void CStochNextReactionMethod::updatePriorityQueue(size_t reaction_index, C_FLOA
 
   // if the model contains assignment we use a less efficient loop over all reactions since
   // we do not know the exact dependencies
-  const std::set<size_t> & dep_nodes = mDG.getDependents(reaction_index);
-  std::set<size_t>::const_iterator di;
+  const size_t * di = mDG.beginDependents(reaction_index);
+  const size_t * de = mDG.endDependents(reaction_index);
 
-  for (di = dep_nodes.begin(); di != dep_nodes.end(); ++di)
+  for (; di != de; ++di)
     {
       if (*di != reaction_index)
         {
@@ -0,0 +1,545 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <string.h>
+
+#include "copasi/copasi.h"
+
+#ifdef USE_OMP
+# include <omp.h>
+#endif // USE_OMP
+
+#include "copasi/trajectory/CStochasticEnsemble.h"
+#include "copasi/trajectory/CTrajectoryTask.h"
+#include "copasi/trajectory/CTrajectoryMethod.h"
+
+#include "copasi/math/CMathContainer.h"
+#include "copasi/utilities/CCopasiException.h"
+#include "copasi/utilities/CProcessReport.h"
+
+// static
+bool CStochasticEnsemble::isSupportedMethod(const CTaskEnum::Method & method)
+{
+  switch (method)
+    {
+      case CTaskEnum::Method::stochastic:
+      case CTaskEnum::Method::directMethod:
+      case CTaskEnum::Method::logarithmicDirectMethod:
+      case CTaskEnum::Method::tauLeap:
+      case CTaskEnum::Method::tauLeapCGP:
+      case CTaskEnum::Method::adaptiveSA:
+        return true;
+        break;
+
+      default:
+        break;
+    }
+
+  return false;
+}
+
+// static
+unsigned C_INT32 CStochasticEnsemble::getRealizationSeed(const unsigned C_INT32 & seed, const size_t & realization)
+{
+  // We split the seed with the SplitMix64 finalizer which maps consecutive
+  // realizations to uncorrelated seeds.
+  unsigned C_INT64 Z = (((unsigned C_INT64) seed) << 32) + (unsigned C_INT64) realization;
+
+  Z += 0x9E3779B97F4A7C15ULL;
+  Z = (Z ^ (Z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  Z = (Z ^ (Z >> 27)) * 0x94D049BB133111EBULL;
+  Z = Z ^ (Z >> 31);
+
+  return (unsigned C_INT32)(Z >> 32);
+}
+
+CStochasticEnsemble::CStochasticEnsemble():
+  mWorkers(),
+  mInitialState(),
+  mStartState(),
+  mSeed(0),
+  mQuantiles(),
+  mTimes(),
+  mRealizations(0),
+  mFailedRealizations(0),
+  mMean(),
+  mSquaredDeviations(),
+  mQuantileEstimators()
+{
+  mQuantiles.push_back(0.05);
+  mQuantiles.push_back(0.5);
+  mQuantiles.push_back(0.95);
+}
+
+CStochasticEnsemble::~CStochasticEnsemble()
+{
+  cleanupWorkers();
+}
+
+void CStochasticEnsemble::setQuantiles(const std::vector< C_FLOAT64 > & quantiles)
+{
+  mQuantiles = quantiles;
+}
+
+const std::vector< C_FLOAT64 > & CStochasticEnsemble::getQuantiles() const
+{
+  return mQuantiles;
+}
+
+bool CStochasticEnsemble::calculate(const CTrajectoryTask & task,
+                                    const size_t & realizations,
+                                    const unsigned C_INT32 & seed,
+                                    const std::vector< C_FLOAT64 > & times,
+                                    CProcessReport * pCallBack)
+{
+  mRealizations = 0;
+  mFailedRealizations = 0;
+  mSeed = seed;
+
+  mTimes.resize(times.size());
+
+  if (!times.empty())
+    {
+      memcpy(mTimes.array(), &times[0], times.size() * sizeof(C_FLOAT64));
+    }
+
+  if (!initializeWorkers(task))
+    {
+      cleanupWorkers();
+      return false;
+    }
+
+  const CMathContainer & Container = *task.getMathContainer();
+  mInitialState = Container.getCompleteInitialState();
+  mStartState = Container.getState(false);
+
+  size_t Columns = mStartState.size();
+  size_t Quantiles = mQuantiles.size();
+
+  mMean.resize(mTimes.size(), Columns);
+  mMean = 0.0;
+  mSquaredDeviations.resize(mTimes.size(), Columns);
+  mSquaredDeviations = 0.0;
+
+  sQuantile Empty;
+  memset(&Empty, 0, sizeof(sQuantile));
+  mQuantileEstimators.assign(mTimes.size() * Columns * Quantiles, Empty);
+
+  // Each realization of a batch is stored until the whole batch is accumulated.
+  size_t BatchSize = 4 * mWorkers.size();
+  std::vector< CMatrix< C_FLOAT64 > > Results(BatchSize);
+  CVector< bool > Success(BatchSize);
+
+  std::vector< CMatrix< C_FLOAT64 > >::iterator itResult = Results.begin();
+  std::vector< CMatrix< C_FLOAT64 > >::iterator endResult = Results.end();
+
+  for (; itResult != endResult; ++itResult)
+    {
+      itResult->resize(mTimes.size(), Columns);
+    }
+
+  unsigned C_INT32 Counter = 0;
+  unsigned C_INT32 Total = (unsigned C_INT32) realizations;
+  size_t hCounter = C_INVALID_INDEX;
+
+  if (pCallBack != NULL)
+    {
+      hCounter = pCallBack->addItem("Realizations", Counter, &Total);
+    }
+
+  bool Continue = true;
+  size_t First = 0;
+
+  for (; First < realizations && Continue; First += BatchSize)
+    {
+      size_t Last = std::min(First + BatchSize, realizations);
+
+#ifdef USE_OMP
+      // Each realization is calculated independently, i.e., the assignment of
+      // realizations to workers does not influence the result.
+      C_INT32 iLast = (C_INT32) Last;
+
+      #pragma omp parallel for schedule(dynamic) num_threads(mWorkers.size())
+
+      for (C_INT32 i = (C_INT32) First; i < iLast; ++i)
+        {
+          Success[i - First] = calculateRealization(mWorkers[omp_get_thread_num()], i, Results[i - First]);
+        }
+
+#else
+
+      for (size_t i = First; i < Last; ++i)
+        {
+          Success[i - First] = calculateRealization(mWorkers[0], i, Results[i - First]);
+        }
+
+#endif // USE_OMP
+
+      for (size_t i = First; i < Last; ++i)
+        {
+          if (Success[i - First])
+            {
+              accumulate(Results[i - First]);
+            }
+          else
+            {
+              ++mFailedRealizations;
+            }
+        }
+
+      Counter = (unsigned C_INT32) Last;
+
+      if (hCounter != C_INVALID_INDEX)
+        {
+          Continue = pCallBack->progressItem(hCounter);
+        }
+    }
+
+  if (hCounter != C_INVALID_INDEX)
+    {
+      pCallBack->finishItem(hCounter);
+    }
+
+  cleanupWorkers();
+
+  return Continue && mRealizations > 0;
+}
+
+const CVector< C_FLOAT64 > & CStochasticEnsemble::getTimes() const
+{
+  return mTimes;
+}
+
+const size_t & CStochasticEnsemble::getRealizations() const
+{
+  return mRealizations;
+}
+
+const size_t & CStochasticEnsemble::getFailedRealizations() const
+{
+  return mFailedRealizations;
+}
+
+const CMatrix< C_FLOAT64 > & CStochasticEnsemble::getMean() const
+{
+  return mMean;
+}
+
+CMatrix< C_FLOAT64 > CStochasticEnsemble::getVariance() const
+{
+  CMatrix< C_FLOAT64 > Variance(mSquaredDeviations.numRows(), mSquaredDeviations.numCols());
+
+  if (mRealizations < 2)
+    {
+      Variance = 0.0;
+      return Variance;
+    }
+
+  const C_FLOAT64 * pSquaredDeviation = mSquaredDeviations.array();
+  C_FLOAT64 * pVariance = Variance.array();
+  C_FLOAT64 * pVarianceEnd = pVariance + Variance.size();
+
+  for (; pVariance != pVarianceEnd; ++pVariance, ++pSquaredDeviation)
+    {
+      *pVariance = *pSquaredDeviation / (mRealizations - 1);
+    }
+
+  return Variance;
+}
+
+CMatrix< C_FLOAT64 > CStochasticEnsemble::getQuantile(const size_t & index) const
+{
+  CMatrix< C_FLOAT64 > Quantile(mMean.numRows(), mMean.numCols());
+
+  if (index >= mQuantiles.size())
+    {
+      Quantile = std::numeric_limits< C_FLOAT64 >::quiet_NaN();
+      return Quantile;
+    }
+
+  const sQuantile * pEstimator = mQuantileEstimators.empty() ? NULL : &mQuantileEstimators[index];
+  C_FLOAT64 * pQuantile = Quantile.array();
+  C_FLOAT64 * pQuantileEnd = pQuantile + Quantile.size();
+
+  for (; pQuantile != pQuantileEnd; ++pQuantile, pEstimator += mQuantiles.size())
+    {
+      *pQuantile = getEstimate(*pEstimator, mQuantiles[index]);
+    }
+
+  return Quantile;
+}
+
+bool CStochasticEnsemble::initializeWorkers(const CTrajectoryTask & task)
+{
+  cleanupWorkers();
+
+  const CMathContainer * pSource = task.getMathContainer();
+
+  if (pSource == NULL ||
+      task.getMethod() == NULL ||
+      !isSupportedMethod(task.getMethod()->getSubType()))
+    {
+      return false;
+    }
+
+  size_t Threads = 1;
+
+#ifdef USE_OMP
+  Threads = std::max(1, omp_get_max_threads());
+#endif // USE_OMP
+
+  mWorkers.resize(Threads);
+
+  std::vector< sWorker >::iterator it = mWorkers.begin();
+  std::vector< sWorker >::iterator end = mWorkers.end();
+
+  for (; it != end; ++it)
+    {
+      it->pContainer = NULL;
+      it->pTask = NULL;
+    }
+
+  bool success = true;
+
+  for (it = mWorkers.begin(); it != end && success; ++it)
+    {
+      it->pContainer = new CMathContainer(*pSource);
+
+      if (it->pContainer->getValues().size() != pSource->getValues().size())
+        {
+          success = false;
+          break;
+        }
+
+      // The task copies need an ancestor to find the data model, however the task
+      // list must not know about them.
+      try
+        {
+          it->pTask = new CTrajectoryTask(task, NO_PARENT);
+          it->pTask->setObjectParent(task.getObjectParent());
+          it->pTask->setMathContainer(it->pContainer);
+          success &= it->pTask->initialize(CCopasiTask::NO_OUTPUT, NULL, NULL);
+        }
+
+      catch (...)
+        {
+          success = false;
+        }
+    }
+
+  return success;
+}
+
+void CStochasticEnsemble::cleanupWorkers()
+{
+  std::vector< sWorker >::iterator it = mWorkers.begin();
+  std::vector< sWorker >::iterator end = mWorkers.end();
+
+  for (; it != end; ++it)
+    {
+      // The tasks are not children of their parent, see initializeWorkers.
+      if (it->pTask != NULL)
+        {
+          it->pTask->setObjectParent(NULL);
+          pdelete(it->pTask);
+        }
+
+      pdelete(it->pContainer);
+    }
+
+  mWorkers.clear();
+}
+
+bool CStochasticEnsemble::calculateRealization(sWorker & worker,
+    const size_t & realization,
+    CMatrix< C_FLOAT64 > & states) const
+{
+  CMathContainer & Container = *worker.pContainer;
+  CTrajectoryTask & Task = *worker.pTask;
+
+  bool success = true;
+
+  try
+    {
+      Container.setCompleteInitialState(mInitialState);
+      Container.setState(mStartState);
+      Container.updateSimulatedValues(false);
+
+      unsigned C_INT32 Seed = getRealizationSeed(mSeed, realization);
+      Task.getMethod()->setValue("Use Random Seed", true);
+      Task.getMethod()->setValue("Random Seed", Seed);
+
+      Task.mProceed = true;
+      Task.processStart(false);
+
+      // We need to execute any scheduled events for T_0
+      CMath::StateChange StateChange = Container.processQueue(true);
+
+      if (StateChange)
+        {
+          Task.mContainerState = Container.getState(Task.mUpdateMoieties);
+          Task.mpTrajectoryMethod->stateChange(StateChange);
+        }
+
+      const CVectorCore< C_FLOAT64 > & State = Container.getState(false);
+      size_t i, imax = mTimes.size();
+
+      for (i = 0; i < imax && success; ++i)
+        {
+          if (i > 0)
+            {
+              success = Task.processStep(mTimes[i], i + 1 == imax);
+            }
+
+          memcpy(states[i], State.array(), State.size() * sizeof(C_FLOAT64));
+        }
+    }
+
+  catch (CCopasiException &)
+    {
+      // We do not want to clog the message cue.
+      CCopasiMessage::getLastMessage();
+
+      success = false;
+    }
+
+  catch (...)
+    {
+      success = false;
+    }
+
+  return success;
+}
+
+void CStochasticEnsemble::accumulate(const CMatrix< C_FLOAT64 > & states)
+{
+  ++mRealizations;
+
+  const C_FLOAT64 * pState = states.array();
+  const C_FLOAT64 * pStateEnd = pState + states.size();
+  C_FLOAT64 * pMean = mMean.array();
+  C_FLOAT64 * pSquaredDeviation = mSquaredDeviations.array();
+  sQuantile * pEstimator = mQuantileEstimators.empty() ? NULL : &mQuantileEstimators[0];
+  std::vector< C_FLOAT64 >::const_iterator itQuantile;
+  std::vector< C_FLOAT64 >::const_iterator endQuantile = mQuantiles.end();
+
+  for (; pState != pStateEnd; ++pState, ++pMean, ++pSquaredDeviation)
+    {
+      C_FLOAT64 Delta = *pState - *pMean;
+      *pMean += Delta / mRealizations;
+      *pSquaredDeviation += Delta * (*pState - *pMean);
+
+      for (itQuantile = mQuantiles.begin(); itQuantile != endQuantile; ++itQuantile, ++pEstimator)
+        {
+          addObservation(*pEstimator, *itQuantile, *pState);
+        }
+    }
+}
+
+// static
+void CStochasticEnsemble::addObservation(sQuantile & quantile,
+    const C_FLOAT64 & probability,
+    const C_FLOAT64 & value)
+{
+  C_FLOAT64 * q = quantile.Heights;
+  C_FLOAT64 * n = quantile.Positions;
+
+  // The first 5 observations are stored as they are.
+  if (quantile.Count < 5)
+    {
+      q[quantile.Count++] = value;
+
+      if (quantile.Count == 5)
+        {
+          std::sort(q, q + 5);
+
+          for (size_t i = 0; i < 5; ++i)
+            n[i] = i + 1;
+        }
+
+      return;
+    }
+
+  // Find the cell containing the value and adjust the extreme markers
+  size_t k;
+
+  if (value < q[0])
+    {
+      q[0] = value;
+      k = 0;
+    }
+  else if (value >= q[4])
+    {
+      q[4] = value;
+      k = 3;
+    }
+  else
+    {
+      for (k = 0; k < 3; ++k)
+        if (value < q[k + 1]) break;
+    }
+
+  for (size_t i = k + 1; i < 5; ++i)
+    n[i] += 1.0;
+
+  ++quantile.Count;
+
+  // The desired marker positions
+  const C_FLOAT64 Increments[5] = {0.0, 0.5 * probability, probability, 0.5 * (1.0 + probability), 1.0};
+
+  for (size_t i = 1; i < 4; ++i)
+    {
+      C_FLOAT64 d = 1.0 + (quantile.Count - 1) * Increments[i] - n[i];
+
+      if ((d >= 1.0 && n[i + 1] - n[i] > 1.0) ||
+          (d <= -1.0 && n[i - 1] - n[i] < -1.0))
+        {
+          C_FLOAT64 s = d < 0.0 ? -1.0 : 1.0;
+
+          // Piecewise parabolic prediction
+          C_FLOAT64 qp = q[i] + s / (n[i + 1] - n[i - 1]) *
+                         ((n[i] - n[i - 1] + s) * (q[i + 1] - q[i]) / (n[i + 1] - n[i]) +
+                          (n[i + 1] - n[i] - s) * (q[i] - q[i - 1]) / (n[i] - n[i - 1]));
+
+          if (q[i - 1] < qp && qp < q[i + 1])
+            {
+              q[i] = qp;
+            }
+          else
+            {
+              // Linear prediction
+              size_t j = s < 0.0 ? i - 1 : i + 1;
+              q[i] += s * (q[j] - q[i]) / (n[j] - n[i]);
+            }
+
+          n[i] += s;
+        }
+    }
+}
+
+// static
+C_FLOAT64 CStochasticEnsemble::getEstimate(const sQuantile & quantile,
+    const C_FLOAT64 & probability)
+{
+  if (quantile.Count == 0)
+    {
+      return std::numeric_limits< C_FLOAT64 >::quiet_NaN();
+    }
+
+  if (quantile.Count >= 5)
+    {
+      return quantile.Heights[2];
+    }
+
+  // For less than 5 observations we return the exact sample quantile.
+  C_FLOAT64 Sorted[5];
+  memcpy(Sorted, quantile.Heights, quantile.Count * sizeof(C_FLOAT64));
+  std::sort(Sorted, Sorted + quantile.Count);
+
+  return Sorted[(size_t) floor(probability * (quantile.Count - 1) + 0.5)];
+}
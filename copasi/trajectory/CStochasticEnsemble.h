@@ -0,0 +1,260 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#ifndef COPASI_CStochasticEnsemble
+#define COPASI_CStochasticEnsemble
+
+#include <vector>
+
+#include "copasi/core/CVector.h"
+#include "copasi/core/CMatrix.h"
+#include "copasi/utilities/CTaskEnum.h"
+
+class CTrajectoryTask;
+class CMathContainer;
+class CProcessReport;
+
+/**
+ * A stochastic ensemble calculates statistics of many realizations of a stochastic time
+ * course on a common output grid. The realizations are distributed over workers each owning
+ * an independently compiled copy of the math container and a copy of the trajectory task.
+ * Realization i uses a random seed derived from the ensemble seed and i, i.e., the result
+ * is reproducible and does not depend on the number of threads.
+ *
+ * The realizations are not stored. Mean and variance are accumulated with Welford's
+ * algorithm and quantiles are estimated with the P-square algorithm of Jain and Chlamtac.
+ * The realizations of a batch are accumulated in the order of their index after the
+ * whole batch has been calculated.
+ *
+ * The columns of the statistics correspond to the complete state of the container
+ * (see CMathContainer::getState(false)).
+ */
+class CStochasticEnsemble
+{
+private:
+  /**
+   * The P-square estimator of a single quantile
+   */
+  struct sQuantile
+  {
+    C_FLOAT64 Heights[5];
+    C_FLOAT64 Positions[5];
+    size_t Count;
+  };
+
+  struct sWorker
+  {
+    CMathContainer * pContainer;
+    CTrajectoryTask * pTask;
+  };
+
+  /**
+   * Hidden copy constructor
+   */
+  CStochasticEnsemble(const CStochasticEnsemble & src);
+
+  /**
+   * Hidden assignment operator
+   */
+  CStochasticEnsemble & operator = (const CStochasticEnsemble & rhs);
+
+public:
+  /**
+   * Check whether the method supports the calculation of an ensemble
+   * @param const CTaskEnum::Method & method
+   * @return bool isSupported
+   */
+  static bool isSupportedMethod(const CTaskEnum::Method & method);
+
+  /**
+   * Derive the seed of a realization from the seed of the ensemble
+   * @param const unsigned C_INT32 & seed
+   * @param const size_t & realization
+   * @return unsigned C_INT32 realizationSeed
+   */
+  static unsigned C_INT32 getRealizationSeed(const unsigned C_INT32 & seed, const size_t & realization);
+
+  /**
+   * Default constructor
+   */
+  CStochasticEnsemble();
+
+  /**
+   * Destructor
+   */
+  ~CStochasticEnsemble();
+
+  /**
+   * Set the probabilities of the estimated quantiles. The default is 0.05, 0.5, and 0.95.
+   * @param const std::vector< C_FLOAT64 > & quantiles
+   */
+  void setQuantiles(const std::vector< C_FLOAT64 > & quantiles);
+
+  /**
+   * Retrieve the probabilities of the estimated quantiles
+   * @return const std::vector< C_FLOAT64 > & quantiles
+   */
+  const std::vector< C_FLOAT64 > & getQuantiles() const;
+
+  /**
+   * Calculate the ensemble statistics. All realizations start from the current state of
+   * the container of the task, which must be initialized. The first time must be the current time.
+   * @param const CTrajectoryTask & task
+   * @param const size_t & realizations
+   * @param const unsigned C_INT32 & seed
+   * @param const std::vector< C_FLOAT64 > & times
+   * @param CProcessReport * pCallBack
+   * @return bool success
+   */
+  bool calculate(const CTrajectoryTask & task,
+                 const size_t & realizations,
+                 const unsigned C_INT32 & seed,
+                 const std::vector< C_FLOAT64 > & times,
+                 CProcessReport * pCallBack);
+
+  /**
+   * Retrieve the times of the output grid
+   * @return const CVector< C_FLOAT64 > & times
+   */
+  const CVector< C_FLOAT64 > & getTimes() const;
+
+  /**
+   * Retrieve the number of successfully calculated realizations
+   * @return const size_t & realizations
+   */
+  const size_t & getRealizations() const;
+
+  /**
+   * Retrieve the number of failed realizations, which are not part of the statistics
+   * @return const size_t & failedRealizations
+   */
+  const size_t & getFailedRealizations() const;
+
+  /**
+   * Retrieve the mean (rows: times, columns: state values)
+   * @return const CMatrix< C_FLOAT64 > & mean
+   */
+  const CMatrix< C_FLOAT64 > & getMean() const;
+
+  /**
+   * Retrieve the sample variance (rows: times, columns: state values)
+   * @return CMatrix< C_FLOAT64 > variance
+   */
+  CMatrix< C_FLOAT64 > getVariance() const;
+
+  /**
+   * Retrieve the estimate of the indexed quantile (rows: times, columns: state values)
+   * @param const size_t & index
+   * @return CMatrix< C_FLOAT64 > quantile
+   */
+  CMatrix< C_FLOAT64 > getQuantile(const size_t & index) const;
+
+private:
+  /**
+   * Create the workers for the given task
+   * @param const CTrajectoryTask & task
+   * @return bool success
+   */
+  bool initializeWorkers(const CTrajectoryTask & task);
+
+  /**
+   * Release the workers
+   */
+  void cleanupWorkers();
+
+  /**
+   * Calculate a single realization
+   * @param sWorker & worker
+   * @param const size_t & realization
+   * @param CMatrix< C_FLOAT64 > & states
+   * @return bool success
+   */
+  bool calculateRealization(sWorker & worker,
+                            const size_t & realization,
+                            CMatrix< C_FLOAT64 > & states) const;
+
+  /**
+   * Add the states of a realization to the statistics
+   * @param const CMatrix< C_FLOAT64 > & states
+   */
+  void accumulate(const CMatrix< C_FLOAT64 > & states);
+
+  /**
+   * Add an observation to a P-square estimator
+   * @param sQuantile & quantile
+   * @param const C_FLOAT64 & probability
+   * @param const C_FLOAT64 & value
+   */
+  static void addObservation(sQuantile & quantile,
+                             const C_FLOAT64 & probability,
+                             const C_FLOAT64 & value);
+
+  /**
+   * Retrieve the estimate of a P-square estimator
+   * @param const sQuantile & quantile
+   * @param const C_FLOAT64 & probability
+   * @return C_FLOAT64 estimate
+   */
+  static C_FLOAT64 getEstimate(const sQuantile & quantile,
+                               const C_FLOAT64 & probability);
+
+  /**
+   * The workers
+   */
+  std::vector< sWorker > mWorkers;
+
+  /**
+   * The complete initial state of the container of the task
+   */
+  CVector< C_FLOAT64 > mInitialState;
+
+  /**
+   * The state of the container of the task from which all realizations start
+   */
+  CVector< C_FLOAT64 > mStartState;
+
+  /**
+   * The seed of the ensemble
+   */
+  unsigned C_INT32 mSeed;
+
+  /**
+   * The probabilities of the estimated quantiles
+   */
+  std::vector< C_FLOAT64 > mQuantiles;
+
+  /**
+   * The times of the output grid
+   */
+  CVector< C_FLOAT64 > mTimes;
+
+  /**
+   * The number of successfully calculated realizations
+   */
+  size_t mRealizations;
+
+  /**
+   * The number of failed realizations
+   */
+  size_t mFailedRealizations;
+
+  /**
+   * The mean of all realizations
+   */
+  CMatrix< C_FLOAT64 > mMean;
+
+  /**
+   * The sum of the squared deviations from the mean
+   */
+  CMatrix< C_FLOAT64 > mSquaredDeviations;
+
+  /**
+   * The quantile estimators, the estimators for time i, state value j, and quantile k
+   * are located at ((i * columns) + j) * quantiles + k
+   */
+  std::vector< sQuantile > mQuantileEstimators;
+};
+
+#endif // COPASI_CStochasticEnsemble
@@ -0,0 +1,486 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#include <cmath>
+#include <limits>
+#include <string.h>
+
+#include "copasi/copasi.h"
+
+#include "copasi/trajectory/CTauLeapCGPMethod.h"
+
+#include "copasi/math/CMathContainer.h"
+#include "copasi/model/CChemEq.h"
+#include "copasi/model/CChemEqElement.h"
+#include "copasi/model/CMetab.h"
+#include "copasi/model/CReaction.h"
+#include "copasi/randomGenerator/CRandom.h"
+
+// The number of reactions above which propensities are calculated in parallel
+#define PARALLEL_PROPENSITIES 512
+
+// Exact steps are taken if the leap is shorter than this multiple of the mean time between reactions
+#define EXACT_STEP_FACTOR 10.0
+
+CTauLeapCGPMethod::CTauLeapCGPMethod(const CDataContainer * pParent,
+                                     const CTaskEnum::Method & methodType,
+                                     const CTaskEnum::Task & taskType):
+  CTauLeapMethod(pParent, methodType, taskType),
+  mCriticalFirings(10.0),
+  mUseBinomial(true),
+  mExactSteps(100),
+  mStoichiometryStart(),
+  mStoichiometrySpecies(),
+  mStoichiometryValues(),
+  mHighestOrder(),
+  mHighestOrderMultiplicity(),
+  mMaxFirings(),
+  mCritical(),
+  mProbabilities(),
+  mSpeciesBackup(),
+  mA0Critical(0.0)
+{
+  initializeParameter();
+}
+
+CTauLeapCGPMethod::CTauLeapCGPMethod(const CTauLeapCGPMethod & src,
+                                     const CDataContainer * pParent):
+  CTauLeapMethod(src, pParent),
+  mCriticalFirings(src.mCriticalFirings),
+  mUseBinomial(src.mUseBinomial),
+  mExactSteps(src.mExactSteps),
+  mStoichiometryStart(),
+  mStoichiometrySpecies(),
+  mStoichiometryValues(),
+  mHighestOrder(),
+  mHighestOrderMultiplicity(),
+  mMaxFirings(),
+  mCritical(),
+  mProbabilities(),
+  mSpeciesBackup(),
+  mA0Critical(0.0)
+{
+  initializeParameter();
+}
+
+CTauLeapCGPMethod::~CTauLeapCGPMethod()
+{}
+
+void CTauLeapCGPMethod::initializeParameter()
+{
+  assertParameter("Critical Firings", CCopasiParameter::Type::UINT, (unsigned C_INT32) 10);
+  assertParameter("Use Binomial Leaps", CCopasiParameter::Type::BOOL, true);
+  assertParameter("Max Exact Steps", CCopasiParameter::Type::UINT, (unsigned C_INT32) 100);
+}
+
+bool CTauLeapCGPMethod::elevateChildren()
+{
+  bool success = CTauLeapMethod::elevateChildren();
+
+  initializeParameter();
+
+  return success;
+}
+
+void CTauLeapCGPMethod::start()
+{
+  CTauLeapMethod::start();
+
+  mCriticalFirings = getValue< unsigned C_INT32 >("Critical Firings");
+  mUseBinomial = getValue< bool >("Use Binomial Leaps");
+  mExactSteps = getValue< unsigned C_INT32 >("Max Exact Steps");
+
+  const C_FLOAT64 * pFirstSpecies = mContainerState.array() + mFirstReactionSpeciesIndex;
+
+  // Build the sparse stoichiometry (CSR) from the number balances.
+  std::vector< size_t > Species;
+  std::vector< C_FLOAT64 > Values;
+
+  mStoichiometryStart.resize(mNumReactions + 1);
+
+  CMathReaction * pReaction = mReactions.array();
+  size_t j;
+
+  for (j = 0; j < mNumReactions; ++j, ++pReaction)
+    {
+      mStoichiometryStart[j] = Species.size();
+
+      const CMathReaction::Balance & Balance = pReaction->getNumberBalance();
+      const CMathReaction::SpeciesBalance * it = Balance.array();
+      const CMathReaction::SpeciesBalance * end = it + Balance.size();
+
+      for (; it != end; ++it)
+        {
+          size_t Index = it->first - pFirstSpecies;
+
+          if (Index < mNumReactionSpecies && it->second != 0.0)
+            {
+              Species.push_back(Index);
+              Values.push_back(it->second);
+            }
+        }
+    }
+
+  mStoichiometryStart[mNumReactions] = Species.size();
+
+  mStoichiometrySpecies.resize(Species.size());
+  mStoichiometryValues.resize(Values.size());
+
+  if (!Species.empty())
+    {
+      memcpy(mStoichiometrySpecies.array(), &Species[0], Species.size() * sizeof(size_t));
+      memcpy(mStoichiometryValues.array(), &Values[0], Values.size() * sizeof(C_FLOAT64));
+    }
+
+  // Determine the highest order of the reactions consuming each species (HOR) and
+  // the multiplicity of the species in these reactions.
+  mHighestOrder.resize(mNumReactionSpecies);
+  mHighestOrder = 0.0;
+  mHighestOrderMultiplicity.resize(mNumReactionSpecies);
+  mHighestOrderMultiplicity = 0.0;
+
+  for (j = 0, pReaction = mReactions.array(); j < mNumReactions; ++j, ++pReaction)
+    {
+      const CDataVector< CChemEqElement > & Substrates = pReaction->getModelReaction()->getChemEq().getSubstrates();
+      CDataVector< CChemEqElement >::const_iterator it = Substrates.begin();
+      CDataVector< CChemEqElement >::const_iterator end = Substrates.end();
+
+      C_FLOAT64 Order = 0.0;
+
+      for (; it != end; ++it)
+        Order += it->getMultiplicity();
+
+      for (it = Substrates.begin(); it != end; ++it)
+        {
+          const CMathObject * pObject = mpContainer->getMathObject(it->getMetabolite()->getValueReference());
+
+          if (pObject == NULL) continue;
+
+          size_t Index = (const C_FLOAT64 *) pObject->getValuePointer() - pFirstSpecies;
+
+          if (Index >= mNumReactionSpecies) continue;
+
+          if (Order > mHighestOrder[Index])
+            {
+              mHighestOrder[Index] = Order;
+              mHighestOrderMultiplicity[Index] = it->getMultiplicity();
+            }
+          else if (Order == mHighestOrder[Index] &&
+                   it->getMultiplicity() > mHighestOrderMultiplicity[Index])
+            {
+              mHighestOrderMultiplicity[Index] = it->getMultiplicity();
+            }
+        }
+    }
+
+  mMaxFirings.resize(mNumReactions);
+  mCritical.resize(mNumReactions);
+  mProbabilities.resize(mNumReactions);
+  mSpeciesBackup.resize(mNumReactionSpecies);
+}
+
+C_FLOAT64 CTauLeapCGPMethod::doSingleStep(C_FLOAT64 ds)
+{
+  calculatePropensities();
+
+  if (mA0 <= 0.0)
+    return ds;
+
+  C_FLOAT64 Tau1 = calculateTau();
+
+  if (Tau1 < EXACT_STEP_FACTOR / mA0 &&
+      mExactSteps > 0)
+    {
+      return doExactSteps(ds);
+    }
+
+  // The time to the next firing of a critical reaction
+  C_FLOAT64 Tau2 = std::numeric_limits< C_FLOAT64 >::infinity();
+
+  if (mA0Critical > 0.0)
+    Tau2 = mpRandomGenerator->getRandomExp() / mA0Critical;
+
+  while (true)
+    {
+      C_FLOAT64 Tau = std::min(Tau1, ds);
+      bool FireCritical = false;
+
+      if (Tau2 <= Tau)
+        {
+          Tau = Tau2;
+          FireCritical = true;
+        }
+
+      drawFirings(Tau);
+
+      if (FireCritical)
+        mK[selectCriticalReaction()] = 1.0;
+
+      if (applyFirings())
+        return Tau;
+
+      // A population became negative, we retry with half the leap of the non-critical reactions.
+      Tau1 = 0.5 * std::min(Tau1, ds);
+    }
+
+  return 0.0;
+}
+
+void CTauLeapCGPMethod::calculatePropensities()
+{
+  CMathObject * pPropensity = mPropensityObjects.array();
+  C_INT32 imax = (C_INT32) mNumReactions;
+
+  // The propensities are independent of each other and can be calculated concurrently.
+#ifdef USE_OMP
+  #pragma omp parallel for schedule(static) if (imax > PARALLEL_PROPENSITIES)
+#endif // USE_OMP
+
+  for (C_INT32 i = 0; i < imax; ++i)
+    pPropensity[i].calculateValue();
+
+  mA0 = 0.0;
+
+  const C_FLOAT64 * pAmu = mAmu.array();
+  const C_FLOAT64 * pAmuEnd = pAmu + mNumReactions;
+
+  for (; pAmu != pAmuEnd; ++pAmu)
+    mA0 += *pAmu;
+}
+
+C_FLOAT64 CTauLeapCGPMethod::calculateTau()
+{
+  const C_FLOAT64 * pSpecies = mContainerState.array() + mFirstReactionSpeciesIndex;
+  const size_t * pStart = mStoichiometryStart.array();
+  const size_t * pIndex = mStoichiometrySpecies.array();
+  const C_FLOAT64 * pValue = mStoichiometryValues.array();
+  const C_FLOAT64 * pAmu = mAmu.array();
+
+  mA0Critical = 0.0;
+  mAvgDX = 0.0;
+  mSigDX = 0.0;
+
+  size_t j, k;
+
+  for (j = 0; j < mNumReactions; ++j, ++pStart, ++pAmu)
+    {
+      // The maximal number of firings before a reactant is exhausted
+      C_FLOAT64 MaxFirings = std::numeric_limits< C_FLOAT64 >::infinity();
+
+      for (k = *pStart; k < *(pStart + 1); ++k)
+        if (pValue[k] < 0.0)
+          {
+            C_FLOAT64 Firings = floor(pSpecies[pIndex[k]] / -pValue[k]);
+
+            if (Firings < MaxFirings)
+              MaxFirings = Firings;
+          }
+
+      mMaxFirings[j] = MaxFirings;
+      mCritical[j] = (*pAmu > 0.0 && MaxFirings < mCriticalFirings);
+
+      if (mCritical[j])
+        {
+          mA0Critical += *pAmu;
+          continue;
+        }
+
+      // The mean and the variance of the expected change of the species caused by non-critical reactions
+      for (k = *pStart; k < *(pStart + 1); ++k)
+        {
+          mAvgDX[pIndex[k]] += pValue[k] * *pAmu;
+          mSigDX[pIndex[k]] += pValue[k] * pValue[k] * *pAmu;
+        }
+    }
+
+  C_FLOAT64 Tau = std::numeric_limits< C_FLOAT64 >::infinity();
+
+  const C_FLOAT64 * pHighestOrder = mHighestOrder.array();
+  const C_FLOAT64 * pMultiplicity = mHighestOrderMultiplicity.array();
+  const C_FLOAT64 * pAvgDX = mAvgDX.array();
+  const C_FLOAT64 * pSigDX = mSigDX.array();
+  const C_FLOAT64 * pSpeciesEnd = pSpecies + mNumReactionSpecies;
+
+  for (; pSpecies != pSpeciesEnd; ++pSpecies, ++pHighestOrder, ++pMultiplicity, ++pAvgDX, ++pSigDX)
+    {
+      // Only reactants limit the leap.
+      if (*pHighestOrder == 0.0) continue;
+
+      const C_FLOAT64 & x = *pSpecies;
+      C_FLOAT64 g = *pHighestOrder;
+
+      // Cao, Gillespie, and Petzold (2006), Eq. (27)
+      if (x > *pMultiplicity)
+        {
+          if (*pHighestOrder == 2.0 && *pMultiplicity == 2.0)
+            g = 2.0 + 1.0 / (x - 1.0);
+          else if (*pHighestOrder == 3.0 && *pMultiplicity == 2.0)
+            g = 1.5 * (2.0 + 1.0 / (x - 1.0));
+          else if (*pHighestOrder == 3.0 && *pMultiplicity == 3.0)
+            g = 3.0 + 1.0 / (x - 1.0) + 2.0 / (x - 2.0);
+        }
+
+      C_FLOAT64 Bound = std::max(mEpsilon * x / g, 1.0);
+
+      if (*pAvgDX != 0.0)
+        Tau = std::min(Tau, Bound / fabs(*pAvgDX));
+
+      if (*pSigDX != 0.0)
+        Tau = std::min(Tau, Bound * Bound / *pSigDX);
+    }
+
+  return Tau;
+}
+
+C_FLOAT64 CTauLeapCGPMethod::doExactSteps(const C_FLOAT64 & ds)
+{
+  C_FLOAT64 StartTime = *mpContainerStateTime;
+  C_FLOAT64 Time = 0.0;
+  unsigned C_INT32 Step = 0;
+
+  while (true)
+    {
+      if (mA0 <= 0.0)
+        return ds;
+
+      C_FLOAT64 Delta = mpRandomGenerator->getRandomExp() / mA0;
+
+      if (Time + Delta > ds)
+        return ds;
+
+      Time += Delta;
+
+      // Select the reaction
+      C_FLOAT64 Rand = mpRandomGenerator->getRandomOO() * mA0;
+      const C_FLOAT64 * pAmu = mAmu.array();
+      const C_FLOAT64 * pAmuEnd = pAmu + mNumReactions - 1;
+
+      for (; pAmu != pAmuEnd && Rand >= *pAmu; ++pAmu)
+        Rand -= *pAmu;
+
+      size_t Reaction = pAmu - mAmu.array();
+
+      C_FLOAT64 * pSpecies = mContainerState.array() + mFirstReactionSpeciesIndex;
+      size_t k, kmax = mStoichiometryStart[Reaction + 1];
+
+      for (k = mStoichiometryStart[Reaction]; k < kmax; ++k)
+        pSpecies[mStoichiometrySpecies[k]] += mStoichiometryValues[k];
+
+      if (++Step >= mExactSteps)
+        break;
+
+      *mpContainerStateTime = StartTime + Time;
+      mpContainer->updateSimulatedValues(false);
+      calculatePropensities();
+    }
+
+  return Time;
+}
+
+void CTauLeapCGPMethod::drawFirings(const C_FLOAT64 & tau)
+{
+  const C_FLOAT64 * pAmu = mAmu.array();
+  const C_FLOAT64 * pMaxFirings = mMaxFirings.array();
+  const bool * pCritical = mCritical.array();
+  C_FLOAT64 * pK = mK.array();
+  C_FLOAT64 * pKEnd = pK + mNumReactions;
+  C_FLOAT64 * pProbability = mProbabilities.array();
+
+  for (; pK != pKEnd; ++pK, ++pAmu, ++pMaxFirings, ++pCritical, ++pProbability)
+    {
+      if (*pCritical)
+        {
+          *pK = 0.0;
+          *pProbability = 0.0;
+          continue;
+        }
+
+      C_FLOAT64 Lambda = *pAmu * tau;
+
+      if (Lambda < 0.0)
+        CCopasiMessage(CCopasiMessage::EXCEPTION, MCTrajectoryMethod + 10);
+      else if (Lambda > 2.0e9)
+        CCopasiMessage(CCopasiMessage::EXCEPTION, MCTrajectoryMethod + 26);
+
+      *pK = Lambda;
+
+      // Reactions consuming species fire at most the maximal number of firings.
+      if (*pMaxFirings < std::numeric_limits< C_FLOAT64 >::infinity())
+        *pProbability = (*pMaxFirings > 0.0) ? std::min(Lambda / *pMaxFirings, 1.0) : 0.0;
+      else
+        *pProbability = -1.0;
+    }
+
+  if (!mUseBinomial)
+    {
+      mpRandomGenerator->fillRandomPoisson(mK.array(), mK.array(), mNumReactions);
+      return;
+    }
+
+  // Draw all bounded reactions in one batch. Negative probabilities yield 0.
+  mpRandomGenerator->fillRandomBinomial(mProbabilities.array(), mMaxFirings.array(), mProbabilities.array(), mNumReactions);
+
+  pMaxFirings = mMaxFirings.array();
+  pProbability = mProbabilities.array();
+
+  for (pK = mK.array(); pK != pKEnd; ++pK, ++pMaxFirings, ++pProbability)
+    {
+      if (*pMaxFirings < std::numeric_limits< C_FLOAT64 >::infinity())
+        *pK = *pProbability;
+      else if (*pK > 0.0)
+        *pK = mpRandomGenerator->getRandomPoisson(*pK);
+    }
+}
+
+size_t CTauLeapCGPMethod::selectCriticalReaction()
+{
+  C_FLOAT64 Rand = mpRandomGenerator->getRandomOO() * mA0Critical;
+  size_t Selected = C_INVALID_INDEX;
+
+  for (size_t j = 0; j < mNumReactions; ++j)
+    if (mCritical[j])
+      {
+        Selected = j;
+        Rand -= mAmu[j];
+
+        if (Rand < 0.0) break;
+      }
+
+  return Selected;
+}
+
+bool CTauLeapCGPMethod::applyFirings()
+{
+  C_FLOAT64 * pSpecies = mContainerState.array() + mFirstReactionSpeciesIndex;
+
+  memcpy(mSpeciesBackup.array(), pSpecies, mNumReactionSpecies * sizeof(C_FLOAT64));
+
+  const size_t * pStart = mStoichiometryStart.array();
+  const size_t * pIndex = mStoichiometrySpecies.array();
+  const C_FLOAT64 * pValue = mStoichiometryValues.array();
+  const C_FLOAT64 * pK = mK.array();
+  size_t j, k;
+
+  for (j = 0; j < mNumReactions; ++j, ++pStart, ++pK)
+    if (*pK != 0.0)
+      {
+        for (k = *pStart; k < *(pStart + 1); ++k)
+          pSpecies[pIndex[k]] += pValue[k] * *pK;
+      }
+
+  bool Negative = false;
+  const C_FLOAT64 * pSpeciesEnd = pSpecies + mNumReactionSpecies;
+
+  for (C_FLOAT64 * pIt = pSpecies; pIt != pSpeciesEnd; ++pIt)
+    Negative |= (*pIt < -0.5);
+
+  if (Negative)
+    {
+      memcpy(pSpecies, mSpeciesBackup.array(), mNumReactionSpecies * sizeof(C_FLOAT64));
+      return false;
+    }
+
+  return true;
+}
@@ -0,0 +1,190 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#ifndef COPASI_CTauLeapCGPMethod
+#define COPASI_CTauLeapCGPMethod
+
+#include "copasi/trajectory/CTauLeapMethod.h"
+
+/**
+ * The tau-leap method with the tau selection of Cao, Gillespie, and Petzold (2006):
+ * Efficient step size selection for the tau-leaping simulation method. J. Chem. Phys.,
+ * 124:044109.
+ *
+ * Reactions which can fire fewer than "Critical Firings" times before exhausting one of
+ * their reactants are critical. The leap is selected for the non-critical reactions such
+ * that the relative change of the propensities is bounded by epsilon. At most one critical
+ * reaction fires during a leap. If the leap is short compared to the mean time between
+ * reactions, exact stochastic simulation steps are taken instead. Negative populations are
+ * therefore rare and the leap is only halved in this case.
+ *
+ * The numbers of firings are drawn in one batch, either as Poisson variates or, bounded by
+ * the number of possible firings, as binomial variates. The stoichiometry is applied with
+ * a sparse (CSR) update kernel and the propensities are calculated in parallel for large
+ * models if COPASI is built with OpenMP.
+ */
+class CTauLeapCGPMethod : public CTauLeapMethod
+{
+private:
+  /**
+   * Default constructor.
+   */
+  CTauLeapCGPMethod();
+
+public:
+  /**
+   * Specific constructor
+   * @param const CDataContainer * pParent
+   * @param const CTaskEnum::Method & methodType (default: tauLeapCGP)
+   * @param const CTaskEnum::Task & taskType (default: timeCourse)
+   */
+  CTauLeapCGPMethod(const CDataContainer * pParent,
+                    const CTaskEnum::Method & methodType = CTaskEnum::Method::tauLeapCGP,
+                    const CTaskEnum::Task & taskType = CTaskEnum::Task::timeCourse);
+
+  /**
+   * Copy constructor
+   * @param const CTauLeapCGPMethod & src
+   * @param const CDataContainer * pParent (default: NULL)
+   */
+  CTauLeapCGPMethod(const CTauLeapCGPMethod & src,
+                    const CDataContainer * pParent);
+
+  /**
+   *   Destructor.
+   */
+  ~CTauLeapCGPMethod();
+
+  /**
+   * This methods must be called to elevate subgroups to
+   * derived objects. The default implementation does nothing.
+   * @return bool success
+   */
+  virtual bool elevateChildren();
+
+  /**
+   *  This instructs the method to prepare for integration
+   *  starting with the initialState given.
+   */
+  virtual void start();
+
+protected:
+  /**
+   *  Simulates the system over the next interval of time. The timestep
+   *  is given as argument.
+   *
+   *  @param  ds A C_FLOAT64 specifying the timestep
+   */
+  virtual C_FLOAT64 doSingleStep(C_FLOAT64 ds);
+
+private:
+  /**
+   * Initialize the method parameter
+   */
+  void initializeParameter();
+
+  /**
+   * Calculate the propensities for all reactions, in parallel for large models
+   */
+  void calculatePropensities();
+
+  /**
+   * Calculate the leap for the non-critical reactions
+   * @return C_FLOAT64 tau
+   */
+  C_FLOAT64 calculateTau();
+
+  /**
+   * Perform exact stochastic simulation steps within the given time
+   * @param const C_FLOAT64 & ds
+   * @return C_FLOAT64 time
+   */
+  C_FLOAT64 doExactSteps(const C_FLOAT64 & ds);
+
+  /**
+   * Draw the numbers of firings of the non-critical reactions in a leap
+   * @param const C_FLOAT64 & tau
+   */
+  void drawFirings(const C_FLOAT64 & tau);
+
+  /**
+   * Select a critical reaction with a probability proportional to its propensity
+   * @return size_t reaction
+   */
+  size_t selectCriticalReaction();
+
+  /**
+   * Apply the numbers of firings mK to the species
+   * @return bool success (false if a population became negative)
+   */
+  bool applyFirings();
+
+  /**
+   * The number of firings below which a reaction is critical
+   */
+  C_FLOAT64 mCriticalFirings;
+
+  /**
+   * Indicates whether the firings are drawn from the binomial distribution
+   */
+  bool mUseBinomial;
+
+  /**
+   * The maximal number of exact steps taken if the leap is too short
+   */
+  unsigned C_INT32 mExactSteps;
+
+  /**
+   * The start of the stoichiometry of each reaction (size: reactions + 1)
+   */
+  CVector< size_t > mStoichiometryStart;
+
+  /**
+   * The species indexes of the stoichiometry
+   */
+  CVector< size_t > mStoichiometrySpecies;
+
+  /**
+   * The stoichiometric coefficients
+   */
+  CVector< C_FLOAT64 > mStoichiometryValues;
+
+  /**
+   * The highest order of the reactions consuming each species
+   */
+  CVector< C_FLOAT64 > mHighestOrder;
+
+  /**
+   * The highest multiplicity of each species in the reactions with the highest order
+   */
+  CVector< C_FLOAT64 > mHighestOrderMultiplicity;
+
+  /**
+   * The maximal number of firings of each reaction
+   */
+  CVector< C_FLOAT64 > mMaxFirings;
+
+  /**
+   * Indicates whether a reaction is critical
+   */
+  CVector< bool > mCritical;
+
+  /**
+   * Probabilities of the binomial draws
+   */
+  CVector< C_FLOAT64 > mProbabilities;
+
+  /**
+   * The species values before the leap
+   */
+  CVector< C_FLOAT64 > mSpeciesBackup;
+
+  /**
+   * The total propensity of the critical reactions
+   */
+  C_FLOAT64 mA0Critical;
+};
+
+#endif // COPASI_CTauLeapCGPMethod
@@ -310,9 +310,12 @@ C_FLOAT64 CTauLeapMethod::doSingleStep(C_FLOAT64 ds)
       else if (Lambda > 2.0e9)
         CCopasiMessage(CCopasiMessage::EXCEPTION, MCTrajectoryMethod + 26);
 
-      *pK = mpRandomGenerator->getRandomPoisson(Lambda);
+      *pK = Lambda;
     }
 
+  // Draw the number of firings of all reactions in one batch.
+  mpRandomGenerator->fillRandomPoisson(mK.array(), mK.array(), mNumReactions);
+
   while (!updateSystem())
     {
       Tau *= 0.5;
@@ -109,7 +109,7 @@ protected:
    *
    *  @param  ds A C_FLOAT64 specifying the timestep
    */
-  C_FLOAT64 doSingleStep(C_FLOAT64 ds);
+  virtual C_FLOAT64 doSingleStep(C_FLOAT64 ds);
 
   /**
    * Calculate the propensities for all reactions
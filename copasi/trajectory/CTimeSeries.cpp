@@ -50,12 +50,10 @@ C_FLOAT64 CTimeSeries::mDummyFloat(0.0);
 
 CTimeSeries::CTimeSeries():
   COutputInterface(),
-  CMatrix< C_FLOAT64 >(),
+  mStorage(),
   mAllocatedSteps(0),
   mRecordedSteps(0),
   mNumVariables(0),
-  mpIt(mpBuffer),
-  mpEnd(mpBuffer + size()),
   mContainerValues(),
   mTitles(),
   mCompartment(),
@@ -66,12 +64,10 @@ CTimeSeries::CTimeSeries():
 
 CTimeSeries::CTimeSeries(const CTimeSeries & src):
   COutputInterface(src),
-  CMatrix< C_FLOAT64 >(src),
+  mStorage(src.mStorage),
   mAllocatedSteps(src.mAllocatedSteps),
-  mRecordedSteps(src.mRecordedSteps),
+  mRecordedSteps(mStorage.getRows()),
   mNumVariables(src.mNumVariables),
-  mpIt(mpBuffer + mRecordedSteps * mCols),
-  mpEnd(mpBuffer + size()),
   mContainerValues(),
   mTitles(src.mTitles),
   mCompartment(src.mCompartment),
@@ -93,30 +89,24 @@ void CTimeSeries::allocate(const size_t & steps)
 
 void CTimeSeries::increaseAllocation()
 {
-  size_t diff;
-  diff = mAllocatedSteps / 4;
-
-  if (diff < 10)
-    diff = 10;
-  else if (diff > 10000)
-    diff = 10000;
-
-  mAllocatedSteps += diff;
-  CMatrix< C_FLOAT64 >::resize(mAllocatedSteps, mCols, true);
+  // The storage grows block by block without copying the recorded steps, i.e.,
+  // we only keep track of the number of steps for which blocks are allocated.
+  size_t RowsPerBlock = mStorage.getRowsPerBlock();
+  mAllocatedSteps = ((mRecordedSteps / RowsPerBlock) + 1) * RowsPerBlock;
+}
 
-  mpIt = mpBuffer + mRecordedSteps * mCols;
-  mpEnd = mpBuffer + size();
+void CTimeSeries::setSpill(const std::string & directory, const size_t & memoryLimit)
+{
+  mStorage.setSpill(directory, memoryLimit);
 }
 
 void CTimeSeries::clear()
 {
   mObjects.clear();
-  CMatrix< C_FLOAT64 >::resize(0, 0);
-  mAllocatedSteps = mRows;
+  mStorage.clear();
+  mAllocatedSteps = 0;
   mRecordedSteps = 0;
   mNumVariables = 0;
-  mpIt = mpBuffer;
-  mpEnd = mpBuffer + size();
   mTitles.clear();
   mCompartment.resize(0);
   mPivot.resize(0);
@@ -159,7 +149,7 @@ bool CTimeSeries::compile(CObjectInterface::ContainerList listOfContainer)
 
   mObjects.clear();
 
-  CMatrix< C_FLOAT64 >::resize(mAllocatedSteps + 1, imax);
+  mStorage.initialize(imax, mAllocatedSteps + 1);
 
   mPivot.resize(imax);
   mTitles.resize(imax);
@@ -169,8 +159,6 @@ bool CTimeSeries::compile(CObjectInterface::ContainerList listOfContainer)
 
   mRecordedSteps = 0;
   mNumVariables = Fixed;
-  mpIt = mpBuffer;
-  mpEnd = mpBuffer + size();
 
   mNumberToQuantityFactor = pContainer->getModel().getNumber2QuantityFactor();
 
@@ -256,16 +244,12 @@ void CTimeSeries::output(const COutputInterface::Activity & activity)
   if (activity != DURING)
     return;
 
-  // We may have to reallocate due to additional output caused from events
-  if (mpIt == mpEnd)
-    {
-      increaseAllocation();
-    }
+  // Additional output caused by events is appended to a new block if needed.
+  C_FLOAT64 * pRow = mStorage.appendRow();
 
-  if (mpIt != mpEnd)
+  if (pRow != NULL)
     {
-      memcpy(mpIt, mContainerValues.array(), mCols * sizeof(C_FLOAT64));
-      mpIt += mCols;
+      memcpy(pRow, mContainerValues.array(), mStorage.getColumns() * sizeof(C_FLOAT64));
       mRecordedSteps++;
     }
 }
@@ -273,20 +257,15 @@ void CTimeSeries::output(const COutputInterface::Activity & activity)
 // virtual
 void CTimeSeries::separate(const COutputInterface::Activity & /* activity */)
 {
-  // We may have to reallocate due to additional output caused from events
-  if (mpIt == mpEnd)
-    {
-      increaseAllocation();
-    }
+  C_FLOAT64 * pIt = mStorage.appendRow();
 
-  if (mpIt != mpEnd)
+  if (pIt != NULL)
     {
-      C_FLOAT64 * pIt = mpIt;
-      mpIt += mCols;
+      C_FLOAT64 * pEnd = pIt + mStorage.getColumns();
       mRecordedSteps++;
 
       // We copy NaN to indicate separation, which is similar to plotting.
-      for (; pIt != mpIt; ++pIt)
+      for (; pIt != pEnd; ++pIt)
         *pIt = std::numeric_limits< C_FLOAT64 >::quiet_NaN();
     }
 }
@@ -307,7 +286,7 @@ const C_FLOAT64 & CTimeSeries::getData(const size_t & step,
                                        const size_t & var) const
 {
   if (step < mRecordedSteps && var < mNumVariables)
-    return *(mpBuffer + step * mCols + mPivot[var]);
+    return *(mStorage.getRow(step) + mPivot[var]);
 
   return mDummyFloat;
 }
@@ -316,18 +295,22 @@ C_FLOAT64 CTimeSeries::getConcentrationData(const size_t & step,
     const size_t & var) const
 {
   if (step < mRecordedSteps && var < mNumVariables)
-    {
-      const size_t & Col = mPivot[var];
-
-      if (mCompartment[Col] != C_INVALID_INDEX)
-        return *(mpBuffer + step * mCols + Col) * mNumberToQuantityFactor / *(mpBuffer + step * mCols + mCompartment[Col]);
-      else
-        return *(mpBuffer + step * mCols + Col);
-    }
+    return getRowConcentration(mStorage.getRow(step), var);
 
   return mDummyFloat;
 }
 
+C_FLOAT64 CTimeSeries::getRowConcentration(const C_FLOAT64 * pRow,
+    const size_t & var) const
+{
+  const size_t & Col = mPivot[var];
+
+  if (mCompartment[Col] != C_INVALID_INDEX)
+    return pRow[Col] * mNumberToQuantityFactor / pRow[mCompartment[Col]];
+
+  return pRow[Col];
+}
+
 const std::string & CTimeSeries::getTitle(const size_t & var) const
 {
   if (var < mNumVariables)
@@ -437,10 +420,9 @@ CTimeSeries::save(std::ostream& str, bool writeParticleNumbers,
 
   if (!str.good()) return 1;
 
-  size_t counter;
-  size_t maxCount = mRecordedSteps;
+  CTimeSeriesRowIterator itRow(*this);
 
-  for (counter = 0; counter < maxCount; ++counter)
+  for (; itRow.isValid(); itRow.next())
     {
       stringStream.str("");
       stringStream.clear();
@@ -451,11 +433,11 @@ CTimeSeries::save(std::ostream& str, bool writeParticleNumbers,
 
           if (writeParticleNumbers)
             {
-              value = this->getData(counter, counter2);
+              value = itRow.getData(counter2);
             }
           else
             {
-              value = this->getConcentrationData(counter, counter2);
+              value = itRow.getConcentrationData(counter2);
             }
 
           stringStream << value << separator;
@@ -477,3 +459,87 @@ int CTimeSeries::save(const std::string& fileName, bool writeParticleNumbers, co
   fileStream.close();
   return result;
 }
+
+CTimeSeriesRowIterator::CTimeSeriesRowIterator(const CTimeSeries & timeSeries):
+  mpTimeSeries(&timeSeries),
+  mStep(0),
+  mBlock(0),
+  mpRow(NULL),
+  mpBlockEnd(NULL)
+{
+  if (mpTimeSeries->mRecordedSteps > 0)
+    {
+      const CTimeSeriesStorage & Storage = mpTimeSeries->mStorage;
+
+      mpRow = Storage.getBlock(0);
+      mpBlockEnd = mpRow + Storage.getRowsPerBlock() * Storage.getColumns();
+    }
+}
+
+CTimeSeriesRowIterator::~CTimeSeriesRowIterator()
+{}
+
+bool CTimeSeriesRowIterator::isValid() const
+{
+  return mStep < mpTimeSeries->mRecordedSteps;
+}
+
+bool CTimeSeriesRowIterator::next()
+{
+  if (!isValid())
+    return false;
+
+  ++mStep;
+
+  if (!isValid())
+    return false;
+
+  const CTimeSeriesStorage & Storage = mpTimeSeries->mStorage;
+
+  mpRow += Storage.getColumns();
+
+  if (mpRow == mpBlockEnd)
+    {
+      mpRow = Storage.getBlock(++mBlock);
+      mpBlockEnd = mpRow + Storage.getRowsPerBlock() * Storage.getColumns();
+    }
+
+  return true;
+}
+
+const size_t & CTimeSeriesRowIterator::getStep() const
+{
+  return mStep;
+}
+
+C_FLOAT64 CTimeSeriesRowIterator::getData(const size_t & var) const
+{
+  if (isValid() && var < mpTimeSeries->mNumVariables)
+    return mpRow[mpTimeSeries->mPivot[var]];
+
+  return CTimeSeries::mDummyFloat;
+}
+
+C_FLOAT64 CTimeSeriesRowIterator::getConcentrationData(const size_t & var) const
+{
+  if (isValid() && var < mpTimeSeries->mNumVariables)
+    return mpTimeSeries->getRowConcentration(mpRow, var);
+
+  return CTimeSeries::mDummyFloat;
+}
+
+std::vector< C_FLOAT64 > CTimeSeriesRowIterator::getRow(const bool & concentrations) const
+{
+  std::vector< C_FLOAT64 > Row;
+
+  if (!isValid())
+    return Row;
+
+  size_t i, imax = mpTimeSeries->mNumVariables;
+  Row.resize(imax);
+
+  for (i = 0; i < imax; ++i)
+    Row[i] = concentrations ? getConcentrationData(i) : getData(i);
+
+  return Row;
+}
@@ -28,16 +28,18 @@
 #include <vector>
 #include <ostream>
 
-#include "copasi/core/CMatrix.h"
 #include "copasi/core/CVector.h"
 #include "copasi/model/CState.h"
 #include "copasi/output/COutputHandler.h"
+#include "copasi/trajectory/CTimeSeriesStorage.h"
 
 class CModel;
 class CDataModel;
 
-class CTimeSeries : public COutputInterface, protected CMatrix< C_FLOAT64 >
+class CTimeSeries : public COutputInterface
 {
+  friend class CTimeSeriesRowIterator;
+
 private:
   //since the assignment operator are not properly implemented
   //they should be inaccessible
@@ -101,6 +103,14 @@ public:
    */
   void increaseAllocation();
 
+  /**
+   * Spill the recorded steps exceeding the memory limit to a memory-mapped file in the
+   * given directory. An empty directory disables spilling. This must be set before compiling.
+   * @param const std::string & directory
+   * @param const size_t & memoryLimit (in bytes)
+   */
+  void setSpill(const std::string & directory, const size_t & memoryLimit);
+
   /**
    * Clear the time series
    */
@@ -182,6 +192,19 @@ public:
   std::string getSBMLId(const size_t & variable, const CDataModel* pDataModel) const;
 
 private:
+  /**
+   * Retrieve the data (concentration for species) for the given row and variable
+   * @param const C_FLOAT64 * pRow
+   * @param const size_t & variable
+   * @return C_FLOAT64 data
+   */
+  C_FLOAT64 getRowConcentration(const C_FLOAT64 * pRow,
+                                const size_t & variable) const;
+
+  /**
+   * The chunked storage of the recorded steps
+   */
+  CTimeSeriesStorage mStorage;
 
   /**
    * The number of allocated steps
@@ -198,16 +221,6 @@ private:
    */
   size_t mNumVariables;
 
-  /**
-   * Iterator pointing the next step (row) to be recorded
-   */
-  C_FLOAT64 * mpIt;
-
-  /**
-   * Iterator pointing beyond the last allocated step (row)
-   */
-  C_FLOAT64 * mpEnd;
-
   /**
    * A reference to the values of the math container
    */
@@ -250,4 +263,88 @@ private:
   static C_FLOAT64 mDummyFloat;
 };
 
+/**
+ * A row iterator streaming the recorded steps of a time series without random access.
+ * The iterator is invalidated when the time series is compiled or cleared.
+ */
+class CTimeSeriesRowIterator
+{
+public:
+  /**
+   * Specific constructor pointing to the first recorded step
+   * @param const CTimeSeries & timeSeries
+   */
+  CTimeSeriesRowIterator(const CTimeSeries & timeSeries);
+
+  /**
+   * Destructor
+   */
+  ~CTimeSeriesRowIterator();
+
+  /**
+   * Check whether the iterator points to a recorded step
+   * @return bool isValid
+   */
+  bool isValid() const;
+
+  /**
+   * Advance to the next recorded step
+   * @return bool isValid
+   */
+  bool next();
+
+  /**
+   * Retrieve the index of the current step
+   * @return const size_t & step
+   */
+  const size_t & getStep() const;
+
+  /**
+   * Retrieve the data (particle number for species) of the current step for the indexed variable
+   * @param const size_t & variable
+   * @return C_FLOAT64 data
+   */
+  C_FLOAT64 getData(const size_t & variable) const;
+
+  /**
+   * Retrieve the data (concentration for species) of the current step for the indexed variable
+   * @param const size_t & variable
+   * @return C_FLOAT64 data
+   */
+  C_FLOAT64 getConcentrationData(const size_t & variable) const;
+
+  /**
+   * Retrieve the data of all variables of the current step
+   * @param const bool & concentrations (default: false)
+   * @return std::vector< C_FLOAT64 > row
+   */
+  std::vector< C_FLOAT64 > getRow(const bool & concentrations = false) const;
+
+private:
+  /**
+   * The time series
+   */
+  const CTimeSeries * mpTimeSeries;
+
+  /**
+   * The index of the current step
+   */
+  size_t mStep;
+
+  /**
+   * The index of the block of the current step
+   */
+  size_t mBlock;
+
+  /**
+   * Pointer to the current row
+   */
+  const C_FLOAT64 * mpRow;
+
+  /**
+   * Pointer beyond the last row of the current block
+   */
+  const C_FLOAT64 * mpBlockEnd;
+};
+
 #endif
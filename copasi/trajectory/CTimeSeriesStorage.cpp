@@ -0,0 +1,259 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#include <string.h>
+#include <limits>
+#include <algorithm>
+
+#ifndef WIN32
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+#endif // WIN32
+
+#include "copasi/copasi.h"
+
+#include "copasi/trajectory/CTimeSeriesStorage.h"
+
+#include "copasi/commandline/CLocaleString.h"
+#include "copasi/utilities/CDirEntry.h"
+#include "copasi/utilities/CCopasiMessage.h"
+
+// The targeted size of a block in bytes
+#define BLOCK_BYTES 1048576
+
+CTimeSeriesStorage::CTimeSeriesStorage():
+  mColumns(0),
+  mRows(0),
+  mRowsPerBlock(1),
+  mBlocks(),
+  mpNext(NULL),
+  mpEnd(NULL),
+  mSpillDirectory(),
+  mMemoryLimit(std::numeric_limits< size_t >::max()),
+  mMemoryUsed(0),
+  mFileDescriptor(-1),
+  mFileSize(0),
+  mMappedBytes(0)
+{}
+
+CTimeSeriesStorage::CTimeSeriesStorage(const CTimeSeriesStorage & src):
+  mColumns(0),
+  mRows(0),
+  mRowsPerBlock(1),
+  mBlocks(),
+  mpNext(NULL),
+  mpEnd(NULL),
+  mSpillDirectory(src.mSpillDirectory),
+  mMemoryLimit(src.mMemoryLimit),
+  mMemoryUsed(0),
+  mFileDescriptor(-1),
+  mFileSize(0),
+  mMappedBytes(0)
+{
+  initialize(src.mColumns, src.mRowsPerBlock);
+
+  for (size_t i = 0; i < src.mRows; ++i)
+    {
+      C_FLOAT64 * pRow = appendRow();
+
+      if (pRow == NULL) break;
+
+      memcpy(pRow, src.getRow(i), mColumns * sizeof(C_FLOAT64));
+    }
+}
+
+CTimeSeriesStorage::~CTimeSeriesStorage()
+{
+  clear();
+}
+
+void CTimeSeriesStorage::setSpill(const std::string & directory, const size_t & memoryLimit)
+{
+  mSpillDirectory = directory;
+  mMemoryLimit = directory.empty() ? std::numeric_limits< size_t >::max() : memoryLimit;
+}
+
+void CTimeSeriesStorage::initialize(const size_t & columns, const size_t & expectedRows)
+{
+  clear();
+
+  mColumns = columns;
+
+  // Blocks hold a whole number of rows.
+  mRowsPerBlock = BLOCK_BYTES / std::max< size_t >(mColumns * sizeof(C_FLOAT64), 1);
+
+  if (mRowsPerBlock > expectedRows)
+    mRowsPerBlock = expectedRows;
+
+  if (mRowsPerBlock < 1)
+    mRowsPerBlock = 1;
+}
+
+void CTimeSeriesStorage::clear()
+{
+  std::vector< sBlock >::iterator it = mBlocks.begin();
+  std::vector< sBlock >::iterator end = mBlocks.end();
+
+  for (; it != end; ++it)
+    {
+#ifndef WIN32
+
+      if (it->Mapped)
+        {
+          munmap(it->pRows, mMappedBytes);
+          continue;
+        }
+
+#endif // WIN32
+
+      delete [] it->pRows;
+    }
+
+  mBlocks.clear();
+  closeSpillFile();
+
+  mRows = 0;
+  mMemoryUsed = 0;
+  mpNext = NULL;
+  mpEnd = NULL;
+}
+
+C_FLOAT64 * CTimeSeriesStorage::appendRow()
+{
+  if (mpNext == mpEnd &&
+      !allocateBlock())
+    {
+      return NULL;
+    }
+
+  C_FLOAT64 * pRow = mpNext;
+  mpNext += mColumns;
+  mRows++;
+
+  return pRow;
+}
+
+const C_FLOAT64 * CTimeSeriesStorage::getRow(const size_t & row) const
+{
+  return mBlocks[row / mRowsPerBlock].pRows + (row % mRowsPerBlock) * mColumns;
+}
+
+const size_t & CTimeSeriesStorage::getRows() const
+{
+  return mRows;
+}
+
+const size_t & CTimeSeriesStorage::getColumns() const
+{
+  return mColumns;
+}
+
+const size_t & CTimeSeriesStorage::getRowsPerBlock() const
+{
+  return mRowsPerBlock;
+}
+
+const C_FLOAT64 * CTimeSeriesStorage::getBlock(const size_t & block) const
+{
+  return mBlocks[block].pRows;
+}
+
+bool CTimeSeriesStorage::allocateBlock()
+{
+  size_t Size = mRowsPerBlock * mColumns;
+  sBlock Block;
+  Block.pRows = NULL;
+  Block.Mapped = false;
+
+  if (mMemoryUsed + Size * sizeof(C_FLOAT64) > mMemoryLimit)
+    {
+      Block.pRows = mapBlock();
+      Block.Mapped = (Block.pRows != NULL);
+    }
+
+  // We fall back to memory if the block cannot be mapped.
+  if (Block.pRows == NULL)
+    {
+      try
+        {
+          Block.pRows = new C_FLOAT64[std::max< size_t >(Size, 1)];
+        }
+
+      catch (...)
+        {
+          return false;
+        }
+
+      mMemoryUsed += Size * sizeof(C_FLOAT64);
+    }
+
+  mBlocks.push_back(Block);
+  mpNext = Block.pRows;
+  mpEnd = Block.pRows + Size;
+
+  return true;
+}
+
+C_FLOAT64 * CTimeSeriesStorage::mapBlock()
+{
+#ifdef WIN32
+  return NULL;
+#else
+
+  if (mFileDescriptor == -1)
+    {
+      std::string FileName = CDirEntry::createTmpName(mSpillDirectory, ".data");
+
+      if (FileName.empty())
+        {
+          CCopasiMessage(CCopasiMessage::WARNING, "Cannot create a spill file for the time series in: %s", mSpillDirectory.c_str());
+          mSpillDirectory.clear();
+          mMemoryLimit = std::numeric_limits< size_t >::max();
+          return NULL;
+        }
+
+      mFileDescriptor = open(CLocaleString::fromUtf8(FileName).c_str(), O_RDWR);
+
+      // The file is removed once it is closed.
+      CDirEntry::remove(FileName);
+
+      if (mFileDescriptor == -1)
+        return NULL;
+
+      size_t PageSize = sysconf(_SC_PAGESIZE);
+      mMappedBytes = ((mRowsPerBlock * mColumns * sizeof(C_FLOAT64) + PageSize - 1) / PageSize) * PageSize;
+      mFileSize = 0;
+    }
+
+  if (ftruncate(mFileDescriptor, mFileSize + mMappedBytes) != 0)
+    return NULL;
+
+  void * pBlock = mmap(NULL, mMappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, mFileDescriptor, mFileSize);
+
+  if (pBlock == MAP_FAILED)
+    return NULL;
+
+  mFileSize += mMappedBytes;
+
+  return static_cast< C_FLOAT64 * >(pBlock);
+#endif // WIN32
+}
+
+void CTimeSeriesStorage::closeSpillFile()
+{
+#ifndef WIN32
+
+  if (mFileDescriptor != -1)
+    {
+      close(mFileDescriptor);
+    }
+
+#endif // WIN32
+
+  mFileDescriptor = -1;
+  mFileSize = 0;
+  mMappedBytes = 0;
+}
@@ -0,0 +1,190 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#ifndef COPASI_CTimeSeriesStorage
+#define COPASI_CTimeSeriesStorage
+
+#include <vector>
+#include <string>
+
+/**
+ * The storage of the rows of a time series. Rows are appended to a list of fixed-size
+ * blocks, i.e., growing the storage never copies recorded rows and pointers to rows stay
+ * valid until the storage is cleared.
+ *
+ * Optionally, blocks exceeding a memory limit are spilled to a memory-mapped temporary
+ * file in a given directory. The file is removed when the storage is cleared or destroyed.
+ * Memory mapping is not supported on Windows, where all blocks are kept in memory.
+ */
+class CTimeSeriesStorage
+{
+private:
+  struct sBlock
+  {
+    C_FLOAT64 * pRows;
+    bool Mapped;
+  };
+
+  /**
+   * Hidden assignment operator
+   */
+  CTimeSeriesStorage & operator = (const CTimeSeriesStorage & rhs);
+
+public:
+  /**
+   * Default constructor
+   */
+  CTimeSeriesStorage();
+
+  /**
+   * Copy constructor. The copy uses its own spill file.
+   * @param const CTimeSeriesStorage & src
+   */
+  CTimeSeriesStorage(const CTimeSeriesStorage & src);
+
+  /**
+   * Destructor
+   */
+  ~CTimeSeriesStorage();
+
+  /**
+   * Set the directory and the memory limit for spilling blocks to a memory-mapped file.
+   * An empty directory disables spilling. The setting applies to blocks allocated afterwards.
+   * @param const std::string & directory
+   * @param const size_t & memoryLimit (in bytes)
+   */
+  void setSpill(const std::string & directory, const size_t & memoryLimit);
+
+  /**
+   * Clear the storage and set the number of columns. The expected number of rows
+   * limits the size of the blocks.
+   * @param const size_t & columns
+   * @param const size_t & expectedRows
+   */
+  void initialize(const size_t & columns, const size_t & expectedRows);
+
+  /**
+   * Remove all rows and release all blocks
+   */
+  void clear();
+
+  /**
+   * Append a row to the storage
+   * @return C_FLOAT64 * pRow (NULL if no block can be allocated)
+   */
+  C_FLOAT64 * appendRow();
+
+  /**
+   * Retrieve the indexed row
+   * @param const size_t & row
+   * @return const C_FLOAT64 * pRow
+   */
+  const C_FLOAT64 * getRow(const size_t & row) const;
+
+  /**
+   * Retrieve the number of rows
+   * @return const size_t & rows
+   */
+  const size_t & getRows() const;
+
+  /**
+   * Retrieve the number of columns
+   * @return const size_t & columns
+   */
+  const size_t & getColumns() const;
+
+  /**
+   * Retrieve the number of rows per block
+   * @return const size_t & rowsPerBlock
+   */
+  const size_t & getRowsPerBlock() const;
+
+  /**
+   * Retrieve the first row of the indexed block
+   * @param const size_t & block
+   * @return const C_FLOAT64 * pRows
+   */
+  const C_FLOAT64 * getBlock(const size_t & block) const;
+
+private:
+  /**
+   * Allocate a new block, which is mapped if the memory limit is reached
+   * @return bool success
+   */
+  bool allocateBlock();
+
+  /**
+   * Map a new block into the spill file
+   * @return C_FLOAT64 * pRows (NULL on failure)
+   */
+  C_FLOAT64 * mapBlock();
+
+  /**
+   * Close and remove the spill file
+   */
+  void closeSpillFile();
+
+  /**
+   * The number of columns
+   */
+  size_t mColumns;
+
+  /**
+   * The number of recorded rows
+   */
+  size_t mRows;
+
+  /**
+   * The number of rows per block
+   */
+  size_t mRowsPerBlock;
+
+  /**
+   * The blocks
+   */
+  std::vector< sBlock > mBlocks;
+
+  /**
+   * Pointer to the next row of the last block
+   */
+  C_FLOAT64 * mpNext;
+
+  /**
+   * Pointer beyond the last row of the last block
+   */
+  C_FLOAT64 * mpEnd;
+
+  /**
+   * The directory of the spill file (empty if spilling is disabled)
+   */
+  std::string mSpillDirectory;
+
+  /**
+   * The memory limit in bytes above which blocks are spilled
+   */
+  size_t mMemoryLimit;
+
+  /**
+   * The number of bytes of blocks kept in memory
+   */
+  size_t mMemoryUsed;
+
+  /**
+   * The file descriptor of the spill file (-1 if not open)
+   */
+  int mFileDescriptor;
+
+  /**
+   * The size of the spill file
+   */
+  size_t mFileSize;
+
+  /**
+   * The number of bytes of a mapped block, which is a multiple of the page size
+   */
+  size_t mMappedBytes;
+};
+
+#endif // COPASI_CTimeSeriesStorage
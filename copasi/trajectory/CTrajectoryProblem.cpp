@@ -43,6 +43,7 @@
 #include "copasi/CopasiDataModel/CDataModel.h"
 #include "copasi/core/CRootContainer.h"
 #include "copasi/utilities/CParameterEstimationUtils.h"
+#include "copasi/output/COutputReduction.h"
 
 //this constructor is only used by derived classes to provide a different task type
 CTrajectoryProblem::CTrajectoryProblem(const CTaskEnum::Task & type,
@@ -58,6 +59,8 @@ CTrajectoryProblem::CTrajectoryProblem(const CTaskEnum::Task & type,
   mpStartInSteadyState(NULL),
   mpUseValues(NULL),
   mpValueString(NULL),
+  mpUseCompiledModel(NULL),
+  mpEnsembleSize(NULL),
   mStepNumberSetLast(true)
 {
   initializeParameter();
@@ -80,6 +83,8 @@ CTrajectoryProblem::CTrajectoryProblem(const CDataContainer * pParent):
   mpStartInSteadyState(NULL),
   mpUseValues(NULL),
   mpValueString(NULL),
+  mpUseCompiledModel(NULL),
+  mpEnsembleSize(NULL),
   mStepNumberSetLast(true)
 {
   initializeParameter();
@@ -104,6 +109,8 @@ CTrajectoryProblem::CTrajectoryProblem(const CTrajectoryProblem & src,
   mpStartInSteadyState(NULL),
   mpUseValues(NULL),
   mpValueString(NULL),
+  mpUseCompiledModel(NULL),
+  mpEnsembleSize(NULL),
   mStepNumberSetLast(src.mStepNumberSetLast)
 {
   initializeParameter();
@@ -129,6 +136,17 @@ void CTrajectoryProblem::initializeParameter()
   mpStartInSteadyState = assertParameter("Start in Steady State", CCopasiParameter::Type::BOOL, false);
   mpUseValues = assertParameter("Use Values", CCopasiParameter::Type::BOOL, false);
   mpValueString = assertParameter("Values", CCopasiParameter::Type::STRING, std::string(""));
+  mpUseCompiledModel = assertParameter("Use Compiled Model", CCopasiParameter::Type::BOOL, false);
+  mpEnsembleSize = assertParameter("Ensemble Size", CCopasiParameter::Type::UINT, (unsigned C_INT32) 1);
+
+  // The output reduction is applied to plots, reports, and the time series by the task.
+  assertParameter("Output Reduction", CCopasiParameter::Type::STRING, COutputReduction::ModeName[COutputReduction::None]);
+  CCopasiParameter * pParm = getParameter("Output Reduction");
+
+  if (pParm != NULL)
+    pParm->setValidValues(COutputReduction::ModeName);
+
+  assertParameter("Output Reduction Parameter", CCopasiParameter::Type::UDOUBLE, (C_FLOAT64) 10.0);
 }
 
 bool CTrajectoryProblem::elevateChildren()
@@ -407,3 +425,23 @@ bool CTrajectoryProblem::getUseValues() const
 {
   return *mpUseValues;
 }
+
+void CTrajectoryProblem::setUseCompiledModel(const bool & useCompiledModel)
+{
+  *mpUseCompiledModel = useCompiledModel;
+}
+
+const bool & CTrajectoryProblem::getUseCompiledModel() const
+{
+  return *mpUseCompiledModel;
+}
+
+void CTrajectoryProblem::setEnsembleSize(const unsigned C_INT32 & ensembleSize)
+{
+  *mpEnsembleSize = ensembleSize;
+}
+
+const unsigned C_INT32 & CTrajectoryProblem::getEnsembleSize() const
+{
+  return *mpEnsembleSize;
+}
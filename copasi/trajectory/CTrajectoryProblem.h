@@ -172,6 +172,31 @@ public:
   void setUseValues(bool flag);
   bool getUseValues() const;
 
+  /**
+   * Set whether the model is compiled to native code (see CMathNativeCode).
+   * @param const bool & useCompiledModel
+   */
+  void setUseCompiledModel(const bool & useCompiledModel);
+
+  /**
+   * Retrieve whether the model is compiled to native code.
+   * @return const bool & useCompiledModel
+   */
+  const bool & getUseCompiledModel() const;
+
+  /**
+   * Set the number of realizations of a stochastic ensemble. Ensembles are only
+   * calculated for sizes larger than 1 (see CStochasticEnsemble).
+   * @param const unsigned C_INT32 & ensembleSize
+   */
+  void setEnsembleSize(const unsigned C_INT32 & ensembleSize);
+
+  /**
+   * Retrieve the number of realizations of a stochastic ensemble.
+   * @return const unsigned C_INT32 & ensembleSize
+   */
+  const unsigned C_INT32 & getEnsembleSize() const;
+
   /**
    * Load a trajectory problem
    * @param "CReadConfig &" configBuffer
@@ -252,6 +277,16 @@ protected:
    */
   std::string* mpValueString;
 
+  /**
+   * Indicates whether the model is compiled to native code
+   */
+  bool * mpUseCompiledModel;
+
+  /**
+   * Pointer to parameter value for the number of realizations of a stochastic ensemble
+   */
+  unsigned C_INT32 * mpEnsembleSize;
+
   /**
    *  Indicate whether the step number or step size was set last.
    */
@@ -40,11 +40,13 @@
 #include "CTrajectoryTask.h"
 #include "CTrajectoryProblem.h"
 #include "CTrajectoryMethod.h"
+#include "CStochasticEnsemble.h"
 #include "copasi/math/CMathContainer.h"
 #include "copasi/model/CModel.h"
 #include "copasi/model/CModel.h"
 #include "copasi/model/CState.h"
 #include "copasi/report/CKeyFactory.h"
+#include "copasi/randomGenerator/CRandom.h"
 #include "copasi/report/CReport.h"
 #include "copasi/utilities/CProcessReport.h"
 #include "copasi/utilities/CCopasiException.h"
@@ -72,7 +74,9 @@ const CTaskEnum::Method CTrajectoryTask::ValidMethods[] =
   CTaskEnum::Method::RADAU5,
   CTaskEnum::Method::stochastic,
   CTaskEnum::Method::directMethod,
+  CTaskEnum::Method::logarithmicDirectMethod,
   CTaskEnum::Method::tauLeap,
+  CTaskEnum::Method::tauLeapCGP,
   CTaskEnum::Method::adaptiveSA,
   CTaskEnum::Method::hybrid,
   CTaskEnum::Method::hybridLSODA,
@@ -98,6 +102,7 @@ CTrajectoryTask::CTrajectoryTask(const CDataContainer * pParent,
   mOutputStartTime(0.0),
   mpLessOrEqual(&fle),
   mpLess(&fl),
+  mpEnsemble(NULL),
   mProceed(true)
 {
   mpProblem = new CTrajectoryProblem(this);
@@ -123,6 +128,7 @@ CTrajectoryTask::CTrajectoryTask(const CTrajectoryTask & src,
   mOutputStartTime(0.0),
   mpLessOrEqual(src.mpLessOrEqual),
   mpLess(src.mpLess),
+  mpEnsemble(NULL),
   mProceed(src.mProceed)
 {
   mpProblem =
@@ -146,7 +152,9 @@ CTrajectoryTask::~CTrajectoryTask()
 }
 
 void CTrajectoryTask::cleanup()
-{}
+{
+  pdelete(mpEnsemble);
+}
 
 void CTrajectoryTask::load(CReadConfig & configBuffer)
 {
@@ -198,6 +206,22 @@ bool CTrajectoryTask::initialize(const OutputFlag & of,
       mTimeSeries.clear();
     }
 
+  if (mpTrajectoryProblem->getEnsembleSize() > 1)
+    {
+      if (!CStochasticEnsemble::isSupportedMethod(mpMethod->getSubType()))
+        {
+          CCopasiMessage(CCopasiMessage::ERROR, "Ensembles are not supported by the method '%s'.",
+                         CTaskEnum::MethodName[mpMethod->getSubType()].c_str());
+          success = false;
+        }
+
+      if (mpTrajectoryProblem->getStartInSteadyState())
+        {
+          CCopasiMessage(CCopasiMessage::ERROR, "Ensembles can not start in a steady state.");
+          success = false;
+        }
+    }
+
   mpSteadyState = NULL;
 
   if (mpTrajectoryProblem->getStartInSteadyState())
@@ -211,6 +235,9 @@ bool CTrajectoryTask::initialize(const OutputFlag & of,
         mpSteadyState->initialize(of, NULL, NULL);
     }
 
+  // This must be done after the steady state is initialized since it shares the container.
+  mpContainer->setUseNativeCode(mpTrajectoryProblem->getUseCompiledModel());
+
   success &= CCopasiTask::initialize(of, pOutputHandler, pOstream);
 
   signalMathContainerChanged();
@@ -218,6 +245,19 @@ bool CTrajectoryTask::initialize(const OutputFlag & of,
   return success;
 }
 
+// virtual
+bool CTrajectoryTask::restore()
+{
+  bool success = CCopasiTask::restore();
+
+  if (mpContainer != NULL)
+    {
+      mpContainer->setUseNativeCode(false);
+    }
+
+  return success;
+}
+
 // virtual
 void CTrajectoryTask::signalMathContainerChanged()
 {
@@ -235,6 +275,9 @@ void CTrajectoryTask::signalMathContainerChanged()
 
 bool CTrajectoryTask::process(const bool& useInitialValues)
 {
+  if (mpTrajectoryProblem->getEnsembleSize() > 1)
+    return processEnsemble(useInitialValues);
+
   if (mpTrajectoryProblem->getUseValues())
     return processValues(useInitialValues);
 
@@ -543,6 +586,121 @@ bool CTrajectoryTask::processValues(const bool& useInitialValues)
   return true;
 }
 
+bool CTrajectoryTask::processEnsemble(const bool & useInitialValues)
+{
+  mProceed = true;
+
+  // All realizations start from the state established here.
+  processStart(useInitialValues);
+
+  const C_FLOAT64 StartTime = *mpContainerStateTime;
+  std::vector< C_FLOAT64 > Times;
+  Times.push_back(StartTime);
+
+  if (mpTrajectoryProblem->getUseValues())
+    {
+      std::set< C_FLOAT64 > Values = mpTrajectoryProblem->getValues();
+
+      if (Values.empty())
+        {
+          CCopasiMessage(CCopasiMessage::ERROR, MCTrajectoryProblem + 32);
+          return false;
+        }
+
+      // We silently ignore values in the past
+      std::set< C_FLOAT64 >::const_iterator it = Values.upper_bound(StartTime);
+      std::set< C_FLOAT64 >::const_iterator end = Values.end();
+
+      for (; it != end; ++it)
+        Times.push_back(*it);
+    }
+  else
+    {
+      C_FLOAT64 Duration = mpTrajectoryProblem->getDuration();
+      C_FLOAT64 StepSize = mpTrajectoryProblem->getStepSize();
+      C_FLOAT64 StepNumber = fabs(Duration) / StepSize;
+
+      if (mpTrajectoryProblem->getAutomaticStepSize() ||
+          std::isnan(StepNumber) ||
+          StepNumber < 1.0)
+        {
+          StepNumber = 1.0;
+        }
+
+      if (StepSize == 0.0 && Duration != 0.0)
+        {
+          CCopasiMessage(CCopasiMessage::ERROR, MCTrajectoryProblem + 1, StepSize);
+          return false;
+        }
+
+      size_t Steps = (size_t) ceil(StepNumber);
+
+      // This is numerically more stable then adding the step size.
+      for (size_t i = 1; i < Steps; ++i)
+        Times.push_back(StartTime + Duration * i / StepNumber);
+
+      Times.push_back(StartTime + Duration);
+    }
+
+  //the output starts only after "outputStartTime" has passed
+  if (useInitialValues)
+    mOutputStartTime = mpTrajectoryProblem->getOutputStartTime();
+  else
+    mOutputStartTime = StartTime + mpTrajectoryProblem->getOutputStartTime();
+
+  mpLessOrEqual = &fle;
+  mpLess = &fl;
+
+  // The seed of the ensemble is the seed of the method if requested.
+  unsigned C_INT32 Seed = CRandom::getSystemSeed();
+
+  if (mpMethod->getParameter("Use Random Seed") != NULL &&
+      mpMethod->getValue< bool >("Use Random Seed"))
+    {
+      Seed = mpMethod->getValue< unsigned C_INT32 >("Random Seed");
+    }
+
+  if (mpEnsemble == NULL)
+    mpEnsemble = new CStochasticEnsemble();
+
+  output(COutputInterface::BEFORE);
+
+  if (mpCallBack != NULL)
+    mpCallBack->setName("performing ensemble simulation...");
+
+  bool success = mpEnsemble->calculate(*this, mpTrajectoryProblem->getEnsembleSize(), Seed, Times, mpCallBack);
+
+  if (mpEnsemble->getFailedRealizations() > 0)
+    {
+      CCopasiMessage(CCopasiMessage::WARNING, "%d of %d realizations failed and are not part of the ensemble statistics.",
+                     (int) mpEnsemble->getFailedRealizations(), (int) mpTrajectoryProblem->getEnsembleSize());
+    }
+
+  // The mean trajectory is reported as the result of the task.
+  if (mpEnsemble->getRealizations() > 0)
+    {
+      const CMatrix< C_FLOAT64 > & Mean = mpEnsemble->getMean();
+      CVectorCore< C_FLOAT64 > State;
+
+      for (size_t i = 0; i < Mean.numRows(); ++i)
+        {
+          if (!(*mpLessOrEqual)(mOutputStartTime, Times[i])) continue;
+
+          State.initialize(Mean.numCols(), const_cast< C_FLOAT64 * >(Mean[i]));
+          mpContainer->setState(State);
+          mpContainer->updateSimulatedValues(false);
+          mpContainer->updateTransientDataValues();
+          mpContainer->pushAllTransientValues();
+
+          output(COutputInterface::DURING);
+        }
+    }
+
+  output(COutputInterface::AFTER);
+
+  return success;
+}
+
 void CTrajectoryTask::processStart(const bool & useInitialValues)
 {
   mContainerState.initialize(mpContainer->getState(mUpdateMoieties));
@@ -733,3 +891,6 @@ void CTrajectoryTask::signalMethodChanged()
 
 const CTimeSeries & CTrajectoryTask::getTimeSeries() const
 {return mTimeSeries;}
+
+const CStochasticEnsemble * CTrajectoryTask::getEnsemble() const
+{return mpEnsemble;}
@@ -44,9 +44,12 @@ class CTrajectoryProblem;
 class CTrajectoryMethod;
 class CMathContainer;
 class CSteadyStateTask;
+class CStochasticEnsemble;
 
 class CTrajectoryTask : public CCopasiTask
 {
+  friend class CStochasticEnsemble;
+
 public:
   static const CTaskEnum::Method ValidMethods[];
 
@@ -98,10 +101,22 @@ public:
    */
   virtual bool process(const bool & useInitialValues);
 
+  /**
+   * Perform necessary cleanup procedures
+   */
+  virtual bool restore();
+
   virtual bool processTrajectory(const bool& useInitialValues);
 
   virtual bool processValues(const bool& useInitialValues);
 
+  /**
+   * Calculate an ensemble of stochastic realizations and output the mean trajectory
+   * @param const bool & useInitialValues
+   * @return bool success
+   */
+  virtual bool processEnsemble(const bool & useInitialValues);
+
   /**
    * Starts the process of integration by calling CTrajectoryMethod::start
    * @param const bool & useInitialValues
@@ -138,6 +153,12 @@ public:
    */
   const CTimeSeries & getTimeSeries() const;
 
+  /**
+   * Retrieve the statistics of the last calculated stochastic ensemble
+   * @return const CStochasticEnsemble * pEnsemble (NULL if no ensemble was calculated)
+   */
+  const CStochasticEnsemble * getEnsemble() const;
+
 protected:
   /**
    * Signal that the math container has changed
@@ -213,6 +234,11 @@ protected:
    */
   bool (*mpLess)(const C_FLOAT64 &, const C_FLOAT64 &);
 
+  /**
+   * The statistics of the last calculated stochastic ensemble
+   */
+  CStochasticEnsemble * mpEnsemble;
+
 protected:
   /**
    * A Boolean flag indication whether to proceed with the integration
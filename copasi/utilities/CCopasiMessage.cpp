@@ -82,8 +82,19 @@ CCopasiMessage CCopasiMessage::getFirstMessage()
     CCopasiMessage(CCopasiMessage::RAW,
                    MCCopasiMessage + 1);
 
-  CCopasiMessage Message(mMessageDeque.front());
-  mMessageDeque.pop_front();
+  CCopasiMessage Message;
+
+#ifdef USE_OMP
+#pragma omp critical (CCopasiMessage_Deque)
+#endif // USE_OMP
+  {
+    // Another thread may have retrieved the message in the meantime.
+    if (!mMessageDeque.empty())
+      {
+        Message = mMessageDeque.front();
+        mMessageDeque.pop_front();
+      }
+  }
 
   return Message;
 }
@@ -94,8 +105,19 @@ CCopasiMessage CCopasiMessage::getLastMessage()
     CCopasiMessage(CCopasiMessage::RAW,
                    MCCopasiMessage + 1);
 
-  CCopasiMessage Message(mMessageDeque.back());
-  mMessageDeque.pop_back();
+  CCopasiMessage Message;
+
+#ifdef USE_OMP
+#pragma omp critical (CCopasiMessage_Deque)
+#endif // USE_OMP
+  {
+    // Another thread may have retrieved the message in the meantime.
+    if (!mMessageDeque.empty())
+      {
+        Message = mMessageDeque.back();
+        mMessageDeque.pop_back();
+      }
+  }
 
   return Message;
 }
@@ -117,6 +139,9 @@ std::string CCopasiMessage::getAllMessageText(const bool & chronological)
 
 void CCopasiMessage::clearDeque()
 {
+#ifdef USE_OMP
+#pragma omp critical (CCopasiMessage_Deque)
+#endif // USE_OMP
   mMessageDeque.clear();
   return;
 }
@@ -335,12 +360,18 @@ void CCopasiMessage::handler(const bool & /* _throw */)
 
   if (mType != RAW) lineBreak();
 
-  // Remove the message: No more messages.
-  if (mMessageDeque.size() == 1 &&
-      mMessageDeque.back().getNumber() == MCCopasiMessage + 1)
-    getLastMessage();
-
-  mMessageDeque.push_back(*this);
+  // Messages may be created concurrently by parallel evaluations.
+#ifdef USE_OMP
+#pragma omp critical (CCopasiMessage_Deque)
+#endif // USE_OMP
+  {
+    // Remove the message: No more messages.
+    if (mMessageDeque.size() == 1 &&
+        mMessageDeque.back().getNumber() == MCCopasiMessage + 1)
+      mMessageDeque.pop_back();
+
+    mMessageDeque.push_back(*this);
+  }
 
   // All messages are printed to std::cerr
   if (COptions::compareValue("Verbose", true) &&
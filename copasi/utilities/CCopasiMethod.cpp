@@ -54,6 +54,7 @@
 #include "copasi/optimization/COptMethodGASR.h"
 #include "copasi/optimization/COptMethodHookeJeeves.h"
 #include "copasi/optimization/COptMethodLevenbergMarquardt.h"
+#include "copasi/optimization/COptMethodMultiStart.h"
 #include "copasi/optimization/COptMethodNelderMead.h"
 #include "copasi/optimization/COptMethodPS.h"
 #include "copasi/optimization/COptMethodPraxis.h"
@@ -76,11 +77,13 @@
 #include "copasi/trajectory/CLsodaMethod.h"
 #include "copasi/trajectory/CRadau5Method.h"
 #include "copasi/trajectory/CStochDirectMethod.h"
+#include "copasi/trajectory/CStochLogDirectMethod.h"
 // #include "copasi/trajectory/CStochMethod.h"
 #include "copasi/trajectory/CHybridNextReactionRKMethod.h"
 #include "copasi/trajectory/CHybridNextReactionLSODAMethod.h"
 #include "copasi/trajectory/CStochNextReactionMethod.h"
 #include "copasi/trajectory/CTauLeapMethod.h"
+#include "copasi/trajectory/CTauLeapCGPMethod.h"
 #include "copasi/trajectory/CTrajAdaptiveSA.h"
 #include "copasi/trajectory/CTrajectoryMethodDsaLsodar.h"
 #include "copasi/trajectory/CStochasticRungeKuttaRI5.h"
@@ -123,6 +126,10 @@ CCopasiMethod * CCopasiMethod::createMethod(const CDataContainer * pParent,
         pMethod = new COptMethodSS(pParent, methodType, taskType);
         break;
 
+      case CTaskEnum::Method::MultiStart:
+        pMethod = new COptMethodMultiStart(pParent, methodType, taskType);
+        break;
+
       case CTaskEnum::Method::GeneticAlgorithm:
         pMethod = new COptMethodGA(pParent, methodType, taskType);
         break;
@@ -191,6 +198,10 @@ CCopasiMethod * CCopasiMethod::createMethod(const CDataContainer * pParent,
         pMethod = new CStochDirectMethod(pParent, methodType, taskType);
         break;
 
+      case CTaskEnum::Method::logarithmicDirectMethod:
+        pMethod = new CStochLogDirectMethod(pParent, methodType, taskType);
+        break;
+
       case CTaskEnum::Method::stochastic:
         pMethod = new CStochNextReactionMethod(pParent, methodType, taskType);
         break;
@@ -199,6 +210,10 @@ CCopasiMethod * CCopasiMethod::createMethod(const CDataContainer * pParent,
         pMethod = new CTauLeapMethod(pParent, methodType, taskType);
         break;
 
+      case CTaskEnum::Method::tauLeapCGP:
+        pMethod = new CTauLeapCGPMethod(pParent, methodType, taskType);
+        break;
+
       case CTaskEnum::Method::adaptiveSA:
         pMethod = new CTrajAdaptiveSA(pParent, methodType, taskType);
         break;
@@ -284,6 +299,7 @@ CCopasiMethod * CCopasiMethod::createMethod(const CDataContainer * pParent,
         break;
 
       case CTaskEnum::Method::timeSensLsoda:
+      case CTaskEnum::Method::timeSensLsodaAnalytic:
         pMethod = new CTimeSensLsodaMethod(pParent, methodType, taskType);
         break;
     }
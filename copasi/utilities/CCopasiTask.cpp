@@ -39,6 +39,7 @@
 #include "copasi/report/CReport.h"
 #include "copasi/report/CKeyFactory.h"
 #include "copasi/output/COutputHandler.h"
+#include "copasi/output/COutputReduction.h"
 #include "copasi/math/CMathContainer.h"
 #include "copasi/model/CModel.h"
 #include "copasi/model/CState.h"
@@ -246,6 +247,7 @@ CCopasiTask::CCopasiTask()
   , mDoOutput(OUTPUT_SE)
   , mpOutputHandler(NULL)
   , mOutputCounter(0)
+  , mpOutputReduction(NULL)
 {
   initObjects();
 }
@@ -271,6 +273,7 @@ CCopasiTask::CCopasiTask(const CDataContainer * pParent,
   , mDoOutput(OUTPUT_SE)
   , mpOutputHandler(NULL)
   , mOutputCounter(0)
+  , mpOutputReduction(NULL)
 {
   initObjects();
 }
@@ -295,6 +298,7 @@ CCopasiTask::CCopasiTask(const CCopasiTask & src,
   , mDoOutput(src.mDoOutput)
   , mpOutputHandler(NULL)
   , mOutputCounter(0)
+  , mpOutputReduction(NULL)
 {
   initObjects();
 }
@@ -303,6 +307,7 @@ CCopasiTask::~CCopasiTask()
 {
   CRootContainer::getKeyFactory()->remove(mKey);
 
+  removeOutputReduction();
   pdelete(mpProblem);
   pdelete(mpMethod);
   pdelete(mpSliders);
@@ -441,6 +446,8 @@ bool CCopasiTask::initialize(const OutputFlag & of,
       mInitialState.resize(0);
     }
 
+  removeOutputReduction();
+
   mDoOutput = of;
   mpOutputHandler = pOutputHandler;
 
@@ -458,6 +465,8 @@ bool CCopasiTask::initialize(const OutputFlag & of,
         CCopasiMessage(CCopasiMessage::COMMANDLINE, MCCopasiTask + 5, getObjectName().c_str());
     }
 
+  insertOutputReduction();
+
   CObjectInterface::ContainerList ListOfContainer;
   ListOfContainer.push_back(this);
 
@@ -513,9 +522,61 @@ bool CCopasiTask::restore()
 
   mpProblem->restore(mUpdateModel);
 
+  removeOutputReduction();
+
   return true;
 }
 
+void CCopasiTask::insertOutputReduction()
+{
+  const CCopasiParameter * pMode = mpProblem->getParameter("Output Reduction");
+  const CCopasiParameter * pParameter = mpProblem->getParameter("Output Reduction Parameter");
+
+  if (pMode == NULL ||
+      pParameter == NULL ||
+      !(mDoOutput & INITIALIZE) ||
+      !(mDoOutput & (REPORT | PLOT)))
+    return;
+
+  COutputReduction::Mode Mode = COutputReduction::ModeName.toEnum(pMode->getValue< std::string >(), COutputReduction::None);
+
+  if (Mode == COutputReduction::None)
+    return;
+
+  mpOutputReduction = new COutputReduction(Mode, pParameter->getValue< C_FLOAT64 >());
+
+  // Invalid parameters disable the reduction.
+  if (mpOutputReduction->getMode() == COutputReduction::None)
+    {
+      pdelete(mpOutputReduction);
+      return;
+    }
+
+  // All interfaces of the handler, i.e., plots, reports, and time series, receive the reduced output.
+  mpOutputReduction->addInterface(mpOutputHandler);
+  mpOutputHandler = mpOutputReduction;
+}
+
+void CCopasiTask::removeOutputReduction()
+{
+  if (mpOutputReduction == NULL) return;
+
+  std::set< COutputInterface * > Interfaces = mpOutputReduction->getInterfaces();
+  std::set< COutputInterface * >::iterator it = Interfaces.begin();
+  std::set< COutputInterface * >::iterator end = Interfaces.end();
+
+  for (; it != end; ++it)
+    {
+      // This makes the original handler its own master again.
+      mpOutputReduction->removeInterface(*it);
+
+      if (mpOutputHandler == mpOutputReduction)
+        mpOutputHandler = static_cast< COutputHandler * >(*it);
+    }
+
+  pdelete(mpOutputReduction);
+}
+
 // virtual
 const CTaskEnum::Method * CCopasiTask::getValidMethods() const
 {
@@ -46,6 +46,7 @@ class CCopasiProblem;
 class CCopasiMethod;
 class CCopasiParameterGroup;
 class CProcessReport;
+class COutputReduction;
 
 class CCopasiTask : public CDataContainer
 {
@@ -347,6 +348,21 @@ public:
    */
   virtual bool restore();
 
+private:
+  /**
+   * Insert an output reduction in front of the output handler if the problem
+   * requests it through the parameters "Output Reduction" and "Output Reduction Parameter".
+   * Only tasks which own their output, i.e., not subtasks, reduce the output.
+   */
+  void insertOutputReduction();
+
+  /**
+   * Remove the output reduction and restore the original output handler
+   */
+  void removeOutputReduction();
+
+public:
+
 #ifndef SWIG
 
   /**
@@ -533,6 +549,11 @@ protected:
   COutputHandler * mpOutputHandler;
   unsigned C_INT32 mOutputCounter;
 
+  /**
+   * The output reduction in front of the output handler if requested by the problem
+   */
+  COutputReduction * mpOutputReduction;
+
 #ifndef SWIG
   // used by language bindings to hold last process warnings / errors
   //   however, swig stumbles over this if it sees it here
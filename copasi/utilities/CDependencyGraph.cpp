@@ -51,7 +51,11 @@ const std::set <size_t> & CDependencyGraphNode::getDependents() const
 }
 
 // dependency graph
-CDependencyGraph::CDependencyGraph() {}
+CDependencyGraph::CDependencyGraph():
+  mNodes(),
+  mFrozenOffsets(),
+  mFrozenDependents()
+{}
 CDependencyGraph::~CDependencyGraph() {}
 
 void CDependencyGraph::addNode(const size_t & node)
@@ -65,12 +69,16 @@ void CDependencyGraph::addNode(const size_t & node)
 void CDependencyGraph::resize(const size_t & n)
 {
   mNodes.resize(n);
+  mFrozenOffsets.clear();
+  mFrozenDependents.clear();
 }
 
 void CDependencyGraph::addDependent(const size_t & node, const size_t & dependent)
 {
   //addNode(node);
   mNodes[node].addDependent(dependent);
+  mFrozenOffsets.clear();
+  mFrozenDependents.clear();
 }
 
 const std::set <size_t> & CDependencyGraph::getDependents(const size_t & node) const
@@ -86,7 +94,34 @@ const std::set <size_t> & CDependencyGraph::getDependents(const size_t & node) c
 }
 
 void CDependencyGraph::clear()
-{mNodes.clear();}
+{
+  mNodes.clear();
+  mFrozenOffsets.clear();
+  mFrozenDependents.clear();
+}
+
+void CDependencyGraph::freeze()
+{
+  mFrozenOffsets.resize(mNodes.size() + 1);
+  mFrozenDependents.clear();
+
+  std::vector< CDependencyGraphNode >::const_iterator it = mNodes.begin();
+  std::vector< CDependencyGraphNode >::const_iterator end = mNodes.end();
+  std::vector< size_t >::iterator itOffset = mFrozenOffsets.begin();
+
+  for (; it != end; ++it, ++itOffset)
+    {
+      *itOffset = mFrozenDependents.size();
+      mFrozenDependents.insert(mFrozenDependents.end(), it->getDependents().begin(), it->getDependents().end());
+    }
+
+  *itOffset = mFrozenDependents.size();
+}
+
+bool CDependencyGraph::isFrozen() const
+{
+  return mFrozenOffsets.size() == mNodes.size() + 1;
+}
 
 std::ostream & operator<<(std::ostream &os,
                           const CDependencyGraphNode & d)
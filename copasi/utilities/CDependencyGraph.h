@@ -102,6 +102,39 @@ public:
 
   void clear();
 
+  /**
+   * Freeze the graph into a compressed sparse row form, i.e., the dependents of all
+   * nodes are stored in ascending order in one contiguous array. The frozen form is
+   * discarded when the graph is modified.
+   */
+  void freeze();
+
+  /**
+   * Check whether the graph is frozen
+   * @return bool isFrozen
+   */
+  bool isFrozen() const;
+
+  /**
+   * Retrieve the first dependent of the given node in the frozen graph
+   * @param const size_t & node
+   * @return const size_t * begin
+   */
+  const size_t * beginDependents(const size_t & node) const
+  {
+    return mFrozenDependents.data() + mFrozenOffsets[node];
+  }
+
+  /**
+   * Retrieve the end of the dependents of the given node in the frozen graph
+   * @param const size_t & node
+   * @return const size_t * end
+   */
+  const size_t * endDependents(const size_t & node) const
+  {
+    return mFrozenDependents.data() + mFrozenOffsets[node + 1];
+  }
+
 private:
 
   /**
@@ -115,6 +148,16 @@ private:
    */
   std::vector<CDependencyGraphNode> mNodes;
 
+  /**
+   * The offsets of the dependents of each node in the frozen graph (size: nodes + 1)
+   */
+  std::vector< size_t > mFrozenOffsets;
+
+  /**
+   * The dependents of all nodes in the frozen graph
+   */
+  std::vector< size_t > mFrozenDependents;
+
   /**
    * insert operator
    */
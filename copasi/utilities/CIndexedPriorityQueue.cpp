@@ -22,18 +22,104 @@
 // Properties, Inc. and EML Research, gGmbH.
 // All rights reserved.
 
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
 #include "copasi/copasi.h"
 #include "CCopasiMessage.h"
 #include "CIndexedPriorityQueue.h"
 
-CIndexedPriorityQueue::CIndexedPriorityQueue()
-{}
+// The minimal number of buckets of the calendar
+#define MIN_BUCKETS 16
+
+// The number of keys sampled to determine the bucket width
+#define WIDTH_SAMPLE 64
+
+// Days beyond this limit are not exactly representable
+#define MAX_DAY 4.0e15
+
+// static
+std::ostream * CIndexedPriorityQueue::mpRecorder = NULL;
+
+CIndexedPriorityQueue::CIndexedPriorityQueue(const Type & type):
+  mType(type),
+  mShift(2),
+  mHeap(),
+  mIndexPointer(),
+  mKeys(),
+  mDays(),
+  mBucketPointer(),
+  mBuckets(),
+  mBucketWidth(1.0),
+  mBucketMask(0),
+  mSize(0),
+  mCurrentDay(0.0),
+  mTopIndex(C_INVALID_INDEX),
+  mTopValid(false),
+  mSearches(0),
+  mSearchCost(0),
+  mRecalibrate(false)
+{
+  setType(type);
+}
 
 CIndexedPriorityQueue::~CIndexedPriorityQueue()
 {}
 
+void CIndexedPriorityQueue::setType(const Type & type)
+{
+  mType = type;
+
+  switch (mType)
+    {
+      case Type::BinaryHeap:
+        mShift = 1;
+        break;
+
+      case Type::QuaternaryHeap:
+        mShift = 2;
+        break;
+
+      case Type::OctonaryHeap:
+        mShift = 3;
+        break;
+
+      case Type::CalendarQueue:
+        mShift = 1;
+        break;
+    }
+
+  clear();
+}
+
+const CIndexedPriorityQueue::Type & CIndexedPriorityQueue::getType() const
+{
+  return mType;
+}
+
+// static
+void CIndexedPriorityQueue::setRecorder(std::ostream * pRecorder)
+{
+  mpRecorder = pRecorder;
+
+  if (mpRecorder != NULL)
+    mpRecorder->precision(17);
+}
+
 C_FLOAT64 CIndexedPriorityQueue::topKey() const
 {
+  if (mpRecorder != NULL) *mpRecorder << "t\n";
+
+  if (mType == Type::CalendarQueue)
+    {
+      if (mSize == 0) return std::numeric_limits<C_FLOAT64>::quiet_NaN();
+
+      if (!mTopValid) calendarFindTop();
+
+      return mKeys[mTopIndex];
+    }
+
   if (mHeap.empty()) return std::numeric_limits<C_FLOAT64>::quiet_NaN();
 
   return mHeap[0].mKey;
@@ -41,6 +127,15 @@ C_FLOAT64 CIndexedPriorityQueue::topKey() const
 
 size_t CIndexedPriorityQueue::topIndex() const
 {
+  if (mType == Type::CalendarQueue)
+    {
+      if (mSize == 0) return C_INVALID_INDEX;
+
+      if (!mTopValid) calendarFindTop();
+
+      return mTopIndex;
+    }
+
   if (mHeap.empty())
     return C_INVALID_INDEX;
 
@@ -50,23 +145,49 @@ size_t CIndexedPriorityQueue::topIndex() const
 // juergen: added 26 July, 2002
 size_t CIndexedPriorityQueue::removeStochReaction(const size_t index)
 {
-  size_t t;
+  if (mpRecorder != NULL) *mpRecorder << "r " << index << "\n";
 
   // check if index is valid
   if (index >= mIndexPointer.size()) return C_INVALID_INDEX;
 
-  if ((mIndexPointer[index] != C_INVALID_INDEX) && (mIndexPointer[index] != (mHeap.size() - 1))) // if the node with the given index exists in the tree
+  if (mType == Type::CalendarQueue)
     {
-      // remove the node with the given index from the tree
-      swapNodes(t = mIndexPointer[index], mHeap.size() - 1);
+      if (mBucketPointer[index] == C_INVALID_INDEX) return 0;
+
+      calendarRemove(index);
+      mSize--;
+
+      if (mTopIndex == index)
+        mTopValid = false;
+
+      if (mBucketMask + 1 > MIN_BUCKETS && 4 * mSize < mBucketMask + 1)
+        calendarResize((mBucketMask + 1) / 2);
+      else if (mRecalibrate)
+        calendarResize(mBucketMask + 1);
+
+      return 0;
+    }
+
+  size_t pos = mIndexPointer[index];
+
+  // the node with the given index does not exist in the tree
+  if (pos == C_INVALID_INDEX) return 0;
+
+  mIndexPointer[index] = C_INVALID_INDEX;
+
+  // the last node in the heap fills the gap
+  size_t last = mHeap.size() - 1;
+
+  if (pos != last)
+    {
+      mHeap[pos] = mHeap[last];
+      mIndexPointer[mHeap[pos].mIndex] = pos;
       mHeap.pop_back();
-      mIndexPointer[index] = -1;
-      heapify(t);
+      updateAux(pos);
     }
-  else if (mIndexPointer[index] == (mHeap.size() - 1)) // last node in the heap
+  else
     {
       mHeap.pop_back();
-      mIndexPointer[index] = -1;
     }
 
   return 0;
@@ -75,40 +196,69 @@ size_t CIndexedPriorityQueue::removeStochReaction(const size_t index)
 // juergen: added 26 July, 2002
 size_t CIndexedPriorityQueue::insertStochReaction(const size_t index, const C_FLOAT64 key)
 {
-  size_t pos;
+  if (mpRecorder != NULL) *mpRecorder << "i " << index << " " << key << "\n";
 
   // check if index is valid
   if (index >= mIndexPointer.size()) return - 1;
 
-  // first the node is inserted at the end of the heap
-  mIndexPointer[index] = mHeap.size();
-  PQNode heap_node(index, key);
-  mHeap.push_back(heap_node);
-  // bubble the node up the tree to the right position !
-  pos = mIndexPointer[index];
+  if (mType == Type::CalendarQueue)
+    {
+      if (mRecalibrate)
+        calendarResize(mBucketMask + 1);
+
+      if (mBucketPointer[index] != C_INVALID_INDEX)
+        calendarRemove(index);
+      else
+        mSize++;
+
+      mKeys[index] = key;
+      calendarInsert(index);
+      calendarUpdateTop(index);
+
+      if (mSize > 2 * (mBucketMask + 1))
+        calendarResize(2 * (mBucketMask + 1));
+
+      return 0;
+    }
 
-  while ((pos > 0) && (mHeap[parent(pos)].mKey > key))
+  // the node is already in the tree
+  if (mIndexPointer[index] != C_INVALID_INDEX)
     {
-      swapNodes(pos, parent(pos));
-      pos = parent(pos);
+      mHeap[mIndexPointer[index]].mKey = key;
+      updateAux(mIndexPointer[index]);
+
+      return 0;
     }
 
+  // first the node is inserted at the end of the heap
+  mIndexPointer[index] = mHeap.size();
+  mHeap.push_back(PQNode(index, key));
+
+  // bubble the node up the tree to the right position !
+  siftUp(mIndexPointer[index]);
+
   return 0;
 }
 
 // juergen: added 26 July, 2002
 void CIndexedPriorityQueue::initializeIndexPointer(const size_t numberOfReactions)
 {
-  size_t i;
+  if (mpRecorder != NULL) *mpRecorder << "n " << numberOfReactions << "\n";
+
+  mIndexPointer.resize(mIndexPointer.size() + numberOfReactions, C_INVALID_INDEX);
 
-  for (i = 0; i < numberOfReactions; i++)
+  if (mType == Type::CalendarQueue)
     {
-      mIndexPointer.push_back(C_INVALID_INDEX);
+      mKeys.resize(mIndexPointer.size(), std::numeric_limits< C_FLOAT64 >::quiet_NaN());
+      mDays.resize(mIndexPointer.size(), 0.0);
+      mBucketPointer.resize(mIndexPointer.size(), C_INVALID_INDEX);
     }
 }
 
 size_t CIndexedPriorityQueue::pushPair(const size_t index, const C_FLOAT64 key)
 {
+  if (mpRecorder != NULL) *mpRecorder << "p " << index << " " << key << "\n";
+
   // Add an element to the priority queue. This merely pushes an item onto
   // the back of the vector corresponding to the heap, and pushes the index
   // onto the back of the vector corresponding to the index structure.
@@ -118,14 +268,28 @@ size_t CIndexedPriorityQueue::pushPair(const size_t index, const C_FLOAT64 key)
   // be done using the buildHeap() method
 
   // First check that the index corresponds to the heap size before insertion
-  if (static_cast<unsigned int>(index) != mHeap.size())
+  if (index != mIndexPointer.size())
     {
       CCopasiMessage(CCopasiMessage::ERROR, "Error inserting pair into priority queue");
       return - 1;
     }
 
-  PQNode heap_node(index, key);
-  mHeap.push_back(heap_node);
+  if (mType == Type::CalendarQueue)
+    {
+      // The calendar is sized in buildHeap.
+      mKeys.push_back(key);
+      mDays.push_back(0.0);
+      mBucketPointer.push_back(C_INVALID_INDEX);
+      mIndexPointer.push_back(C_INVALID_INDEX);
+      mSize++;
+
+      calendarInsert(index);
+      mTopValid = false;
+
+      return 0;
+    }
+
+  mHeap.push_back(PQNode(index, key));
   // at first, position == index
   size_t position = index; // for clarity
   mIndexPointer.push_back(position);
@@ -134,104 +298,304 @@ size_t CIndexedPriorityQueue::pushPair(const size_t index, const C_FLOAT64 key)
 
 void CIndexedPriorityQueue::buildHeap()
 {
-  for (size_t i = mHeap.size() / 2 - 1; i != C_INVALID_INDEX; i--)
+  if (mpRecorder != NULL) *mpRecorder << "b\n";
+
+  if (mType == Type::CalendarQueue)
     {
-      heapify(i);
+      size_t Buckets = MIN_BUCKETS;
+
+      while (Buckets < mSize)
+        Buckets <<= 1;
+
+      calendarResize(Buckets);
+      mTopValid = false;
+
+      return;
+    }
+
+  if (mHeap.size() < 2) return;
+
+  for (size_t i = parent(mHeap.size() - 1); i != C_INVALID_INDEX; i--)
+    {
+      siftDown(i);
     }
 }
 
 void CIndexedPriorityQueue::clear()
-{mHeap.clear(); mIndexPointer.clear();}
+{
+  if (mpRecorder != NULL) *mpRecorder << "c\n";
+
+  mHeap.clear();
+  mIndexPointer.clear();
+
+  mKeys.clear();
+  mDays.clear();
+  mBucketPointer.clear();
+  mBuckets.assign(2, std::vector< size_t >());
+  mBucketWidth = 1.0;
+  mBucketMask = 0;
+  mSize = 0;
+  mCurrentDay = std::numeric_limits< C_FLOAT64 >::infinity();
+  mTopIndex = C_INVALID_INDEX;
+  mTopValid = false;
+  mSearches = 0;
+  mSearchCost = 0;
+  mRecalibrate = false;
+}
 
 void CIndexedPriorityQueue::updateNode(const size_t index, const C_FLOAT64 new_key)
 {
+  if (mpRecorder != NULL) *mpRecorder << "u " << index << " " << new_key << "\n";
+
+  if (mType == Type::CalendarQueue)
+    {
+      if (mRecalibrate)
+        calendarResize(mBucketMask + 1);
+
+      calendarRemove(index);
+      mKeys[index] = new_key;
+      calendarInsert(index);
+      calendarUpdateTop(index);
+
+      return;
+    }
+
   size_t pos = mIndexPointer[index];
-  //    cout << "Setting heap at " << pos << " to be " << new_key << endl;
   mHeap[pos].mKey = new_key;
   updateAux(pos);
 }
 
-void CIndexedPriorityQueue::swapNodes(const size_t pos1, const size_t pos2)
+size_t CIndexedPriorityQueue::siftUp(size_t pos)
 {
-  //    cout << "Swapping node " << pos1 << "(" << mHeap[pos1].mKey << ") with node ";
-  //    cout << pos2 << "(" << mHeap[pos2].mKey << ")\n";
-  C_FLOAT64 tempkey = mHeap[pos1].mKey;
-  size_t index1 = mHeap[pos1].mIndex;
-  size_t index2 = mHeap[pos2].mIndex;
-  // Put the contents of the node at pos2 into the node at pos1
-  mHeap[pos1].mIndex = index2;
-  mHeap[pos1].mKey = mHeap[pos2].mKey;
-  // Put the contents formerly in the node at pos1 into the node at pos2
-  mHeap[pos2].mIndex = index1;
-  mHeap[pos2].mKey = tempkey;
-  // Swap the pointers in the index vector
-  mIndexPointer[index1] = pos2;
-  mIndexPointer[index2] = pos1;
+  // The node is moved into its final position only once.
+  PQNode Node = mHeap[pos];
+
+  while (pos > 0)
+    {
+      size_t Parent = parent(pos);
+
+      if (!(Node.mKey < mHeap[Parent].mKey)) break;
+
+      mHeap[pos] = mHeap[Parent];
+      mIndexPointer[mHeap[pos].mIndex] = pos;
+      pos = Parent;
+    }
+
+  mHeap[pos] = Node;
+  mIndexPointer[Node.mIndex] = pos;
+
+  return pos;
 }
 
-void CIndexedPriorityQueue::heapify(const size_t current)
+void CIndexedPriorityQueue::siftDown(size_t pos)
 {
-  size_t left = leftChild(current);
-  size_t right = rightChild(current);
-  size_t highest_priority = current;
+  PQNode Node = mHeap[pos];
+  size_t Size = mHeap.size();
+  size_t Arity = 1 << mShift;
 
-  //    cout << "Heapifying " << current << "(Currently " << mHeap[current].mKey << ")" << endl;
-  if ((static_cast<unsigned int>(left) < mHeap.size()) && (mHeap[left].mKey < mHeap[current].mKey))
+  while (true)
     {
-      highest_priority = left;
-    }
+      size_t Child = firstChild(pos);
 
-  if ((static_cast<unsigned int>(right) < mHeap.size()) && (mHeap[right].mKey < mHeap[highest_priority].mKey))
-    {
-      highest_priority = right;
+      if (Child >= Size) break;
+
+      // The children are adjacent in memory.
+      size_t End = std::min(Child + Arity, Size);
+      size_t Min = Child;
+
+      for (++Child; Child < End; ++Child)
+        if (mHeap[Child].mKey < mHeap[Min].mKey)
+          Min = Child;
+
+      if (!(mHeap[Min].mKey < Node.mKey)) break;
+
+      mHeap[pos] = mHeap[Min];
+      mIndexPointer[mHeap[pos].mIndex] = pos;
+      pos = Min;
     }
 
-  if (highest_priority != current)
+  mHeap[pos] = Node;
+  mIndexPointer[Node.mIndex] = pos;
+}
+
+void CIndexedPriorityQueue::updateAux(const size_t pos)
+{
+  if (pos > 0 &&
+      mHeap[pos].mKey < mHeap[parent(pos)].mKey)
+    siftUp(pos);
+  else
+    siftDown(pos);
+}
+
+C_FLOAT64 CIndexedPriorityQueue::calendarDay(const C_FLOAT64 & key) const
+{
+  C_FLOAT64 Day = floor(key / mBucketWidth);
+
+  // NaN and large keys are kept in the overflow bucket.
+  if (Day < MAX_DAY)
+    return std::max(Day, -MAX_DAY);
+
+  return std::numeric_limits< C_FLOAT64 >::infinity();
+}
+
+void CIndexedPriorityQueue::calendarInsert(const size_t & index)
+{
+  C_FLOAT64 Day = calendarDay(mKeys[index]);
+  size_t Bucket = mBucketMask + 1;
+
+  if (Day < std::numeric_limits< C_FLOAT64 >::infinity())
     {
-      swapNodes(current, highest_priority);
-      heapify(highest_priority);
+      Bucket = (size_t)(C_INT64) Day & mBucketMask;
+
+      if (Day < mCurrentDay)
+        mCurrentDay = Day;
     }
+
+  std::vector< size_t > & Nodes = mBuckets[Bucket];
+
+  mDays[index] = Day;
+  mBucketPointer[index] = Bucket;
+  mIndexPointer[index] = Nodes.size();
+  Nodes.push_back(index);
 }
 
-void CIndexedPriorityQueue::updateAux(const size_t pos)
+void CIndexedPriorityQueue::calendarRemove(const size_t & index)
 {
-  size_t parent_pos = parent(pos);
-  C_FLOAT64 keyval = mHeap[pos].mKey;
+  std::vector< size_t > & Nodes = mBuckets[mBucketPointer[index]];
+  size_t Pos = mIndexPointer[index];
+
+  Nodes[Pos] = Nodes.back();
+  mIndexPointer[Nodes[Pos]] = Pos;
+  Nodes.pop_back();
+
+  mBucketPointer[index] = C_INVALID_INDEX;
+  mIndexPointer[index] = C_INVALID_INDEX;
+}
+
+void CIndexedPriorityQueue::calendarUpdateTop(const size_t & index)
+{
+  if (!mTopValid) return;
+
+  if (index == mTopIndex)
+    mTopValid = false;
+  else if (mKeys[index] < mKeys[mTopIndex])
+    mTopIndex = index;
+}
+
+void CIndexedPriorityQueue::calendarFindTop() const
+{
+  size_t Buckets = mBucketMask + 1;
+  const std::vector< size_t > & Overflow = mBuckets[Buckets];
+
+  mTopIndex = C_INVALID_INDEX;
+  mTopValid = true;
 
-  if (parent_pos != C_INVALID_INDEX &&
-      keyval < mHeap[parent_pos].mKey)
+  std::vector< size_t >::const_iterator it;
+  std::vector< size_t >::const_iterator end;
+
+  if (Overflow.size() == mSize)
     {
-      swapNodes(pos, parent_pos);
-      updateAux(parent_pos);
+      mTopIndex = Overflow[0];
+
+      for (it = Overflow.begin(), end = Overflow.end(); it != end; ++it)
+        if (mKeys[*it] < mKeys[mTopIndex])
+          mTopIndex = *it;
+
+      return;
     }
-  else
+
+  // We scan one year of the calendar starting with the current day.
+  C_FLOAT64 Day = mCurrentDay;
+  size_t Cost = 0;
+
+  for (size_t i = 0; i < Buckets; ++i, Day += 1.0)
     {
-      size_t left = leftChild(pos);
-      size_t right = rightChild(pos);
-      C_FLOAT64 min = 0.0;
-      size_t min_pos = 0;
+      const std::vector< size_t > & Nodes = mBuckets[(size_t)(C_INT64) Day & mBucketMask];
+      Cost += Nodes.size() + 1;
 
-      if (left < mHeap.size())
+      for (it = Nodes.begin(), end = Nodes.end(); it != end; ++it)
+        if (mDays[*it] == Day &&
+            (mTopIndex == C_INVALID_INDEX || mKeys[*it] < mKeys[mTopIndex]))
+          mTopIndex = *it;
+
+      if (mTopIndex != C_INVALID_INDEX)
         {
-          min = mHeap[left].mKey;
-          min_pos = left;
+          mCurrentDay = Day;
+          break;
         }
+    }
 
-      C_FLOAT64 val; // = mHeap[right].mKey; //!!!
+  // All nodes are more than a year ahead, i.e., the bucket width is too small.
+  if (mTopIndex == C_INVALID_INDEX)
+    {
+      std::vector< std::vector< size_t > >::const_iterator itBucket = mBuckets.begin();
+      std::vector< std::vector< size_t > >::const_iterator endBucket = itBucket + Buckets;
 
-      if ((right < mHeap.size()) && ((val = mHeap[right].mKey) < min))
-        {
-          min = val;
-          min_pos = right;
-        }
+      for (; itBucket != endBucket; ++itBucket)
+        for (it = itBucket->begin(), end = itBucket->end(); it != end; ++it)
+          if (mTopIndex == C_INVALID_INDEX || mKeys[*it] < mKeys[mTopIndex])
+            mTopIndex = *it;
 
-      if ((min_pos > 0) && (keyval > min))
-        {
-          //            swapNodes(mHeap[pos].mIndex, min_pos);
-          swapNodes(pos, min_pos);
-          updateAux(min_pos);
-        }
+      mCurrentDay = mDays[mTopIndex];
+      mRecalibrate = true;
+    }
+
+  // The bucket width is recalibrated if the search becomes too expensive.
+  mSearches++;
+  mSearchCost += Cost;
+
+  if (mSearches >= std::max< size_t >(Buckets, MIN_BUCKETS))
+    {
+      if (mSearchCost > 8 * mSearches)
+        mRecalibrate = true;
+
+      mSearches = 0;
+      mSearchCost = 0;
+    }
+}
+
+void CIndexedPriorityQueue::calendarResize(const size_t & buckets)
+{
+  std::vector< size_t > Queued;
+  std::vector< C_FLOAT64 > Keys;
+
+  size_t i, imax = mBucketPointer.size();
+
+  for (i = 0; i < imax; ++i)
+    if (mBucketPointer[i] != C_INVALID_INDEX)
+      {
+        Queued.push_back(i);
+
+        if (fabs(mKeys[i]) < std::numeric_limits< C_FLOAT64 >::infinity())
+          Keys.push_back(mKeys[i]);
+      }
+
+  // The bucket width is 3 times the average separation of the lowest keys (Brown 1988).
+  size_t Sample = std::min< size_t >(Keys.size(), WIDTH_SAMPLE);
+
+  if (Sample > 1)
+    {
+      std::partial_sort(Keys.begin(), Keys.begin() + Sample, Keys.end());
+      C_FLOAT64 Separation = (Keys[Sample - 1] - Keys[0]) / (Sample - 1);
+
+      if (Separation > 0.0 &&
+          Separation < std::numeric_limits< C_FLOAT64 >::infinity())
+        mBucketWidth = 3.0 * Separation;
     }
+
+  mBuckets.assign(buckets + 1, std::vector< size_t >());
+  mBucketMask = buckets - 1;
+  mCurrentDay = std::numeric_limits< C_FLOAT64 >::infinity();
+
+  std::vector< size_t >::const_iterator it = Queued.begin();
+  std::vector< size_t >::const_iterator end = Queued.end();
+
+  for (; it != end; ++it)
+    calendarInsert(*it);
+
+  mSearches = 0;
+  mSearchCost = 0;
+  mRecalibrate = false;
 }
 
 #ifdef TEST_PRIORITY_QUEUE
@@ -297,6 +661,24 @@ std::ostream & operator<<(std::ostream &os, const CIndexedPriorityQueue & d)
 
   os << "PQ: " << std::endl;
 
+  if (d.mType == CIndexedPriorityQueue::Type::CalendarQueue)
+    {
+      os << "  mBuckets: " << std::endl;
+
+      for (i = 0; i < d.mBuckets.size(); i++)
+        {
+          std::vector< size_t >::const_iterator it = d.mBuckets[i].begin();
+          std::vector< size_t >::const_iterator end = d.mBuckets[i].end();
+
+          for (; it != end; ++it)
+            os << i << ": (" << *it << ", " << d.mKeys[*it] << ")" << std::endl;
+        }
+
+      os << std::endl;
+
+      return os;
+    }
+
   std::vector <PQNode>::const_iterator it;
   os << "  mHeap: " << std::endl;
 
@@ -20,6 +20,8 @@
 
 #include <queue>
 #include <utility>
+#include <vector>
+#include <iostream>
 
 class CIndexedPriorityQueue;
 
@@ -73,22 +75,60 @@ private:
  * The indexed priority queue as applied to stochastic simulations is described in
  * "Efficient Exact Stochastic Simulation of Chemical Systems with Many Species
  * and Many Channels", Gibson and Bruck, J. Phys. Chem. A 104 (2000) 1876-1889
+ *
+ * The queue is implemented either as a d-ary heap (d = 2, 4, or 8) or as a calendar
+ * queue (R. Brown, Calendar queues: a fast O(1) priority queue implementation for the
+ * simulation event set problem, Commun. ACM 31 (1988) 1220-1227). The children of a node
+ * in a 4-ary or 8-ary heap are adjacent in memory, which reduces the height of the
+ * heap and the number of cache lines touched by an update. The calendar queue has a
+ * constant expected cost per operation if the keys are evenly spread.
  */
 
 class CIndexedPriorityQueue
 {
 public:
+  /**
+   * Enumeration of the implementations
+   */
+  enum struct Type
+  {
+    BinaryHeap,
+    QuaternaryHeap,
+    OctonaryHeap,
+    CalendarQueue
+  };
+
   // Lifecycle methods
   /**
    * Constructor
+   * @param const Type & type (default: QuaternaryHeap)
    */
-  CIndexedPriorityQueue();
+  CIndexedPriorityQueue(const Type & type = Type::QuaternaryHeap);
 
   /**
    * Destructor
    */
   ~CIndexedPriorityQueue();
 
+  /**
+   * Set the implementation. This clears the queue.
+   * @param const Type & type
+   */
+  void setType(const Type & type);
+
+  /**
+   * Retrieve the implementation
+   * @return const Type & type
+   */
+  const Type & getType() const;
+
+  /**
+   * Record all operations on priority queues to the given stream, which allows
+   * to replay them, e.g., for benchmarking. Recording is stopped for NULL.
+   * @param std::ostream * pRecorder
+   */
+  static void setRecorder(std::ostream * pRecorder);
+
   // Accessors
   /**
    * Get the index associated with the highest priority node
@@ -131,7 +171,7 @@ public:
   /**
    * Return the size of the heap
    */
-  size_t size() const {return mHeap.size();}
+  size_t size() const {return mType == Type::CalendarQueue ? mSize : mHeap.size();}
 
   // Operations
   /**
@@ -155,11 +195,15 @@ public:
   void updateNode(const size_t index, const C_FLOAT64 key);
 
   /**
-   * Overloads the [] operator. Gives the indexth element on the heap
+   * Overloads the [] operator. Gives the index'th element on the heap. For the
+   * calendar queue the key of the node with the index pos is returned.
    * @return Returns the key
    */
   C_FLOAT64 operator[](const size_t pos) const
   {
+    if (mType == Type::CalendarQueue)
+      return mKeys[pos];
+
     return mHeap[pos].mKey;
   }
 
@@ -171,6 +215,9 @@ public:
    */
   C_FLOAT64 getKey(const size_t index) const
   {
+    if (mType == Type::CalendarQueue)
+      return mKeys[index];
+
     // does not consider negative IndexPointer
     return mHeap[mIndexPointer[index]].mKey;
   }
@@ -184,15 +231,18 @@ public:
 private:
   // Private operations
   /**
-   *  Swap a pair of nodes and update the index structure accordingly.
+   * Move the node at the given position up the heap until its parent has a lower key.
+   * @param size_t pos
+   * @return size_t pos The new position of the node
    */
-  void swapNodes(const size_t index1, const size_t index2);
+  size_t siftUp(size_t pos);
 
   /**
-   * Make a tree rooted at a given position into a heap
-   * @param pos The root position of the tree to heapify
+   * Move the node at the given position down the heap until all its children have
+   * a higher key.
+   * @param size_t pos
    */
-  void heapify(const size_t pos);
+  void siftDown(size_t pos);
 
   /**
    * Used by the updateNode function. Update the node at a given position.
@@ -206,32 +256,146 @@ private:
    * @param pos The current node position
    * @return The parent node position
    */
-  size_t parent(const size_t pos) const {return (pos + 1) / 2 - 1;}
+  size_t parent(const size_t pos) const {return (pos - 1) >> mShift;}
 
   /**
-   * Provide the position in the heap of the left child of the current node.
+   * Provide the position in the heap of the first child of the current node.
+   * The other children follow in consecutive positions.
    * @param pos The current node position
-   * @return The left child position
+   * @return The first child position
    */
-  size_t leftChild(const size_t pos) const {return 2*pos + 1;}
+  size_t firstChild(const size_t pos) const {return (pos << mShift) + 1;}
 
   /**
-   * Provide the position in the heap of the right child of the current node.
-   * @param pos The current node position
-   * @return The right child position
+   * Insert the node with the given index into the bucket of the calendar
+   * @param const size_t & index
    */
-  size_t rightChild(const size_t pos) const {return 2*pos + 2;}
+  void calendarInsert(const size_t & index);
+
+  /**
+   * Remove the node with the given index from its bucket of the calendar
+   * @param const size_t & index
+   */
+  void calendarRemove(const size_t & index);
+
+  /**
+   * Update the top of the calendar after the key of the node with the given
+   * index has been changed or the node has been inserted.
+   * @param const size_t & index
+   */
+  void calendarUpdateTop(const size_t & index);
+
+  /**
+   * Find the node with the lowest key in the calendar
+   */
+  void calendarFindTop() const;
+
+  /**
+   * Resize the calendar to the given number of buckets and determine the bucket
+   * width from the current keys.
+   * @param const size_t & buckets
+   */
+  void calendarResize(const size_t & buckets);
+
+  /**
+   * Determine the day, i.e., the bucket number before wrapping, of a key.
+   * @param const C_FLOAT64 & key
+   * @return C_FLOAT64 day (infinity if the node belongs into the overflow bucket)
+   */
+  C_FLOAT64 calendarDay(const C_FLOAT64 & key) const;
 
 private:
   // Members
+  /**
+   * The implementation
+   */
+  Type mType;
+
+  /**
+   * The binary logarithm of the arity of the heap
+   */
+  size_t mShift;
+
   /**
    * The vector which stores the heap
    */
   std::vector<PQNode> mHeap;
+
   /**
-   * The vector which stores a pointer to each indexed node on the heap
+   * The vector which stores a pointer to each indexed node on the heap. For the
+   * calendar queue this is the position of the node within its bucket.
    */
   std::vector<size_t> mIndexPointer;
+
+  /**
+   * The keys of the nodes in the calendar queue by index
+   */
+  std::vector< C_FLOAT64 > mKeys;
+
+  /**
+   * The day of the nodes in the calendar queue by index
+   */
+  std::vector< C_FLOAT64 > mDays;
+
+  /**
+   * The bucket of the nodes in the calendar queue by index (C_INVALID_INDEX if not queued)
+   */
+  std::vector< size_t > mBucketPointer;
+
+  /**
+   * The buckets of the calendar, the last bucket holds nodes with infinite or NaN keys
+   */
+  std::vector< std::vector< size_t > > mBuckets;
+
+  /**
+   * The width of a bucket of the calendar
+   */
+  C_FLOAT64 mBucketWidth;
+
+  /**
+   * The number of buckets of the calendar minus one (the number of buckets is a power of 2)
+   */
+  size_t mBucketMask;
+
+  /**
+   * The number of nodes in the calendar queue
+   */
+  size_t mSize;
+
+  /**
+   * A lower bound of the days of all nodes in the calendar queue
+   */
+  mutable C_FLOAT64 mCurrentDay;
+
+  /**
+   * The index of the node with the lowest key in the calendar queue
+   */
+  mutable size_t mTopIndex;
+
+  /**
+   * Indicates whether mTopIndex is valid
+   */
+  mutable bool mTopValid;
+
+  /**
+   * The number of searches for the top since the last calibration of the calendar
+   */
+  mutable size_t mSearches;
+
+  /**
+   * The number of buckets and nodes visited during these searches
+   */
+  mutable size_t mSearchCost;
+
+  /**
+   * Indicates whether the bucket width must be recalibrated
+   */
+  mutable bool mRecalibrate;
+
+  /**
+   * The stream all operations are recorded to
+   */
+  static std::ostream * mpRecorder;
 };
 
 #endif // COPASI_CPriorityQueue
@@ -0,0 +1,437 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <set>
+
+#include "copasi/copasi.h"
+
+#include "copasi/utilities/CSparseLU.h"
+#include "copasi/utilities/CSparseMatrix.h"
+
+// A pivot candidate on the diagonal is accepted if its magnitude is at least this
+// fraction of the largest candidate.
+#define PIVOT_THRESHOLD 0.1
+
+CSparseLU::CSparseLU():
+  mSize(0),
+  mpMatrix(NULL),
+  mColumnOrder(),
+  mRowOfStep(),
+  mStepOfRow(),
+  mLColumnStart(),
+  mLRowIndex(),
+  mLValues(),
+  mUColumnStart(),
+  mURowIndex(),
+  mUValues(),
+  mUDiagonal(),
+  mFactorized(false),
+  mWork(),
+  mReach(),
+  mVisited(),
+  mStack()
+{}
+
+CSparseLU::CSparseLU(const CSparseLU & /* src */):
+  mSize(0),
+  mpMatrix(NULL),
+  mColumnOrder(),
+  mRowOfStep(),
+  mStepOfRow(),
+  mLColumnStart(),
+  mLRowIndex(),
+  mLValues(),
+  mUColumnStart(),
+  mURowIndex(),
+  mUValues(),
+  mUDiagonal(),
+  mFactorized(false),
+  mWork(),
+  mReach(),
+  mVisited(),
+  mStack()
+{}
+
+CSparseLU::~CSparseLU()
+{
+  pdelete(mpMatrix);
+}
+
+bool CSparseLU::analyze(const CMatrix< C_INT32 > & pattern)
+{
+  pdelete(mpMatrix);
+
+  mSize = pattern.numRows();
+
+  if (mSize != pattern.numCols())
+    {
+      mSize = 0;
+      clear();
+
+      return false;
+    }
+
+  size_t Row, Col;
+  size_t NonZeros = 0;
+
+  for (Row = 0; Row < mSize; ++Row)
+    for (Col = 0; Col < mSize; ++Col)
+      if (Row == Col || pattern(Row, Col) != 0)
+        ++NonZeros;
+
+  mpMatrix = new CCompressedColumnFormat(mSize, mSize, NonZeros);
+
+  size_t * pColumnStart = mpMatrix->getColumnStart();
+  size_t * pRowIndex = mpMatrix->getRowIndex();
+  size_t Index = 0;
+
+  for (Col = 0; Col < mSize; ++Col)
+    {
+      pColumnStart[Col] = Index;
+
+      for (Row = 0; Row < mSize; ++Row)
+        if (Row == Col || pattern(Row, Col) != 0)
+          {
+            pRowIndex[Index++] = Row;
+          }
+    }
+
+  orderMinimumDegree();
+
+  mRowOfStep.resize(mSize);
+  mStepOfRow.resize(mSize);
+  mUDiagonal.resize(mSize);
+  mWork.resize(mSize);
+  clear();
+
+  return true;
+}
+
+void CSparseLU::orderMinimumDegree()
+{
+  mColumnOrder.resize(mSize);
+
+  const size_t * pColumnStart = mpMatrix->getColumnStart();
+  const size_t * pRowIndex = mpMatrix->getRowIndex();
+
+  // The elimination graph of A + A^T
+  std::vector< std::set< size_t > > Adjacent(mSize);
+  size_t Row, Col, Index;
+
+  for (Col = 0; Col < mSize; ++Col)
+    for (Index = pColumnStart[Col]; Index < pColumnStart[Col + 1]; ++Index)
+      if ((Row = pRowIndex[Index]) != Col)
+        {
+          Adjacent[Row].insert(Col);
+          Adjacent[Col].insert(Row);
+        }
+
+  // The nodes ordered by degree and index. The index breaks ties, i.e., the order is deterministic.
+  std::set< std::pair< size_t, size_t > > Degrees;
+
+  for (Row = 0; Row < mSize; ++Row)
+    Degrees.insert(std::make_pair(Adjacent[Row].size(), Row));
+
+  std::set< size_t >::const_iterator it, end, itOther;
+
+  for (size_t Step = 0; Step < mSize; ++Step)
+    {
+      size_t Node = Degrees.begin()->second;
+      Degrees.erase(Degrees.begin());
+      mColumnOrder[Step] = Node;
+
+      const std::set< size_t > & Neighbors = Adjacent[Node];
+      end = Neighbors.end();
+
+      // Remove the node from the graph
+      for (it = Neighbors.begin(); it != end; ++it)
+        {
+          Degrees.erase(std::make_pair(Adjacent[*it].size(), *it));
+          Adjacent[*it].erase(Node);
+        }
+
+      // The elimination connects all neighbors with each other.
+      for (it = Neighbors.begin(); it != end; ++it)
+        {
+          for (itOther = Neighbors.begin(); itOther != end; ++itOther)
+            if (*itOther != *it)
+              Adjacent[*it].insert(*itOther);
+
+          Degrees.insert(std::make_pair(Adjacent[*it].size(), *it));
+        }
+
+      Adjacent[Node].clear();
+    }
+}
+
+bool CSparseLU::factorize(const CMatrix< C_FLOAT64 > & matrix,
+                          const C_FLOAT64 & shift)
+{
+  clear();
+
+  if (mpMatrix == NULL ||
+      matrix.numRows() != mSize ||
+      matrix.numCols() != mSize)
+    return false;
+
+  const size_t * pColumnStart = mpMatrix->getColumnStart();
+  const size_t * pRowIndex = mpMatrix->getRowIndex();
+  C_FLOAT64 * pValue = mpMatrix->getValues();
+
+  size_t Row, Col, Index;
+
+  // Gather the values of the structural non-zeros
+  C_FLOAT64 Norm = 0.0;
+
+  for (Col = 0; Col < mSize; ++Col)
+    for (Index = pColumnStart[Col]; Index < pColumnStart[Col + 1]; ++Index)
+      {
+        pValue[Index] = matrix(pRowIndex[Index], Col);
+
+        // The diagonal is always part of the structure.
+        if (pRowIndex[Index] == Col)
+          pValue[Index] += shift;
+
+        if (std::isnan(pValue[Index])) return false;
+
+        Norm = std::max(Norm, fabs(pValue[Index]));
+      }
+
+  // Pivots below this tolerance indicate a numerically singular matrix.
+  C_FLOAT64 Tolerance = 100.0 * std::numeric_limits< C_FLOAT64 >::epsilon() * Norm;
+
+  mWork = 0.0;
+  C_FLOAT64 * pX = mWork.array();
+
+  std::vector< size_t >::const_iterator itReach, endReach;
+
+  for (size_t Step = 0; Step < mSize; ++Step)
+    {
+      Col = mColumnOrder[Step];
+
+      mLColumnStart.push_back(mLRowIndex.size());
+      mUColumnStart.push_back(mURowIndex.size());
+
+      // The rows which may become non-zero
+      reach(Col, Step);
+
+      for (Index = pColumnStart[Col]; Index < pColumnStart[Col + 1]; ++Index)
+        pX[pRowIndex[Index]] = pValue[Index];
+
+      // Solve L * x = A(:, Col) for the rows which are already pivots
+      endReach = mReach.end();
+
+      for (itReach = mReach.begin(); itReach != endReach; ++itReach)
+        {
+          size_t PivotStep = mStepOfRow[*itReach];
+
+          if (PivotStep == C_INVALID_INDEX) continue;
+
+          C_FLOAT64 Xj = pX[*itReach];
+
+          for (Index = mLColumnStart[PivotStep]; Index < mLColumnStart[PivotStep + 1]; ++Index)
+            pX[mLRowIndex[Index]] -= mLValues[Index] * Xj;
+        }
+
+      // Select the pivot among the remaining rows preferring the diagonal.
+      size_t PivotRow = C_INVALID_INDEX;
+      C_FLOAT64 Max = -1.0;
+
+      for (itReach = mReach.begin(); itReach != endReach; ++itReach)
+        if (mStepOfRow[*itReach] == C_INVALID_INDEX &&
+            fabs(pX[*itReach]) > Max)
+          {
+            Max = fabs(pX[*itReach]);
+            PivotRow = *itReach;
+          }
+
+      if (mStepOfRow[Col] == C_INVALID_INDEX &&
+          fabs(pX[Col]) >= PIVOT_THRESHOLD * Max)
+        PivotRow = Col;
+
+      if (PivotRow == C_INVALID_INDEX ||
+          !(fabs(pX[PivotRow]) > Tolerance))
+        {
+          for (itReach = mReach.begin(); itReach != endReach; ++itReach)
+            pX[*itReach] = 0.0;
+
+          clear();
+          return false;
+        }
+
+      C_FLOAT64 Pivot = pX[PivotRow];
+
+      for (itReach = mReach.begin(); itReach != endReach; ++itReach)
+        {
+          Row = *itReach;
+
+          if (mStepOfRow[Row] != C_INVALID_INDEX)
+            {
+              mURowIndex.push_back(mStepOfRow[Row]);
+              mUValues.push_back(pX[Row]);
+            }
+          else if (Row != PivotRow && pX[Row] != 0.0)
+            {
+              mLRowIndex.push_back(Row);
+              mLValues.push_back(pX[Row] / Pivot);
+            }
+
+          pX[Row] = 0.0;
+        }
+
+      mUDiagonal[Step] = Pivot;
+      mRowOfStep[Step] = PivotRow;
+      mStepOfRow[PivotRow] = Step;
+    }
+
+  mLColumnStart.push_back(mLRowIndex.size());
+  mUColumnStart.push_back(mURowIndex.size());
+
+  // Express the rows of L in steps
+  std::vector< size_t >::iterator itRow = mLRowIndex.begin();
+  std::vector< size_t >::iterator endRow = mLRowIndex.end();
+
+  for (; itRow != endRow; ++itRow)
+    *itRow = mStepOfRow[*itRow];
+
+  mFactorized = true;
+
+  return true;
+}
+
+void CSparseLU::reach(const size_t & column, const size_t & step)
+{
+  mReach.clear();
+
+  const size_t * pColumnStart = mpMatrix->getColumnStart();
+  const size_t * pRowIndex = mpMatrix->getRowIndex();
+
+  size_t Visited = step + 1;
+  size_t Index;
+
+  for (Index = pColumnStart[column]; Index < pColumnStart[column + 1]; ++Index)
+    {
+      size_t Start = pRowIndex[Index];
+
+      if (mVisited[Start] == Visited) continue;
+
+      mVisited[Start] = Visited;
+      mStack.push_back(std::make_pair(Start, (size_t) 0));
+
+      // Depth first search in the graph of L, where the children of a pivot row are
+      // the rows of its column of L.
+      while (!mStack.empty())
+        {
+          std::pair< size_t, size_t > & Current = mStack.back();
+          size_t PivotStep = mStepOfRow[Current.first];
+          bool Descended = false;
+
+          if (PivotStep != C_INVALID_INDEX)
+            {
+              size_t Child = mLColumnStart[PivotStep] + Current.second;
+              size_t ChildEnd = mLColumnStart[PivotStep + 1];
+
+              for (; Child < ChildEnd; ++Child)
+                if (mVisited[mLRowIndex[Child]] != Visited)
+                  {
+                    Current.second = Child - mLColumnStart[PivotStep] + 1;
+                    mVisited[mLRowIndex[Child]] = Visited;
+                    mStack.push_back(std::make_pair(mLRowIndex[Child], (size_t) 0));
+                    Descended = true;
+                    break;
+                  }
+            }
+
+          if (!Descended)
+            {
+              mReach.push_back(mStack.back().first);
+              mStack.pop_back();
+            }
+        }
+    }
+
+  // The reverse post order is a topological order.
+  std::reverse(mReach.begin(), mReach.end());
+}
+
+bool CSparseLU::solve(const CVectorCore< const C_FLOAT64 > & bVector,
+                      CVector< C_FLOAT64 > & xVector) const
+{
+  if (!mFactorized ||
+      bVector.size() != mSize)
+    return false;
+
+  C_FLOAT64 * pY = mWork.array();
+  size_t Step, Index;
+
+  // y = P * b
+  for (Step = 0; Step < mSize; ++Step)
+    pY[Step] = bVector[mRowOfStep[Step]];
+
+  // Solve L * z = y
+  for (Step = 0; Step < mSize; ++Step)
+    {
+      C_FLOAT64 Yj = pY[Step];
+
+      if (Yj == 0.0) continue;
+
+      for (Index = mLColumnStart[Step]; Index < mLColumnStart[Step + 1]; ++Index)
+        pY[mLRowIndex[Index]] -= mLValues[Index] * Yj;
+    }
+
+  // Solve U * z = y
+  for (Step = mSize; Step-- > 0;)
+    {
+      pY[Step] /= mUDiagonal[Step];
+      C_FLOAT64 Yj = pY[Step];
+
+      if (Yj == 0.0) continue;
+
+      for (Index = mUColumnStart[Step]; Index < mUColumnStart[Step + 1]; ++Index)
+        pY[mURowIndex[Index]] -= mUValues[Index] * Yj;
+    }
+
+  // x = Q * z
+  xVector.resize(mSize);
+
+  for (Step = 0; Step < mSize; ++Step)
+    xVector[mColumnOrder[Step]] = pY[Step];
+
+  return true;
+}
+
+const size_t & CSparseLU::size() const
+{
+  return mSize;
+}
+
+size_t CSparseLU::numNonZeros() const
+{
+  return mpMatrix != NULL ? mpMatrix->numNonZeros() : 0;
+}
+
+size_t CSparseLU::numFactorNonZeros() const
+{
+  return mLRowIndex.size() + mURowIndex.size() + mSize;
+}
+
+void CSparseLU::clear()
+{
+  // The capacity of the factors is kept since the next factorization is expected to be of similar size.
+  mFactorized = false;
+
+  mLColumnStart.clear();
+  mLRowIndex.clear();
+  mLValues.clear();
+  mUColumnStart.clear();
+  mURowIndex.clear();
+  mUValues.clear();
+
+  mStepOfRow.assign(mSize, C_INVALID_INDEX);
+  mVisited.assign(mSize, 0);
+}
@@ -0,0 +1,185 @@
+// Copyright (C) 2019 - 2020 by Pedro Mendes, Rector and Visitors of the
+// University of Virginia, University of Heidelberg, and University
+// of Connecticut School of Medicine.
+// All rights reserved.
+
+#ifndef COPASI_CSparseLU
+#define COPASI_CSparseLU
+
+#include <vector>
+
+#include "copasi/core/CVector.h"
+#include "copasi/core/CMatrix.h"
+
+class CCompressedColumnFormat;
+
+/**
+ * The class CSparseLU solves square linear systems A * x = b with a sparse LU factorization
+ *      P * A * Q = L * U
+ * The structure of A is analyzed once by analyze(), which stores the structural non-zeros in
+ * compressed column format and determines a fill reducing column order Q by minimum degree
+ * ordering of the structure of A + A^T. The numerical factorization factorize() may be repeated
+ * for different values of A with the same structure. It is a left looking factorization
+ * (Gilbert-Peierls) with threshold partial pivoting which prefers the diagonal.
+ */
+class CSparseLU
+{
+public:
+  /**
+   * Default constructor
+   */
+  CSparseLU();
+
+  /**
+   * Copy constructor, the analysis and factorization are not copied.
+   * @param const CSparseLU & src
+   */
+  CSparseLU(const CSparseLU & src);
+
+  /**
+   * Destructor
+   */
+  ~CSparseLU();
+
+  /**
+   * Analyze the structure of the square matrix. All non-zero entries and the diagonal
+   * are considered to be structural non-zeros.
+   * @param const CMatrix< C_INT32 > & pattern
+   * @return bool success
+   */
+  bool analyze(const CMatrix< C_INT32 > & pattern);
+
+  /**
+   * Factorize the matrix + shift * I where the matrix must have the structure provided to
+   * analyze. Entries outside the structure are ignored.
+   * @param const CMatrix< C_FLOAT64 > & matrix
+   * @param const C_FLOAT64 & shift (default: 0.0)
+   * @return bool success (false if the matrix is numerically singular)
+   */
+  bool factorize(const CMatrix< C_FLOAT64 > & matrix,
+                 const C_FLOAT64 & shift = 0.0);
+
+  /**
+   * Solve A * x = b with the last successful factorization
+   * @param const CVectorCore< const C_FLOAT64 > & bVector
+   * @param CVector< C_FLOAT64 > & xVector
+   * @return bool success
+   */
+  bool solve(const CVectorCore< const C_FLOAT64 > & bVector,
+             CVector< C_FLOAT64 > & xVector) const;
+
+  /**
+   * Retrieve the dimension of the analyzed matrix
+   * @return const size_t & size
+   */
+  const size_t & size() const;
+
+  /**
+   * Retrieve the number of structural non-zeros of the analyzed matrix
+   * @return size_t numNonZeros
+   */
+  size_t numNonZeros() const;
+
+  /**
+   * Retrieve the number of non-zeros of the factors L and U of the last factorization
+   * @return size_t numFactorNonZeros
+   */
+  size_t numFactorNonZeros() const;
+
+private:
+  /**
+   * Assignment is not supported
+   */
+  CSparseLU & operator = (const CSparseLU & rhs);
+
+  /**
+   * Determine the minimum degree order of the structure of A + A^T
+   */
+  void orderMinimumDegree();
+
+  /**
+   * Determine the rows reachable from the structure of the indexed column in the graph
+   * of L. The rows are returned in topological order in mReach.
+   * @param const size_t & column
+   * @param const size_t & step
+   */
+  void reach(const size_t & column, const size_t & step);
+
+  /**
+   * Clear the factorization
+   */
+  void clear();
+
+  // Attributes
+  /**
+   * The dimension of the matrix
+   */
+  size_t mSize;
+
+  /**
+   * The structural non-zeros and their values of the matrix A
+   */
+  CCompressedColumnFormat * mpMatrix;
+
+  /**
+   * The column order Q, i.e., step k eliminates the column mColumnOrder[k]
+   */
+  std::vector< size_t > mColumnOrder;
+
+  /**
+   * The pivot row of each step
+   */
+  std::vector< size_t > mRowOfStep;
+
+  /**
+   * The step in which a row is pivot (C_INVALID_INDEX if not yet pivot)
+   */
+  std::vector< size_t > mStepOfRow;
+
+  /**
+   * The strictly lower triangular part of L in compressed column format.
+   * The unit diagonal is not stored.
+   */
+  std::vector< size_t > mLColumnStart;
+  std::vector< size_t > mLRowIndex;
+  std::vector< C_FLOAT64 > mLValues;
+
+  /**
+   * The strictly upper triangular part of U in compressed column format
+   */
+  std::vector< size_t > mUColumnStart;
+  std::vector< size_t > mURowIndex;
+  std::vector< C_FLOAT64 > mUValues;
+
+  /**
+   * The diagonal of U
+   */
+  CVector< C_FLOAT64 > mUDiagonal;
+
+  /**
+   * Indicates whether the current factorization is valid
+   */
+  bool mFactorized;
+
+  /**
+   * Dense work vector
+   */
+  mutable CVector< C_FLOAT64 > mWork;
+
+  /**
+   * The rows reached while computing a column of the factorization
+   */
+  std::vector< size_t > mReach;
+
+  /**
+   * The step (plus one) in which a row was last visited
+   */
+  std::vector< size_t > mVisited;
+
+  /**
+   * The depth first search stack of rows and positions in their column of L
+   */
+  std::vector< std::pair< size_t, size_t > > mStack;
+};
+
+#endif // COPASI_CSparseLU
@@ -503,8 +503,8 @@ CCompressedColumnFormat::CCompressedColumnFormat(const CSparseMatrix & matrix):
 
 CCompressedColumnFormat::~CCompressedColumnFormat()
 {
-  pdelete(mpValue);
-  pdelete(mpRowIndex);
+  pdeletev(mpValue);
+  pdeletev(mpRowIndex);
   pdeletev(mpColumnStart);
 }
 
@@ -537,9 +537,9 @@ size_t * CCompressedColumnFormat::getColumnStart()
 
 CCompressedColumnFormat & CCompressedColumnFormat::operator = (const CSparseMatrix & matrix)
 {
-  pdelete(mpValue);
-  pdelete(mpRowIndex);
-  pdelete(mpColumnStart);
+  pdeletev(mpValue);
+  pdeletev(mpRowIndex);
+  pdeletev(mpColumnStart);
 
   mNumRows = matrix.numRows();
   mNumCols = matrix.numCols();
@@ -108,7 +108,11 @@ const CEnumAnnotation< std::string, CTaskEnum::Method > CTaskEnum::MethodName(
   "Cross Section Finder",
   "Linear Noise Approximation",
   "Analytics Finder",
-  "LSODA Sensitivities"
+  "LSODA Sensitivities",
+  "LSODA Sensitivities (Analytic)",
+  "Stochastic (Logarithmic Direct method)",
+  "Stochastic (\xcf\x84-Leap, Cao-Gillespie-Petzold)",
+  "Multi-Start"
 });
 
 const CEnumAnnotation< std::string, CTaskEnum::Method > CTaskEnum::MethodXML(
@@ -164,5 +168,9 @@ const CEnumAnnotation< std::string, CTaskEnum::Method > CTaskEnum::MethodXML(
   "crossSectionMethod",
   "LinearNoiseApproximation",
   "analyticsMethod",
-  "Sensitivities(LSODA)"
+  "Sensitivities(LSODA)",
+  "Sensitivities(LSODA,Analytic)",
+  "LogarithmicDirectMethod",
+  "TauLeapCGP",
+  "MultiStart"
 });
@@ -110,6 +110,10 @@ public:
     linearNoiseApproximation,
     analyticsMethod,
     timeSensLsoda,
+    timeSensLsodaAnalytic,
+    logarithmicDirectMethod,
+    tauLeapCGP,
+    MultiStart,
     __SIZE
   };
 
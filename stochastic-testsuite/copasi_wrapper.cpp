@@ -118,10 +118,18 @@ int main(int argc, char *argv[])
     {
       MethodType = CTaskEnum::Method::directMethod;
     }
+  else if (!strcmp(pMethodType, "logarithmicDirectMethod"))
+    {
+      MethodType = CTaskEnum::Method::logarithmicDirectMethod;
+    }
   else if (!strcmp(pMethodType, "tauLeap"))
     {
       MethodType = CTaskEnum::Method::tauLeap;
     }
+  else if (!strcmp(pMethodType, "tauLeapCGP"))
+    {
+      MethodType = CTaskEnum::Method::tauLeapCGP;
+    }
   else if (!strcmp(pMethodType, "adaptiveSA"))
     {
       MethodType = CTaskEnum::Method::adaptiveSA;
@@ -139,8 +147,10 @@ int main(int argc, char *argv[])
       std::cerr << "Invalid method type. Valid options are:" << std::endl;
       std::cerr << "    stochastic" << std::endl;
       std::cerr << "    directMethod" << std::endl;
+      std::cerr << "    logarithmicDirectMethod" << std::endl;
       std::cerr << "    adaptiveSA" << std::endl;
       std::cerr << "    tauLeap" << std::endl;
+      std::cerr << "    tauLeapCGP" << std::endl;
       std::cerr << "    LSODA" << std::endl;
       std::cerr << "    HybridODE45" << std::endl;
     }